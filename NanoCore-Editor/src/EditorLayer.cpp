@@ -1,6 +1,10 @@
 #include "EditorLayer.h"
 #include "modules/entity/SceneSerializer.h"
+#include "modules/entity/SceneBinarySerializer.h"
+#include "modules/entity/AssetImportPipeline.h"
 #include "modules/utils/PlatformUtils.h"
+#include "modules/utils/AssetPack.h"
+#include "modules/utils/Timer.h"
 #include "core/math/NanoMath.h"
 
 #include <imgui/imgui.h>
@@ -52,6 +56,7 @@ namespace NanoCore {
 		m_PanelManager->AddPanel<SysStatusPanel>(PanelCategory::Edit, "SysStatusPanel", "SysStatus", true);
 		m_PanelManager->AddPanel<ContentPanel>(PanelCategory::Edit, "ContentPanel", "Content", true);
 		m_PanelManager->AddPanel<GlobalSettingPanel>(PanelCategory::Edit, "GlobalSettingPanel", "GlobalSetting", true);
+		m_PanelManager->AddPanel<ScriptProfilerPanel>(PanelCategory::View, "ScriptProfilerPanel", "Script Profiler", false);
 
 		m_CheckerboardTexture = Texture2D::Create("resources/textures/empty.png");
 		m_IconPlay = Texture2D::Create("resources/icons/Play.png");
@@ -66,14 +71,17 @@ namespace NanoCore {
 
 		m_EditorScene = Shared<Scene>::Create();
 		m_ActiveScene = m_EditorScene;
+		m_SceneSaver = std::make_unique<SceneSaver>();
 
 		auto commandLineArgs = Application::Get().GetSpecification().CommandLineArgs;
 		if (commandLineArgs.Count > 1)
 		{
 			auto sceneFilePath = commandLineArgs[1];
 			SceneSerializer serializer(m_ActiveScene);
-			serializer.Deserialize(sceneFilePath);
+			if (serializer.Deserialize(sceneFilePath))
+				m_EditorScenePath = sceneFilePath;
 		}
+		m_SceneSaver->SetScene(m_EditorScene, m_EditorScenePath);
 
 		m_EditorCamera = EditorCamera(30.0f, 1.778f, 0.1f, 1000.0f);
 		RenderUtils::SetLineWidth(4.0f);
@@ -85,6 +93,9 @@ namespace NanoCore {
 	void EditorLayer::OnDetach()
 	{
 		RA_PROFILE_FUNCTION();
+
+		// Waits for saves still being written
+		m_SceneSaver.reset();
 	}
 
 	void EditorLayer::OnUpdate(Timestep ts)
@@ -121,6 +132,7 @@ namespace NanoCore {
 			m_EditorCamera.OnUpdate(ts);
 
 			m_ActiveScene->OnUpdateEditor(ts, m_EditorCamera);
+			m_SceneSaver->OnUpdate(ts);
 			break;
 		}
 		case SceneState::Simulate:
@@ -562,6 +574,23 @@ namespace NanoCore {
 
 					if (ImGui::BeginMenuEx("File","A"))
 					{
+						if (ImGui::MenuItem("New Scene", "Ctrl+N"))
+							NewScene();
+
+						if (ImGui::MenuItem("Open Scene...", "Ctrl+O"))
+							OpenScene();
+
+						if (ImGui::MenuItem("Save Scene", "Ctrl+S"))
+							SaveScene();
+
+						if (ImGui::MenuItem("Save Scene As...", "Ctrl+Shift+S"))
+							SaveSceneAs();
+
+						ImGui::Separator();
+
+						if (ImGui::MenuItem("Export Binary Scene...", nullptr, false, m_SceneState == SceneState::Edit))
+							ExportBinaryScene();
+
 						ImGui::EndMenu();
 					}
 
@@ -587,6 +616,8 @@ namespace NanoCore {
 
 					if (ImGui::BeginMenu("View"))
 					{
+						for (auto& [id, panelData] : m_PanelManager->GetPanels(PanelCategory::View))
+							ImGui::MenuItem(panelData.Name, nullptr, &panelData.IsOpen);
 
 						ImGui::EndMenu();
 					}
@@ -601,6 +632,9 @@ namespace NanoCore {
 
 					if (ImGui::BeginMenu("Tools"))
 					{
+						if (ImGui::MenuItem("Build Asset Pack..."))
+							BuildAssetPack();
+
 						ImGui::EndMenu();
 					}
 
@@ -697,6 +731,28 @@ namespace NanoCore {
 			break;
 		}
 
+		// Quick save and load of the running scene
+		case Key::F5:
+		{
+			if (m_SceneState != SceneState::Edit)
+			{
+				Timer timer;
+				m_QuickSave.Capture(*m_ActiveScene);
+				NANO_ENGINE_LOG_INFO("Quick saved {} bytes in {:.2f}ms", m_QuickSave.GetData().size(), timer.ElapsedMillis());
+			}
+			break;
+		}
+		case Key::F9:
+		{
+			if (m_SceneState != SceneState::Edit && !m_QuickSave.IsEmpty())
+			{
+				Timer timer;
+				if (m_QuickSave.Restore(*m_ActiveScene))
+					NANO_ENGINE_LOG_INFO("Quick loaded in {:.2f}ms", timer.ElapsedMillis());
+			}
+			break;
+		}
+
 		// Gizmos
 		case Key::Q:
 		{
@@ -807,13 +863,15 @@ namespace NanoCore {
 		m_ActiveScene = Shared<Scene>::Create();
 		m_ActiveScene->OnViewportResize((uint32_t)m_ViewportSize.x, (uint32_t)m_ViewportSize.y);
 		m_HierarchyPanel->SetScene((m_ActiveScene));
+		m_EditorScene = m_ActiveScene;
 
 		m_EditorScenePath = std::filesystem::path();
+		m_SceneSaver->SetScene(m_EditorScene, m_EditorScenePath);
 	}
 
 	void EditorLayer::OpenScene()
 	{
-		std::string filepath = FileDialogs::OpenFile("NanoCore Scene (*.nanocore)\0*.nanocore\0");
+		std::string filepath = FileDialogs::OpenFile("NanoCore Scene (*.nanocore;*.nanoscene)\0*.nanocore;*.nanoscene\0");
 		if (!filepath.empty())
 			OpenScene(filepath);
 	}
@@ -823,14 +881,33 @@ namespace NanoCore {
 		if (m_SceneState != SceneState::Edit)
 			OnSceneStop();
 
-		if (path.extension().string() != ".nanocore")
+		std::string extension = path.extension().string();
+		if (extension != ".nanocore" && extension != ".nanoscene")
 		{
 			return;
 		}
 
 		Shared<Scene> newScene = Shared<Scene>::Create();
-		SceneSerializer serializer(newScene);
-		if (serializer.Deserialize(path.string()))
+		bool loaded = false;
+		if (extension == ".nanoscene")
+		{
+			SceneBinarySerializer serializer(newScene);
+			loaded = serializer.Deserialize(path);
+		}
+		else if (std::filesystem::path derivedPath = AssetImportPipeline::GetDerivedDataPath(path); !derivedPath.empty())
+		{
+			// The imported binary scene with the journal replayed, the YAML is only parsed when
+			// either changed
+			SceneBinarySerializer serializer(newScene);
+			loaded = serializer.Deserialize(derivedPath);
+		}
+		else
+		{
+			SceneSerializer serializer(newScene);
+			loaded = serializer.Deserialize(path.string());
+		}
+
+		if (loaded)
 		{
 			m_EditorScene = newScene;
 			m_EditorScene->OnViewportResize((uint32_t)m_ViewportSize.x, (uint32_t)m_ViewportSize.y);
@@ -838,6 +915,7 @@ namespace NanoCore {
 
 			m_ActiveScene = m_EditorScene;
 			m_EditorScenePath = path;
+			m_SceneSaver->SetScene(m_EditorScene, m_EditorScenePath);
 		}
 	}
 
@@ -859,8 +937,55 @@ namespace NanoCore {
 		}
 	}
 
+	void EditorLayer::ExportBinaryScene()
+	{
+		// Binary scenes are a load format, edits still go to the .nanocore file
+		std::string filepath = FileDialogs::SaveFile("NanoCore Binary Scene (*.nanoscene)\0*.nanoscene\0");
+		if (!filepath.empty())
+		{
+			SceneBinarySerializer serializer(m_EditorScene);
+			serializer.Serialize(filepath);
+		}
+	}
+
+	void EditorLayer::BuildAssetPack()
+	{
+		std::string filepath = FileDialogs::SaveFile("NanoCore Asset Pack (*.nanopack)\0*.nanopack\0");
+		if (filepath.empty())
+			return;
+
+		AssetPackBuilder builder;
+		builder.AddDirectory(Project::GetAssetDirectory());
+
+		Timer timer;
+		AssetPackStats stats;
+		if (builder.Build(filepath, &stats))
+		{
+			NANO_ENGINE_LOG_INFO("Packed {} files ({} compressed) into '{}', {} -> {} bytes in {:.2f}ms",
+				stats.FileCount, stats.CompressedCount, filepath, stats.Size, stats.StoredSize, timer.ElapsedMillis());
+		}
+	}
+
 	void EditorLayer::SerializeScene(Shared<Scene> scene, const std::filesystem::path& path)
 	{
+		// A scene opened from a .nanoscene is saved back in the same format
+		if (path.extension().string() == ".nanoscene")
+		{
+			SceneBinarySerializer serializer(scene);
+			serializer.Serialize(path);
+			return;
+		}
+
+		// The editor scene is saved incrementally on the save thread
+		if (scene == m_EditorScene)
+		{
+			if (m_SceneSaver->GetPath() != path)
+				m_SceneSaver->SetScene(scene, path);
+
+			m_SceneSaver->Save();
+			return;
+		}
+
 		SceneSerializer serializer(scene);
 		serializer.Serialize(path.string());
 	}
@@ -872,8 +997,10 @@ namespace NanoCore {
 
 		m_SceneState = SceneState::Play;
 
+		Timer timer;
 		m_ActiveScene = Scene::Copy(m_EditorScene);
 		m_ActiveScene->OnRuntimeStart();
+		m_EnterPlayModeTime = timer.ElapsedMillis();
 
 		m_HierarchyPanel->SetScene(m_ActiveScene);
 	}
@@ -885,8 +1012,10 @@ namespace NanoCore {
 
 		m_SceneState = SceneState::Simulate;
 
+		Timer timer;
 		m_ActiveScene = Scene::Copy(m_EditorScene);
 		m_ActiveScene->OnSimulationStart();
+		m_EnterPlayModeTime = timer.ElapsedMillis();
 
 		m_HierarchyPanel->SetScene(m_ActiveScene);
 	}
@@ -901,6 +1030,7 @@ namespace NanoCore {
 			m_ActiveScene->OnSimulationStop();
 
 		m_SceneState = SceneState::Edit;
+		m_QuickSave.Clear();
 
 		m_ActiveScene = m_EditorScene;
 
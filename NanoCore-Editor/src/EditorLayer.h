@@ -6,8 +6,11 @@
 #include "components/SysStatusPanel.h"
 #include "components/ViewportPanel.h"
 #include "components/GlobalSettingPanel.h"
+#include "components/ScriptProfilerPanel.h"
 
 #include "modules/entity/EditorCamera.h"
+#include "modules/entity/SceneSaver.h"
+#include "modules/entity/SceneSnapshot.h"
 
 #include "components/PanelManager.h"
 
@@ -43,6 +46,8 @@ namespace NanoCore {
 
 		void SaveScene();
 		void SaveSceneAs();
+		void ExportBinaryScene();
+		void BuildAssetPack();
 
 		void SerializeScene(Shared<Scene> scene, const std::filesystem::path& path);
 
@@ -81,6 +86,8 @@ namespace NanoCore {
 		Shared<Scene> m_ActiveScene;
 		Shared<Scene> m_EditorScene;
 		std::filesystem::path m_EditorScenePath;
+		// Saves and autosaves the editor scene in the background
+		Unique<SceneSaver> m_SceneSaver;
 		Entity m_SquareEntity;
 		Entity m_CameraEntity;
 		Entity m_SecondCamera;
@@ -114,6 +121,11 @@ namespace NanoCore {
 			Edit = 0, Play = 1, Simulate = 2
 		};
 		SceneState m_SceneState = SceneState::Edit;
+		// F5/F9 quick save of the running scene, dropped when it stops
+		SceneSnapshot m_QuickSave;
+
+		// Time spent copying the editor scene and starting the runtime, in milliseconds
+		float m_EnterPlayModeTime = 0.0f;
 
 		// Panels
 		Shared<HierarchyPanel> m_HierarchyPanel;
@@ -2,12 +2,15 @@
 
 #include "HierarchyPanel.h"
 #include "modules/entity/Components.h"
+#include "modules/entity/ComponentReflection.h"
+#include "modules/entity/AssetManager.h"
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cctype>
 #include <cstring>
 
 /* The Microsoft C++ compiler is non-compliant with the C++ standard and needs
@@ -111,8 +114,11 @@ namespace NanoCore {
 		}
 	}
 
-	static void DrawVec3Control(const std::string& label, glm::vec3& values, float resetValue = 0.0f, float columnWidth = 100.0f)
+	// True when the values were edited
+	static bool DrawVec3Control(const std::string& label, glm::vec3& values, float resetValue = 0.0f, float columnWidth = 100.0f)
 	{
+		bool changed = false;
+
 		ImGuiIO& io = ImGui::GetIO();
 		auto boldFont = io.Fonts->Fonts[0];
 
@@ -134,12 +140,15 @@ namespace NanoCore {
 		ImGui::PushStyleColor(ImGuiCol_ButtonActive, ImVec4{ 0.8f, 0.1f, 0.15f, 1.0f });
 		ImGui::PushFont(boldFont);
 		if (ImGui::Button("X", buttonSize))
+		{
 			values.x = resetValue;
+			changed = true;
+		}
 		ImGui::PopFont();
 		ImGui::PopStyleColor(3);
 
 		ImGui::SameLine();
-		ImGui::DragFloat("##X", &values.x, 0.1f, 0.0f, 0.0f, "%.2f");
+		changed |= ImGui::DragFloat("##X", &values.x, 0.1f, 0.0f, 0.0f, "%.2f");
 		ImGui::PopItemWidth();
 		ImGui::SameLine();
 
@@ -148,12 +157,15 @@ namespace NanoCore {
 		ImGui::PushStyleColor(ImGuiCol_ButtonActive, ImVec4{ 0.2f, 0.7f, 0.2f, 1.0f });
 		ImGui::PushFont(boldFont);
 		if (ImGui::Button("Y", buttonSize))
+		{
 			values.y = resetValue;
+			changed = true;
+		}
 		ImGui::PopFont();
 		ImGui::PopStyleColor(3);
 
 		ImGui::SameLine();
-		ImGui::DragFloat("##Y", &values.y, 0.1f, 0.0f, 0.0f, "%.2f");
+		changed |= ImGui::DragFloat("##Y", &values.y, 0.1f, 0.0f, 0.0f, "%.2f");
 		ImGui::PopItemWidth();
 		ImGui::SameLine();
 
@@ -162,12 +174,15 @@ namespace NanoCore {
 		ImGui::PushStyleColor(ImGuiCol_ButtonActive, ImVec4{ 0.1f, 0.25f, 0.8f, 1.0f });
 		ImGui::PushFont(boldFont);
 		if (ImGui::Button("Z", buttonSize))
+		{
 			values.z = resetValue;
+			changed = true;
+		}
 		ImGui::PopFont();
 		ImGui::PopStyleColor(3);
 
 		ImGui::SameLine();
-		ImGui::DragFloat("##Z", &values.z, 0.1f, 0.0f, 0.0f, "%.2f");
+		changed |= ImGui::DragFloat("##Z", &values.z, 0.1f, 0.0f, 0.0f, "%.2f");
 		ImGui::PopItemWidth();
 
 		ImGui::PopStyleVar();
@@ -175,8 +190,10 @@ namespace NanoCore {
 		ImGui::Columns(1);
 
 		ImGui::PopID();
+		return changed;
 	}
 
+	// uiFunction draws the widgets of the component and returns whether any of them edited it
 	template<typename T, typename UIFunction>
 	static void DrawComponent(const std::string& name, Entity entity, UIFunction uiFunction)
 	{
@@ -209,7 +226,10 @@ namespace NanoCore {
 
 			if (open)
 			{
-				uiFunction(component);
+				// Widgets edit the component in place, edits are patched so the saver and physics see them
+				if (uiFunction(component))
+					entity.PatchComponent<T>();
+
 				ImGui::TreePop();
 			}
 
@@ -218,6 +238,94 @@ namespace NanoCore {
 		}
 	}
 
+	// "RestitutionThreshold" -> "Restitution Threshold"
+	static std::string GetFieldLabel(std::string_view name)
+	{
+		std::string label;
+		for (size_t i = 0; i < name.size(); i++)
+		{
+			if (i > 0 && std::isupper((unsigned char)name[i]) && std::islower((unsigned char)name[i - 1]))
+				label += ' ';
+			label += name[i];
+		}
+		return label;
+	}
+
+	template<typename Field, typename Component>
+	static bool DrawReflectedField(const Field& field, Component& component)
+	{
+		using T = typename Field::ValueType;
+		std::string label = GetFieldLabel(field.Name);
+
+		T value = field.Get(component);
+		bool changed = false;
+
+		if constexpr (std::is_enum_v<T>)
+		{
+			const auto& names = EnumReflection<T>::Names;
+			std::string current(EnumToString(value));
+			if (ImGui::BeginCombo(label.c_str(), current.c_str()))
+			{
+				for (size_t i = 0; i < names.size(); i++)
+				{
+					bool isSelected = (size_t)value == i;
+					if (ImGui::Selectable(std::string(names[i]).c_str(), isSelected))
+					{
+						value = (T)i;
+						changed = true;
+					}
+
+					if (isSelected)
+						ImGui::SetItemDefaultFocus();
+				}
+
+				ImGui::EndCombo();
+			}
+		}
+		else if constexpr (std::is_same_v<T, bool>)
+			changed = ImGui::Checkbox(label.c_str(), &value);
+		else if constexpr (std::is_same_v<T, float>)
+			changed = ImGui::DragFloat(label.c_str(), &value, field.Speed, field.Min, field.Max);
+		else if constexpr (std::is_same_v<T, glm::vec2>)
+			changed = ImGui::DragFloat2(label.c_str(), glm::value_ptr(value), field.Speed, field.Min, field.Max);
+		else if constexpr (std::is_same_v<T, glm::vec3>)
+			changed = ImGui::DragFloat3(label.c_str(), glm::value_ptr(value), field.Speed, field.Min, field.Max);
+		else if constexpr (std::is_same_v<T, glm::vec4>)
+			changed = ImGui::ColorEdit4(label.c_str(), glm::value_ptr(value));
+		else if constexpr (std::is_same_v<T, std::string>)
+		{
+			char buffer[256];
+			memset(buffer, 0, sizeof(buffer));
+			std::strncpy(buffer, value.c_str(), sizeof(buffer) - 1);
+			if (ImGui::InputText(label.c_str(), buffer, sizeof(buffer)))
+			{
+				value = buffer;
+				changed = true;
+			}
+		}
+		else if constexpr (std::is_same_v<T, UUID>)
+			ImGui::Text("%s: %llu", label.c_str(), (unsigned long long)(uint64_t)value);
+
+		if (changed)
+			field.Set(component, value);
+		return changed;
+	}
+
+	// Default inspector for components without a hand-written one
+	template<typename Component>
+	static bool DrawReflectedFields(Component& component)
+	{
+		bool changed = false;
+		ForEachField<Component>([&](const auto& field) { changed |= DrawReflectedField(field, component); });
+		return changed;
+	}
+
+	template<typename T>
+	static void DrawReflectedComponent(Entity entity)
+	{
+		DrawComponent<T>(std::string(ComponentReflection<T>::DisplayName), entity, [](auto& component) { return DrawReflectedFields(component); });
+	}
+
 	void HierarchyPanel::DrawComponents(Entity entity)
 	{
 		if (entity.HasComponent<TagComponent>())
@@ -230,6 +338,7 @@ namespace NanoCore {
 			if (ImGui::InputText("##Tag", buffer, sizeof(buffer)))
 			{
 				tag = std::string(buffer);
+				entity.PatchComponent<TagComponent>();
 			}
 		}
 
@@ -241,13 +350,14 @@ namespace NanoCore {
 
 		if (ImGui::BeginPopup("AddComponent"))
 		{
-			DisplayAddComponentEntry<CameraComponent>("Camera");
+			DisplayAddComponentEntry<CameraComponent>();
 			DisplayAddComponentEntry<ScriptComponent>("Script");
-			DisplayAddComponentEntry<SpriteRendererComponent>("Sprite Renderer");
-			DisplayAddComponentEntry<CircleRendererComponent>("Circle Renderer");
-			DisplayAddComponentEntry<Rigidbody2DComponent>("Rigidbody 2D");
-			DisplayAddComponentEntry<BoxCollider2DComponent>("Box Collider 2D");
-			DisplayAddComponentEntry<CircleCollider2DComponent>("Circle Collider 2D");
+			DisplayAddComponentEntry<SpriteRendererComponent>();
+			DisplayAddComponentEntry<CircleRendererComponent>();
+			DisplayAddComponentEntry<TextComponent>();
+			DisplayAddComponentEntry<Rigidbody2DComponent>();
+			DisplayAddComponentEntry<BoxCollider2DComponent>();
+			DisplayAddComponentEntry<CircleCollider2DComponent>();
 
 			ImGui::EndPopup();
 		}
@@ -256,11 +366,15 @@ namespace NanoCore {
 
 		DrawComponent<TransformComponent>("Transform", entity, [](auto& component)
 			{
-				DrawVec3Control("Translation", component.Translation);
+				bool changed = DrawVec3Control("Translation", component.Translation);
 				glm::vec3 rotation = glm::degrees(component.Rotation);
-				DrawVec3Control("Rotation", rotation);
-				component.Rotation = glm::radians(rotation);
-				DrawVec3Control("Scale", component.Scale, 1.0f);
+				if (DrawVec3Control("Rotation", rotation))
+				{
+					component.Rotation = glm::radians(rotation);
+					changed = true;
+				}
+				changed |= DrawVec3Control("Scale", component.Scale, 1.0f);
+				return changed;
 			});
 
 		DrawComponent<ScriptComponent>("Script", entity, [entity, scene = m_Context](auto& component) mutable
@@ -273,8 +387,13 @@ namespace NanoCore {
 				if (!scriptClassExists)
 					ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.2f, 0.3f, 1.0f));
 
+				// Field values live in the script field storage, only the class is part of the component
+				bool changed = false;
 				if (ImGui::InputText("Class", buffer, sizeof(buffer)))
+				{
 					component.ClassName = buffer;
+					changed = true;
+				}
 
 				// Fields
 				bool sceneRunning = scene->IsRunning();
@@ -284,14 +403,14 @@ namespace NanoCore {
 					if (scriptInstance)
 					{
 						const auto& fields = scriptInstance->GetScriptClass()->GetFields();
-						for (const auto& [name, field] : fields)
+						for (const ScriptField& field : fields)
 						{
 							if (field.Type == ScriptFieldType::Float)
 							{
-								float data = scriptInstance->GetFieldValue<float>(name);
-								if (ImGui::DragFloat(name.c_str(), &data))
+								float data = scriptInstance->GetFieldValue<float>(field.Name);
+								if (ImGui::DragFloat(field.Name.c_str(), &data))
 								{
-									scriptInstance->SetFieldValue(name, data);
+									scriptInstance->SetFieldValue(field.Name, data);
 								}
 							}
 						}
@@ -304,35 +423,15 @@ namespace NanoCore {
 						Shared<ScriptClass> entityClass = ScriptEngine::GetEntityClass(component.ClassName);
 						const auto& fields = entityClass->GetFields();
 
-						auto& entityFields = ScriptEngine::GetScriptFieldMap(entity);
-						for (const auto& [name, field] : fields)
+						auto& entityFields = ScriptEngine::GetScriptFieldStorage(entity, entityClass);
+						for (const ScriptField& field : fields)
 						{
-							// Field has been set in editor
-							if (entityFields.find(name) != entityFields.end())
-							{
-								ScriptFieldInstance& scriptField = entityFields.at(name);
-
-								// Display control to set it maybe
-								if (field.Type == ScriptFieldType::Float)
-								{
-									float data = scriptField.GetValue<float>();
-									if (ImGui::DragFloat(name.c_str(), &data))
-										scriptField.SetValue(data);
-								}
-							}
-							else
+							// Fields not set in editor read as zero until they are
+							if (field.Type == ScriptFieldType::Float)
 							{
-								// Display control to set it maybe
-								if (field.Type == ScriptFieldType::Float)
-								{
-									float data = 0.0f;
-									if (ImGui::DragFloat(name.c_str(), &data))
-									{
-										ScriptFieldInstance& fieldInstance = entityFields[name];
-										fieldInstance.Field = field;
-										fieldInstance.SetValue(data);
-									}
-								}
+								float data = entityFields.GetValue<float>(field);
+								if (ImGui::DragFloat(field.Name.c_str(), &data))
+									entityFields.SetValue(field, data);
 							}
 						}
 					}
@@ -340,6 +439,8 @@ namespace NanoCore {
 
 				if (!scriptClassExists)
 					ImGui::PopStyleColor();
+
+				return changed;
 			});
 
 
@@ -347,7 +448,7 @@ namespace NanoCore {
 			{
 				auto& camera = component.Camera;
 
-				ImGui::Checkbox("Primary", &component.Primary);
+				bool changed = ImGui::Checkbox("Primary", &component.Primary);
 
 				const char* projectionTypeStrings[] = { "Perspective", "Orthographic" };
 				const char* currentProjectionTypeString = projectionTypeStrings[(int)camera.GetProjectionType()];
@@ -360,6 +461,7 @@ namespace NanoCore {
 						{
 							currentProjectionTypeString = projectionTypeStrings[i];
 							camera.SetProjectionType((SceneCamera::ProjectionType)i);
+							changed = true;
 						}
 
 						if (isSelected)
@@ -373,38 +475,58 @@ namespace NanoCore {
 				{
 					float perspectiveVerticalFov = glm::degrees(camera.GetPerspectiveVerticalFOV());
 					if (ImGui::DragFloat("Vertical FOV", &perspectiveVerticalFov))
+					{
 						camera.SetPerspectiveVerticalFOV(glm::radians(perspectiveVerticalFov));
+						changed = true;
+					}
 
 					float perspectiveNear = camera.GetPerspectiveNearClip();
 					if (ImGui::DragFloat("Near", &perspectiveNear))
+					{
 						camera.SetPerspectiveNearClip(perspectiveNear);
+						changed = true;
+					}
 
 					float perspectiveFar = camera.GetPerspectiveFarClip();
 					if (ImGui::DragFloat("Far", &perspectiveFar))
+					{
 						camera.SetPerspectiveFarClip(perspectiveFar);
+						changed = true;
+					}
 				}
 
 				if (camera.GetProjectionType() == SceneCamera::ProjectionType::Orthographic)
 				{
 					float orthoSize = camera.GetOrthographicSize();
 					if (ImGui::DragFloat("Size", &orthoSize))
+					{
 						camera.SetOrthographicSize(orthoSize);
+						changed = true;
+					}
 
 					float orthoNear = camera.GetOrthographicNearClip();
 					if (ImGui::DragFloat("Near", &orthoNear))
+					{
 						camera.SetOrthographicNearClip(orthoNear);
+						changed = true;
+					}
 
 					float orthoFar = camera.GetOrthographicFarClip();
 					if (ImGui::DragFloat("Far", &orthoFar))
+					{
 						camera.SetOrthographicFarClip(orthoFar);
+						changed = true;
+					}
 
-					ImGui::Checkbox("Fixed Aspect Ratio", &component.FixedAspectRatio);
+					changed |= ImGui::Checkbox("Fixed Aspect Ratio", &component.FixedAspectRatio);
 				}
+
+				return changed;
 			});
 
 		DrawComponent<SpriteRendererComponent>("Sprite Renderer", entity, [](auto& component)
 			{
-				ImGui::ColorEdit4("Color", glm::value_ptr(component.Color));
+				bool changed = ImGui::ColorEdit4("Color", glm::value_ptr(component.Color));
 
 				ImGui::Button("Texture", ImVec2(100.0f, 0.0f));
 				if (ImGui::BeginDragDropTarget())
@@ -413,69 +535,32 @@ namespace NanoCore {
 					{
 						const wchar_t* path = (const wchar_t*)payload->Data;
 						std::filesystem::path texturePath = std::filesystem::path(g_AssetPath) / path;
-						Shared<Texture2D> texture = Texture2D::Create(texturePath.string());
-						if (texture->IsLoaded())
+						Shared<Texture2D> texture = AssetManager::GetTexture(texturePath);
+						if (texture && texture->IsLoaded())
+						{
 							component.Texture = texture;
+							changed = true;
+						}
 						else{}
 					}
 					ImGui::EndDragDropTarget();
 				}
 
-				ImGui::DragFloat("Tiling Factor", &component.TilingFactor, 0.1f, 0.0f, 100.0f);
+				changed |= ImGui::DragFloat("Tiling Factor", &component.TilingFactor, 0.1f, 0.0f, 100.0f);
+				return changed;
 			});
 
-		DrawComponent<CircleRendererComponent>("Circle Renderer", entity, [](auto& component)
-			{
-				ImGui::ColorEdit4("Color", glm::value_ptr(component.Color));
-				ImGui::DragFloat("Thickness", &component.Thickness, 0.025f, 0.0f, 1.0f);
-				ImGui::DragFloat("Fade", &component.Fade, 0.00025f, 0.0f, 1.0f);
-			});
+		DrawReflectedComponent<CircleRendererComponent>(entity);
+		DrawReflectedComponent<TextComponent>(entity);
+		DrawReflectedComponent<Rigidbody2DComponent>(entity);
+		DrawReflectedComponent<BoxCollider2DComponent>(entity);
+		DrawReflectedComponent<CircleCollider2DComponent>(entity);
 
-		DrawComponent<Rigidbody2DComponent>("Rigidbody 2D", entity, [](auto& component)
-			{
-				const char* bodyTypeStrings[] = { "Static", "Dynamic", "Kinematic" };
-				const char* currentBodyTypeString = bodyTypeStrings[(int)component.Type];
-				if (ImGui::BeginCombo("Body Type", currentBodyTypeString))
-				{
-					for (int i = 0; i < 2; i++)
-					{
-						bool isSelected = currentBodyTypeString == bodyTypeStrings[i];
-						if (ImGui::Selectable(bodyTypeStrings[i], isSelected))
-						{
-							currentBodyTypeString = bodyTypeStrings[i];
-							component.Type = (Rigidbody2DComponent::BodyType)i;
-						}
-
-						if (isSelected)
-							ImGui::SetItemDefaultFocus();
-					}
-
-					ImGui::EndCombo();
-				}
-
-				ImGui::Checkbox("Fixed Rotation", &component.FixedRotation);
-			});
-
-		DrawComponent<BoxCollider2DComponent>("Box Collider 2D", entity, [](auto& component)
-			{
-				ImGui::DragFloat2("Offset", glm::value_ptr(component.Offset));
-				ImGui::DragFloat2("Size", glm::value_ptr(component.Size));
-				ImGui::DragFloat("Density", &component.Density, 0.01f, 0.0f, 1.0f);
-				ImGui::DragFloat("Friction", &component.Friction, 0.01f, 0.0f, 1.0f);
-				ImGui::DragFloat("Restitution", &component.Restitution, 0.01f, 0.0f, 1.0f);
-				ImGui::DragFloat("Restitution Threshold", &component.RestitutionThreshold, 0.01f, 0.0f);
-			});
-
-		DrawComponent<CircleCollider2DComponent>("Circle Collider 2D", entity, [](auto& component)
-			{
-				ImGui::DragFloat2("Offset", glm::value_ptr(component.Offset));
-				ImGui::DragFloat("Radius", &component.Radius);
-				ImGui::DragFloat("Density", &component.Density, 0.01f, 0.0f, 1.0f);
-				ImGui::DragFloat("Friction", &component.Friction, 0.01f, 0.0f, 1.0f);
-				ImGui::DragFloat("Restitution", &component.Restitution, 0.01f, 0.0f, 1.0f);
-				ImGui::DragFloat("Restitution Threshold", &component.RestitutionThreshold, 0.01f, 0.0f);
-			});
+	}
 
+	template<typename T>
+	void HierarchyPanel::DisplayAddComponentEntry() {
+		DisplayAddComponentEntry<T>(std::string(ComponentReflection<T>::DisplayName));
 	}
 
 	template<typename T>
@@ -18,6 +18,9 @@ namespace NanoCore {
 		Entity GetSelectedEntity() const { return m_SelectionContext; }
 		void SetSelectedEntity(Entity entity);
 	private:
+		// Uses the reflected display name
+		template<typename T>
+		void DisplayAddComponentEntry();
 		template<typename T>
 		void DisplayAddComponentEntry(const std::string& entryName);
 
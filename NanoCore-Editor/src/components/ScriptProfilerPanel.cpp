@@ -0,0 +1,161 @@
+#include "ScriptProfilerPanel.h"
+#include <imgui/imgui.h>
+
+#include <numeric>
+
+namespace NanoCore {
+
+	static float GetClassFrameMs(const ScriptClassProfile& classProfile)
+	{
+		float frameMs = 0.0f;
+		for (const auto& method : classProfile.Methods)
+			frameMs += method.FrameMs;
+		return frameMs;
+	}
+
+	ScriptProfilerPanel::ScriptProfilerPanel()
+	{
+	}
+
+	void ScriptProfilerPanel::OnUIRender(bool& isOpen)
+	{
+		if (ImGui::Begin("Script Profiler", &isOpen))
+		{
+			bool enabled = ScriptProfiler::IsEnabled();
+			if (ImGui::Checkbox("Enabled", &enabled))
+				ScriptProfiler::SetEnabled(enabled);
+
+			ImGui::SameLine();
+			if (ImGui::Button("Reset"))
+				ScriptProfiler::Reset();
+
+			if (ImGui::CollapsingHeader("Classes", ImGuiTreeNodeFlags_DefaultOpen))
+				DrawClassTable();
+
+			if (ImGui::CollapsingHeader("Internal Calls", ImGuiTreeNodeFlags_DefaultOpen))
+				DrawInternalCallTable();
+
+			if (ImGui::CollapsingHeader("Managed Heap", ImGuiTreeNodeFlags_DefaultOpen))
+				DrawGCStats();
+		}
+		ImGui::End();
+	}
+
+	void ScriptProfilerPanel::DrawClassTable()
+	{
+		const auto& classes = ScriptProfiler::GetClassProfiles();
+
+		m_SortedClasses.resize(classes.size());
+		std::iota(m_SortedClasses.begin(), m_SortedClasses.end(), 0);
+		std::sort(m_SortedClasses.begin(), m_SortedClasses.end(), [&classes](uint32_t a, uint32_t b)
+		{
+			return GetClassFrameMs(classes[a]) > GetClassFrameMs(classes[b]);
+		});
+
+		const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable;
+		if (!ImGui::BeginTable("ScriptClasses", 6, flags))
+			return;
+
+		ImGui::TableSetupColumn("Class / Method");
+		ImGui::TableSetupColumn("Calls");
+		ImGui::TableSetupColumn("Frame (ms)");
+		ImGui::TableSetupColumn("Average (ms)");
+		ImGui::TableSetupColumn("Peak (ms)");
+		ImGui::TableSetupColumn("Total Calls");
+		ImGui::TableHeadersRow();
+
+		for (uint32_t classIndex : m_SortedClasses)
+		{
+			const ScriptClassProfile& classProfile = classes[classIndex];
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			bool open = ImGui::TreeNodeEx(classProfile.ClassName.c_str(), ImGuiTreeNodeFlags_SpanFullWidth);
+			ImGui::TableNextColumn();
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", GetClassFrameMs(classProfile));
+
+			if (!open)
+				continue;
+
+			for (size_t i = 0; i < classProfile.Methods.size(); i++)
+			{
+				const ScriptMethodProfile& method = classProfile.Methods[i];
+				if (method.TotalCalls == 0 && method.PendingCalls == 0)
+					continue;
+
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Indent();
+				ImGui::TextUnformatted(Utils::ScriptProfileMethodToString((ScriptProfileMethod)i));
+				ImGui::Unindent();
+				ImGui::TableNextColumn();
+				ImGui::Text("%u", method.FrameCalls);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", method.FrameMs);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", method.AverageMs);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", method.PeakMs);
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", (unsigned long long)method.TotalCalls);
+			}
+
+			ImGui::TreePop();
+		}
+
+		ImGui::EndTable();
+	}
+
+	void ScriptProfilerPanel::DrawInternalCallTable()
+	{
+		const auto& calls = ScriptProfiler::GetInternalCallProfiles();
+
+		m_SortedInternalCalls.resize(calls.size());
+		std::iota(m_SortedInternalCalls.begin(), m_SortedInternalCalls.end(), 0);
+		std::sort(m_SortedInternalCalls.begin(), m_SortedInternalCalls.end(), [&calls](uint32_t a, uint32_t b)
+		{
+			return calls[a].FrameCalls > calls[b].FrameCalls;
+		});
+
+		const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable;
+		if (!ImGui::BeginTable("ScriptInternalCalls", 3, flags))
+			return;
+
+		ImGui::TableSetupColumn("Function");
+		ImGui::TableSetupColumn("Calls / Frame");
+		ImGui::TableSetupColumn("Total Calls");
+		ImGui::TableHeadersRow();
+
+		for (uint32_t callIndex : m_SortedInternalCalls)
+		{
+			const ScriptInternalCallProfile& call = calls[callIndex];
+			if (call.TotalCalls == 0 && call.PendingCalls == 0)
+				continue;
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(call.Name);
+			ImGui::TableNextColumn();
+			ImGui::Text("%u", call.FrameCalls);
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", (unsigned long long)call.TotalCalls);
+		}
+
+		ImGui::EndTable();
+	}
+
+	void ScriptProfilerPanel::DrawGCStats()
+	{
+		const ScriptGCProfile& gc = ScriptProfiler::GetGCProfile();
+
+		ImGui::Text("Heap: %.2f MB (%.2f MB used)", (float)gc.HeapSize / (1024.0f * 1024.0f), (float)gc.UsedSize / (1024.0f * 1024.0f));
+		for (size_t generation = 0; generation < gc.Collections.size(); generation++)
+			ImGui::Text("Gen %zu collections: %d", generation, gc.Collections[generation]);
+
+		ImGui::Text("Pauses this frame: %u (%.3f ms)", gc.FramePauses, gc.FramePauseMs);
+		ImGui::Text("Peak pause: %.3f ms", gc.PeakPauseMs);
+		ImGui::Text("Total paused: %.3f ms", gc.TotalPauseMs);
+	}
+
+}
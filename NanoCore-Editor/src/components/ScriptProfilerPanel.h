@@ -0,0 +1,25 @@
+#pragma once
+#include "NanoCore.h"
+#include "NanoPanel.h"
+
+namespace NanoCore {
+
+	class ScriptProfilerPanel : public NanoPanel
+	{
+	public:
+		ScriptProfilerPanel();
+
+		virtual void OnUIRender(bool& isOpen) override;
+
+	private:
+		void DrawClassTable();
+		void DrawInternalCallTable();
+		void DrawGCStats();
+
+	private:
+		// Rebuilt every frame, sorted by frame cost
+		std::vector<uint32_t> m_SortedClasses;
+		std::vector<uint32_t> m_SortedInternalCalls;
+	};
+
+}
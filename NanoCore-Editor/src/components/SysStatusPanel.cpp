@@ -1,10 +1,6 @@
 #include "SysStatusPanel.h"
 #include "Imgui/imgui.h"
 
-#include "spdlog/fmt/bundled/core.h"
-#include "spdlog/fmt/bundled/format.h"
-#include "spdlog/fmt/bundled/format-inl.h"
-
 NanoCore::SysStatusPanel::SysStatusPanel()
 {
 }
@@ -12,10 +8,10 @@ NanoCore::SysStatusPanel::SysStatusPanel()
 void NanoCore::SysStatusPanel::OnUIRender(bool& isOpen)
 {
 	if (ImGui::Begin("Stats")) {
-		std::string name = "None";
+		const char* name = "None";
 		if (EditorLayer::GetEditorContext()->m_HoveredEntity)
-			name = EditorLayer::GetEditorContext()->m_HoveredEntity.GetComponent<TagComponent>().Tag;
-		ImGui::Text("Hovered Entity: %s", name.c_str());
+			name = EditorLayer::GetEditorContext()->m_HoveredEntity.GetComponent<TagComponent>().Tag.c_str();
+		ImGui::Text("Hovered Entity: %s", name);
 
 		auto stats = RenderUtils::GetStats();
 		ImGui::Text("RenderUtils Stats:");
@@ -24,21 +20,30 @@ void NanoCore::SysStatusPanel::OnUIRender(bool& isOpen)
 		ImGui::Text("Vertices: %d", stats.GetTotalVertexCount());
 		ImGui::Text("Indices: %d", stats.GetTotalIndexCount());
 
-		ImGui::Text(fmt::format("Distance: {}", EditorLayer::GetEditorContext()->m_EditorCamera.m_Distance).c_str());
-		ImGui::Text(fmt::format("Focal Point: {}, {}, {}", EditorLayer::GetEditorContext()->m_EditorCamera.m_FocalPoint.x, EditorLayer::GetEditorContext()->m_EditorCamera.m_FocalPoint.y, EditorLayer::GetEditorContext()->m_EditorCamera.m_FocalPoint.z).c_str());
-		//ImGui::Text(fmt::format("Rotation: {}, {}, {}", EditorLayer::GetEditorContext()->m_EditorCamera.m_WorldRotation.x, EditorLayer::GetEditorContext()->m_EditorCamera.m_WorldRotation.y, EditorLayer::GetEditorContext()->m_EditorCamera.m_WorldRotation.z).c_str());
-		ImGui::Text(fmt::format("Up Dir: {}, {}, {}", EditorLayer::GetEditorContext()->m_EditorCamera.GetUpDirection().x, EditorLayer::GetEditorContext()->m_EditorCamera.GetUpDirection().y, EditorLayer::GetEditorContext()->m_EditorCamera.GetUpDirection().z).c_str());
-		ImGui::Text(fmt::format("Strafe Dir: {}, {}, {}", EditorLayer::GetEditorContext()->m_EditorCamera.GetRightDirection().x, EditorLayer::GetEditorContext()->m_EditorCamera.GetRightDirection().y, EditorLayer::GetEditorContext()->m_EditorCamera.GetRightDirection().z).c_str());
-		ImGui::Text(fmt::format("Yaw: {}", EditorLayer::GetEditorContext()->m_EditorCamera.m_Yaw).c_str());
-		//ImGui::Text(fmt::format("Yaw Delta: {}", EditorLayer::GetEditorContext()->m_EditorCamera.m_YawDelta).c_str());
-		ImGui::Text(fmt::format("Pitch: {}", EditorLayer::GetEditorContext()->m_EditorCamera.m_Pitch).c_str());
-		//ImGui::Text(fmt::format("Pitch Delta: {}", EditorLayer::GetEditorContext()->m_EditorCamera.m_PitchDelta).c_str());
-		ImGui::Text(fmt::format("Position: ({}, {}, {})", EditorLayer::GetEditorContext()->m_EditorCamera.m_Position.x, EditorLayer::GetEditorContext()->m_EditorCamera.m_Position.y, EditorLayer::GetEditorContext()->m_EditorCamera.m_Position.z).c_str());
-		//ImGui::Text(fmt::format("Position Delta: ({}, {}, {})", EditorLayer::GetEditorContext()->m_EditorCamera.m_PositionDelta.x, EditorLayer::GetEditorContext()->m_EditorCamera.m_PositionDelta.y, EditorLayer::GetEditorContext()->m_EditorCamera.m_PositionDelta.z).c_str());
-		ImGui::Text(fmt::format("View matrix: [{}, {}, {}, {}]", EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[0].x, EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[0].y, EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[0].z, EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[0].w).c_str());
-		ImGui::Text(fmt::format("		      [{}, {}, {}, {}]", EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[1].x, EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[1].y, EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[1].z, EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[1].w).c_str());
-		ImGui::Text(fmt::format("		      [{}, {}, {}, {}]", EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[2].x, EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[2].y, EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[2].z, EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[2].w).c_str());
-		ImGui::Text(fmt::format("		      [{}, {}, {}, {}]", EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[3].x, EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[3].y, EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[3].z, EditorLayer::GetEditorContext()->m_EditorCamera.m_ViewMatrix[3].w).c_str());
+		ImGui::Text("Enter Play Mode: %.3f ms", EditorLayer::GetEditorContext()->m_EnterPlayModeTime);
+
+		// Formatted by ImGui into its own buffer, no temporary strings every frame
+		const EditorCamera& camera = EditorLayer::GetEditorContext()->m_EditorCamera;
+		ImGui::Text("Distance: %f", camera.m_Distance);
+		ImGui::Text("Focal Point: %f, %f, %f", camera.m_FocalPoint.x, camera.m_FocalPoint.y, camera.m_FocalPoint.z);
+		ImGui::Text("Up Dir: %f, %f, %f", camera.GetUpDirection().x, camera.GetUpDirection().y, camera.GetUpDirection().z);
+		ImGui::Text("Strafe Dir: %f, %f, %f", camera.GetRightDirection().x, camera.GetRightDirection().y, camera.GetRightDirection().z);
+		ImGui::Text("Yaw: %f", camera.m_Yaw);
+		ImGui::Text("Pitch: %f", camera.m_Pitch);
+		ImGui::Text("Position: (%f, %f, %f)", camera.m_Position.x, camera.m_Position.y, camera.m_Position.z);
+		for (int row = 0; row < 4; row++)
+		{
+			const glm::vec4& column = camera.m_ViewMatrix[row];
+			ImGui::Text(row == 0 ? "View matrix: [%f, %f, %f, %f]" : "             [%f, %f, %f, %f]", column.x, column.y, column.z, column.w);
+		}
+
+		const FrameAllocatorStats& frameStats = FrameAllocator::GetStats();
+		ImGui::Text("Frame Allocator:");
+		ImGui::Text("Capacity: %.1f KB", (float)frameStats.Capacity / 1024.0f);
+		ImGui::Text("Last Frame Peak: %.1f KB", (float)frameStats.LastFramePeak / 1024.0f);
+		ImGui::Text("High-Water Mark: %.1f KB", (float)frameStats.HighWaterMark / 1024.0f);
+		if (frameStats.LastFrameOverflow > 0)
+			ImGui::Text("Last Frame Overflow: %.1f KB", (float)frameStats.LastFrameOverflow / 1024.0f);
 
 		ImGui::End();
 	}
@@ -98,6 +98,7 @@ void NanoCore::ViewportPanel::OnUIRender(bool& isOpen)
 				tc.Translation = translation;
 				tc.Rotation += deltaRotation;
 				tc.Scale = scale;
+				selectedEntity.PatchComponent<TransformComponent>();
 			}
 		}
 
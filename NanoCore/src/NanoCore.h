@@ -58,8 +58,11 @@
 
 #include "modules/entity/Entity.h"
 #include "modules/entity/Components.h"
+#include "modules/entity/AssetManager.h"
+#include "modules/entity/AssetImportPipeline.h"
 #include "modules/entity/Asset.h"
 #include "modules/entity/SceneSerializer.h"
+#include "modules/entity/SceneBinarySerializer.h"
 
 #include "core/math/NanoMath.h"
 #include "modules/entity/EditorCamera.h"
@@ -7,6 +7,11 @@
 
 #include "modules/events/Input.h"
 #include "modules/utils/PlatformUtils.h"
+#include "modules/utils/FrameAllocator.h"
+#include "modules/utils/ThreadPool.h"
+#include "modules/utils/FileManager.h"
+#include "modules/entity/AssetManager.h"
+#include "modules/entity/AssetImportPipeline.h"
 
 #include "modules/info/Project.h"
 #include "modules/script/ScriptEngine.h"
@@ -28,10 +33,18 @@ namespace NanoCore{
 		if (!m_Specification.WorkingDirectory.empty())
 			std::filesystem::current_path(m_Specification.WorkingDirectory);
 
+		FrameAllocator::Init();
+		ThreadPool::Init();
+
+		for (const std::string& pack : m_Specification.AssetPacks)
+			FileSystem::MountAssetPack(pack);
+
 		m_Window = Window::Create(WindowProps(m_Specification.Name));
 		m_Window->SetEventCallback(NANO_EVENT_BIND(Application::OnEvent));
 
 		Renderer::Init();
+		AssetManager::Init();
+		AssetImportPipeline::Init();
 		//ScriptEngine::Init();
 
 
@@ -48,8 +61,16 @@ namespace NanoCore{
 	{
 		RA_PROFILE_FUNCTION();
 
+		// Loads still running on the workers import through the pipeline
+		AssetManager::Shutdown();
+		AssetImportPipeline::Shutdown();
 		Renderer::Shutdown();
 		//ScriptEngine::Shutdown();
+
+		FileSystem::StopWatching();
+		FileSystem::UnmountAssetPacks();
+		ThreadPool::Shutdown();
+		FrameAllocator::Shutdown();
 	}
 
 	void Application::PushLayer(Layer* layer)
@@ -104,13 +125,16 @@ namespace NanoCore{
 		{
 			RA_PROFILE_SCOPE("RunLoop");
 
-			float time = Time::GetTime();
-			Timestep timestep = time - m_LastFrameTime;
+			// Keep absolute time in double precision, only the frame delta fits a float
+			double time = Time::GetTime();
+			Timestep timestep = (float)(time - m_LastFrameTime);
 			m_LastFrameTime = time;
 
 			//ExecuteMainThreadQueue();
 
 			ProcessEvents();
+			FileSystem::DispatchFileSystemChanges();
+			AssetManager::SyncLoadedAssets();
 			if (!m_Minimized)
 			{
 				{
@@ -131,6 +155,8 @@ namespace NanoCore{
 			}
 
 			m_Window->OnUpdate();
+
+			FrameAllocator::EndFrame();
 		}
 	}
 
@@ -159,15 +185,16 @@ namespace NanoCore{
 	{
 		m_Window->ProcessEvents();
 
-		std::scoped_lock<std::mutex> lock(m_EventQueueMutex);
-
-		// Process custom event queue
-		while (m_EventQueue.size() > 0)
+		// Process custom event queue. The queues swap so handlers run without the
+		// lock held, events they queue run next frame. Both keep their capacity.
 		{
-			auto& func = m_EventQueue.front();
-			func();
-			m_EventQueue.pop();
+			std::scoped_lock<std::mutex> lock(m_EventQueueMutex);
+			std::swap(m_EventQueue, m_ProcessingEventQueue);
 		}
+
+		for (auto& func : m_ProcessingEventQueue)
+			func();
+		m_ProcessingEventQueue.clear();
 	}
 
 	void Application::ExecuteMainThreadQueue()
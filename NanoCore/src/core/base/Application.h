@@ -8,11 +8,13 @@
 #include "modules/events/ApplicationEvent.h"
 
 #include "modules/utils/Timestep.h"
+#include "modules/utils/FrameAllocator.h"
 
 #include "modules/ui/UILayer.h"
 
 #include <queue>
 #include <mutex>
+#include <vector>
 int main(int argc, char** argv);
 
 namespace NanoCore{
@@ -33,6 +35,8 @@ namespace NanoCore{
 		std::string Name = "NanoCoreApplication";
 		std::string WorkingDirectory;
 		std::string LogoPath;
+		// Asset packs mounted at startup, relative to the working directory
+		std::vector<std::string> AssetPacks;
 		ApplicationCommandLineArgs CommandLineArgs;
 	};
 
@@ -50,7 +54,8 @@ namespace NanoCore{
 		template<typename Func>
 		void QueueEvent(Func&& func)
 		{
-			m_EventQueue.push(func);
+			std::scoped_lock<std::mutex> lock(m_EventQueueMutex);
+			m_EventQueue.emplace_back(std::forward<Func>(func));
 		}
 
 
@@ -59,15 +64,25 @@ namespace NanoCore{
 		{
 			static_assert(std::is_assignable_v<Event, TEvent>);
 
-			std::shared_ptr<TEvent> event = std::make_shared<TEvent>(std::forward<TEventArgs>(args)...);
 			if constexpr (DispatchImmediately)
 			{
-				OnEvent(*event);
+				TEvent event(std::forward<TEventArgs>(args)...);
+				OnEvent(event);
+			}
+			else if (FrameAllocator::IsOwnerThread())
+			{
+				// Queued events run at the start of the next frame, frame memory lives that long
+				TEvent* event = new (FrameAllocator::Allocate(sizeof(TEvent), alignof(TEvent))) TEvent(std::forward<TEventArgs>(args)...);
+
+				std::scoped_lock<std::mutex> lock(m_EventQueueMutex);
+				m_EventQueue.emplace_back([event]() { Application::Get().OnEvent(*event); event->~TEvent(); });
 			}
 			else
 			{
+				std::shared_ptr<TEvent> event = std::make_shared<TEvent>(std::forward<TEventArgs>(args)...);
+
 				std::scoped_lock<std::mutex> lock(m_EventQueueMutex);
-				m_EventQueue.push([event](){ Application::Get().OnEvent(*event); });
+				m_EventQueue.emplace_back([event]() { Application::Get().OnEvent(*event); });
 			}
 		}
 
@@ -97,14 +112,15 @@ namespace NanoCore{
 		bool m_Running = true;
 		bool m_Minimized = false;
 		LayerStack m_LayerStack;
-		float m_LastFrameTime = 0.0f;
+		double m_LastFrameTime = 0.0;
 
 
 		std::vector<std::function<void()>> m_MainThreadQueue;
 		std::mutex m_MainThreadQueueMutex;
 
 		std::mutex m_EventQueueMutex;
-		std::queue<std::function<void()>> m_EventQueue;
+		std::vector<std::function<void()>> m_EventQueue;
+		std::vector<std::function<void()>> m_ProcessingEventQueue;
 		std::vector<EventCallbackFn> m_EventCallbacks;
 
 
@@ -1,6 +1,56 @@
 #pragma once
 
 #include "core/base/Base.h"
+#include "modules/utils/UUID.h"
+#include "AssetTypes.h"
 
 #include <filesystem>
+#include <vector>
 
+namespace NanoCore {
+
+	using AssetHandle = UUID;
+
+	// Base of everything the AssetManager hands out
+	class Asset : public RefCount
+	{
+	public:
+		AssetHandle Handle = 0;
+		uint16_t Flags = (uint16_t)AssetFlag::None;
+
+		virtual ~Asset() = default;
+
+		virtual AssetType GetAssetType() const { return AssetType::None; }
+
+		// Bytes the asset keeps in memory and on the GPU, counted against the AssetManager budget
+		virtual uint64_t GetCPUMemorySize() const { return 0; }
+		virtual uint64_t GetGPUMemorySize() const { return 0; }
+
+		bool IsValid() const { return !(Flags & ((uint16_t)AssetFlag::Missing | (uint16_t)AssetFlag::Invalid)); }
+
+		bool IsFlagSet(AssetFlag flag) const { return Flags & (uint16_t)flag; }
+		void SetFlag(AssetFlag flag, bool value = true)
+		{
+			if (value)
+				Flags |= (uint16_t)flag;
+			else
+				Flags &= ~(uint16_t)flag;
+		}
+	};
+
+	// Registry entry of an asset, stored in the project's asset registry
+	struct AssetMetadata
+	{
+		AssetHandle Handle = 0;
+		AssetType Type = AssetType::None;
+
+		// Relative to the project's asset directory when the file is inside it
+		std::filesystem::path FilePath;
+
+		// Loaded before the asset and kept resident while it is
+		std::vector<AssetHandle> Dependencies;
+
+		bool IsValid() const { return Handle != 0; }
+	};
+
+}
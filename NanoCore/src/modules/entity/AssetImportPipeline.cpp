@@ -0,0 +1,636 @@
+#include "ncpch.h"
+#include "AssetImportPipeline.h"
+
+#include "AssetManager.h"
+#include "modules/info/Project.h"
+#include "modules/utils/FileManager.h"
+#include "modules/utils/Hash.h"
+#include "modules/utils/ThreadPool.h"
+#include "modules/utils/Timer.h"
+
+#include <fstream>
+#include <thread>
+#include <unordered_set>
+
+#include <yaml-cpp/yaml.h>
+
+namespace NanoCore {
+
+	struct AssetCacheEntry
+	{
+		AssetType Type = AssetType::None;
+		uint64_t SourceHash = 0;
+		// Of the source when it was hashed
+		uint64_t SourceSize = 0;
+		int64_t SourceWriteTime = 0;
+		uint32_t ImporterVersion = 0;
+		// AssetImporter::GetDependencyKey when it was imported
+		uint64_t DependencyKey = 0;
+
+		// The source changed since it was hashed, or its derived data is gone
+		bool Stale = true;
+		// The source is current but its importer failed, there's no derived data
+		bool Failed = false;
+	};
+
+	enum class AssetImportResult
+	{
+		Imported, Unchanged, Failed
+	};
+
+	struct AssetImportPipelineData
+	{
+		// Only changed at startup, read by the workers without a lock
+		std::unordered_map<AssetType, Unique<AssetImporter>> Importers;
+
+		// Guards everything below, the workers import too
+		std::mutex Mutex;
+		// Source path relative to the asset directory, generic spelling
+		std::unordered_map<std::string, AssetCacheEntry> Entries;
+		bool IndexDirty = false;
+
+		// Absolute, empty without an active project
+		std::filesystem::path AssetDirectory;
+		std::filesystem::path DerivedDataDirectory;
+		std::filesystem::path IndexPath;
+
+		// Main thread only
+		std::filesystem::path WatchedDirectory;
+		uint32_t ChangeCallback = 0;
+	};
+
+	static AssetImportPipelineData* s_Data = nullptr;
+
+	namespace Utils {
+
+		static bool IsInside(const std::filesystem::path& path, const std::filesystem::path& directory)
+		{
+			std::filesystem::path relative = path.lexically_relative(directory);
+			return !relative.empty() && *relative.begin() != "..";
+		}
+
+		static bool GetSourceStamp(const std::filesystem::path& path, uint64_t& size, int64_t& writeTime)
+		{
+			std::error_code error;
+			size = std::filesystem::file_size(path, error);
+			if (error)
+				return false;
+
+			writeTime = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+			return !error;
+		}
+
+	}
+
+	// Cache index key of a source, empty for files outside the asset directory and for
+	// derived data that happens to lie inside it
+	static std::string GetEntryKey(const std::filesystem::path& sourcePath)
+	{
+		std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+		if (s_Data->AssetDirectory.empty())
+			return {};
+
+		std::filesystem::path path = std::filesystem::absolute(sourcePath).lexically_normal();
+		if (!Utils::IsInside(path, s_Data->AssetDirectory) || Utils::IsInside(path, s_Data->DerivedDataDirectory))
+			return {};
+
+		return path.lexically_relative(s_Data->AssetDirectory).generic_string();
+	}
+
+	static const AssetImporter* FindImporter(const std::filesystem::path& sourcePath)
+	{
+		const AssetImporter* importer = AssetImportPipeline::GetImporter(Utils::AssetTypeFromExtension(sourcePath.extension().string()));
+		return importer && importer->CanImport(sourcePath) ? importer : nullptr;
+	}
+
+	// Made by another importer version or under other dependencies, the source itself isn't checked.
+	// The dependency key is taken before locking, importers may touch the file system for it.
+	static bool IsOutdated(const AssetCacheEntry& entry, const AssetImporter& importer, uint64_t dependencyKey)
+	{
+		return entry.ImporterVersion != importer.GetVersion() || entry.DependencyKey != dependencyKey;
+	}
+
+	// Caller holds the lock
+	static std::filesystem::path GetDerivedPath(const AssetCacheEntry& entry, const AssetImporter& importer)
+	{
+		return s_Data->DerivedDataDirectory / fmt::format("{:016x}-{:016x}-{}{}", entry.SourceHash, entry.DependencyKey, entry.ImporterVersion, importer.GetExtension());
+	}
+
+	// Caller holds the lock. Deletes derived data no entry refers to anymore, a reader that
+	// still has the file open keeps it on Windows and the next cache load removes it.
+	static void ReleaseDerivedData(const std::filesystem::path& derivedPath)
+	{
+		for (const auto& [key, entry] : s_Data->Entries)
+		{
+			const AssetImporter* importer = AssetImportPipeline::GetImporter(entry.Type);
+			if (!entry.Stale && !entry.Failed && importer && GetDerivedPath(entry, *importer) == derivedPath)
+				return;
+		}
+
+		std::error_code error;
+		std::filesystem::remove(derivedPath, error);
+	}
+
+	// Hashes the source and runs its importer unless derived data for that hash exists already
+	static AssetImportResult ImportSource(const std::filesystem::path& sourcePath, const std::string& key, const AssetImporter& importer, bool force)
+	{
+		RA_PROFILE_FUNCTION();
+
+		AssetCacheEntry imported;
+		imported.Type = importer.GetAssetType();
+		imported.ImporterVersion = importer.GetVersion();
+		imported.DependencyKey = importer.GetDependencyKey(sourcePath);
+		imported.Stale = false;
+
+		bool readable = Utils::GetSourceStamp(sourcePath, imported.SourceSize, imported.SourceWriteTime);
+		if (readable)
+		{
+			MappedFile source;
+			readable = source.Open(sourcePath);
+			if (readable)
+				imported.SourceHash = Hash::Hash64(source.GetData(), source.GetSize());
+		}
+
+		std::filesystem::path derivedPath, previousPath;
+		{
+			std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+			derivedPath = GetDerivedPath(imported, importer);
+
+			auto it = s_Data->Entries.find(key);
+			if (it != s_Data->Entries.end() && !it->second.Stale && !it->second.Failed)
+				previousPath = GetDerivedPath(it->second, importer);
+		}
+
+		AssetImportResult result = AssetImportResult::Unchanged;
+		if (!readable)
+		{
+			result = AssetImportResult::Failed;
+		}
+		else if (force || !std::filesystem::exists(derivedPath))
+		{
+			// Written under a name of its own and moved into place, two threads importing the
+			// same source write the same bytes and whichever moves last wins
+			std::filesystem::path temporaryPath = derivedPath;
+			temporaryPath += fmt::format(".{}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+			std::error_code error;
+			if (importer.Import(sourcePath, temporaryPath))
+			{
+				std::filesystem::rename(temporaryPath, derivedPath, error);
+				result = !error || std::filesystem::exists(derivedPath) ? AssetImportResult::Imported : AssetImportResult::Failed;
+			}
+			else
+			{
+				result = AssetImportResult::Failed;
+			}
+			std::filesystem::remove(temporaryPath, error);
+		}
+
+		if (result == AssetImportResult::Failed)
+			NANO_ENGINE_LOG_WARN("Failed to import {} '{}'", Utils::AssetTypeToString(imported.Type), sourcePath.string());
+
+		std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+		imported.Failed = result == AssetImportResult::Failed;
+		s_Data->Entries[key] = imported;
+		s_Data->IndexDirty = true;
+
+		if (!previousPath.empty() && previousPath != derivedPath)
+			ReleaseDerivedData(previousPath);
+
+		return result;
+	}
+
+	struct StaleSource
+	{
+		std::filesystem::path Path;
+		std::string Key;
+		const AssetImporter* Importer;
+	};
+
+	// Imports the sources on the thread pool, the calling thread helps
+	static AssetImportStats ImportSources(const std::vector<StaleSource>& sources, std::vector<std::filesystem::path>* importedPaths = nullptr)
+	{
+		std::vector<AssetImportResult> results(sources.size());
+		ThreadPool::ParallelFor(sources.size(), 1, [&](size_t first, size_t last)
+			{
+				for (size_t i = first; i < last; i++)
+					results[i] = ImportSource(sources[i].Path, sources[i].Key, *sources[i].Importer, false);
+			});
+
+		AssetImportStats stats;
+		stats.SourceCount = (uint32_t)sources.size();
+		for (size_t i = 0; i < sources.size(); i++)
+		{
+			switch (results[i])
+			{
+			case AssetImportResult::Imported:
+				stats.ImportedCount++;
+				if (importedPaths)
+					importedPaths->push_back(sources[i].Path);
+				break;
+			case AssetImportResult::Unchanged: stats.UnchangedCount++; break;
+			case AssetImportResult::Failed:    stats.FailedCount++; break;
+			}
+		}
+		return stats;
+	}
+
+	// Reloads the loaded assets whose derived data changed
+	static void ReloadImportedAssets(const std::vector<std::filesystem::path>& importedPaths)
+	{
+		for (const std::filesystem::path& path : importedPaths)
+		{
+			if (AssetHandle handle = AssetManager::GetAssetHandle(path))
+				AssetManager::ReloadAsset(handle);
+		}
+	}
+
+	// Removes derived data no entry refers to, leftovers of older importer versions and of
+	// imports that were interrupted
+	static void CollectGarbage()
+	{
+		std::unordered_set<std::string> referenced;
+		{
+			std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+			for (const auto& [key, entry] : s_Data->Entries)
+			{
+				const AssetImporter* importer = AssetImportPipeline::GetImporter(entry.Type);
+				if (!entry.Stale && !entry.Failed && importer)
+					referenced.insert(GetDerivedPath(entry, *importer).generic_string());
+			}
+		}
+
+		std::error_code error;
+		for (const auto& file : std::filesystem::directory_iterator(s_Data->DerivedDataDirectory, error))
+		{
+			if (referenced.find(file.path().generic_string()) == referenced.end())
+				std::filesystem::remove(file.path(), error);
+		}
+	}
+
+	static void OnFileSystemChanged(const std::vector<FileSystemChangedEvent>& events)
+	{
+		RA_PROFILE_FUNCTION();
+
+		bool refresh = false;
+		std::vector<StaleSource> sources;
+		for (const FileSystemChangedEvent& event : events)
+		{
+			// Anything below a changed directory may have changed, the whole tree is checked
+			if (event.IsDirectory)
+			{
+				refresh = true;
+				continue;
+			}
+
+			std::string key = GetEntryKey(event.FilePath);
+			const AssetImporter* importer = FindImporter(event.FilePath);
+			if (key.empty() || !importer)
+				continue;
+
+			std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+			if (event.Action == FileSystemAction::Rename && !event.OldName.empty())
+			{
+				std::filesystem::path oldPath = std::filesystem::path(key).parent_path() / event.OldName;
+				s_Data->Entries.erase(oldPath.generic_string());
+				s_Data->IndexDirty = true;
+			}
+
+			if (event.Action == FileSystemAction::Delete)
+			{
+				s_Data->Entries.erase(key);
+				s_Data->IndexDirty = true;
+				continue;
+			}
+
+			AssetCacheEntry& entry = s_Data->Entries[key];
+			entry.Type = importer->GetAssetType();
+			entry.Stale = true;
+
+			// Importers that aren't thread safe run when their data is asked for
+			if (importer->IsThreadSafe())
+				sources.push_back({ event.FilePath, key, importer });
+		}
+
+		std::vector<std::filesystem::path> importedPaths;
+		if (refresh)
+		{
+			// Covers the single files of the batch as well
+			AssetImportPipeline::Refresh();
+			for (const StaleSource& source : sources)
+				importedPaths.push_back(source.Path);
+		}
+		else if (!sources.empty())
+		{
+			Timer timer;
+			AssetImportStats stats = ImportSources(sources, &importedPaths);
+			if (stats.ImportedCount > 0)
+				NANO_ENGINE_LOG_INFO("Reimported {} assets in {:.2f}ms", stats.ImportedCount, timer.ElapsedMillis());
+		}
+
+		ReloadImportedAssets(importedPaths);
+	}
+
+	void AssetImportPipeline::Init()
+	{
+		s_Data = new AssetImportPipelineData();
+
+		RegisterImporter(std::make_unique<TextureImporter>());
+		RegisterImporter(std::make_unique<SceneImporter>());
+
+		s_Data->ChangeCallback = FileSystem::AddChangeCallback(OnFileSystemChanged);
+	}
+
+	void AssetImportPipeline::Shutdown()
+	{
+		FileSystem::RemoveChangeCallback(s_Data->ChangeCallback);
+		SaveCache();
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	void AssetImportPipeline::RegisterImporter(Unique<AssetImporter> importer)
+	{
+		AssetType type = importer->GetAssetType();
+		s_Data->Importers[type] = std::move(importer);
+	}
+
+	const AssetImporter* AssetImportPipeline::GetImporter(AssetType type)
+	{
+		auto it = s_Data->Importers.find(type);
+		return it != s_Data->Importers.end() ? it->second.get() : nullptr;
+	}
+
+	bool AssetImportPipeline::LoadCache()
+	{
+		RA_PROFILE_FUNCTION();
+
+		if (!s_Data->WatchedDirectory.empty())
+		{
+			FileSystem::UnwatchDirectory(s_Data->WatchedDirectory);
+			s_Data->WatchedDirectory.clear();
+		}
+
+		{
+			std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+			s_Data->Entries.clear();
+			s_Data->IndexDirty = false;
+			s_Data->AssetDirectory.clear();
+
+			if (!Project::GetActive())
+				return false;
+
+			std::filesystem::path cacheDirectory = std::filesystem::absolute(Project::GetCacheDirectory()).lexically_normal();
+			s_Data->AssetDirectory = std::filesystem::absolute(Project::GetAssetDirectory()).lexically_normal();
+			s_Data->DerivedDataDirectory = cacheDirectory / "Assets";
+			s_Data->IndexPath = cacheDirectory / "AssetCache.yaml";
+		}
+
+		FileSystem::CreateDirectory(s_Data->DerivedDataDirectory);
+
+		if (std::filesystem::exists(s_Data->IndexPath))
+		{
+			try
+			{
+				YAML::Node data = YAML::LoadFile(s_Data->IndexPath.string());
+
+				std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+				if (auto sources = data["Sources"])
+				{
+					for (auto node : sources)
+					{
+						AssetCacheEntry entry;
+						entry.Type = Utils::AssetTypeFromString(node["Type"].as<std::string>());
+						entry.SourceHash = node["Hash"].as<uint64_t>();
+						entry.SourceSize = node["Size"].as<uint64_t>();
+						entry.SourceWriteTime = node["WriteTime"].as<int64_t>();
+						entry.ImporterVersion = node["Version"].as<uint32_t>();
+						if (auto dependencies = node["Dependencies"])
+							entry.DependencyKey = dependencies.as<uint64_t>();
+						entry.Stale = false;
+
+						s_Data->Entries[node["Path"].as<std::string>()] = entry;
+					}
+				}
+			}
+			catch (YAML::Exception& e)
+			{
+				NANO_ENGINE_LOG_WARN("Asset cache index '{}' is damaged, everything is imported again\n     {}", s_Data->IndexPath.string(), e.what());
+
+				std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+				s_Data->Entries.clear();
+			}
+		}
+
+		Refresh();
+		CollectGarbage();
+		SaveCache();
+
+		s_Data->WatchedDirectory = s_Data->AssetDirectory;
+		FileSystem::WatchDirectory(s_Data->WatchedDirectory);
+		return true;
+	}
+
+	void AssetImportPipeline::SaveCache()
+	{
+		std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+		if (!s_Data->IndexDirty || s_Data->AssetDirectory.empty())
+			return;
+
+		RA_PROFILE_FUNCTION();
+
+		// Only current entries, stale and failed sources are looked at again next time.
+		// Sorted by path so the file diffs cleanly.
+		std::vector<std::pair<const std::string*, const AssetCacheEntry*>> sorted;
+		sorted.reserve(s_Data->Entries.size());
+		for (const auto& [key, entry] : s_Data->Entries)
+		{
+			if (!entry.Stale && !entry.Failed)
+				sorted.emplace_back(&key, &entry);
+		}
+		std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return *a.first < *b.first; });
+
+		YAML::Emitter out;
+		out << YAML::BeginMap;
+		out << YAML::Key << "Sources" << YAML::Value << YAML::BeginSeq;
+		for (const auto& [key, entry] : sorted)
+		{
+			out << YAML::BeginMap;
+			out << YAML::Key << "Path" << YAML::Value << *key;
+			out << YAML::Key << "Type" << YAML::Value << Utils::AssetTypeToString(entry->Type);
+			out << YAML::Key << "Hash" << YAML::Value << entry->SourceHash;
+			out << YAML::Key << "Size" << YAML::Value << entry->SourceSize;
+			out << YAML::Key << "WriteTime" << YAML::Value << entry->SourceWriteTime;
+			out << YAML::Key << "Version" << YAML::Value << entry->ImporterVersion;
+			if (entry->DependencyKey != 0)
+				out << YAML::Key << "Dependencies" << YAML::Value << entry->DependencyKey;
+			out << YAML::EndMap;
+		}
+		out << YAML::EndSeq;
+		out << YAML::EndMap;
+
+		std::ofstream fout(s_Data->IndexPath);
+		fout << out.c_str();
+		if (!fout)
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to write asset cache index '{}'", s_Data->IndexPath.string());
+			return;
+		}
+
+		s_Data->IndexDirty = false;
+	}
+
+	AssetImportStats AssetImportPipeline::Refresh()
+	{
+		RA_PROFILE_FUNCTION();
+
+		std::filesystem::path assetDirectory, derivedDataDirectory;
+		{
+			std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+			assetDirectory = s_Data->AssetDirectory;
+			derivedDataDirectory = s_Data->DerivedDataDirectory;
+		}
+
+		if (assetDirectory.empty())
+			return {};
+
+		Timer timer;
+
+		// Only stats the sources, a source is hashed when its size or write time changed
+		std::vector<StaleSource> sources;
+		std::unordered_set<std::string> visited;
+		uint32_t sourceCount = 0;
+
+		std::error_code error;
+		auto it = std::filesystem::recursive_directory_iterator(assetDirectory, std::filesystem::directory_options::skip_permission_denied, error);
+		for (auto end = std::filesystem::recursive_directory_iterator(); it != end; it.increment(error))
+		{
+			if (error)
+				break;
+
+			const std::filesystem::directory_entry& file = *it;
+			if (file.is_directory(error))
+			{
+				if (file.path().lexically_normal() == derivedDataDirectory)
+					it.disable_recursion_pending();
+				continue;
+			}
+
+			const AssetImporter* importer = FindImporter(file.path());
+			if (!importer)
+				continue;
+
+			uint64_t size = 0;
+			int64_t writeTime = 0;
+			if (!Utils::GetSourceStamp(file.path(), size, writeTime))
+				continue;
+
+			sourceCount++;
+			std::string key = file.path().lexically_normal().lexically_relative(assetDirectory).generic_string();
+
+			uint64_t dependencyKey = importer->GetDependencyKey(file.path());
+			std::filesystem::path derivedPath;
+			{
+				std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+				visited.insert(key);
+
+				AssetCacheEntry& entry = s_Data->Entries[key];
+				entry.Type = importer->GetAssetType();
+				if (entry.Stale || entry.SourceSize != size || entry.SourceWriteTime != writeTime || IsOutdated(entry, *importer, dependencyKey))
+					entry.Stale = true;
+				else if (!entry.Failed)
+					derivedPath = GetDerivedPath(entry, *importer);
+			}
+
+			// The cache directory may have been cleared
+			if (!derivedPath.empty() && !std::filesystem::exists(derivedPath))
+			{
+				std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+				s_Data->Entries[key].Stale = true;
+				derivedPath.clear();
+			}
+
+			if (derivedPath.empty() && importer->IsThreadSafe())
+				sources.push_back({ file.path(), std::move(key), importer });
+		}
+
+		// Sources deleted since the last refresh
+		{
+			std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+			for (auto entry = s_Data->Entries.begin(); entry != s_Data->Entries.end();)
+			{
+				if (visited.find(entry->first) == visited.end())
+				{
+					entry = s_Data->Entries.erase(entry);
+					s_Data->IndexDirty = true;
+				}
+				else
+				{
+					++entry;
+				}
+			}
+		}
+
+		AssetImportStats stats = ImportSources(sources);
+		stats.SourceCount = sourceCount;
+
+		if (stats.ImportedCount > 0 || stats.FailedCount > 0)
+		{
+			NANO_ENGINE_LOG_INFO("Imported {} of {} assets in {:.2f}ms ({} unchanged, {} failed)",
+				stats.ImportedCount, stats.SourceCount, timer.ElapsedMillis(), stats.UnchangedCount, stats.FailedCount);
+		}
+
+		return stats;
+	}
+
+	std::filesystem::path AssetImportPipeline::GetDerivedDataPath(const std::filesystem::path& sourcePath)
+	{
+		std::string key = GetEntryKey(sourcePath);
+		const AssetImporter* importer = FindImporter(sourcePath);
+		if (key.empty() || !importer)
+			return {};
+
+		uint64_t dependencyKey = importer->GetDependencyKey(sourcePath);
+		{
+			std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+			auto it = s_Data->Entries.find(key);
+			if (it != s_Data->Entries.end() && !it->second.Stale && !IsOutdated(it->second, *importer, dependencyKey))
+				return it->second.Failed ? std::filesystem::path() : GetDerivedPath(it->second, *importer);
+		}
+
+		if (ImportSource(sourcePath, key, *importer, false) == AssetImportResult::Failed)
+			return {};
+
+		std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+		return GetDerivedPath(s_Data->Entries[key], *importer);
+	}
+
+	bool AssetImportPipeline::IsStale(const std::filesystem::path& sourcePath)
+	{
+		std::string key = GetEntryKey(sourcePath);
+		const AssetImporter* importer = FindImporter(sourcePath);
+		if (key.empty() || !importer)
+			return false;
+
+		uint64_t dependencyKey = importer->GetDependencyKey(sourcePath);
+		std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+		auto it = s_Data->Entries.find(key);
+		return it == s_Data->Entries.end() || it->second.Stale || IsOutdated(it->second, *importer, dependencyKey);
+	}
+
+	std::filesystem::path AssetImportPipeline::Reimport(const std::filesystem::path& sourcePath)
+	{
+		std::string key = GetEntryKey(sourcePath);
+		const AssetImporter* importer = FindImporter(sourcePath);
+		if (key.empty() || !importer)
+			return {};
+
+		if (ImportSource(sourcePath, key, *importer, true) == AssetImportResult::Failed)
+			return {};
+
+		std::scoped_lock<std::mutex> lock(s_Data->Mutex);
+		return GetDerivedPath(s_Data->Entries[key], *importer);
+	}
+
+}
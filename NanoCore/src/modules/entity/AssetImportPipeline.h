@@ -0,0 +1,57 @@
+#pragma once
+
+#include "core/base/Base.h"
+#include "AssetImporter.h"
+
+#include <filesystem>
+
+namespace NanoCore {
+
+	struct AssetImportStats
+	{
+		uint32_t SourceCount = 0;
+		uint32_t ImportedCount = 0;
+		// Sources whose contents hadn't changed, only their cache entry was updated
+		uint32_t UnchangedCount = 0;
+		uint32_t FailedCount = 0;
+	};
+
+	// Keeps the derived data of the active project's assets in Project::GetCacheDirectory().
+	// Derived files are named after the hash of their source, the importer's dependency key and
+	// the importer version, so identical sources share them and a source reverted to older
+	// contents finds its old data.
+	// The cache index remembers the size and write time every source had when it was hashed;
+	// on a warm cache startup only stats the sources and reads the index.
+	// Stale sources are imported in parallel when the project is opened and when the file
+	// watcher reports a change, importers that aren't thread safe run when their data is asked for.
+	class AssetImportPipeline
+	{
+	public:
+		// Registers the built in importers
+		static void Init();
+		static void Shutdown();
+
+		// One importer per asset type, a later one replaces the earlier
+		static void RegisterImporter(Unique<AssetImporter> importer);
+		static const AssetImporter* GetImporter(AssetType type);
+
+		// Cache index of the active project, loaded when the project becomes active.
+		// Loading brings the cache up to date and starts watching the asset directory.
+		static bool LoadCache();
+		static void SaveCache();
+
+		// Imports every stale source in the asset directory
+		static AssetImportStats Refresh();
+
+		// Derived data of a source, imported first if it is stale. Thread safe for sources with
+		// a thread safe importer, the rest only on the main thread. Empty without an active
+		// project, for files no importer handles and for sources that fail to import.
+		static std::filesystem::path GetDerivedDataPath(const std::filesystem::path& sourcePath);
+		static bool IsStale(const std::filesystem::path& sourcePath);
+
+		// Imports the source even if its cache entry looks current, for derived data that turned
+		// out damaged. Thread safe like GetDerivedDataPath.
+		static std::filesystem::path Reimport(const std::filesystem::path& sourcePath);
+	};
+
+}
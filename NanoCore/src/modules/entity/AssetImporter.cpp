@@ -0,0 +1,140 @@
+#include "ncpch.h"
+#include "AssetImporter.h"
+
+#include "SceneBinarySerializer.h"
+#include "SceneSerializer.h"
+#include "modules/script/ScriptEngine.h"
+#include "modules/utils/Compression.h"
+#include "modules/utils/FileManager.h"
+#include "modules/utils/Hash.h"
+
+#include <fstream>
+
+namespace NanoCore {
+
+	//--------------------------------------------------------------------------
+	// Textures
+
+	// "NCTX"
+	static constexpr uint32_t TextureDataMagic = 0x5854434E;
+	static constexpr uint32_t CompressedTextureFlag = 1 << 0;
+
+	// Followed by the stored pixels
+	struct TextureDataHeader
+	{
+		uint32_t Magic = TextureDataMagic;
+		uint32_t Width = 0, Height = 0;
+		uint32_t Channels = 0;
+		uint32_t MipCount = 0;
+		uint32_t Flags = 0;
+		// CRC32C of the stored pixels
+		uint32_t Checksum = 0;
+		uint32_t Reserved = 0;
+		uint64_t Size = 0;
+		uint64_t StoredSize = 0;
+	};
+
+	bool TextureImporter::Import(const std::filesystem::path& sourcePath, const std::filesystem::path& derivedPath) const
+	{
+		RA_PROFILE_FUNCTION();
+
+		TextureImage image;
+		if (!Texture2D::DecodeImageFile(sourcePath.string(), image))
+			return false;
+
+		Texture2D::GenerateMips(image);
+
+		TextureDataHeader header;
+		header.Width = image.Width;
+		header.Height = image.Height;
+		header.Channels = image.Channels;
+		header.MipCount = image.MipCount;
+		header.Size = image.Pixels.size();
+
+		// Kept compressed when that saves an eighth or more, like asset packs do
+		std::vector<uint8_t> compressed(Compression::GetMaxCompressedSizeLZ4(image.Pixels.size()));
+		size_t compressedSize = Compression::CompressLZ4(image.Pixels.data(), image.Pixels.size(), compressed.data(), compressed.size());
+		const std::vector<uint8_t>* stored = &image.Pixels;
+		if (compressedSize > 0 && compressedSize <= image.Pixels.size() - image.Pixels.size() / 8)
+		{
+			compressed.resize(compressedSize);
+			stored = &compressed;
+			header.Flags |= CompressedTextureFlag;
+		}
+
+		header.StoredSize = stored->size();
+		header.Checksum = Hash::CRC32C(stored->data(), stored->size());
+
+		std::ofstream stream(derivedPath, std::ios::binary | std::ios::trunc);
+		stream.write((const char*)&header, sizeof(TextureDataHeader));
+		stream.write((const char*)stored->data(), stored->size());
+		return (bool)stream;
+	}
+
+	bool TextureImporter::ReadImage(const std::filesystem::path& derivedPath, TextureImage& image)
+	{
+		RA_PROFILE_FUNCTION();
+
+		MappedFile file;
+		if (!file.Open(derivedPath) || file.GetSize() < sizeof(TextureDataHeader))
+			return false;
+
+		TextureDataHeader header;
+		memcpy(&header, file.GetData(), sizeof(TextureDataHeader));
+		if (header.Magic != TextureDataMagic || header.StoredSize != file.GetSize() - sizeof(TextureDataHeader))
+			return false;
+
+		image.Width = header.Width;
+		image.Height = header.Height;
+		image.Channels = header.Channels;
+		image.MipCount = header.MipCount;
+
+		uint64_t size = 0;
+		for (uint32_t mip = 0; mip < image.MipCount && mip < 32; mip++)
+			size += image.GetMipSize(mip);
+		if (header.Size != size || header.MipCount == 0 || header.MipCount > 32 || (header.Channels != 3 && header.Channels != 4))
+			return false;
+
+		const uint8_t* stored = file.GetData() + sizeof(TextureDataHeader);
+		if (Hash::CRC32C(stored, header.StoredSize) != header.Checksum)
+			return false;
+
+		image.Pixels.resize(header.Size);
+		if (!(header.Flags & CompressedTextureFlag))
+		{
+			if (header.StoredSize != header.Size)
+				return false;
+
+			memcpy(image.Pixels.data(), stored, header.Size);
+			return true;
+		}
+		return Compression::DecompressLZ4(stored, header.StoredSize, image.Pixels.data(), header.Size);
+	}
+
+	//--------------------------------------------------------------------------
+	// Scenes
+
+	uint64_t SceneImporter::GetDependencyKey(const std::filesystem::path& sourcePath) const
+	{
+		uint64_t key[3] = { ScriptEngine::GetClassLayoutHash(), 0, 0 };
+
+		// Stamped rather than hashed, the journal grows with every autosave
+		std::error_code error;
+		std::filesystem::path journalPath = SceneSerializer::GetJournalPath(sourcePath);
+		if (std::filesystem::exists(journalPath, error))
+		{
+			key[1] = std::filesystem::file_size(journalPath, error);
+			key[2] = (uint64_t)std::filesystem::last_write_time(journalPath, error).time_since_epoch().count();
+		}
+
+		return Hash::Hash64(key, sizeof(key));
+	}
+
+	bool SceneImporter::Import(const std::filesystem::path& sourcePath, const std::filesystem::path& derivedPath) const
+	{
+		RA_PROFILE_FUNCTION();
+
+		return SceneBinarySerializer::ExportFromYAML(sourcePath, derivedPath);
+	}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "AssetTypes.h"
+#include "modules/rendering/Texture.h"
+
+#include <filesystem>
+
+namespace NanoCore {
+
+	// Turns the source file of one asset type into the derived data the runtime loads
+	// instead. Registered with the AssetImportPipeline, which decides when to run it.
+	class AssetImporter
+	{
+	public:
+		virtual ~AssetImporter() = default;
+
+		virtual AssetType GetAssetType() const = 0;
+		// Bumped whenever the output changes, derived data of older versions is imported again
+		virtual uint32_t GetVersion() const = 0;
+		// Of the derived data files
+		virtual const char* GetExtension() const = 0;
+		// Importers that aren't only run on the main thread, when their data is asked for
+		virtual bool IsThreadSafe() const { return true; }
+		// Files of the asset type that are sources of this importer, not already derived data
+		virtual bool CanImport(const std::filesystem::path& sourcePath) const { return true; }
+		// State besides the source's contents its derived data depends on, derived data made
+		// under a different key is imported again. Asked on every lookup, keep it cheap.
+		virtual uint64_t GetDependencyKey(const std::filesystem::path& sourcePath) const { return 0; }
+
+		virtual bool Import(const std::filesystem::path& sourcePath, const std::filesystem::path& derivedPath) const = 0;
+	};
+
+	// Decoded image with its whole mip chain, LZ4 compressed. Loading it is a decompress
+	// instead of decoding the image and building the mips again.
+	class TextureImporter : public AssetImporter
+	{
+	public:
+		virtual AssetType GetAssetType() const override { return AssetType::Texture; }
+		virtual uint32_t GetVersion() const override { return 1; }
+		virtual const char* GetExtension() const override { return ".nctex"; }
+
+		virtual bool Import(const std::filesystem::path& sourcePath, const std::filesystem::path& derivedPath) const override;
+
+		// Thread safe, false if the file is damaged
+		static bool ReadImage(const std::filesystem::path& derivedPath, TextureImage& image);
+	};
+
+	// YAML scene in the binary scene format
+	class SceneImporter : public AssetImporter
+	{
+	public:
+		virtual AssetType GetAssetType() const override { return AssetType::Scene; }
+		virtual uint32_t GetVersion() const override { return 1; }
+		virtual const char* GetExtension() const override { return ".nanoscene"; }
+		// Deserializing the YAML gets its textures from the AssetManager
+		virtual bool IsThreadSafe() const override { return false; }
+		// .nanoscene files are binary already
+		virtual bool CanImport(const std::filesystem::path& sourcePath) const override { return sourcePath.extension() == ".nanocore"; }
+		// Autosaves go to the scene's journal, which the import replays, and script fields
+		// are stored in the layout of the loaded script classes
+		virtual uint64_t GetDependencyKey(const std::filesystem::path& sourcePath) const override;
+
+		virtual bool Import(const std::filesystem::path& sourcePath, const std::filesystem::path& derivedPath) const override;
+	};
+
+}
@@ -0,0 +1,751 @@
+#include "ncpch.h"
+#include "AssetManager.h"
+#include "AssetImportPipeline.h"
+
+#include "modules/info/Project.h"
+#include "modules/utils/ThreadPool.h"
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+
+#include <yaml-cpp/yaml.h>
+
+namespace NanoCore {
+
+	// CPU side of a load. Filled in by a worker, turned into the asset on the main thread.
+	struct AssetLoadJob
+	{
+		AssetHandle Handle = 0;
+		AssetType Type = AssetType::None;
+		std::string Path;
+		// Handed to a worker, set on the main thread
+		bool Dispatched = false;
+
+		TextureImage Image;
+		bool Succeeded = false;
+		// Decoded bytes, fixed once the job is done
+		uint64_t CPUBytes = 0;
+
+		std::mutex Mutex;
+		std::condition_variable Finished;
+		bool Done = false;
+	};
+
+	struct AssetEntry
+	{
+		AssetMetadata Metadata;
+		AssetState State = AssetState::NotLoaded;
+		Shared<Asset> Instance;
+
+		// The load that is running, completed loads of other jobs are stale
+		std::shared_ptr<AssetLoadJob> Load;
+
+		uint64_t CPUBytes = 0, GPUBytes = 0;
+		// Value of the use counter at the last GetAsset, for LRU eviction
+		uint64_t LastUsed = 0;
+		// Loaded assets that depend on this one
+		uint32_t Dependents = 0;
+	};
+
+	struct AssetManagerData
+	{
+		std::unordered_map<AssetHandle, AssetEntry> Assets;
+		// Full path, as GetFullPath spells it, to handle
+		std::unordered_map<std::string, AssetHandle> PathHandles;
+		bool RegistryDirty = false;
+
+		AssetMemoryBudget Budget;
+		uint64_t CPUBytes = 0, GPUBytes = 0;
+		uint64_t UseCounter = 0;
+		bool OverBudgetWarned = false;
+
+		// Waiting for a free load slot, oldest first
+		std::deque<std::shared_ptr<AssetLoadJob>> QueuedLoads;
+		std::vector<std::shared_ptr<AssetLoadJob>> LoadsInFlight;
+
+		// Pushed by the workers
+		std::mutex CompletedMutex;
+		std::vector<std::shared_ptr<AssetLoadJob>> CompletedLoads;
+
+		// Decoded, waiting for their upload, and the bytes they hold
+		std::deque<std::shared_ptr<AssetLoadJob>> PendingUploads;
+		uint64_t PendingUploadBytes = 0;
+	};
+
+	static AssetManagerData* s_Data = nullptr;
+
+	// Paths inside the asset directory are stored relative to it, anything else absolute
+	static std::filesystem::path GetRegistryPath(const std::filesystem::path& filepath)
+	{
+		std::filesystem::path path = std::filesystem::absolute(filepath).lexically_normal();
+		if (Project::GetActive())
+		{
+			std::filesystem::path relative = path.lexically_relative(std::filesystem::absolute(Project::GetAssetDirectory()).lexically_normal());
+			if (!relative.empty() && *relative.begin() != "..")
+				return relative;
+		}
+		return path;
+	}
+
+	// How the rest of the engine spells the file, the asset directory is relative to the working directory
+	static std::filesystem::path GetFullPath(const AssetMetadata& metadata)
+	{
+		if (metadata.FilePath.is_absolute() || !Project::GetActive())
+			return metadata.FilePath;
+
+		return (Project::GetAssetDirectory() / metadata.FilePath).lexically_normal();
+	}
+
+	static AssetEntry* FindEntry(AssetHandle handle)
+	{
+		auto it = s_Data->Assets.find(handle);
+		return it != s_Data->Assets.end() ? &it->second : nullptr;
+	}
+
+	static void AddEntry(const AssetMetadata& metadata)
+	{
+		AssetEntry& entry = s_Data->Assets[metadata.Handle];
+		entry.Metadata = metadata;
+		s_Data->PathHandles[GetFullPath(metadata).generic_string()] = metadata.Handle;
+	}
+
+	//--------------------------------------------------------------------------
+	// Loaders, one case per asset type the manager can load
+
+	// Runs on a worker, or on the main thread for synchronous loads
+	static bool DecodeAsset(AssetLoadJob& job)
+	{
+		switch (job.Type)
+		{
+		case AssetType::Texture:
+		{
+			// Served from the imported mip chain. Files outside the project's asset directory
+			// and images that failed to import are decoded from the source.
+			std::filesystem::path derivedPath = AssetImportPipeline::GetDerivedDataPath(job.Path);
+			if (derivedPath.empty())
+				return Texture2D::DecodeImageFile(job.Path, job.Image);
+
+			if (TextureImporter::ReadImage(derivedPath, job.Image))
+				return true;
+
+			NANO_ENGINE_LOG_WARN("Imported data of '{}' is damaged, importing it again", job.Path);
+			derivedPath = AssetImportPipeline::Reimport(job.Path);
+			return !derivedPath.empty() && TextureImporter::ReadImage(derivedPath, job.Image);
+		}
+		}
+		return false;
+	}
+
+	// Main thread, may return an asset flagged Missing/Invalid for failed decodes
+	static Shared<Asset> CreateAsset(AssetLoadJob& job)
+	{
+		switch (job.Type)
+		{
+		case AssetType::Texture:
+			return Texture2D::Create(job.Path, job.Image);
+		}
+		return nullptr;
+	}
+
+	// Main thread, swaps the new data into the asset everyone already holds
+	static void ReloadInstance(AssetEntry& entry, AssetLoadJob& job)
+	{
+		switch (job.Type)
+		{
+		case AssetType::Texture:
+			entry.Instance.As<Texture2D>()->Reload(job.Image);
+			break;
+		}
+	}
+
+	static bool IsLoadable(AssetType type)
+	{
+		return type == AssetType::Texture;
+	}
+
+	//--------------------------------------------------------------------------
+
+	static void DispatchLoad(const std::shared_ptr<AssetLoadJob>& job)
+	{
+		job->Dispatched = true;
+		s_Data->LoadsInFlight.push_back(job);
+
+		ThreadPool::Submit([job]()
+			{
+				job->Succeeded = DecodeAsset(*job);
+				job->CPUBytes = job->Image.Pixels.size();
+
+				// The manager may only go away once Done is set, so it's touched first
+				{
+					std::scoped_lock<std::mutex> lock(s_Data->CompletedMutex);
+					s_Data->CompletedLoads.push_back(job);
+				}
+
+				{
+					std::scoped_lock<std::mutex> lock(job->Mutex);
+					job->Done = true;
+				}
+				job->Finished.notify_all();
+			});
+	}
+
+	// Starts queued loads while there are free slots and decoded data fits the CPU budget
+	static void DispatchQueuedLoads()
+	{
+		while (!s_Data->QueuedLoads.empty()
+			&& s_Data->LoadsInFlight.size() < s_Data->Budget.MaxLoadsInFlight
+			&& s_Data->CPUBytes + s_Data->PendingUploadBytes < s_Data->Budget.CPUBytes)
+		{
+			std::shared_ptr<AssetLoadJob> job = std::move(s_Data->QueuedLoads.front());
+			s_Data->QueuedLoads.pop_front();
+
+			// Finished synchronously or unloaded while it waited
+			AssetEntry* entry = FindEntry(job->Handle);
+			if (!entry || entry->Load != job)
+				continue;
+
+			DispatchLoad(job);
+		}
+	}
+
+	static bool DependsOn(AssetHandle handle, AssetHandle dependency)
+	{
+		if (handle == dependency)
+			return true;
+
+		AssetEntry* entry = FindEntry(handle);
+		if (!entry)
+			return false;
+
+		for (AssetHandle next : entry->Metadata.Dependencies)
+		{
+			if (DependsOn(next, dependency))
+				return true;
+		}
+		return false;
+	}
+
+	static void ReleaseDependencies(AssetEntry& entry)
+	{
+		for (AssetHandle dependency : entry.Metadata.Dependencies)
+		{
+			if (AssetEntry* dependencyEntry = FindEntry(dependency); dependencyEntry && dependencyEntry->Dependents > 0)
+				dependencyEntry->Dependents--;
+		}
+	}
+
+	static void Unload(AssetEntry& entry)
+	{
+		if (entry.State == AssetState::Ready)
+		{
+			ReleaseDependencies(entry);
+			s_Data->CPUBytes -= entry.CPUBytes;
+			s_Data->GPUBytes -= entry.GPUBytes;
+		}
+
+		entry.Instance = nullptr;
+		entry.Load.reset();
+		entry.CPUBytes = entry.GPUBytes = 0;
+		entry.State = AssetState::NotLoaded;
+	}
+
+	static void FinishLoad(AssetEntry& entry, AssetLoadJob& job)
+	{
+		RA_PROFILE_FUNCTION();
+
+		entry.Load.reset();
+
+		Shared<Asset> asset = CreateAsset(job);
+		if (!asset)
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to load asset '{}'", job.Path);
+			entry.State = AssetState::Failed;
+			return;
+		}
+
+		asset->Handle = entry.Metadata.Handle;
+		if (!job.Succeeded)
+		{
+			bool exists = std::filesystem::exists(job.Path);
+			asset->SetFlag(exists ? AssetFlag::Invalid : AssetFlag::Missing);
+			NANO_ENGINE_LOG_WARN("Asset '{}' is {}", job.Path, exists ? "invalid" : "missing");
+		}
+
+		// Dependencies queued before the asset usually finished first, the rest load here
+		for (AssetHandle dependency : entry.Metadata.Dependencies)
+		{
+			AssetManager::GetAsset(dependency);
+			if (AssetEntry* dependencyEntry = FindEntry(dependency))
+				dependencyEntry->Dependents++;
+		}
+
+		entry.Instance = asset;
+		entry.State = AssetState::Ready;
+		entry.CPUBytes = asset->GetCPUMemorySize();
+		entry.GPUBytes = asset->GetGPUMemorySize();
+		entry.LastUsed = ++s_Data->UseCounter;
+
+		s_Data->CPUBytes += entry.CPUBytes;
+		s_Data->GPUBytes += entry.GPUBytes;
+	}
+
+	// Loaded assets only the manager references, least recently used first
+	static void EvictToBudget()
+	{
+		const AssetMemoryBudget& budget = s_Data->Budget;
+		auto overBudget = [&]() { return s_Data->CPUBytes > budget.CPUBytes || s_Data->GPUBytes > budget.GPUBytes; };
+
+		if (!overBudget())
+		{
+			s_Data->OverBudgetWarned = false;
+			return;
+		}
+
+		std::vector<AssetEntry*> candidates;
+		for (auto& [handle, entry] : s_Data->Assets)
+		{
+			if (entry.State == AssetState::Ready && entry.Dependents == 0 && entry.Instance->GetRefCount() == 1)
+				candidates.push_back(&entry);
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const AssetEntry* a, const AssetEntry* b) { return a->LastUsed < b->LastUsed; });
+
+		for (AssetEntry* entry : candidates)
+		{
+			if (!overBudget())
+				break;
+
+			Unload(*entry);
+		}
+
+		if (overBudget() && !s_Data->OverBudgetWarned)
+		{
+			NANO_ENGINE_LOG_WARN("Assets in use exceed the memory budget ({} MB CPU, {} MB GPU)",
+				s_Data->CPUBytes / (1024 * 1024), s_Data->GPUBytes / (1024 * 1024));
+			s_Data->OverBudgetWarned = true;
+		}
+	}
+
+	void AssetManager::Init()
+	{
+		s_Data = new AssetManagerData();
+	}
+
+	void AssetManager::Shutdown()
+	{
+		// Workers still hold s_Data until their job is done
+		for (const std::shared_ptr<AssetLoadJob>& job : s_Data->LoadsInFlight)
+		{
+			std::unique_lock<std::mutex> lock(job->Mutex);
+			job->Finished.wait(lock, [&] { return job->Done; });
+		}
+
+		SaveRegistry();
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	bool AssetManager::LoadRegistry()
+	{
+		RA_PROFILE_FUNCTION();
+
+		for (auto& [handle, entry] : s_Data->Assets)
+			Unload(entry);
+		s_Data->Assets.clear();
+		s_Data->PathHandles.clear();
+		s_Data->QueuedLoads.clear();
+		s_Data->RegistryDirty = false;
+
+		if (!Project::GetActive() || Project::GetActive()->GetConfig().AssetRegistryPath.empty())
+			return false;
+
+		std::filesystem::path registryPath = Project::GetAssetRegistryPath();
+		if (!std::filesystem::exists(registryPath))
+			return false;
+
+		YAML::Node data;
+		try
+		{
+			data = YAML::LoadFile(registryPath.string());
+		}
+		catch (YAML::Exception& e)
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to load asset registry '{}'\n     {}", registryPath.string(), e.what());
+			return false;
+		}
+
+		auto assets = data["Assets"];
+		if (!assets)
+			return false;
+
+		for (auto node : assets)
+		{
+			AssetMetadata metadata;
+			metadata.Handle = node["Handle"].as<uint64_t>();
+			metadata.FilePath = node["FilePath"].as<std::string>();
+			metadata.Type = Utils::AssetTypeFromString(node["Type"].as<std::string>());
+
+			if (auto dependencies = node["Dependencies"])
+			{
+				for (auto dependency : dependencies)
+					metadata.Dependencies.push_back(dependency.as<uint64_t>());
+			}
+
+			if (metadata.Type == AssetType::None)
+				continue;
+
+			AddEntry(metadata);
+		}
+
+		NANO_ENGINE_LOG_INFO("Loaded asset registry with {} assets", s_Data->Assets.size());
+		return true;
+	}
+
+	void AssetManager::SaveRegistry()
+	{
+		if (!s_Data->RegistryDirty || !Project::GetActive() || Project::GetActive()->GetConfig().AssetRegistryPath.empty())
+			return;
+
+		RA_PROFILE_FUNCTION();
+
+		// Sorted by handle so the file diffs cleanly
+		std::vector<const AssetMetadata*> sorted;
+		sorted.reserve(s_Data->Assets.size());
+		for (const auto& [handle, entry] : s_Data->Assets)
+			sorted.push_back(&entry.Metadata);
+		std::sort(sorted.begin(), sorted.end(), [](const AssetMetadata* a, const AssetMetadata* b) { return (uint64_t)a->Handle < (uint64_t)b->Handle; });
+
+		YAML::Emitter out;
+		out << YAML::BeginMap;
+		out << YAML::Key << "Assets" << YAML::Value << YAML::BeginSeq;
+		for (const AssetMetadata* metadata : sorted)
+		{
+			out << YAML::BeginMap;
+			out << YAML::Key << "Handle" << YAML::Value << (uint64_t)metadata->Handle;
+			out << YAML::Key << "FilePath" << YAML::Value << metadata->FilePath.generic_string();
+			out << YAML::Key << "Type" << YAML::Value << Utils::AssetTypeToString(metadata->Type);
+			if (!metadata->Dependencies.empty())
+			{
+				out << YAML::Key << "Dependencies" << YAML::Value << YAML::Flow << YAML::BeginSeq;
+				for (AssetHandle dependency : metadata->Dependencies)
+					out << (uint64_t)dependency;
+				out << YAML::EndSeq;
+			}
+			out << YAML::EndMap;
+		}
+		out << YAML::EndSeq;
+		out << YAML::EndMap;
+
+		std::filesystem::path registryPath = Project::GetAssetRegistryPath();
+		std::ofstream fout(registryPath);
+		fout << out.c_str();
+		if (!fout)
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to write asset registry '{}'", registryPath.string());
+			return;
+		}
+
+		s_Data->RegistryDirty = false;
+	}
+
+	AssetHandle AssetManager::ImportAsset(const std::filesystem::path& filepath)
+	{
+		if (AssetHandle handle = GetAssetHandle(filepath))
+			return handle;
+
+		AssetMetadata metadata;
+		metadata.FilePath = GetRegistryPath(filepath);
+		metadata.Type = Utils::AssetTypeFromExtension(filepath.extension().string());
+		if (metadata.Type == AssetType::None)
+		{
+			NANO_ENGINE_LOG_WARN("'{}' is not an asset type", filepath.string());
+			return 0;
+		}
+
+		metadata.Handle = AssetHandle();
+		AddEntry(metadata);
+		s_Data->RegistryDirty = true;
+		return metadata.Handle;
+	}
+
+	void AssetManager::RemoveAsset(AssetHandle handle)
+	{
+		AssetEntry* entry = FindEntry(handle);
+		if (!entry)
+			return;
+
+		Unload(*entry);
+		s_Data->PathHandles.erase(GetFullPath(entry->Metadata).generic_string());
+		s_Data->Assets.erase(handle);
+		s_Data->RegistryDirty = true;
+	}
+
+	AssetHandle AssetManager::GetAssetHandle(const std::filesystem::path& filepath)
+	{
+		AssetMetadata metadata;
+		metadata.FilePath = GetRegistryPath(filepath);
+
+		auto it = s_Data->PathHandles.find(GetFullPath(metadata).generic_string());
+		return it != s_Data->PathHandles.end() ? it->second : AssetHandle(0);
+	}
+
+	bool AssetManager::IsAssetHandleValid(AssetHandle handle)
+	{
+		return handle != 0 && FindEntry(handle);
+	}
+
+	const AssetMetadata& AssetManager::GetAssetMetadata(AssetHandle handle)
+	{
+		static const AssetMetadata s_NullMetadata;
+
+		AssetEntry* entry = FindEntry(handle);
+		return entry ? entry->Metadata : s_NullMetadata;
+	}
+
+	std::filesystem::path AssetManager::GetFileSystemPath(AssetHandle handle)
+	{
+		AssetEntry* entry = FindEntry(handle);
+		return entry ? GetFullPath(entry->Metadata) : std::filesystem::path();
+	}
+
+	void AssetManager::AddDependency(AssetHandle handle, AssetHandle dependency)
+	{
+		AssetEntry* entry = FindEntry(handle);
+		NANO_ENGINE_LOG_ASSERT(entry && IsAssetHandleValid(dependency), "Invalid asset dependency!");
+		NANO_ENGINE_LOG_ASSERT(!DependsOn(dependency, handle), "Asset dependencies can't form a cycle!");
+
+		std::vector<AssetHandle>& dependencies = entry->Metadata.Dependencies;
+		if (std::find(dependencies.begin(), dependencies.end(), dependency) != dependencies.end())
+			return;
+
+		dependencies.push_back(dependency);
+		s_Data->RegistryDirty = true;
+
+		// Loaded assets hold their dependencies from now on
+		if (entry->State == AssetState::Ready)
+		{
+			GetAsset(dependency);
+			FindEntry(dependency)->Dependents++;
+		}
+	}
+
+	Shared<Asset> AssetManager::GetAsset(AssetHandle handle)
+	{
+		AssetEntry* entry = FindEntry(handle);
+		if (!entry)
+			return nullptr;
+
+		if (entry->State == AssetState::NotLoaded || entry->State == AssetState::Loading)
+		{
+			if (!IsLoadable(entry->Metadata.Type))
+			{
+				NANO_ENGINE_LOG_ERROR("Assets of type {} can't be loaded by the asset manager", Utils::AssetTypeToString(entry->Metadata.Type));
+				entry->State = AssetState::Failed;
+				return nullptr;
+			}
+
+			std::shared_ptr<AssetLoadJob> job = entry->Load;
+			if (job && job->Dispatched)
+			{
+				std::unique_lock<std::mutex> lock(job->Mutex);
+				job->Finished.wait(lock, [&] { return job->Done; });
+			}
+			else
+			{
+				// Not started or still queued, the queued job is dropped as stale
+				job = std::make_shared<AssetLoadJob>();
+				job->Handle = handle;
+				job->Type = entry->Metadata.Type;
+				job->Path = GetFullPath(entry->Metadata).string();
+				job->Succeeded = DecodeAsset(*job);
+			}
+
+			FinishLoad(*entry, *job);
+		}
+
+		if (entry->State != AssetState::Ready)
+			return nullptr;
+
+		entry->LastUsed = ++s_Data->UseCounter;
+		return entry->Instance;
+	}
+
+	void AssetManager::RequestLoad(AssetHandle handle)
+	{
+		AssetEntry* entry = FindEntry(handle);
+		if (!entry || entry->State != AssetState::NotLoaded)
+			return;
+
+		if (!IsLoadable(entry->Metadata.Type))
+		{
+			NANO_ENGINE_LOG_ERROR("Assets of type {} can't be loaded by the asset manager", Utils::AssetTypeToString(entry->Metadata.Type));
+			entry->State = AssetState::Failed;
+			return;
+		}
+
+		// Dependencies go first so they're usually ready when the asset is finished
+		for (AssetHandle dependency : entry->Metadata.Dependencies)
+			RequestLoad(dependency);
+
+		auto job = std::make_shared<AssetLoadJob>();
+		job->Handle = handle;
+		job->Type = entry->Metadata.Type;
+		job->Path = GetFullPath(entry->Metadata).string();
+
+		entry->Load = job;
+		entry->State = AssetState::Loading;
+		s_Data->QueuedLoads.push_back(std::move(job));
+
+		DispatchQueuedLoads();
+	}
+
+	void AssetManager::ReloadAsset(AssetHandle handle)
+	{
+		RA_PROFILE_FUNCTION();
+
+		AssetEntry* entry = FindEntry(handle);
+		if (!entry)
+			return;
+
+		switch (entry->State)
+		{
+		case AssetState::Loading:
+			// The running job may have read the old data, it's dropped as stale
+			Unload(*entry);
+			RequestLoad(handle);
+			return;
+		case AssetState::Failed:
+			// Tried again on the next GetAsset
+			entry->State = AssetState::NotLoaded;
+			return;
+		case AssetState::NotLoaded:
+			return;
+		}
+
+		AssetLoadJob job;
+		job.Handle = handle;
+		job.Type = entry->Metadata.Type;
+		job.Path = GetFullPath(entry->Metadata).string();
+		if (!DecodeAsset(job))
+		{
+			NANO_ENGINE_LOG_WARN("Failed to reload asset '{}', keeping the loaded one", job.Path);
+			return;
+		}
+
+		ReloadInstance(*entry, job);
+		entry->Instance->SetFlag(AssetFlag::Missing, false);
+		entry->Instance->SetFlag(AssetFlag::Invalid, false);
+
+		s_Data->CPUBytes -= entry->CPUBytes;
+		s_Data->GPUBytes -= entry->GPUBytes;
+		entry->CPUBytes = entry->Instance->GetCPUMemorySize();
+		entry->GPUBytes = entry->Instance->GetGPUMemorySize();
+		s_Data->CPUBytes += entry->CPUBytes;
+		s_Data->GPUBytes += entry->GPUBytes;
+
+		NANO_ENGINE_LOG_INFO("Reloaded asset '{}'", job.Path);
+	}
+
+	AssetState AssetManager::GetAssetState(AssetHandle handle)
+	{
+		AssetEntry* entry = FindEntry(handle);
+		return entry ? entry->State : AssetState::NotLoaded;
+	}
+
+	void AssetManager::UnloadAsset(AssetHandle handle)
+	{
+		if (AssetEntry* entry = FindEntry(handle))
+			Unload(*entry);
+	}
+
+	void AssetManager::UnloadUnusedAssets()
+	{
+		for (auto& [handle, entry] : s_Data->Assets)
+		{
+			if (entry.State == AssetState::Ready && entry.Dependents == 0 && entry.Instance->GetRefCount() == 1)
+				Unload(entry);
+		}
+	}
+
+	Shared<Texture2D> AssetManager::GetTexture(const std::filesystem::path& filepath)
+	{
+		AssetHandle handle = ImportAsset(filepath);
+		if (!handle)
+			return nullptr;
+
+		if (GetAssetMetadata(handle).Type != AssetType::Texture)
+		{
+			NANO_ENGINE_LOG_WARN("'{}' is not a texture", filepath.string());
+			return nullptr;
+		}
+
+		return GetAsset<Texture2D>(handle);
+	}
+
+	void AssetManager::SyncLoadedAssets()
+	{
+		RA_PROFILE_FUNCTION();
+
+		{
+			std::scoped_lock<std::mutex> lock(s_Data->CompletedMutex);
+			for (std::shared_ptr<AssetLoadJob>& job : s_Data->CompletedLoads)
+			{
+				auto it = std::find(s_Data->LoadsInFlight.begin(), s_Data->LoadsInFlight.end(), job);
+				if (it != s_Data->LoadsInFlight.end())
+					s_Data->LoadsInFlight.erase(it);
+
+				s_Data->PendingUploadBytes += job->CPUBytes;
+				s_Data->PendingUploads.push_back(std::move(job));
+			}
+			s_Data->CompletedLoads.clear();
+		}
+
+		uint64_t uploaded = 0;
+		while (!s_Data->PendingUploads.empty() && (uploaded == 0 || uploaded < s_Data->Budget.UploadBytesPerFrame))
+		{
+			std::shared_ptr<AssetLoadJob> job = std::move(s_Data->PendingUploads.front());
+			s_Data->PendingUploads.pop_front();
+			s_Data->PendingUploadBytes -= job->CPUBytes;
+
+			// Finished by GetAsset or unloaded in the meantime
+			AssetEntry* entry = FindEntry(job->Handle);
+			if (!entry || entry->Load != job)
+				continue;
+
+			FinishLoad(*entry, *job);
+			uploaded += std::max<uint64_t>(job->CPUBytes, 1);
+		}
+
+		DispatchQueuedLoads();
+		EvictToBudget();
+	}
+
+	void AssetManager::SetMemoryBudget(const AssetMemoryBudget& budget)
+	{
+		s_Data->Budget = budget;
+		s_Data->OverBudgetWarned = false;
+	}
+
+	const AssetMemoryBudget& AssetManager::GetMemoryBudget()
+	{
+		return s_Data->Budget;
+	}
+
+	AssetMemoryStats AssetManager::GetMemoryStats()
+	{
+		AssetMemoryStats stats;
+		stats.CPUBytes = s_Data->CPUBytes + s_Data->PendingUploadBytes;
+		stats.GPUBytes = s_Data->GPUBytes;
+		for (const auto& [handle, entry] : s_Data->Assets)
+		{
+			if (entry.State == AssetState::Ready)
+				stats.LoadedAssets++;
+			else if (entry.State == AssetState::Loading)
+				stats.PendingLoads++;
+		}
+		return stats;
+	}
+
+}
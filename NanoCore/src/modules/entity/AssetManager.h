@@ -0,0 +1,111 @@
+#pragma once
+
+#include "core/base/Base.h"
+#include "Asset.h"
+#include "modules/rendering/Texture.h"
+
+#include <filesystem>
+
+namespace NanoCore {
+
+	enum class AssetState : uint8_t
+	{
+		NotLoaded = 0,
+		// Queued or decoding on a worker, or decoded and waiting for its upload
+		Loading,
+		Ready,
+		Failed
+	};
+
+	struct AssetMemoryBudget
+	{
+		// Loaded assets plus decoded data waiting for upload
+		uint64_t CPUBytes = 256ull * 1024 * 1024;
+		uint64_t GPUBytes = 1024ull * 1024 * 1024;
+
+		// Decoded bytes uploaded by one SyncLoadedAssets, the rest waits for the next frame.
+		// At least one asset is uploaded every frame.
+		uint64_t UploadBytesPerFrame = 32ull * 1024 * 1024;
+		uint32_t MaxLoadsInFlight = 64;
+	};
+
+	struct AssetMemoryStats
+	{
+		uint64_t CPUBytes = 0;
+		uint64_t GPUBytes = 0;
+		uint32_t LoadedAssets = 0;
+		uint32_t PendingLoads = 0;
+	};
+
+	// Owns the assets of the active project by handle. Every file is loaded once and shared,
+	// either when first asked for (GetAsset) or in the background (RequestLoad). Assets nothing
+	// outside the manager references anymore stay cached and are unloaded least recently used
+	// first once the memory budget is exceeded.
+	// Main thread only, the manager runs its decoding jobs on the ThreadPool itself.
+	class AssetManager
+	{
+	public:
+		static void Init();
+		static void Shutdown();
+
+		// Registry of the active project at Project::GetAssetRegistryPath(), loaded when
+		// the project becomes active. Saving only writes when handles were added or removed.
+		static bool LoadRegistry();
+		static void SaveRegistry();
+
+		// Registers a file and returns its handle, the existing one if the file is known.
+		// 0 if the extension isn't an asset type.
+		static AssetHandle ImportAsset(const std::filesystem::path& filepath);
+		static void RemoveAsset(AssetHandle handle);
+
+		static AssetHandle GetAssetHandle(const std::filesystem::path& filepath);
+		static bool IsAssetHandleValid(AssetHandle handle);
+		static const AssetMetadata& GetAssetMetadata(AssetHandle handle);
+		static std::filesystem::path GetFileSystemPath(AssetHandle handle);
+
+		// Dependencies are loaded before the asset and aren't evicted while it is loaded
+		static void AddDependency(AssetHandle handle, AssetHandle dependency);
+
+		// Loads on the calling thread unless the asset is ready, waits for a load already
+		// running on a worker. Null if the asset can't be loaded.
+		static Shared<Asset> GetAsset(AssetHandle handle);
+
+		template<typename T>
+		static Shared<T> GetAsset(AssetHandle handle)
+		{
+			Shared<Asset> asset = GetAsset(handle);
+			if (!dynamic_cast<T*>(asset.Raw()))
+				return nullptr;
+
+			return asset.As<T>();
+		}
+
+		// Starts loading the asset and its dependencies in the background, the result is
+		// picked up by SyncLoadedAssets
+		static void RequestLoad(AssetHandle handle);
+		static AssetState GetAssetState(AssetHandle handle);
+		static bool IsAssetLoaded(AssetHandle handle) { return GetAssetState(handle) == AssetState::Ready; }
+
+		// Loads the asset again from its current file into the instance everyone holds.
+		// The import pipeline calls it for assets whose source changed.
+		static void ReloadAsset(AssetHandle handle);
+
+		// Drops the manager's reference, the asset lives on in whoever still holds it
+		static void UnloadAsset(AssetHandle handle);
+		// Unloads every asset only the manager references
+		static void UnloadUnusedAssets();
+
+		// Texture of an image file, imported on first use. Files that can't be decoded give an
+		// unloaded texture flagged Missing or Invalid, like Texture2D::Create(path) does.
+		static Shared<Texture2D> GetTexture(const std::filesystem::path& filepath);
+
+		// Uploads finished background loads, starts queued ones and evicts down to the budget.
+		// Called once per frame.
+		static void SyncLoadedAssets();
+
+		static void SetMemoryBudget(const AssetMemoryBudget& budget);
+		static const AssetMemoryBudget& GetMemoryBudget();
+		static AssetMemoryStats GetMemoryStats();
+	};
+
+}
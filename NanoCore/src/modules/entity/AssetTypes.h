@@ -1,7 +1,8 @@
 #pragma once
+#include <algorithm>
 #include <string>
-#include "core/log/log.h"
-#include "Core/base/Base.h"
+#include "core/log/Log.h"
+#include "core/base/Base.h"
 
 namespace NanoCore {
 
@@ -85,5 +86,21 @@ namespace NanoCore {
 			return "None";
 		}
 
+		inline AssetType AssetTypeFromExtension(std::string extension)
+		{
+			std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower(c); });
+
+			if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp")
+				return AssetType::Texture;
+			if (extension == ".nanocore" || extension == ".nanoscene")
+				return AssetType::Scene;
+			if (extension == ".ttf")
+				return AssetType::Font;
+			if (extension == ".cs")
+				return AssetType::Script;
+
+			return AssetType::None;
+		}
+
 	}
 }
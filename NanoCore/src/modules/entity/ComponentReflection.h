@@ -0,0 +1,313 @@
+#pragma once
+
+#include "Components.h"
+#include "modules/utils/Hash.h"
+
+#include <array>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace NanoCore {
+
+	// One serialized member of a component. Plain fields read and write the member,
+	// properties go through accessors for state that lives behind setters.
+	template<typename Component, typename T>
+	struct ReflectedField
+	{
+		using ComponentType = Component;
+		using ValueType = T;
+
+		std::string_view Name;
+		T Component::* Member = nullptr;
+		T(*Getter)(const Component&) = nullptr;
+		void(*Setter)(Component&, const T&) = nullptr;
+
+		// Nested YAML map the field is written under, empty to write it directly
+		std::string_view Group;
+
+		// Editor drag speed and limits, Min == Max means unbounded
+		float Speed = 0.1f;
+		float Min = 0.0f;
+		float Max = 0.0f;
+
+		T Get(const Component& component) const
+		{
+			return Member ? component.*Member : Getter(component);
+		}
+
+		void Set(Component& component, const T& value) const
+		{
+			if (Member)
+				component.*Member = value;
+			else
+				Setter(component, value);
+		}
+
+		constexpr ReflectedField InGroup(std::string_view group) const
+		{
+			ReflectedField field = *this;
+			field.Group = group;
+			return field;
+		}
+
+		constexpr ReflectedField Range(float min, float max, float speed) const
+		{
+			ReflectedField field = *this;
+			field.Min = min;
+			field.Max = max;
+			field.Speed = speed;
+			return field;
+		}
+	};
+
+	template<typename Component, typename T>
+	constexpr ReflectedField<Component, T> Field(std::string_view name, T Component::* member)
+	{
+		return { name, member };
+	}
+
+	// Template arguments have to be spelled out so capture-less lambdas convert to the accessors
+	template<typename Component, typename T>
+	constexpr ReflectedField<Component, T> Property(std::string_view name, T(*getter)(const Component&), void(*setter)(Component&, const T&))
+	{
+		return { name, nullptr, getter, setter };
+	}
+
+	// Names of enum values, indexed by the underlying value
+	template<typename Enum>
+	struct EnumReflection;
+
+	template<>
+	struct EnumReflection<SceneCamera::ProjectionType>
+	{
+		static constexpr std::array<std::string_view, 2> Names = { "Perspective", "Orthographic" };
+	};
+
+	template<>
+	struct EnumReflection<Rigidbody2DComponent::BodyType>
+	{
+		static constexpr std::array<std::string_view, 3> Names = { "Static", "Dynamic", "Kinematic" };
+	};
+
+	template<typename Enum>
+	std::string_view EnumToString(Enum value)
+	{
+		const auto& names = EnumReflection<Enum>::Names;
+		return (size_t)value < names.size() ? names[(size_t)value] : std::string_view();
+	}
+
+	template<typename Enum>
+	bool EnumFromString(std::string_view name, Enum& value)
+	{
+		const auto& names = EnumReflection<Enum>::Names;
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			if (names[i] == name)
+			{
+				value = (Enum)i;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Specialized once per component: the serialized name, the editor name and the fields.
+	// Serializers, copies, script registration and editor widgets are generated from these.
+	template<typename Component>
+	struct ComponentReflection;
+
+	template<>
+	struct ComponentReflection<TagComponent>
+	{
+		static constexpr std::string_view Name = "TagComponent";
+		static constexpr std::string_view DisplayName = "Tag";
+		static constexpr auto Fields = std::make_tuple(
+			Field("Tag", &TagComponent::Tag));
+	};
+
+	template<>
+	struct ComponentReflection<TransformComponent>
+	{
+		static constexpr std::string_view Name = "TransformComponent";
+		static constexpr std::string_view DisplayName = "Transform";
+		static constexpr auto Fields = std::make_tuple(
+			Field("Translation", &TransformComponent::Translation),
+			Field("Rotation", &TransformComponent::Rotation),
+			Field("Scale", &TransformComponent::Scale));
+	};
+
+	template<>
+	struct ComponentReflection<CameraComponent>
+	{
+		static constexpr std::string_view Name = "CameraComponent";
+		static constexpr std::string_view DisplayName = "Camera";
+		static constexpr auto Fields = std::make_tuple(
+			Property<CameraComponent, SceneCamera::ProjectionType>("ProjectionType",
+				[](const CameraComponent& cc) { return cc.Camera.GetProjectionType(); },
+				[](CameraComponent& cc, const SceneCamera::ProjectionType& type) { cc.Camera.SetProjectionType(type); }).InGroup("Camera"),
+			Property<CameraComponent, float>("PerspectiveFOV",
+				[](const CameraComponent& cc) { return cc.Camera.GetPerspectiveVerticalFOV(); },
+				[](CameraComponent& cc, const float& fov) { cc.Camera.SetPerspectiveVerticalFOV(fov); }).InGroup("Camera"),
+			Property<CameraComponent, float>("PerspectiveNear",
+				[](const CameraComponent& cc) { return cc.Camera.GetPerspectiveNearClip(); },
+				[](CameraComponent& cc, const float& nearClip) { cc.Camera.SetPerspectiveNearClip(nearClip); }).InGroup("Camera"),
+			Property<CameraComponent, float>("PerspectiveFar",
+				[](const CameraComponent& cc) { return cc.Camera.GetPerspectiveFarClip(); },
+				[](CameraComponent& cc, const float& farClip) { cc.Camera.SetPerspectiveFarClip(farClip); }).InGroup("Camera"),
+			Property<CameraComponent, float>("OrthographicSize",
+				[](const CameraComponent& cc) { return cc.Camera.GetOrthographicSize(); },
+				[](CameraComponent& cc, const float& size) { cc.Camera.SetOrthographicSize(size); }).InGroup("Camera"),
+			Property<CameraComponent, float>("OrthographicNear",
+				[](const CameraComponent& cc) { return cc.Camera.GetOrthographicNearClip(); },
+				[](CameraComponent& cc, const float& nearClip) { cc.Camera.SetOrthographicNearClip(nearClip); }).InGroup("Camera"),
+			Property<CameraComponent, float>("OrthographicFar",
+				[](const CameraComponent& cc) { return cc.Camera.GetOrthographicFarClip(); },
+				[](CameraComponent& cc, const float& farClip) { cc.Camera.SetOrthographicFarClip(farClip); }).InGroup("Camera"),
+			Field("Primary", &CameraComponent::Primary),
+			Field("FixedAspectRatio", &CameraComponent::FixedAspectRatio));
+	};
+
+	template<>
+	struct ComponentReflection<SpriteRendererComponent>
+	{
+		static constexpr std::string_view Name = "SpriteRendererComponent";
+		static constexpr std::string_view DisplayName = "Sprite Renderer";
+		static constexpr auto Fields = std::make_tuple(
+			Field("Color", &SpriteRendererComponent::Color),
+			// Stored as the texture path
+			Field("TexturePath", &SpriteRendererComponent::Texture),
+			Field("TilingFactor", &SpriteRendererComponent::TilingFactor).Range(0.0f, 100.0f, 0.1f));
+	};
+
+	template<>
+	struct ComponentReflection<CircleRendererComponent>
+	{
+		static constexpr std::string_view Name = "CircleRendererComponent";
+		static constexpr std::string_view DisplayName = "Circle Renderer";
+		static constexpr auto Fields = std::make_tuple(
+			Field("Color", &CircleRendererComponent::Color),
+			Field("Thickness", &CircleRendererComponent::Thickness).Range(0.0f, 1.0f, 0.025f),
+			Field("Fade", &CircleRendererComponent::Fade).Range(0.0f, 1.0f, 0.00025f));
+	};
+
+	template<>
+	struct ComponentReflection<TextComponent>
+	{
+		static constexpr std::string_view Name = "TextComponent";
+		static constexpr std::string_view DisplayName = "Text";
+		static constexpr auto Fields = std::make_tuple(
+			Field("TextString", &TextComponent::TextString),
+			Field("FontHandle", &TextComponent::FontHandle),
+			Field("Color", &TextComponent::Color),
+			Field("LineSpacing", &TextComponent::LineSpacing).Range(0.0f, 0.0f, 0.025f),
+			Field("Kerning", &TextComponent::Kerning).Range(0.0f, 0.0f, 0.025f),
+			Field("MaxWidth", &TextComponent::MaxWidth).Range(0.0f, 0.0f, 0.025f));
+	};
+
+	template<>
+	struct ComponentReflection<PrefabComponent>
+	{
+		static constexpr std::string_view Name = "PrefabComponent";
+		static constexpr std::string_view DisplayName = "Prefab";
+		static constexpr auto Fields = std::make_tuple(
+			Field("PrefabID", &PrefabComponent::PrefabID),
+			Field("EntityID", &PrefabComponent::EntityID));
+	};
+
+	template<>
+	struct ComponentReflection<RelationshipComponent>
+	{
+		static constexpr std::string_view Name = "RelationshipComponent";
+		static constexpr std::string_view DisplayName = "Relationship";
+		static constexpr auto Fields = std::make_tuple(
+			Field("Parent", &RelationshipComponent::ParentHandle),
+			Field("Children", &RelationshipComponent::Children));
+	};
+
+	template<>
+	struct ComponentReflection<Rigidbody2DComponent>
+	{
+		static constexpr std::string_view Name = "Rigidbody2DComponent";
+		static constexpr std::string_view DisplayName = "Rigidbody 2D";
+		static constexpr auto Fields = std::make_tuple(
+			Field("BodyType", &Rigidbody2DComponent::Type),
+			Field("FixedRotation", &Rigidbody2DComponent::FixedRotation));
+	};
+
+	template<>
+	struct ComponentReflection<BoxCollider2DComponent>
+	{
+		static constexpr std::string_view Name = "BoxCollider2DComponent";
+		static constexpr std::string_view DisplayName = "Box Collider 2D";
+		static constexpr auto Fields = std::make_tuple(
+			Field("Offset", &BoxCollider2DComponent::Offset),
+			Field("Size", &BoxCollider2DComponent::Size),
+			Field("Density", &BoxCollider2DComponent::Density).Range(0.0f, 1.0f, 0.01f),
+			Field("Friction", &BoxCollider2DComponent::Friction).Range(0.0f, 1.0f, 0.01f),
+			Field("Restitution", &BoxCollider2DComponent::Restitution).Range(0.0f, 1.0f, 0.01f),
+			Field("RestitutionThreshold", &BoxCollider2DComponent::RestitutionThreshold).Range(0.0f, 0.0f, 0.01f));
+	};
+
+	template<>
+	struct ComponentReflection<CircleCollider2DComponent>
+	{
+		static constexpr std::string_view Name = "CircleCollider2DComponent";
+		static constexpr std::string_view DisplayName = "Circle Collider 2D";
+		static constexpr auto Fields = std::make_tuple(
+			Field("Offset", &CircleCollider2DComponent::Offset),
+			Field("Radius", &CircleCollider2DComponent::Radius),
+			Field("Density", &CircleCollider2DComponent::Density).Range(0.0f, 1.0f, 0.01f),
+			Field("Friction", &CircleCollider2DComponent::Friction).Range(0.0f, 1.0f, 0.01f),
+			Field("Restitution", &CircleCollider2DComponent::Restitution).Range(0.0f, 1.0f, 0.01f),
+			Field("RestitutionThreshold", &CircleCollider2DComponent::RestitutionThreshold).Range(0.0f, 0.0f, 0.01f));
+	};
+
+	// Everything that is serialized through reflection, in file order.
+	// IDComponent and ScriptComponent are written by hand.
+	using ReflectedComponents =
+		ComponentGroup<TagComponent, TransformComponent, CameraComponent,
+		SpriteRendererComponent, CircleRendererComponent, TextComponent,
+		PrefabComponent, RelationshipComponent,
+		Rigidbody2DComponent, BoxCollider2DComponent, CircleCollider2DComponent>;
+
+	template<typename T>
+	struct TypeTag
+	{
+		using Type = T;
+	};
+
+	template<typename... Component, typename Fn>
+	void ForEachComponentType(ComponentGroup<Component...>, Fn&& fn)
+	{
+		(fn(TypeTag<Component>{}), ...);
+	}
+
+	template<typename Component, typename Fn>
+	void ForEachField(Fn&& fn)
+	{
+		std::apply([&](const auto&... fields) { (fn(fields), ...); }, ComponentReflection<Component>::Fields);
+	}
+
+	template<typename Component>
+	constexpr uint32_t GetComponentTypeID()
+	{
+		return Hash::GenerateFNVHash(ComponentReflection<Component>::Name);
+	}
+
+	template<typename T, typename... Component>
+	constexpr bool ComponentGroupContains(ComponentGroup<Component...>)
+	{
+		return (std::is_same_v<T, Component> || ...);
+	}
+
+	// Tags are copied together with the entity identity, everything else has to be in AllComponents
+	template<typename... Component>
+	constexpr bool AreReflectedComponentsCopied(ComponentGroup<Component...>)
+	{
+		return ((std::is_same_v<Component, TagComponent> || ComponentGroupContains<Component>(AllComponents{})) && ...);
+	}
+
+	static_assert(AreReflectedComponentsCopied(ReflectedComponents{}), "A reflected component is missing from AllComponents!");
+
+}
@@ -214,9 +214,34 @@ namespace NanoCore{
 			: ScriptClassHandle(scriptClassHandle) {}
 	};
 
+	// Components copied by Scene::Copy and DuplicateEntity. ComponentReflection.h
+	// checks at compile time that every reflected component is listed here.
 	using AllComponents =
 		ComponentGroup<TransformComponent, SpriteRendererComponent,
 		CircleRendererComponent, CameraComponent, NativeScriptComponent,
+		TextComponent, PrefabComponent, RelationshipComponent,
 		Rigidbody2DComponent, BoxCollider2DComponent, CircleCollider2DComponent>;
 
+	template<typename... A, typename... B>
+	ComponentGroup<A..., B...> JoinComponentGroups(ComponentGroup<A...>, ComponentGroup<B...>);
+
+	// Components Scene change tracking tells apart, each gets one bit of the dirty mask
+	using ChangeTrackedComponents = decltype(JoinComponentGroups(ComponentGroup<IDComponent, TagComponent, ScriptComponent>{}, AllComponents{}));
+
+	template<typename T, typename... Component>
+	constexpr uint64_t GetComponentBit(ComponentGroup<Component...>)
+	{
+		static_assert(sizeof...(Component) <= 64);
+
+		uint64_t bit = 1, result = 0;
+		((result |= std::is_same_v<T, Component> ? bit : 0, bit <<= 1), ...);
+		return result;
+	}
+
+	template<typename T>
+	constexpr uint64_t GetDirtyBit()
+	{
+		return GetComponentBit<T>(ChangeTrackedComponents{});
+	}
+
 }
\ No newline at end of file
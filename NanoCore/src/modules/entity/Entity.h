@@ -52,6 +52,15 @@ namespace NanoCore{
 			m_Scene->m_Registry.remove<T>(m_EntityHandle);
 		}
 
+		// Reports an edit made through a component reference to the registry's on_update
+		// listeners, the scene's change tracking and the running physics world among them
+		template<typename T>
+		void PatchComponent()
+		{
+			NANO_ENGINE_LOG_ASSERT(HasComponent<T>(), "Entity does not have component!");
+			m_Scene->m_Registry.patch<T>(m_EntityHandle);
+		}
+
 		operator bool() const { return m_EntityHandle != entt::null; }
 		operator entt::entity() const { return m_EntityHandle; }
 		operator uint32_t() const { return (uint32_t)m_EntityHandle; }
@@ -7,58 +7,115 @@
 
 #include "modules/script/ScriptEngine.h"
 #include "modules/utils/RenderUtils.h"
+#include "modules/info/Project.h"
 
 #include <glm/glm.hpp>
 
 #include "Entity.h"
 
-// Box2D
-#include "box2d/b2_world.h"
-#include "box2d/b2_body.h"
-#include "box2d/b2_fixture.h"
-#include "box2d/b2_polygon_shape.h"
-#include "box2d/b2_circle_shape.h"
+#include "modules/physics/PhysicsWorld2D.h"
 
 namespace NanoCore{
 
-	static b2BodyType Rigidbody2DTypeToBox2DBody(Rigidbody2DComponent::BodyType bodyType)
+	Scene::Scene()
 	{
-		switch (bodyType)
-		{
-		case Rigidbody2DComponent::BodyType::Static:    return b2_staticBody;
-		case Rigidbody2DComponent::BodyType::Dynamic:   return b2_dynamicBody;
-		case Rigidbody2DComponent::BodyType::Kinematic: return b2_kinematicBody;
-		}
+		// The sprite group owns transform storage and reorders it when sprites come and go
+		m_Registry.on_construct<TransformComponent>().connect<&Scene::OnTransformStorageChanged>(*this);
+		m_Registry.on_destroy<TransformComponent>().connect<&Scene::OnTransformStorageChanged>(*this);
+		m_Registry.on_construct<SpriteRendererComponent>().connect<&Scene::OnTransformStorageChanged>(*this);
+		m_Registry.on_destroy<SpriteRendererComponent>().connect<&Scene::OnTransformStorageChanged>(*this);
+	}
 
-		NANO_ENGINE_LOG_ASSERT(false, "Unknown body type");
-		return b2_staticBody;
+	Scene::~Scene()
+	{
 	}
 
-	Scene::Scene()
+	template<typename... Component>
+	void Scene::ConnectChangeTracking(ComponentGroup<Component...>)
 	{
+		([&]()
+			{
+				m_Registry.on_construct<Component>().template connect<&Scene::OnTrackedComponentChanged<Component>>(*this);
+				m_Registry.on_update<Component>().template connect<&Scene::OnTrackedComponentChanged<Component>>(*this);
+				m_Registry.on_destroy<Component>().template connect<&Scene::OnTrackedComponentChanged<Component>>(*this);
+			}(), ...);
 	}
 
-	Scene::~Scene()
+	void Scene::EnableChangeTracking()
 	{
-		delete m_PhysicsWorld;
+		if (m_ChangeTrackingEnabled)
+			return;
+
+		m_ChangeTrackingEnabled = true;
+		ConnectChangeTracking(ChangeTrackedComponents{});
+		m_Registry.on_destroy<IDComponent>().connect<&Scene::OnTrackedEntityDestroyed>(*this);
+	}
+
+	template<typename Component>
+	void Scene::OnTrackedComponentChanged(entt::registry& registry, entt::entity entity)
+	{
+		m_DirtyEntities[entity] |= GetDirtyBit<Component>();
+	}
+
+	void Scene::OnTrackedEntityDestroyed(entt::registry& registry, entt::entity entity)
+	{
+		// Components destroyed after the ID mark the handle dirty again, TakeChanges() skips it
+		m_DestroyedEntities.insert(registry.get<IDComponent>(entity).ID);
+		m_DirtyEntities.erase(entity);
+	}
+
+	void Scene::MarkDirty(entt::entity entity, uint64_t componentMask)
+	{
+		if (m_ChangeTrackingEnabled)
+			m_DirtyEntities[entity] |= componentMask;
+	}
+
+	SceneChanges Scene::TakeChanges()
+	{
+		SceneChanges changes;
+		changes.Dirty.reserve(m_DirtyEntities.size());
+		for (auto [entity, mask] : m_DirtyEntities)
+		{
+			if (!m_Registry.valid(entity) || !m_Registry.has<IDComponent>(entity))
+				continue;
+
+			UUID uuid = m_Registry.get<IDComponent>(entity).ID;
+			changes.Dirty[uuid] |= mask;
+		}
+
+		// An entity destroyed and created again under the same UUID is just dirty
+		for (UUID uuid : m_DestroyedEntities)
+		{
+			if (changes.Dirty.find(uuid) == changes.Dirty.end())
+				changes.Destroyed.insert(uuid);
+		}
+
+		m_DirtyEntities.clear();
+		m_DestroyedEntities.clear();
+		return changes;
 	}
 
 	template<typename... Component>
-	static void CopyComponent(entt::registry& dst, entt::registry& src, const std::unordered_map<UUID, entt::entity>& enttMap)
+	static void CopyComponentStorage(entt::registry& dst, const entt::registry& src)
 	{
 		([&]()
 			{
-				auto view = src.view<Component>();
-				for (auto srcEntity : view)
-				{
-					entt::entity dstEntity = enttMap.at(src.get<IDComponent>(srcEntity).ID);
+				const size_t count = src.size<Component>();
+				if (count == 0)
+					return;
 
-					auto& srcComponent = src.get<Component>(srcEntity);
-					dst.emplace_or_replace<Component>(dstEntity, srcComponent);
-				}
+				const entt::entity* entities = src.data<Component>();
+				const Component* components = src.raw<Component>();
+				dst.insert<Component>(entities, entities + count, components, components + count);
 			}(), ...);
 	}
 
+	template<typename... Component>
+	static void CopyComponentStorage(ComponentGroup<Component...>, entt::registry& dst, const entt::registry& src)
+	{
+		CopyComponentStorage<Component...>(dst, src);
+	}
+
 	Entity Scene::FindEntityByName(std::string_view name)
 	{
 		auto view = m_Registry.view<TagComponent>();
@@ -71,12 +128,6 @@ namespace NanoCore{
 		return {};
 	}
 
-	template<typename... Component>
-	static void CopyComponent(ComponentGroup<Component...>, entt::registry& dst, entt::registry& src, const std::unordered_map<UUID, entt::entity>& enttMap)
-	{
-		CopyComponent<Component...>(dst, src, enttMap);
-	}
-
 	template<typename... Component>
 	static void CopyComponentIfExists(Entity dst, Entity src)
 	{
@@ -95,27 +146,27 @@ namespace NanoCore{
 
 	Shared<Scene> Scene::Copy(Shared<Scene> other)
 	{
+		RA_PROFILE_FUNCTION();
+
 		Shared<Scene> newScene = Shared<Scene>::Create();
 
 		newScene->m_ViewportWidth = other->m_ViewportWidth;
 		newScene->m_ViewportHeight = other->m_ViewportHeight;
 
-		auto& srcSceneRegistry = other->m_Registry;
+		const auto& srcSceneRegistry = other->m_Registry;
 		auto& dstSceneRegistry = newScene->m_Registry;
-		std::unordered_map<UUID, entt::entity> enttMap;
 
-		// Create entities in new scene
-		auto idView = srcSceneRegistry.view<IDComponent>();
-		for (auto e : idView)
-		{
-			UUID uuid = srcSceneRegistry.get<IDComponent>(e).ID;
-			const auto& name = srcSceneRegistry.get<TagComponent>(e).Tag;
-			Entity newEntity = newScene->CreateEntityWithUUID(uuid, name);
-			enttMap[uuid] = (entt::entity)newEntity;
-		}
+		// Clone the entity pool as is so every entity keeps its identifier,
+		// then copy each component storage in one bulk insert
+		dstSceneRegistry.assign(srcSceneRegistry.data(), srcSceneRegistry.data() + srcSceneRegistry.size());
+
+		CopyComponentStorage<IDComponent, TagComponent, ScriptComponent>(dstSceneRegistry, srcSceneRegistry);
+		CopyComponentStorage(AllComponents{}, dstSceneRegistry, srcSceneRegistry);
 
-		// Copy components (except IDComponent and TagComponent)
-		CopyComponent(AllComponents{}, dstSceneRegistry, srcSceneRegistry, enttMap);
+		// Identifiers are preserved, so the UUID lookup carries over unchanged
+		newScene->m_EntityMap = other->m_EntityMap;
+
+		newScene->BuildPhysics2DSnapshot();
 
 		return newScene;
 	}
@@ -142,13 +193,17 @@ namespace NanoCore{
 
 	void Scene::DestroyEntity(Entity entity)
 	{
-		m_Registry.destroy(entity);
+		if (m_IsRunning && entity.HasComponent<ScriptComponent>())
+			ScriptEngine::OnDestroyEntity(entity);
+
 		m_EntityMap.erase(entity.GetUUID());
+		m_Registry.destroy(entity);
 	}
 
 	void Scene::OnRuntimeStart()
 	{
 		m_IsRunning = true;
+		UpdateFixedStepSettings();
 		OnPhysics2DStart();
 
 		// Scripting
@@ -168,11 +223,13 @@ namespace NanoCore{
 	void Scene::OnRuntimeStop()
 	{
 		m_IsRunning = false;
+		ScriptEngine::OnRuntimeStop();
 		OnPhysics2DStop();
 	}
 
 	void Scene::OnSimulationStart()
 	{
+		UpdateFixedStepSettings();
 		OnPhysics2DStart();
 	}
 
@@ -186,12 +243,7 @@ namespace NanoCore{
 		// Update scripts
 		{
 			// C# Entity OnUpdate
-			auto view = m_Registry.view<ScriptComponent>();
-			for (auto e : view)
-			{
-				Entity entity = { e, this };
-				ScriptEngine::OnUpdateEntity(entity, ts);
-			}
+			ScriptEngine::OnUpdate(ts);
 
 			m_Registry.view<NativeScriptComponent>().each([=](auto entity, auto& nsc)
 				{
@@ -207,27 +259,8 @@ namespace NanoCore{
 				});
 		}
 
-		// Physics
-		{
-			const int32_t velocityIterations = 6;
-			const int32_t positionIterations = 2;
-			m_PhysicsWorld->Step(ts, velocityIterations, positionIterations);
-
-			// Retrieve transform from Box2D
-			auto view = m_Registry.view<Rigidbody2DComponent>();
-			for (auto e : view)
-			{
-				Entity entity = { e, this };
-				auto& transform = entity.GetComponent<TransformComponent>();
-				auto& rb2d = entity.GetComponent<Rigidbody2DComponent>();
-
-				b2Body* body = (b2Body*)rb2d.RuntimeBody;
-				const auto& position = body->GetPosition();
-				transform.Translation.x = position.x;
-				transform.Translation.y = position.y;
-				transform.Rotation.z = body->GetAngle();
-			}
-		}
+		// Scripts OnFixedUpdate and physics
+		OnFixedUpdate(ts, true);
 
 		// Render 2D
 		Camera* mainCamera = nullptr;
@@ -281,29 +314,68 @@ namespace NanoCore{
 	void Scene::OnUpdateSimulation(Timestep ts, EditorCamera& camera)
 	{
 		// Physics
+		OnFixedUpdate(ts, false);
+
+		// Render
+		RenderScene(camera);
+	}
+
+	void Scene::UpdateFixedStepSettings()
+	{
+		m_FixedTimeAccumulator = 0.0f;
+
+		Shared<Project> project = Project::GetActive();
+		if (!project)
+			return;
+
+		const ProjectConfig& config = project->GetConfig();
+		m_FixedTimestep = 1.0f / (float)std::max(config.FixedStepRate, 1);
+		m_MaxFixedStepsPerFrame = (uint32_t)std::max(config.MaxFixedStepsPerFrame, 1);
+	}
+
+	void Scene::OnFixedUpdate(Timestep ts, bool updateScripts)
+	{
+		RA_PROFILE_FUNCTION();
+
+		// Collect the steps kicked off last frame before anything touches the world again
+		m_PhysicsWorld->WaitForSimulation();
+
+		m_FixedTimeAccumulator += ts;
+
+		uint32_t steps = 0;
+		while (m_FixedTimeAccumulator >= m_FixedTimestep)
 		{
-			const int32_t velocityIterations = 6;
-			const int32_t positionIterations = 2;
-			m_PhysicsWorld->Step(ts, velocityIterations, positionIterations);
+			// Spiral of death guard: drop the backlog instead of falling further behind
+			if (steps == m_MaxFixedStepsPerFrame)
+			{
+				m_FixedTimeAccumulator = std::fmod(m_FixedTimeAccumulator, m_FixedTimestep);
+				break;
+			}
 
-			// Retrieve transform from Box2D
-			auto view = m_Registry.view<Rigidbody2DComponent>();
-			for (auto e : view)
+			if (updateScripts)
 			{
-				Entity entity = { e, this };
-				auto& transform = entity.GetComponent<TransformComponent>();
-				auto& rb2d = entity.GetComponent<Rigidbody2DComponent>();
-
-				b2Body* body = (b2Body*)rb2d.RuntimeBody;
-				const auto& position = body->GetPosition();
-				transform.Translation.x = position.x;
-				transform.Translation.y = position.y;
-				transform.Rotation.z = body->GetAngle();
+				ScriptEngine::OnFixedUpdate(m_FixedTimestep);
+
+				m_Registry.view<NativeScriptComponent>().each([=](auto entity, auto& nsc)
+					{
+						if (nsc.Instance)
+							nsc.Instance->OnFixedUpdate(m_FixedTimestep);
+					});
 			}
+
+			if (!m_PhysicsWorld->IsPipelined())
+				m_PhysicsWorld->Step(m_FixedTimestep);
+
+			m_FixedTimeAccumulator -= m_FixedTimestep;
+			steps++;
 		}
 
-		// Render
-		RenderScene(camera);
+		// These steps overlap with rendering this frame and are picked up by the next one
+		if (m_PhysicsWorld->IsPipelined())
+			m_PhysicsWorld->StepAsync(m_FixedTimestep, steps);
+
+		// Render between the last two fixed steps by the fraction of a step still pending
+		m_PhysicsWorld->WriteTransforms(m_FixedTimeAccumulator / m_FixedTimestep);
 	}
 
 	void Scene::OnUpdateEditor(Timestep ts, EditorCamera& camera)
@@ -345,6 +417,14 @@ namespace NanoCore{
 		CopyComponentIfExists(AllComponents{}, newEntity, entity);
 	}
 
+	Entity Scene::CopyEntityTo(Entity entity, Scene& target)
+	{
+		Entity newEntity = target.CreateEntityWithUUID(entity.GetUUID(), entity.GetName());
+		CopyComponentIfExists<ScriptComponent>(newEntity, entity);
+		CopyComponentIfExists(AllComponents{}, newEntity, entity);
+		return newEntity;
+	}
+
 	Entity Scene::GetEntityByUUID(UUID uuid)
 	{
 		// TODO(Yan): Maybe should be assert
@@ -359,65 +439,41 @@ namespace NanoCore{
 	{
 	}
 
-	void Scene::OnPhysics2DStart()
+	void Scene::BuildPhysics2DSnapshot()
 	{
-		m_PhysicsWorld = new b2World({ 0.0f, -9.8f });
+		RA_PROFILE_FUNCTION();
+
+		m_PhysicsSnapshot = std::make_unique<Physics2DSnapshot>();
+		auto& bodies = m_PhysicsSnapshot->Bodies;
 
 		auto view = m_Registry.view<Rigidbody2DComponent>();
+		bodies.reserve(view.size());
 		for (auto e : view)
-		{
-			Entity entity = { e, this };
-			auto& transform = entity.GetComponent<TransformComponent>();
-			auto& rb2d = entity.GetComponent<Rigidbody2DComponent>();
+			PhysicsWorld2D::BuildBodySnapshot(m_Registry, e, bodies.emplace_back());
+	}
 
-			b2BodyDef bodyDef;
-			bodyDef.type = Rigidbody2DTypeToBox2DBody(rb2d.Type);
-			bodyDef.position.Set(transform.Translation.x, transform.Translation.y);
-			bodyDef.angle = transform.Rotation.z;
+	void Scene::OnPhysics2DStart()
+	{
+		RA_PROFILE_FUNCTION();
 
-			b2Body* body = m_PhysicsWorld->CreateBody(&bodyDef);
-			body->SetFixedRotation(rb2d.FixedRotation);
-			rb2d.RuntimeBody = body;
+		if (!m_PhysicsSnapshot)
+			BuildPhysics2DSnapshot();
 
-			if (entity.HasComponent<BoxCollider2DComponent>())
-			{
-				auto& bc2d = entity.GetComponent<BoxCollider2DComponent>();
-
-				b2PolygonShape boxShape;
-				boxShape.SetAsBox(bc2d.Size.x * transform.Scale.x, bc2d.Size.y * transform.Scale.y);
-
-				b2FixtureDef fixtureDef;
-				fixtureDef.shape = &boxShape;
-				fixtureDef.density = bc2d.Density;
-				fixtureDef.friction = bc2d.Friction;
-				fixtureDef.restitution = bc2d.Restitution;
-				fixtureDef.restitutionThreshold = bc2d.RestitutionThreshold;
-				body->CreateFixture(&fixtureDef);
-			}
+		bool pipelined = false;
+		if (Shared<Project> project = Project::GetActive())
+			pipelined = project->GetConfig().PipelinedPhysics;
 
-			if (entity.HasComponent<CircleCollider2DComponent>())
-			{
-				auto& cc2d = entity.GetComponent<CircleCollider2DComponent>();
-
-				b2CircleShape circleShape;
-				circleShape.m_p.Set(cc2d.Offset.x, cc2d.Offset.y);
-				circleShape.m_radius = transform.Scale.x * cc2d.Radius;
-
-				b2FixtureDef fixtureDef;
-				fixtureDef.shape = &circleShape;
-				fixtureDef.density = cc2d.Density;
-				fixtureDef.friction = cc2d.Friction;
-				fixtureDef.restitution = cc2d.Restitution;
-				fixtureDef.restitutionThreshold = cc2d.RestitutionThreshold;
-				body->CreateFixture(&fixtureDef);
-			}
-		}
+		// The sprite group owns transform storage and sorts it when first built,
+		// build it now so that sort can't invalidate the physics transform cache
+		m_Registry.group<TransformComponent>(entt::get<SpriteRendererComponent>);
+
+		m_PhysicsWorld = std::make_unique<PhysicsWorld2D>(m_Registry, glm::vec2{ 0.0f, -9.8f }, pipelined);
+		m_PhysicsWorld->CreateBodies(*m_PhysicsSnapshot);
 	}
 
 	void Scene::OnPhysics2DStop()
 	{
-		delete m_PhysicsWorld;
-		m_PhysicsWorld = nullptr;
+		m_PhysicsWorld.reset();
 	}
 
 	void Scene::RenderScene(EditorCamera& camera)
@@ -492,6 +548,21 @@ namespace NanoCore{
 	{
 	}
 
+	template<>
+	void Scene::OnComponentAdded<TextComponent>(Entity entity, TextComponent& component)
+	{
+	}
+
+	template<>
+	void Scene::OnComponentAdded<PrefabComponent>(Entity entity, PrefabComponent& component)
+	{
+	}
+
+	template<>
+	void Scene::OnComponentAdded<RelationshipComponent>(Entity entity, RelationshipComponent& component)
+	{
+	}
+
 	template<>
 	void Scene::OnComponentAdded<Rigidbody2DComponent>(Entity entity, Rigidbody2DComponent& component)
 	{
@@ -6,11 +6,25 @@
 
 #include "entt/entt.hpp"
 
-class b2World;
+#include <unordered_set>
 
 namespace NanoCore{
 
 	class Entity;
+	class PhysicsWorld2D;
+	template<typename... Component>
+	struct ComponentGroup;
+	struct Physics2DSnapshot;
+
+	// What changed in a scene since the last Scene::TakeChanges()
+	struct SceneChanges
+	{
+		// Created or modified entities and the GetDirtyBit() mask of what changed
+		std::unordered_map<UUID, uint64_t> Dirty;
+		std::unordered_set<UUID> Destroyed;
+
+		bool Empty() const { return Dirty.empty() && Destroyed.empty(); }
+	};
 
 	class Scene : public RefCount
 	{
@@ -36,36 +50,82 @@ namespace NanoCore{
 		void OnViewportResize(uint32_t width, uint32_t height);
 
 		void DuplicateEntity(Entity entity);
+		// Copies an entity with all of its components into another scene, keeping its UUID
+		Entity CopyEntityTo(Entity entity, Scene& target);
 		Entity GetEntityByUUID(UUID uuid);
 		Entity GetPrimaryCameraEntity();
 		bool IsRunning() const { return m_IsRunning; }
 		Entity FindEntityByName(std::string_view name);
+		PhysicsWorld2D* GetPhysicsWorld2D() { return m_PhysicsWorld.get(); }
+
 		template<typename... Components>
 		auto GetAllEntitiesWith()
 		{
 			return m_Registry.view<Components...>();
 		}
+
+		// Changes whenever TransformComponent storage may have moved,
+		// pointers into it are only valid while this stays the same
+		uint64_t GetTransformStorageVersion() const { return m_TransformStorageVersion; }
+
+		// Dirty tracking for incremental saves. Off until enabled, so runtime copies don't pay for it.
+		// Added/removed components and entities are picked up from the registry, edits made
+		// through component references have to be patched (Entity::PatchComponent), which the
+		// tracking picks up from on_update like the physics world does.
+		void EnableChangeTracking();
+		bool IsChangeTrackingEnabled() const { return m_ChangeTrackingEnabled; }
+		void MarkDirty(entt::entity entity, uint64_t componentMask);
+		bool HasChanges() const { return !m_DirtyEntities.empty() || !m_DestroyedEntities.empty(); }
+		SceneChanges TakeChanges();
 	private:
 		template<typename T>
 		void OnComponentAdded(Entity entity, T& component);
 
 		void OnPhysics2DStart();
 		void OnPhysics2DStop();
+		void BuildPhysics2DSnapshot();
+
+		void OnFixedUpdate(Timestep ts, bool updateScripts);
+		void UpdateFixedStepSettings();
 
 		void RenderScene(EditorCamera& camera);
+
+		void OnTransformStorageChanged(entt::registry& registry, entt::entity entity) { m_TransformStorageVersion++; }
+
+		template<typename... Component>
+		void ConnectChangeTracking(ComponentGroup<Component...>);
+		template<typename Component>
+		void OnTrackedComponentChanged(entt::registry& registry, entt::entity entity);
+		void OnTrackedEntityDestroyed(entt::registry& registry, entt::entity entity);
 	private:
 		entt::registry m_Registry;
 		uint32_t m_ViewportWidth = 0, m_ViewportHeight = 0;
 
 		bool m_IsRunning = false;
 
+		float m_FixedTimestep = 1.0f / 60.0f;
+		uint32_t m_MaxFixedStepsPerFrame = 8;
+		float m_FixedTimeAccumulator = 0.0f;
+
 		std::unordered_map<UUID, entt::entity> m_EntityMap;
-		b2World* m_PhysicsWorld = nullptr;
+		uint64_t m_TransformStorageVersion = 0;
+
+		bool m_ChangeTrackingEnabled = false;
+		std::unordered_map<entt::entity, uint64_t> m_DirtyEntities;
+		std::unordered_set<UUID> m_DestroyedEntities;
+		Unique<PhysicsWorld2D> m_PhysicsWorld;
+
+		// Body/fixture definitions baked by Scene::Copy, consumed by OnPhysics2DStart
+		Unique<Physics2DSnapshot> m_PhysicsSnapshot;
 
 
 		friend class Entity;
 		friend class SceneSerializer;
+		friend class SceneBinarySerializer;
+		friend class SceneStaging;
+		friend class SceneSnapshot;
 		friend class HierarchyPanel;
+		friend class ScriptGlue;
 	};
 
 }
\ No newline at end of file
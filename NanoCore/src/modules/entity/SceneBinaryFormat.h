@@ -0,0 +1,789 @@
+#pragma once
+
+#include "Scene.h"
+#include "Entity.h"
+#include "Components.h"
+#include "ComponentReflection.h"
+#include "AssetManager.h"
+#include "modules/script/ScriptEngine.h"
+#include "modules/utils/ThreadPool.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace NanoCore {
+
+	// Container layout shared by .nanoscene files (SceneBinarySerializer) and in-memory
+	// runtime snapshots (SceneSnapshot): a header, a block table, a deduplicated string
+	// table and one columnar block per component type.
+	namespace SceneBinary {
+
+		// "NCSB", everything in the file is little-endian
+		static constexpr uint32_t FileMagic = 0x4253434E;
+		// Bump whenever the container layout changes. Component fields don't need a bump,
+		// columns are matched by name and missing ones keep their defaults.
+		static constexpr uint32_t FileVersion = 2;
+
+		// Blocks and the columns inside them start on this boundary relative to the
+		// file start, so mapped columns can be read in place
+		static constexpr uint64_t Alignment = 16;
+
+		// Rows decoded per worker task
+		static constexpr size_t RowsPerBatch = 512;
+
+		// Blocks that aren't components, component blocks use GetComponentTypeID()
+		static constexpr uint32_t EntitiesBlock = Hash::GenerateFNVHash("Entities");
+		static constexpr uint32_t ScriptsBlock = Hash::GenerateFNVHash("Scripts");
+		static constexpr uint32_t ScriptFieldsBlock = Hash::GenerateFNVHash("ScriptFields");
+		static constexpr uint32_t UUIDArraysBlock = Hash::GenerateFNVHash("UUIDArrays");
+
+		// Row of the owning entity, first column of every component block
+		static constexpr uint32_t EntityColumn = Hash::GenerateFNVHash("Entity");
+
+		struct StringRef
+		{
+			uint32_t Offset = 0;
+			uint32_t Length = 0;
+		};
+
+		// Range in the UUIDArrays block
+		struct ArrayRef
+		{
+			uint32_t First = 0;
+			uint32_t Count = 0;
+		};
+
+		struct FileHeader
+		{
+			uint32_t Magic = FileMagic;
+			uint32_t Version = FileVersion;
+			uint32_t EntityCount = 0;
+			uint32_t BlockCount = 0;
+			uint64_t BlockTableOffset = 0;
+			uint64_t StringTableOffset = 0;
+			uint64_t StringTableSize = 0;
+			StringRef SceneName;
+		};
+
+		struct BlockEntry
+		{
+			uint32_t TypeID;
+			// Rows in the block, every column holds this many elements
+			uint32_t Count;
+			uint32_t ColumnCount;
+			uint32_t Reserved;
+			uint64_t Offset;
+			uint64_t Size;
+		};
+
+		// Every block starts with its column table, offsets are relative to the block
+		struct ColumnEntry
+		{
+			uint32_t NameHash;
+			uint32_t ElementSize;
+			uint64_t Offset;
+		};
+
+		// Raw bytes of one script field, large enough for a vec4
+		struct ScriptFieldValue
+		{
+			uint8_t Data[16];
+		};
+
+		inline uint64_t AlignUp(uint64_t value)
+		{
+			return (value + Alignment - 1) & ~(Alignment - 1);
+		}
+
+		// Row of every written entity, indexed by the entity part of its identifier. Null entities have no row.
+		class EntityRows
+		{
+		public:
+			static constexpr uint32_t InvalidRow = UINT32_MAX;
+
+			void Build(const entt::registry& registry, const std::vector<entt::entity>& entities)
+			{
+				m_Rows.assign(registry.size(), InvalidRow);
+				for (uint32_t row = 0; row < (uint32_t)entities.size(); row++)
+				{
+					if (entities[row] != entt::null)
+						m_Rows[GetIndex(entities[row])] = row;
+				}
+			}
+
+			uint32_t Find(entt::entity entity) const
+			{
+				size_t index = GetIndex(entity);
+				return index < m_Rows.size() ? m_Rows[index] : InvalidRow;
+			}
+		private:
+			static size_t GetIndex(entt::entity entity) { return (size_t)entt::to_integral(entt::registry::entity(entity)); }
+		private:
+			std::vector<uint32_t> m_Rows;
+		};
+
+		class Writer
+		{
+		public:
+			StringRef AddString(const std::string& string)
+			{
+				auto it = m_StringLookup.find(string);
+				if (it != m_StringLookup.end())
+					return it->second;
+
+				StringRef ref = { (uint32_t)m_Strings.size(), (uint32_t)string.size() };
+				m_Strings.insert(m_Strings.end(), string.begin(), string.end());
+				m_StringLookup.emplace(string, ref);
+				return ref;
+			}
+
+			// Stored as the path, the texture itself is kept so in-memory images can be
+			// loaded without creating it again
+			StringRef AddTexture(const Shared<Texture2D>& texture)
+			{
+				if (!texture)
+					return {};
+
+				auto [it, created] = m_TextureLookup.try_emplace(texture.Raw());
+				if (created)
+				{
+					it->second = AddString(texture->GetPath());
+					m_Textures.emplace_back(it->second.Offset, texture);
+				}
+				return it->second;
+			}
+
+			ArrayRef AddUUIDs(const std::vector<UUID>& uuids)
+			{
+				ArrayRef ref = { (uint32_t)m_UUIDs.size(), (uint32_t)uuids.size() };
+				for (UUID uuid : uuids)
+					m_UUIDs.push_back(uuid);
+				return ref;
+			}
+
+			void BeginBlock(uint32_t typeID, uint32_t count)
+			{
+				m_Blocks.push_back({ typeID, count, 0, 0, 0, 0 });
+				m_BlockColumns.emplace_back();
+				m_BlockData.emplace_back();
+			}
+
+			template<typename T>
+			void WriteColumn(uint32_t nameHash, const std::vector<T>& column)
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				NANO_ENGINE_LOG_ASSERT(column.size() == m_Blocks.back().Count, "Column doesn't match the block row count!");
+
+				std::vector<uint8_t>& data = m_BlockData.back();
+				data.resize(AlignUp(data.size()));
+				m_BlockColumns.back().push_back({ nameHash, (uint32_t)sizeof(T), data.size() });
+				m_Blocks.back().ColumnCount++;
+
+				const uint8_t* bytes = (const uint8_t*)column.data();
+				data.insert(data.end(), bytes, bytes + column.size() * sizeof(T));
+			}
+
+			// Lays everything out in one buffer, magic and version come from the given header.
+			// Padding is zeroed so images of the same scene only differ where the scene does.
+			void WriteImage(std::vector<uint8_t>& image, FileHeader header, const std::string& sceneName)
+			{
+				if (!m_UUIDs.empty())
+				{
+					BeginBlock(UUIDArraysBlock, (uint32_t)m_UUIDs.size());
+					WriteColumn(Hash::GenerateFNVHash("UUID"), m_UUIDs);
+					m_UUIDs.clear();
+				}
+
+				header.SceneName = AddString(sceneName);
+				header.BlockCount = (uint32_t)m_Blocks.size();
+				header.BlockTableOffset = AlignUp(sizeof(FileHeader));
+				header.StringTableOffset = AlignUp(header.BlockTableOffset + sizeof(BlockEntry) * m_Blocks.size());
+				header.StringTableSize = m_Strings.size();
+
+				uint64_t offset = AlignUp(header.StringTableOffset + header.StringTableSize);
+				for (size_t i = 0; i < m_Blocks.size(); i++)
+				{
+					// Column data follows the column table
+					uint64_t tableSize = AlignUp(sizeof(ColumnEntry) * m_BlockColumns[i].size());
+					for (ColumnEntry& column : m_BlockColumns[i])
+						column.Offset += tableSize;
+
+					m_Blocks[i].Offset = offset;
+					m_Blocks[i].Size = tableSize + m_BlockData[i].size();
+					offset = AlignUp(offset + m_Blocks[i].Size);
+				}
+
+				image.clear();
+				image.resize(offset);
+
+				auto write = [&](uint64_t at, const void* data, size_t size)
+				{
+					if (size > 0)
+						memcpy(image.data() + at, data, size);
+				};
+
+				write(0, &header, sizeof(FileHeader));
+				write(header.BlockTableOffset, m_Blocks.data(), sizeof(BlockEntry) * m_Blocks.size());
+				write(header.StringTableOffset, m_Strings.data(), m_Strings.size());
+				for (size_t i = 0; i < m_Blocks.size(); i++)
+				{
+					const std::vector<ColumnEntry>& columns = m_BlockColumns[i];
+					write(m_Blocks[i].Offset, columns.data(), sizeof(ColumnEntry) * columns.size());
+					write(m_Blocks[i].Offset + AlignUp(sizeof(ColumnEntry) * columns.size()), m_BlockData[i].data(), m_BlockData[i].size());
+				}
+			}
+
+			bool WriteFile(const std::filesystem::path& filepath, uint32_t entityCount, const std::string& sceneName)
+			{
+				FileHeader header;
+				header.EntityCount = entityCount;
+
+				std::vector<uint8_t> image;
+				WriteImage(image, header, sceneName);
+
+				std::ofstream stream(filepath, std::ios::binary | std::ios::trunc);
+				if (!stream)
+					return false;
+
+				stream.write((const char*)image.data(), image.size());
+				return stream.good();
+			}
+
+			// Textures referenced by the written image, by the string offset of their path
+			std::vector<std::pair<uint32_t, Shared<Texture2D>>>& GetTextures() { return m_Textures; }
+		private:
+			std::vector<BlockEntry> m_Blocks;
+			std::vector<std::vector<ColumnEntry>> m_BlockColumns;
+			std::vector<std::vector<uint8_t>> m_BlockData;
+
+			std::vector<char> m_Strings;
+			std::unordered_map<std::string, StringRef> m_StringLookup;
+
+			std::unordered_map<const Texture2D*, StringRef> m_TextureLookup;
+			std::vector<std::pair<uint32_t, Shared<Texture2D>>> m_Textures;
+
+			std::vector<uint64_t> m_UUIDs;
+		};
+
+		// Checks the header and block table of an image and finds blocks by type
+		class ImageReader
+		{
+		public:
+			// On failure error holds the reason. The version is left to the caller.
+			bool Open(const uint8_t* data, uint64_t size, uint32_t magic, const char*& error)
+			{
+				m_Data = data;
+				m_Blocks.clear();
+
+				if (size < sizeof(FileHeader))
+				{
+					error = "file is truncated";
+					return false;
+				}
+
+				m_Header = (const FileHeader*)data;
+				if (m_Header->Magic != magic)
+				{
+					error = "wrong file type";
+					return false;
+				}
+
+				if (m_Header->BlockTableOffset > size || sizeof(BlockEntry) * (uint64_t)m_Header->BlockCount > size - m_Header->BlockTableOffset
+					|| m_Header->StringTableOffset > size || m_Header->StringTableSize > size - m_Header->StringTableOffset)
+				{
+					error = "file is truncated";
+					return false;
+				}
+
+				// Blocks of component types that no longer exist are ignored
+				const BlockEntry* blockTable = (const BlockEntry*)(data + m_Header->BlockTableOffset);
+				for (uint32_t i = 0; i < m_Header->BlockCount; i++)
+				{
+					const BlockEntry& entry = blockTable[i];
+					if (entry.Offset > size || entry.Size > size - entry.Offset)
+					{
+						error = "file is truncated";
+						return false;
+					}
+
+					m_Blocks[entry.TypeID] = &entry;
+				}
+				return true;
+			}
+
+			const FileHeader& GetHeader() const { return *m_Header; }
+			const uint8_t* GetData() const { return m_Data; }
+
+			const BlockEntry* FindBlock(uint32_t typeID) const
+			{
+				auto it = m_Blocks.find(typeID);
+				return it != m_Blocks.end() ? it->second : nullptr;
+			}
+		private:
+			const uint8_t* m_Data = nullptr;
+			const FileHeader* m_Header = nullptr;
+			std::unordered_map<uint32_t, const BlockEntry*> m_Blocks;
+		};
+
+		// Looks up the columns of one mapped block by name. A missing block reads as
+		// zero rows, a missing column as null.
+		class BlockReader
+		{
+		public:
+			BlockReader(const uint8_t* fileData, const BlockEntry* entry)
+			{
+				if (!entry)
+					return;
+
+				m_Data = fileData + entry->Offset;
+				m_Size = entry->Size;
+				m_Count = entry->Count;
+
+				if (sizeof(ColumnEntry) * (uint64_t)entry->ColumnCount > m_Size)
+				{
+					m_Valid = false;
+					return;
+				}
+
+				m_Columns = (const ColumnEntry*)m_Data;
+				m_ColumnCount = entry->ColumnCount;
+			}
+
+			BlockReader(const ImageReader& image, uint32_t typeID)
+				: BlockReader(image.GetData(), image.FindBlock(typeID))
+			{
+			}
+
+			template<typename T>
+			const T* ReadColumn(uint32_t nameHash)
+			{
+				if (m_Count == 0)
+					return nullptr;
+
+				for (uint32_t i = 0; i < m_ColumnCount; i++)
+				{
+					const ColumnEntry& column = m_Columns[i];
+					if (column.NameHash != nameHash)
+						continue;
+
+					// A field that changed type reads as missing
+					if (column.ElementSize != sizeof(T))
+						return nullptr;
+
+					uint64_t size = sizeof(T) * (uint64_t)m_Count;
+					if (column.Offset > m_Size || size > m_Size - column.Offset)
+					{
+						m_Valid = false;
+						return nullptr;
+					}
+
+					return (const T*)(m_Data + column.Offset);
+				}
+				return nullptr;
+			}
+
+			uint32_t GetCount() const { return m_Count; }
+			bool IsValid() const { return m_Valid; }
+		private:
+			const uint8_t* m_Data = nullptr;
+			uint64_t m_Size = 0;
+			uint32_t m_Count = 0;
+
+			const ColumnEntry* m_Columns = nullptr;
+			uint32_t m_ColumnCount = 0;
+			bool m_Valid = true;
+		};
+
+		// Shared state for decoding column values
+		struct LoadContext
+		{
+			const char* Strings = nullptr;
+			uint64_t StringsSize = 0;
+
+			const uint64_t* UUIDs = nullptr;
+			uint32_t UUIDCount = 0;
+
+			// Paths are deduplicated in the string table, so each texture is created once.
+			// Filled on the main thread before rows are decoded, workers only look up.
+			std::unordered_map<uint32_t, Shared<Texture2D>> Textures;
+
+			// Resolves the string table and UUID arrays of an image, false if they are damaged
+			bool Init(const ImageReader& image)
+			{
+				const FileHeader& header = image.GetHeader();
+				Strings = (const char*)(image.GetData() + header.StringTableOffset);
+				StringsSize = header.StringTableSize;
+
+				BlockReader uuidBlock(image, UUIDArraysBlock);
+				UUIDs = uuidBlock.ReadColumn<uint64_t>(Hash::GenerateFNVHash("UUID"));
+				UUIDCount = UUIDs ? uuidBlock.GetCount() : 0;
+				return uuidBlock.IsValid();
+			}
+
+			std::string_view GetString(StringRef ref) const
+			{
+				if (ref.Offset > StringsSize || ref.Length > StringsSize - ref.Offset)
+					return {};
+
+				return { Strings + ref.Offset, ref.Length };
+			}
+		};
+
+		// How a reflected field type is stored in a column. Decode runs on worker threads,
+		// anything that has to happen on the main thread goes in Prepare.
+		template<typename T, typename = void>
+		struct ColumnCodec
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "Add a ColumnCodec for this field type");
+			using StoredType = T;
+
+			static void Prepare(const StoredType*, uint32_t, LoadContext&) {}
+
+			static StoredType Encode(const T& value, Writer&) { return value; }
+			static T Decode(const StoredType& stored, LoadContext&) { return stored; }
+		};
+
+		template<typename T>
+		struct ColumnCodec<T, std::enable_if_t<std::is_enum_v<T>>>
+		{
+			using StoredType = uint32_t;
+
+			static void Prepare(const StoredType*, uint32_t, LoadContext&) {}
+
+			static StoredType Encode(const T& value, Writer&) { return (uint32_t)value; }
+			static T Decode(const StoredType& stored, LoadContext&) { return (T)stored; }
+		};
+
+		template<>
+		struct ColumnCodec<bool>
+		{
+			using StoredType = uint8_t;
+
+			static void Prepare(const StoredType*, uint32_t, LoadContext&) {}
+
+			static StoredType Encode(const bool& value, Writer&) { return value; }
+			static bool Decode(const StoredType& stored, LoadContext&) { return stored != 0; }
+		};
+
+		template<>
+		struct ColumnCodec<UUID>
+		{
+			using StoredType = uint64_t;
+
+			static void Prepare(const StoredType*, uint32_t, LoadContext&) {}
+
+			static StoredType Encode(const UUID& value, Writer&) { return value; }
+			static UUID Decode(const StoredType& stored, LoadContext&) { return stored; }
+		};
+
+		template<>
+		struct ColumnCodec<std::string>
+		{
+			using StoredType = StringRef;
+
+			static void Prepare(const StoredType*, uint32_t, LoadContext&) {}
+
+			static StoredType Encode(const std::string& value, Writer& writer) { return writer.AddString(value); }
+			static std::string Decode(const StoredType& stored, LoadContext& context) { return std::string(context.GetString(stored)); }
+		};
+
+		template<>
+		struct ColumnCodec<std::vector<UUID>>
+		{
+			using StoredType = ArrayRef;
+
+			static void Prepare(const StoredType*, uint32_t, LoadContext&) {}
+
+			static StoredType Encode(const std::vector<UUID>& value, Writer& writer) { return writer.AddUUIDs(value); }
+			static std::vector<UUID> Decode(const StoredType& stored, LoadContext& context)
+			{
+				if (stored.First > context.UUIDCount || stored.Count > context.UUIDCount - stored.First)
+					return {};
+
+				return std::vector<UUID>(context.UUIDs + stored.First, context.UUIDs + stored.First + stored.Count);
+			}
+		};
+
+		template<>
+		struct ColumnCodec<Shared<Texture2D>>
+		{
+			using StoredType = StringRef;
+
+			// Textures come from the AssetManager on the main thread, unless the context already
+			// holds them. All of them are requested first so the images decode in parallel.
+			static void Prepare(const StoredType* column, uint32_t count, LoadContext& context)
+			{
+				std::vector<uint32_t> requested;
+				for (uint32_t row = 0; row < count; row++)
+				{
+					if (column[row].Length == 0)
+						continue;
+
+					auto [it, created] = context.Textures.try_emplace(column[row].Offset);
+					if (created)
+					{
+						AssetManager::RequestLoad(AssetManager::ImportAsset(std::string(context.GetString(column[row]))));
+						requested.push_back(row);
+					}
+				}
+
+				for (uint32_t row : requested)
+					context.Textures[column[row].Offset] = AssetManager::GetTexture(std::string(context.GetString(column[row])));
+			}
+
+			static StoredType Encode(const Shared<Texture2D>& value, Writer& writer) { return writer.AddTexture(value); }
+			static Shared<Texture2D> Decode(const StoredType& stored, LoadContext& context)
+			{
+				if (stored.Length == 0)
+					return nullptr;
+
+				auto it = context.Textures.find(stored.Offset);
+				return it != context.Textures.end() ? it->second : nullptr;
+			}
+		};
+
+		template<typename Field>
+		using StoredFieldType = typename ColumnCodec<typename Field::ValueType>::StoredType;
+
+		template<typename Component>
+		constexpr size_t ReflectedFieldCount = std::tuple_size_v<std::decay_t<decltype(ComponentReflection<Component>::Fields)>>;
+
+		template<typename Component>
+		void WriteComponentBlock(Writer& writer, entt::registry& registry, const EntityRows& entityRows)
+		{
+			std::vector<uint32_t> owners;
+			std::vector<const Component*> components;
+
+			auto view = registry.view<Component>();
+			owners.reserve(view.size());
+			components.reserve(view.size());
+			for (auto entity : view)
+			{
+				uint32_t row = entityRows.Find(entity);
+				if (row == EntityRows::InvalidRow)
+					continue;
+
+				owners.push_back(row);
+				components.push_back(&view.template get<Component>(entity));
+			}
+
+			if (owners.empty())
+				return;
+
+			writer.BeginBlock(GetComponentTypeID<Component>(), (uint32_t)owners.size());
+			writer.WriteColumn(EntityColumn, owners);
+
+			ForEachField<Component>([&](const auto& field)
+				{
+					using Field = std::decay_t<decltype(field)>;
+					using Codec = ColumnCodec<typename Field::ValueType>;
+
+					std::vector<typename Codec::StoredType> column;
+					column.reserve(components.size());
+					for (const Component* component : components)
+						column.push_back(Codec::Encode(field.Get(*component), writer));
+
+					writer.WriteColumn(Hash::GenerateFNVHash(field.Name), column);
+				});
+		}
+
+		// One column pointer per reflected field, null for fields missing from the block
+		template<typename Component>
+		auto ReadFieldColumns(BlockReader& block)
+		{
+			return std::apply([&](const auto&... fields)
+				{
+					return std::make_tuple(block.ReadColumn<StoredFieldType<std::decay_t<decltype(fields)>>>(Hash::GenerateFNVHash(fields.Name))...);
+				}, ComponentReflection<Component>::Fields);
+		}
+
+		template<typename Component, typename Columns, size_t... Index>
+		void DecodeRow(Component& component, uint32_t row, const Columns& columns, LoadContext& context, std::index_sequence<Index...>)
+		{
+			const auto& fields = ComponentReflection<Component>::Fields;
+			([&]()
+				{
+					const auto& field = std::get<Index>(fields);
+					using Codec = ColumnCodec<typename std::decay_t<decltype(field)>::ValueType>;
+
+					// Fields missing from the file keep their current values
+					if (const auto* column = std::get<Index>(columns))
+						field.Set(component, Codec::Decode(column[row], context));
+				}(), ...);
+		}
+
+		template<typename Component, typename Columns>
+		void DecodeRow(Component& component, uint32_t row, const Columns& columns, LoadContext& context)
+		{
+			DecodeRow(component, row, columns, context, std::make_index_sequence<ReflectedFieldCount<Component>>());
+		}
+
+		template<typename Component, typename Columns, size_t... Index>
+		void PrepareColumns(const Columns& columns, uint32_t count, LoadContext& context, std::index_sequence<Index...>)
+		{
+			using Fields = std::decay_t<decltype(ComponentReflection<Component>::Fields)>;
+			([&]()
+				{
+					using Codec = ColumnCodec<typename std::tuple_element_t<Index, Fields>::ValueType>;
+					if (const auto* column = std::get<Index>(columns))
+						Codec::Prepare(column, count, context);
+				}(), ...);
+		}
+
+		template<typename Component, typename Columns>
+		void PrepareColumns(const Columns& columns, uint32_t count, LoadContext& context)
+		{
+			PrepareColumns<Component>(columns, count, context, std::make_index_sequence<ReflectedFieldCount<Component>>());
+		}
+
+		// Writes the Scripts and ScriptFields blocks. Field values come from the live script
+		// instances when fromInstances is set, from the script engine's stored values otherwise.
+		inline void WriteScriptBlocks(Writer& writer, Scene* scene, entt::registry& registry, const EntityRows& entityRows, bool fromInstances)
+		{
+			std::vector<uint32_t> owners, firstFields, fieldCounts;
+			std::vector<StringRef> classNames;
+
+			// Set fields of every script, each script owns a contiguous range
+			std::vector<StringRef> fieldNames;
+			std::vector<uint32_t> fieldTypes;
+			std::vector<ScriptFieldValue> fieldValues;
+
+			// Field names are added once per class rather than once per script
+			std::unordered_map<const ScriptClass*, std::vector<StringRef>> classFieldNames;
+			ScriptFieldStorage instanceFields;
+
+			auto view = registry.view<ScriptComponent>();
+			for (auto entity : view)
+			{
+				uint32_t row = entityRows.Find(entity);
+				if (row == EntityRows::InvalidRow)
+					continue;
+
+				const ScriptComponent& sc = view.get<ScriptComponent>(entity);
+				owners.push_back(row);
+				classNames.push_back(writer.AddString(sc.ClassName));
+				firstFields.push_back((uint32_t)fieldNames.size());
+
+				const ScriptFieldStorage* entityFields = nullptr;
+				if (fromInstances)
+				{
+					if (ScriptEngine::SaveInstanceFieldStorage(registry.get<IDComponent>(entity).ID, instanceFields))
+						entityFields = &instanceFields;
+				}
+				else if (Shared<ScriptClass> entityClass = ScriptEngine::GetEntityClass(sc.ClassName))
+				{
+					entityFields = &ScriptEngine::GetScriptFieldStorage(Entity{ entity, scene }, entityClass);
+				}
+
+				if (entityFields && entityFields->Class)
+				{
+					const ScriptClass* entityClass = entityFields->Class.Raw();
+					auto [names, created] = classFieldNames.try_emplace(entityClass);
+					if (created)
+					{
+						for (const ScriptField& field : entityClass->GetFields())
+							names->second.push_back(writer.AddString(field.Name));
+					}
+
+					for (const ScriptField& field : entityClass->GetFields())
+					{
+						if (!entityFields->IsSet(field))
+							continue;
+
+						ScriptFieldValue value = {};
+						memcpy(value.Data, entityFields->Buffer.data() + field.Offset, std::min<size_t>(field.Size, sizeof(value.Data)));
+
+						fieldNames.push_back(names->second[field.Index]);
+						fieldTypes.push_back((uint32_t)field.Type);
+						fieldValues.push_back(value);
+					}
+				}
+
+				fieldCounts.push_back((uint32_t)fieldNames.size() - firstFields.back());
+			}
+
+			if (!owners.empty())
+			{
+				writer.BeginBlock(ScriptsBlock, (uint32_t)owners.size());
+				writer.WriteColumn(EntityColumn, owners);
+				writer.WriteColumn(Hash::GenerateFNVHash("ClassName"), classNames);
+				writer.WriteColumn(Hash::GenerateFNVHash("FirstField"), firstFields);
+				writer.WriteColumn(Hash::GenerateFNVHash("FieldCount"), fieldCounts);
+			}
+
+			if (!fieldNames.empty())
+			{
+				writer.BeginBlock(ScriptFieldsBlock, (uint32_t)fieldNames.size());
+				writer.WriteColumn(Hash::GenerateFNVHash("Name"), fieldNames);
+				writer.WriteColumn(Hash::GenerateFNVHash("Type"), fieldTypes);
+				writer.WriteColumn(Hash::GenerateFNVHash("Value"), fieldValues);
+			}
+		}
+
+		// Columns of the Scripts and ScriptFields blocks
+		class ScriptBlockReader
+		{
+		public:
+			ScriptBlockReader(const ImageReader& image)
+				: m_Scripts(image, ScriptsBlock), m_Fields(image, ScriptFieldsBlock)
+			{
+				Owners = m_Scripts.ReadColumn<uint32_t>(EntityColumn);
+				ClassNames = m_Scripts.ReadColumn<StringRef>(Hash::GenerateFNVHash("ClassName"));
+				m_FirstFields = m_Scripts.ReadColumn<uint32_t>(Hash::GenerateFNVHash("FirstField"));
+				m_FieldCounts = m_Scripts.ReadColumn<uint32_t>(Hash::GenerateFNVHash("FieldCount"));
+
+				m_FieldNames = m_Fields.ReadColumn<StringRef>(Hash::GenerateFNVHash("Name"));
+				m_FieldTypes = m_Fields.ReadColumn<uint32_t>(Hash::GenerateFNVHash("Type"));
+				m_FieldValues = m_Fields.ReadColumn<ScriptFieldValue>(Hash::GenerateFNVHash("Value"));
+			}
+
+			bool IsValid() const
+			{
+				return m_Scripts.IsValid() && m_Fields.IsValid()
+					&& (m_Scripts.GetCount() == 0 || (Owners && ClassNames && m_FirstFields && m_FieldCounts))
+					&& (m_Fields.GetCount() == 0 || (m_FieldNames && m_FieldTypes && m_FieldValues));
+			}
+
+			uint32_t GetCount() const { return m_Scripts.GetCount(); }
+			bool HasFields(uint32_t row) const { return m_FieldCounts[row] > 0; }
+
+			// Copies the field values of one script into storage laid out for entityClass.
+			// Fields that no longer exist are skipped, false if the row's field range is damaged.
+			bool ReadFields(uint32_t row, const LoadContext& context, const ScriptClass& entityClass, ScriptFieldStorage& storage) const
+			{
+				uint32_t first = m_FirstFields[row], count = m_FieldCounts[row];
+				if (first > m_Fields.GetCount() || count > m_Fields.GetCount() - first)
+					return false;
+
+				for (uint32_t fieldRow = first; fieldRow < first + count; fieldRow++)
+				{
+					std::string fieldName(context.GetString(m_FieldNames[fieldRow]));
+					const ScriptField* field = entityClass.FindField(fieldName);
+					if (!field || field->Type != (ScriptFieldType)m_FieldTypes[fieldRow])
+					{
+						NANO_ENGINE_LOG_WARN("Script field '{}.{}' no longer exists or changed type, skipping it", entityClass.GetFullName(), fieldName);
+						continue;
+					}
+
+					memcpy(storage.Buffer.data() + field->Offset, m_FieldValues[fieldRow].Data, std::min<size_t>(field->Size, sizeof(ScriptFieldValue::Data)));
+					storage.AssignedFields[field->Index] = 1;
+				}
+				return true;
+			}
+		public:
+			const uint32_t* Owners = nullptr;
+			const StringRef* ClassNames = nullptr;
+		private:
+			BlockReader m_Scripts;
+			BlockReader m_Fields;
+
+			const uint32_t* m_FirstFields = nullptr;
+			const uint32_t* m_FieldCounts = nullptr;
+			const StringRef* m_FieldNames = nullptr;
+			const uint32_t* m_FieldTypes = nullptr;
+			const ScriptFieldValue* m_FieldValues = nullptr;
+		};
+
+	}
+
+}
@@ -0,0 +1,253 @@
+#include "ncpch.h"
+#include "SceneBinarySerializer.h"
+#include "SceneBinaryFormat.h"
+#include "SceneSerializer.h"
+
+#include "modules/utils/FileManager.h"
+#include "modules/utils/Timer.h"
+
+namespace NanoCore {
+
+	namespace SceneBinary {
+
+		// Builds one component per block row on the worker threads, then inserts all of them in a single call
+		template<typename Component, typename Fn>
+		static bool InsertComponents(entt::registry& registry, const std::vector<entt::entity>& entities, const uint32_t* owners, uint32_t count, Fn&& fill)
+		{
+			if (count == 0)
+				return true;
+
+			if (!owners)
+				return false;
+
+			std::vector<entt::entity> targets(count);
+			for (uint32_t row = 0; row < count; row++)
+			{
+				if (owners[row] >= entities.size())
+					return false;
+
+				targets[row] = entities[owners[row]];
+			}
+
+			std::vector<Component> components(count);
+			ThreadPool::ParallelFor(count, RowsPerBatch, [&](size_t first, size_t last)
+				{
+					for (size_t row = first; row < last; row++)
+						fill((uint32_t)row, components[row]);
+				});
+
+			registry.insert<Component>(targets.begin(), targets.end(), components.begin(), components.end());
+			return true;
+		}
+
+		template<typename Component>
+		static bool ReadComponentBlock(const ImageReader& image, entt::registry& registry, const std::vector<entt::entity>& entities, LoadContext& context)
+		{
+			BlockReader block(image, GetComponentTypeID<Component>());
+			const uint32_t* owners = block.ReadColumn<uint32_t>(EntityColumn);
+
+			// Resolve every column once, rows then index straight into them
+			auto columns = ReadFieldColumns<Component>(block);
+			if (!block.IsValid())
+				return false;
+
+			PrepareColumns<Component>(columns, block.GetCount(), context);
+			return InsertComponents<Component>(registry, entities, owners, block.GetCount(), [&](uint32_t row, Component& component)
+				{
+					DecodeRow(component, row, columns, context);
+				});
+		}
+
+	}
+
+	using namespace SceneBinary;
+
+	SceneBinarySerializer::SceneBinarySerializer(const Shared<Scene>& scene)
+		: m_Scene(scene)
+	{
+	}
+
+	bool SceneBinarySerializer::Serialize(const std::filesystem::path& filepath)
+	{
+		RA_PROFILE_FUNCTION();
+
+		Timer timer;
+		entt::registry& registry = m_Scene->m_Registry;
+		Writer writer;
+
+		// Row of each entity, component blocks refer to these
+		std::vector<entt::entity> entities;
+		EntityRows entityRows;
+		{
+			auto view = registry.view<IDComponent>();
+			entities.assign(view.begin(), view.end());
+			entityRows.Build(registry, entities);
+		}
+
+		const uint32_t entityCount = (uint32_t)entities.size();
+		if (entityCount > 0)
+		{
+			std::vector<uint64_t> uuids(entityCount);
+			for (uint32_t row = 0; row < entityCount; row++)
+				uuids[row] = registry.get<IDComponent>(entities[row]).ID;
+
+			writer.BeginBlock(EntitiesBlock, entityCount);
+			writer.WriteColumn(Hash::GenerateFNVHash("UUID"), uuids);
+		}
+
+		ForEachComponentType(ReflectedComponents{}, [&](auto type)
+			{
+				WriteComponentBlock<typename decltype(type)::Type>(writer, registry, entityRows);
+			});
+
+		// Script components are paired with field values from the script engine
+		WriteScriptBlocks(writer, m_Scene.Raw(), registry, entityRows, false);
+
+		if (!writer.WriteFile(filepath, entityCount, "Untitled"))
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to write binary scene '{}'", filepath.string());
+			return false;
+		}
+
+		NANO_ENGINE_LOG_INFO("Wrote binary scene '{}' ({} entities) in {:.2f}ms", filepath.string(), entityCount, timer.ElapsedMillis());
+		return true;
+	}
+
+	bool SceneBinarySerializer::Deserialize(const std::filesystem::path& filepath)
+	{
+		RA_PROFILE_FUNCTION();
+
+		NANO_ENGINE_LOG_ASSERT(m_Scene->m_EntityMap.empty(), "Binary scenes can only be loaded into an empty scene!");
+
+		Timer timer;
+
+		MappedFile file(filepath);
+		if (!file)
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to open binary scene '{}'", filepath.string());
+			return false;
+		}
+
+		auto corrupt = [&](const char* reason)
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to load binary scene '{}': {}", filepath.string(), reason);
+			return false;
+		};
+
+		ImageReader image;
+		const char* error = nullptr;
+		if (!image.Open(file.GetData(), file.GetSize(), FileMagic, error))
+			return corrupt(error);
+
+		const FileHeader& header = image.GetHeader();
+		if (header.Version != FileVersion)
+		{
+			NANO_ENGINE_LOG_ERROR("Binary scene '{}' has version {}, expected {}. Export it again from the .nanocore scene", filepath.string(), header.Version, FileVersion);
+			return false;
+		}
+
+		LoadContext context;
+		if (!context.Init(image))
+			return corrupt("invalid UUID array block");
+
+		const uint32_t entityCount = header.EntityCount;
+		entt::registry& registry = m_Scene->m_Registry;
+		std::vector<entt::entity> entities(entityCount);
+		{
+			BlockReader entityBlock(image, EntitiesBlock);
+			const uint64_t* uuids = entityBlock.ReadColumn<uint64_t>(Hash::GenerateFNVHash("UUID"));
+			if (!entityBlock.IsValid() || entityBlock.GetCount() != entityCount || (entityCount > 0 && !uuids))
+				return corrupt("entity block doesn't match the entity count");
+
+			registry.create(entities.begin(), entities.end());
+
+			std::vector<IDComponent> ids;
+			ids.reserve(entityCount);
+			for (uint32_t row = 0; row < entityCount; row++)
+				ids.push_back({ uuids[row] });
+
+			registry.insert<IDComponent>(entities.begin(), entities.end(), ids.begin(), ids.end());
+
+			m_Scene->m_EntityMap.reserve(entityCount);
+			for (uint32_t row = 0; row < entityCount; row++)
+				m_Scene->m_EntityMap[uuids[row]] = entities[row];
+		}
+
+		bool componentsLoaded = true;
+		ForEachComponentType(ReflectedComponents{}, [&](auto type)
+			{
+				using Component = typename decltype(type)::Type;
+				if (!componentsLoaded || !image.FindBlock(GetComponentTypeID<Component>()))
+					return;
+
+				componentsLoaded = ReadComponentBlock<Component>(image, registry, entities, context);
+				if (!componentsLoaded)
+					NANO_ENGINE_LOG_ERROR("Invalid {} block", ComponentReflection<Component>::Name);
+			});
+
+		if (!componentsLoaded)
+			return corrupt("invalid component block");
+
+		{
+			ScriptBlockReader scripts(image);
+			if (!scripts.IsValid())
+				return corrupt("invalid script block");
+
+			bool inserted = InsertComponents<ScriptComponent>(registry, entities, scripts.Owners, scripts.GetCount(), [&](uint32_t row, ScriptComponent& sc)
+				{
+					sc.ClassName = context.GetString(scripts.ClassNames[row]);
+				});
+
+			if (!inserted)
+				return corrupt("invalid script block");
+
+			// Field values go to the script engine's per-entity storage, like the YAML loader
+			for (uint32_t row = 0; row < scripts.GetCount(); row++)
+			{
+				if (!scripts.HasFields(row))
+					continue;
+
+				std::string className(context.GetString(scripts.ClassNames[row]));
+				Shared<ScriptClass> entityClass = ScriptEngine::GetEntityClass(className);
+				if (!entityClass)
+				{
+					NANO_ENGINE_LOG_WARN("Script class '{}' not found, skipping its field values", className);
+					continue;
+				}
+
+				ScriptFieldStorage& entityFields = ScriptEngine::GetScriptFieldStorage(Entity{ entities[scripts.Owners[row]], m_Scene.Raw() }, entityClass);
+				if (!scripts.ReadFields(row, context, *entityClass, entityFields))
+					return corrupt("invalid script field range");
+			}
+		}
+
+		NANO_ENGINE_LOG_INFO("Loaded binary scene '{}' ({} entities) in {:.2f}ms", std::string(context.GetString(header.SceneName)), entityCount, timer.ElapsedMillis());
+		return true;
+	}
+
+	bool SceneBinarySerializer::ExportFromYAML(const std::filesystem::path& yamlPath, const std::filesystem::path& binaryPath)
+	{
+		Shared<Scene> scene = Shared<Scene>::Create();
+
+		SceneSerializer serializer(scene);
+		if (!serializer.Deserialize(yamlPath.string()))
+			return false;
+
+		SceneBinarySerializer binarySerializer(scene);
+		return binarySerializer.Serialize(binaryPath);
+	}
+
+	bool SceneBinarySerializer::ExportToYAML(const std::filesystem::path& binaryPath, const std::filesystem::path& yamlPath)
+	{
+		Shared<Scene> scene = Shared<Scene>::Create();
+
+		SceneBinarySerializer binarySerializer(scene);
+		if (!binarySerializer.Deserialize(binaryPath))
+			return false;
+
+		SceneSerializer serializer(scene);
+		serializer.Serialize(yamlPath.string());
+		return true;
+	}
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Scene.h"
+
+#include <filesystem>
+
+namespace NanoCore {
+
+	// Load-optimized counterpart of the YAML .nanocore scene, stored as .nanoscene.
+	// The file is a header, a block table, a deduplicated string table and one
+	// columnar block per component type. Loading maps the file and inserts every
+	// block into the registry in bulk. YAML stays the authoring format.
+	class SceneBinarySerializer
+	{
+	public:
+		SceneBinarySerializer(const Shared<Scene>& scene);
+
+		bool Serialize(const std::filesystem::path& filepath);
+		// Expects an empty scene
+		bool Deserialize(const std::filesystem::path& filepath);
+
+		// Converters between the two formats, the scene goes through a temporary Scene
+		static bool ExportFromYAML(const std::filesystem::path& yamlPath, const std::filesystem::path& binaryPath);
+		static bool ExportToYAML(const std::filesystem::path& binaryPath, const std::filesystem::path& yamlPath);
+	private:
+		Shared<Scene> m_Scene;
+	};
+
+}
@@ -0,0 +1,361 @@
+#include "ncpch.h"
+#include "SceneSaver.h"
+#include "SceneSerializer.h"
+
+#include "Entity.h"
+#include "Components.h"
+#include "modules/script/ScriptEngine.h"
+#include "modules/info/Project.h"
+#include "modules/utils/Timer.h"
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <thread>
+
+namespace NanoCore {
+
+	// Autosaves appended to the journal before the next one rewrites the scene file
+	static constexpr uint32_t JournalEntriesPerFullSave = 16;
+
+	struct SceneSaveJob
+	{
+		uint32_t Generation = 0;
+		std::filesystem::path Path;
+		bool FullSave = false;
+		// The snapshot holds every entity, cached ones are thrown away
+		bool FullSnapshot = false;
+		uint32_t JournalSequence = 0;
+
+		// Copies of the changed entities, owned by the job so the worker never touches the live scene
+		Shared<Scene> Snapshot;
+		std::vector<UUID> Changed;
+		std::unordered_map<UUID, ScriptFieldStorage> ScriptFields;
+		std::vector<UUID> Destroyed;
+
+		float MainThreadMs = 0.0f;
+		float WorkerMs = 0.0f;
+		bool Succeeded = false;
+	};
+
+	struct SceneSaverWorker
+	{
+		std::thread Thread;
+
+		std::mutex Mutex;
+		std::condition_variable Condition;
+		std::condition_variable Idle;
+		std::deque<Unique<SceneSaveJob>> Pending;
+		// Handed back so snapshots (and the textures they hold) are released on the main thread
+		std::vector<Unique<SceneSaveJob>> Finished;
+		bool Busy = false;
+		bool Stopping = false;
+
+		// Worker thread only. YAML of every saved entity in file order, so a full
+		// save only serializes what changed since the previous one.
+		uint32_t Generation = 0;
+		std::vector<UUID> Order;
+		std::unordered_map<UUID, std::string> Fragments;
+
+		void Run();
+		void Process(SceneSaveJob& job);
+		bool WriteJournalEntry(const SceneSaveJob& job, const std::vector<const std::string*>& changed);
+	};
+
+	void SceneSaverWorker::Run()
+	{
+		while (true)
+		{
+			Unique<SceneSaveJob> job;
+			{
+				std::unique_lock<std::mutex> lock(Mutex);
+				Condition.wait(lock, [&] { return Stopping || !Pending.empty(); });
+				if (Pending.empty())
+					return;
+
+				job = std::move(Pending.front());
+				Pending.pop_front();
+				Busy = true;
+			}
+
+			Process(*job);
+
+			std::scoped_lock<std::mutex> lock(Mutex);
+			Finished.push_back(std::move(job));
+			Busy = false;
+			if (Pending.empty())
+				Idle.notify_all();
+		}
+	}
+
+	void SceneSaverWorker::Process(SceneSaveJob& job)
+	{
+		Timer timer;
+
+		if (job.Generation != Generation || job.FullSnapshot)
+		{
+			Generation = job.Generation;
+			Order.clear();
+			Fragments.clear();
+		}
+
+		for (UUID uuid : job.Destroyed)
+			Fragments.erase(uuid);
+
+		std::vector<const std::string*> changed;
+		changed.reserve(job.Changed.size());
+		for (UUID uuid : job.Changed)
+		{
+			Entity entity = job.Snapshot->GetEntityByUUID(uuid);
+
+			auto fields = job.ScriptFields.find(uuid);
+			const ScriptFieldStorage* scriptFields = fields != job.ScriptFields.end() ? &fields->second : nullptr;
+
+			auto [it, created] = Fragments.try_emplace(uuid);
+			if (created)
+				Order.push_back(uuid);
+
+			it->second = SceneSerializer::SerializeEntityFragment(entity, scriptFields);
+			changed.push_back(&it->second);
+		}
+
+		if (job.FullSave)
+		{
+			// Destroyed entities, and ones destroyed and created again, leave stale or duplicate entries behind
+			std::unordered_set<UUID> written;
+			std::vector<UUID> order;
+			std::vector<const std::string*> entities;
+			order.reserve(Fragments.size());
+			entities.reserve(Fragments.size());
+			for (UUID uuid : Order)
+			{
+				auto it = Fragments.find(uuid);
+				if (it == Fragments.end() || !written.insert(uuid).second)
+					continue;
+
+				order.push_back(uuid);
+				entities.push_back(&it->second);
+			}
+			Order = std::move(order);
+
+			job.Succeeded = SceneSerializer::WriteSceneFile(job.Path, entities);
+		}
+		else
+		{
+			job.Succeeded = WriteJournalEntry(job, changed);
+		}
+
+		job.WorkerMs = timer.ElapsedMillis();
+	}
+
+	bool SceneSaverWorker::WriteJournalEntry(const SceneSaveJob& job, const std::vector<const std::string*>& changed)
+	{
+		std::string entry(SceneSerializer::GetJournalEntryMarker());
+		entry += fmt::format("Journal: {}\n", job.JournalSequence);
+		entry += changed.empty() ? "Entities: []\n" : "Entities:\n";
+		for (const std::string* fragment : changed)
+			entry += *fragment;
+
+		entry += "Destroyed: [";
+		for (size_t i = 0; i < job.Destroyed.size(); i++)
+			entry += fmt::format(i == 0 ? "{}" : ", {}", (uint64_t)job.Destroyed[i]);
+		entry += "]\n";
+
+		// One write per entry, a crash can only tear the last one
+		std::ofstream stream(SceneSerializer::GetJournalPath(job.Path), std::ios::binary | std::ios::app);
+		stream.write(entry.data(), entry.size());
+		stream.flush();
+		if (!stream)
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to append to the journal of '{}'", job.Path.string());
+			return false;
+		}
+		return true;
+	}
+
+	SceneSaver::SceneSaver()
+		: m_Worker(std::make_unique<SceneSaverWorker>())
+	{
+		m_Worker->Thread = std::thread([worker = m_Worker.get()] { worker->Run(); });
+	}
+
+	SceneSaver::~SceneSaver()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_Worker->Mutex);
+			m_Worker->Stopping = true;
+		}
+		m_Worker->Condition.notify_all();
+		m_Worker->Thread.join();
+
+		ReleaseFinishedJobs();
+	}
+
+	void SceneSaver::SetScene(const Shared<Scene>& scene, const std::filesystem::path& filepath)
+	{
+		m_Scene = scene;
+		m_Path = filepath;
+		m_Generation++;
+		m_NeedsFullSnapshot = true;
+		m_JournalEntries = 0;
+		m_AutoSaveTimer = 0.0f;
+		m_RetryPending = false;
+
+		if (m_Scene)
+		{
+			m_Scene->EnableChangeTracking();
+			// Everything up to now is covered by the full snapshot
+			m_Scene->TakeChanges();
+		}
+	}
+
+	void SceneSaver::Save()
+	{
+		Submit(true);
+	}
+
+	void SceneSaver::SaveIncremental()
+	{
+		Submit(false);
+	}
+
+	void SceneSaver::OnUpdate(Timestep ts)
+	{
+		ReleaseFinishedJobs();
+
+		Shared<Project> project = Project::GetActive();
+		if (!project || !m_Scene || m_Path.empty())
+			return;
+
+		const ProjectConfig& config = project->GetConfig();
+		if (!config.EnableAutoSave)
+			return;
+
+		m_AutoSaveTimer += ts;
+		if (m_AutoSaveTimer < (float)config.AutoSaveIntervalSeconds)
+			return;
+
+		// A save still running means the disk is slow, try again next interval
+		m_AutoSaveTimer = 0.0f;
+		if (IsSaving() || (!m_Scene->HasChanges() && !m_RetryPending))
+			return;
+
+		Submit(m_JournalEntries >= JournalEntriesPerFullSave);
+	}
+
+	bool SceneSaver::IsSaving() const
+	{
+		std::scoped_lock<std::mutex> lock(m_Worker->Mutex);
+		return m_Worker->Busy || !m_Worker->Pending.empty();
+	}
+
+	void SceneSaver::Flush()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Worker->Mutex);
+			m_Worker->Idle.wait(lock, [&] { return !m_Worker->Busy && m_Worker->Pending.empty(); });
+		}
+		ReleaseFinishedJobs();
+	}
+
+	void SceneSaver::Submit(bool fullSave)
+	{
+		RA_PROFILE_FUNCTION();
+
+		if (!m_Scene || m_Path.empty())
+			return;
+
+		Timer timer;
+
+		// The worker has nothing cached yet, so the journal would have to hold the whole scene
+		if (m_NeedsFullSnapshot)
+			fullSave = true;
+
+		SceneChanges changes = m_Scene->TakeChanges();
+		if (!fullSave && changes.Empty())
+			return;
+
+		auto job = std::make_unique<SceneSaveJob>();
+		job->Generation = m_Generation;
+		job->Path = m_Path;
+		job->FullSave = fullSave;
+		job->FullSnapshot = m_NeedsFullSnapshot;
+		job->Snapshot = Shared<Scene>::Create();
+
+		auto snapshotEntity = [&](Entity entity)
+		{
+			UUID uuid = entity.GetUUID();
+			m_Scene->CopyEntityTo(entity, *job->Snapshot);
+			job->Changed.push_back(uuid);
+
+			// Field values live in the script engine, the worker gets its own copy
+			if (entity.HasComponent<ScriptComponent>())
+			{
+				Shared<ScriptClass> entityClass = ScriptEngine::GetEntityClass(entity.GetComponent<ScriptComponent>().ClassName);
+				job->ScriptFields[uuid] = entityClass ? ScriptEngine::GetScriptFieldStorage(entity, entityClass) : ScriptFieldStorage{};
+			}
+		};
+
+		if (m_NeedsFullSnapshot)
+		{
+			auto view = m_Scene->GetAllEntitiesWith<IDComponent>();
+			job->Changed.reserve(view.size());
+			for (auto entity : view)
+				snapshotEntity({ entity, m_Scene.Raw() });
+
+			m_NeedsFullSnapshot = false;
+		}
+		else
+		{
+			job->Changed.reserve(changes.Dirty.size());
+			for (const auto& [uuid, mask] : changes.Dirty)
+			{
+				if (Entity entity = m_Scene->GetEntityByUUID(uuid))
+					snapshotEntity(entity);
+			}
+			job->Destroyed.assign(changes.Destroyed.begin(), changes.Destroyed.end());
+		}
+
+		if (fullSave)
+			m_JournalEntries = 0;
+		else
+			job->JournalSequence = ++m_JournalEntries;
+
+		m_AutoSaveTimer = 0.0f;
+		m_RetryPending = false;
+		job->MainThreadMs = timer.ElapsedMillis();
+
+		{
+			std::scoped_lock<std::mutex> lock(m_Worker->Mutex);
+			m_Worker->Pending.push_back(std::move(job));
+		}
+		m_Worker->Condition.notify_one();
+	}
+
+	void SceneSaver::ReleaseFinishedJobs()
+	{
+		std::vector<Unique<SceneSaveJob>> finished;
+		{
+			std::scoped_lock<std::mutex> lock(m_Worker->Mutex);
+			finished.swap(m_Worker->Finished);
+		}
+
+		for (const Unique<SceneSaveJob>& job : finished)
+		{
+			if (!job->Succeeded)
+			{
+				// What the worker has cached may no longer match the file, start over
+				if (job->Generation == m_Generation)
+				{
+					m_NeedsFullSnapshot = true;
+					m_RetryPending = true;
+				}
+				continue;
+			}
+
+			NANO_ENGINE_LOG_INFO("{} '{}' ({} entities) in {:.2f}ms, {:.2f}ms on the main thread",
+				job->FullSave ? "Saved scene" : "Journaled changes to", job->Path.string(), job->Changed.size(), job->WorkerMs, job->MainThreadMs);
+		}
+	}
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Scene.h"
+#include "modules/utils/TimeStep.h"
+
+#include <filesystem>
+
+namespace NanoCore {
+
+	struct SceneSaveJob;
+	struct SceneSaverWorker;
+
+	// Saves a .nanocore scene without stalling the frame. The main thread only copies
+	// the entities that changed since the previous save. A worker thread serializes
+	// them, reuses the YAML of every other entity from earlier saves and writes the file.
+	// Autosaves append the changes to the scene's journal and fold it back into a full
+	// save every few entries.
+	class SceneSaver
+	{
+	public:
+		SceneSaver();
+		// Finishes queued saves
+		~SceneSaver();
+
+		// Turns on the scene's change tracking, the next save copies it whole
+		void SetScene(const Shared<Scene>& scene, const std::filesystem::path& filepath);
+		const std::filesystem::path& GetPath() const { return m_Path; }
+
+		// Writes the whole scene and atomically replaces the file
+		void Save();
+		// Appends what changed since the previous save to the journal
+		void SaveIncremental();
+
+		// Runs the autosave timer from the project config and releases finished saves.
+		// Main thread, once per frame.
+		void OnUpdate(Timestep ts);
+
+		bool IsSaving() const;
+		// Blocks until every queued save is written
+		void Flush();
+	private:
+		void Submit(bool fullSave);
+		void ReleaseFinishedJobs();
+	private:
+		Shared<Scene> m_Scene;
+		std::filesystem::path m_Path;
+
+		// Bumped on SetScene(), the worker drops its cached entities when it changes
+		uint32_t m_Generation = 0;
+		bool m_NeedsFullSnapshot = true;
+		// The last save failed, autosave retries it even without new changes
+		bool m_RetryPending = false;
+		uint32_t m_JournalEntries = 0;
+		float m_AutoSaveTimer = 0.0f;
+
+		Unique<SceneSaverWorker> m_Worker;
+	};
+
+}
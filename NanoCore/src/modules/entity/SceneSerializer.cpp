@@ -3,8 +3,14 @@
 
 #include "Entity.h"
 #include "Components.h"
+#include "ComponentReflection.h"
+#include "SceneStaging.h"
+#include "SceneSnapshot.h"
 #include "modules/Script/ScriptEngine.h"
 #include "modules/utils/UUID.h"
+#include "modules/utils/Timer.h"
+#include "modules/utils/ThreadPool.h"
+#include "modules/utils/FileManager.h"
 
 #include <fstream>
 
@@ -108,16 +114,16 @@ namespace YAML {
 
 namespace NanoCore {
 
-#define WRITE_SCRIPT_FIELD(FieldType, Type)           \
-			case ScriptFieldType::FieldType:          \
-				out << scriptField.GetValue<Type>();  \
+#define WRITE_SCRIPT_FIELD(FieldType, Type)                \
+			case ScriptFieldType::FieldType:               \
+				out << entityFields.GetValue<Type>(field); \
 				break
 
 #define READ_SCRIPT_FIELD(FieldType, Type)             \
 	case ScriptFieldType::FieldType:                   \
 	{                                                  \
 		Type data = scriptField["Data"].as<Type>();    \
-		fieldInstance.SetValue(data);                  \
+		entityFields.SetValue(*field, data);           \
 		break;                                         \
 	}
 
@@ -142,90 +148,273 @@ namespace NanoCore {
 		return out;
 	}
 
-	static std::string RigidBody2DBodyTypeToString(Rigidbody2DComponent::BodyType bodyType)
+	// Small enough that a few thousand entities still spread over every worker
+	static constexpr size_t EntitiesPerBatch = 256;
+	template<typename T>
+	static void WriteFieldValue(YAML::Emitter& out, const T& value)
 	{
-		switch (bodyType)
+		if constexpr (std::is_enum_v<T>)
+			out << std::string(EnumToString(value));
+		else if constexpr (std::is_same_v<T, UUID>)
+			out << (uint64_t)value;
+		else if constexpr (std::is_same_v<T, std::vector<UUID>>)
 		{
-		case Rigidbody2DComponent::BodyType::Static:    return "Static";
-		case Rigidbody2DComponent::BodyType::Dynamic:   return "Dynamic";
-		case Rigidbody2DComponent::BodyType::Kinematic: return "Kinematic";
+			out << YAML::Flow << YAML::BeginSeq;
+			for (UUID id : value)
+				out << (uint64_t)id;
+			out << YAML::EndSeq;
 		}
+		else if constexpr (std::is_same_v<T, Shared<Texture2D>>)
+			out << value->GetPath();
+		else
+			out << value;
+	}
 
-		NANO_ENGINE_LOG_ASSERT(false, "Unknown body type");
-		return {};
+	template<typename T>
+	static bool ReadFieldValue(const YAML::Node& node, T& value)
+	{
+		if constexpr (std::is_enum_v<T>)
+		{
+			// Older scenes stored enums as their underlying value
+			int index;
+			if (YAML::convert<int>::decode(node, index))
+			{
+				value = (T)index;
+				return true;
+			}
+			return EnumFromString(node.as<std::string>(), value);
+		}
+		else if constexpr (std::is_same_v<T, UUID>)
+		{
+			value = node.as<uint64_t>();
+			return true;
+		}
+		else if constexpr (std::is_same_v<T, std::vector<UUID>>)
+		{
+			value.clear();
+			for (const auto& id : node)
+				value.push_back(id.as<uint64_t>());
+			return true;
+		}
+		else
+		{
+			value = node.as<T>();
+			return true;
+		}
 	}
 
-	static Rigidbody2DComponent::BodyType RigidBody2DBodyTypeFromString(const std::string& bodyTypeString)
+	template<typename Component>
+	static void SerializeComponent(YAML::Emitter& out, const Component& component)
 	{
-		if (bodyTypeString == "Static")    return Rigidbody2DComponent::BodyType::Static;
-		if (bodyTypeString == "Dynamic")   return Rigidbody2DComponent::BodyType::Dynamic;
-		if (bodyTypeString == "Kinematic") return Rigidbody2DComponent::BodyType::Kinematic;
+		out << YAML::Key << std::string(ComponentReflection<Component>::Name);
+		out << YAML::BeginMap;
+
+		// Fields sharing a group are consecutive and written as one nested map
+		std::string_view group;
+		ForEachField<Component>([&](const auto& field)
+			{
+				using T = typename std::decay_t<decltype(field)>::ValueType;
+
+				T value = field.Get(component);
+				if constexpr (std::is_same_v<T, Shared<Texture2D>>)
+				{
+					if (!value)
+						return;
+				}
+
+				if (field.Group != group)
+				{
+					if (!group.empty())
+						out << YAML::EndMap;
+					if (!field.Group.empty())
+						out << YAML::Key << std::string(field.Group) << YAML::Value << YAML::BeginMap;
+					group = field.Group;
+				}
+
+				out << YAML::Key << std::string(field.Name) << YAML::Value;
+				WriteFieldValue(out, value);
+			});
+
+		if (!group.empty())
+			out << YAML::EndMap;
 
-		NANO_ENGINE_LOG_ASSERT(false, "Unknown body type");
-		return Rigidbody2DComponent::BodyType::Static;
+		out << YAML::EndMap;
 	}
 
-	SceneSerializer::SceneSerializer(const Shared<Scene>& scene)
-		: m_Scene(scene)
+	// Runs on worker threads, so it only reads through const nodes. The non-const
+	// yaml-cpp accessors insert missing keys into the shared document.
+	template<typename Component>
+	static void StageComponent(const YAML::Node& entityNode, uint32_t row, StagedComponents<Component>& staged)
 	{
+		const YAML::Node componentNode = entityNode[ComponentReflection<Component>::Name.data()];
+		if (!componentNode)
+			return;
+
+		Component component = CreateDefaultComponent<Component>();
+		ForEachField<Component>([&](const auto& field)
+			{
+				using T = typename std::decay_t<decltype(field)>::ValueType;
+
+				const YAML::Node parentNode = field.Group.empty() ? componentNode : componentNode[field.Group.data()];
+				if (!parentNode)
+					return;
+
+				// Missing fields keep their defaults, so older scenes still load
+				const YAML::Node fieldNode = parentNode[field.Name.data()];
+				if (!fieldNode)
+					return;
+
+				if constexpr (std::is_same_v<T, Shared<Texture2D>>)
+				{
+					std::string path = fieldNode.as<std::string>();
+					if (!path.empty())
+						staged.Textures.push_back({ (uint32_t)staged.Components.size(), Hash::GenerateFNVHash(field.Name), std::move(path) });
+				}
+				else
+				{
+					T value = field.Get(component);
+					if (ReadFieldValue(fieldNode, value))
+						field.Set(component, value);
+				}
+			});
+
+		staged.Rows.push_back(row);
+		staged.Components.push_back(std::move(component));
 	}
 
-	static void SerializeEntity(YAML::Emitter& out, Entity entity)
+	// Script field values go through the script engine and are applied after the commit
+	struct StagedScriptFields
 	{
-		NANO_ENGINE_LOG_ASSERT(entity.HasComponent<IDComponent>());
+		uint32_t Row;
+		YAML::Node Fields;
+	};
 
-		out << YAML::BeginMap; // Entity
-		out << YAML::Key << "Entity" << YAML::Value << entity.GetUUID();
+	static void StageEntity(const YAML::Node& entityNode, uint32_t row, SceneStagingBatch& batch, std::vector<StagedScriptFields>& scriptFields)
+	{
+		batch.Rows.push_back(row);
+		batch.UUIDs.push_back(entityNode["Entity"].as<uint64_t>());
+
+		ForEachComponentType(ReflectedComponents{}, [&](auto type)
+			{
+				using Component = typename decltype(type)::Type;
+				StageComponent<Component>(entityNode, row, batch.Get<Component>());
+			});
 
-		if (entity.HasComponent<TagComponent>())
+		const YAML::Node scriptComponent = entityNode["ScriptComponent"];
+		if (scriptComponent)
 		{
-			out << YAML::Key << "TagComponent";
-			out << YAML::BeginMap; // TagComponent
+			ScriptComponent sc;
+			sc.ClassName = scriptComponent["ClassName"].as<std::string>();
+			batch.Scripts.Rows.push_back(row);
+			batch.Scripts.Components.push_back(std::move(sc));
+
+			const YAML::Node fields = scriptComponent["ScriptFields"];
+			if (fields)
+				scriptFields.push_back({ row, fields });
+		}
+	}
 
-			auto& tag = entity.GetComponent<TagComponent>().Tag;
-			out << YAML::Key << "Tag" << YAML::Value << tag;
+	// Creates the entities of a parsed Entities sequence in the scene
+	static bool DeserializeEntities(Scene& scene, const std::vector<YAML::Node>& entityNodes, const std::string& source)
+	{
+		Timer timer;
 
-			out << YAML::EndMap; // TagComponent
+		// Workers decode one batch of entities each, the registry is only touched in the commit
+		const size_t entityCount = entityNodes.size();
+		const size_t batchCount = (entityCount + EntitiesPerBatch - 1) / EntitiesPerBatch;
+		std::vector<SceneStagingBatch> batches(batchCount);
+		std::vector<std::vector<StagedScriptFields>> scriptFields(batchCount);
+		try
+		{
+			ThreadPool::ParallelFor(entityCount, EntitiesPerBatch, [&](size_t first, size_t last)
+				{
+					size_t batchIndex = first / EntitiesPerBatch;
+					for (size_t row = first; row < last; row++)
+						StageEntity(entityNodes[row], (uint32_t)row, batches[batchIndex], scriptFields[batchIndex]);
+				});
+		}
+		catch (const YAML::Exception& e)
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to load .NanoCore file '{0}'\n     {1}", source, e.what());
+			return false;
 		}
 
-		if (entity.HasComponent<TransformComponent>())
+		float stagingTime = timer.ElapsedMillis();
+		std::vector<entt::entity> entities = SceneStaging::Commit(scene, batches);
+
+		for (const auto& batchScriptFields : scriptFields)
 		{
-			out << YAML::Key << "TransformComponent";
-			out << YAML::BeginMap; // TransformComponent
+			for (const StagedScriptFields& staged : batchScriptFields)
+			{
+				Entity deserializedEntity = { entities[staged.Row], &scene };
+				const auto& sc = deserializedEntity.GetComponent<ScriptComponent>();
 
-			auto& tc = entity.GetComponent<TransformComponent>();
-			out << YAML::Key << "Translation" << YAML::Value << tc.Translation;
-			out << YAML::Key << "Rotation" << YAML::Value << tc.Rotation;
-			out << YAML::Key << "Scale" << YAML::Value << tc.Scale;
+				Shared<ScriptClass> entityClass = ScriptEngine::GetEntityClass(sc.ClassName);
+				NANO_ENGINE_LOG_ASSERT(entityClass);
+				auto& entityFields = ScriptEngine::GetScriptFieldStorage(deserializedEntity, entityClass);
 
-			out << YAML::EndMap; // TransformComponent
-		}
+				for (const auto& scriptField : staged.Fields)
+				{
+					std::string name = scriptField["Name"].as<std::string>();
+					std::string typeString = scriptField["Type"].as<std::string>();
+					ScriptFieldType type = Utils::ScriptFieldTypeFromString(typeString);
 
-		if (entity.HasComponent<CameraComponent>())
-		{
-			out << YAML::Key << "CameraComponent";
-			out << YAML::BeginMap; // CameraComponent
-
-			auto& cameraComponent = entity.GetComponent<CameraComponent>();
-			auto& camera = cameraComponent.Camera;
-
-			out << YAML::Key << "Camera" << YAML::Value;
-			out << YAML::BeginMap; // Camera
-			out << YAML::Key << "ProjectionType" << YAML::Value << (int)camera.GetProjectionType();
-			out << YAML::Key << "PerspectiveFOV" << YAML::Value << camera.GetPerspectiveVerticalFOV();
-			out << YAML::Key << "PerspectiveNear" << YAML::Value << camera.GetPerspectiveNearClip();
-			out << YAML::Key << "PerspectiveFar" << YAML::Value << camera.GetPerspectiveFarClip();
-			out << YAML::Key << "OrthographicSize" << YAML::Value << camera.GetOrthographicSize();
-			out << YAML::Key << "OrthographicNear" << YAML::Value << camera.GetOrthographicNearClip();
-			out << YAML::Key << "OrthographicFar" << YAML::Value << camera.GetOrthographicFarClip();
-			out << YAML::EndMap; // Camera
-
-			out << YAML::Key << "Primary" << YAML::Value << cameraComponent.Primary;
-			out << YAML::Key << "FixedAspectRatio" << YAML::Value << cameraComponent.FixedAspectRatio;
-
-			out << YAML::EndMap; // CameraComponent
+					const ScriptField* field = entityClass->FindField(name);
+
+					// TODO(Yan): turn this assert into NanoCorenut log warning
+					NANO_ENGINE_LOG_ASSERT(field);
+
+					if (!field)
+						continue;
+
+					switch (type)
+					{
+						READ_SCRIPT_FIELD(Float, float);
+						READ_SCRIPT_FIELD(Double, double);
+						READ_SCRIPT_FIELD(Bool, bool);
+						READ_SCRIPT_FIELD(Char, char);
+						READ_SCRIPT_FIELD(Byte, int8_t);
+						READ_SCRIPT_FIELD(Short, int16_t);
+						READ_SCRIPT_FIELD(Int, int32_t);
+						READ_SCRIPT_FIELD(Long, int64_t);
+						READ_SCRIPT_FIELD(UByte, uint8_t);
+						READ_SCRIPT_FIELD(UShort, uint16_t);
+						READ_SCRIPT_FIELD(UInt, uint32_t);
+						READ_SCRIPT_FIELD(ULong, uint64_t);
+						READ_SCRIPT_FIELD(Vector2, glm::vec2);
+						READ_SCRIPT_FIELD(Vector3, glm::vec3);
+						READ_SCRIPT_FIELD(Vector4, glm::vec4);
+						READ_SCRIPT_FIELD(Entity, UUID);
+					}
+				}
+			}
 		}
 
+		NANO_ENGINE_LOG_INFO("Deserialized '{}' ({} entities, {} batches) in {:.2f}ms, {:.2f}ms decoding",
+			source, entityCount, batchCount, timer.ElapsedMillis(), stagingTime);
+		return true;
+	}
+
+	SceneSerializer::SceneSerializer(const Shared<Scene>& scene)
+		: m_Scene(scene)
+	{
+	}
+
+	// Script fields come from scriptFields when given, otherwise from the script engine
+	static void SerializeEntity(YAML::Emitter& out, Entity entity, const ScriptFieldStorage* scriptFields = nullptr)
+	{
+		NANO_ENGINE_LOG_ASSERT(entity.HasComponent<IDComponent>());
+
+		out << YAML::BeginMap; // Entity
+		out << YAML::Key << "Entity" << YAML::Value << entity.GetUUID();
+
+		ForEachComponentType(ReflectedComponents{}, [&](auto type)
+			{
+				using Component = typename decltype(type)::Type;
+				if (entity.HasComponent<Component>())
+					SerializeComponent(out, entity.GetComponent<Component>());
+			});
+
 		if (entity.HasComponent<ScriptComponent>())
 		{
 			auto& scriptComponent = entity.GetComponent<ScriptComponent>();
@@ -235,24 +424,22 @@ namespace NanoCore {
 			out << YAML::Key << "ClassName" << YAML::Value << scriptComponent.ClassName;
 
 			// Fields
-			Shared<ScriptClass> entityClass = ScriptEngine::GetEntityClass(scriptComponent.ClassName);
-			const auto& fields = entityClass->GetFields();
-			if (fields.size() > 0)
+			Shared<ScriptClass> entityClass = scriptFields ? scriptFields->Class : ScriptEngine::GetEntityClass(scriptComponent.ClassName);
+			if (entityClass && entityClass->GetFields().size() > 0)
 			{
 				out << YAML::Key << "ScriptFields" << YAML::Value;
-				auto& entityFields = ScriptEngine::GetScriptFieldMap(entity);
+				const auto& entityFields = scriptFields ? *scriptFields : ScriptEngine::GetScriptFieldStorage(entity, entityClass);
 				out << YAML::BeginSeq;
-				for (const auto& [name, field] : fields)
+				for (const ScriptField& field : entityClass->GetFields())
 				{
-					if (entityFields.find(name) == entityFields.end())
+					if (!entityFields.IsSet(field))
 						continue;
 
 					out << YAML::BeginMap; // ScriptField
-					out << YAML::Key << "Name" << YAML::Value << name;
+					out << YAML::Key << "Name" << YAML::Value << field.Name;
 					out << YAML::Key << "Type" << YAML::Value << Utils::ScriptFieldTypeToString(field.Type);
 
 					out << YAML::Key << "Data" << YAML::Value;
-					ScriptFieldInstance& scriptField = entityFields.at(name);
 
 					switch (field.Type)
 					{
@@ -281,114 +468,174 @@ namespace NanoCore {
 			out << YAML::EndMap; // ScriptComponent
 		}
 
-		if (entity.HasComponent<SpriteRendererComponent>())
-		{
-			out << YAML::Key << "SpriteRendererComponent";
-			out << YAML::BeginMap; // SpriteRendererComponent
+		out << YAML::EndMap; // Entity
+	}
 
-			auto& spriteRendererComponent = entity.GetComponent<SpriteRendererComponent>();
-			out << YAML::Key << "Color" << YAML::Value << spriteRendererComponent.Color;
-			if (spriteRendererComponent.Texture)
-				out << YAML::Key << "TexturePath" << YAML::Value << spriteRendererComponent.Texture->GetPath();
+	void SceneSerializer::Serialize(const std::string& filepath)
+	{
+		std::vector<std::string> fragments;
+		m_Scene->m_Registry.each([&](auto entityID)
+			{
+				Entity entity = { entityID, m_Scene.Raw() };
+				if (!entity)	
+					return;
 
-			out << YAML::Key << "TilingFactor" << YAML::Value << spriteRendererComponent.TilingFactor;
+				fragments.push_back(SerializeEntityFragment(entity));
+			});
 
-			out << YAML::EndMap; // SpriteRendererComponent
-		}
+		std::vector<const std::string*> entities;
+		entities.reserve(fragments.size());
+		for (const std::string& fragment : fragments)
+			entities.push_back(&fragment);
 
-		if (entity.HasComponent<CircleRendererComponent>())
-		{
-			out << YAML::Key << "CircleRendererComponent";
-			out << YAML::BeginMap; // CircleRendererComponent
+		WriteSceneFile(filepath, entities);
+	}
 
-			auto& circleRendererComponent = entity.GetComponent<CircleRendererComponent>();
-			out << YAML::Key << "Color" << YAML::Value << circleRendererComponent.Color;
-			out << YAML::Key << "Thickness" << YAML::Value << circleRendererComponent.Thickness;
-			out << YAML::Key << "Fade" << YAML::Value << circleRendererComponent.Fade;
+	std::string SceneSerializer::SerializeEntityFragment(Entity entity, const ScriptFieldStorage* scriptFields)
+	{
+		YAML::Emitter out;
+		out << YAML::BeginSeq;
+		SerializeEntity(out, entity, scriptFields);
+		out << YAML::EndSeq;
 
-			out << YAML::EndMap; // CircleRendererComponent
-		}
+		std::string fragment = out.c_str();
+		fragment += '\n';
+		return fragment;
+	}
 
-		if (entity.HasComponent<Rigidbody2DComponent>())
+	bool SceneSerializer::WriteSceneFile(const std::filesystem::path& filepath, const std::vector<const std::string*>& entities)
+	{
+		// Written next to the scene and renamed over it, so a crash never leaves half a file behind
+		std::filesystem::path tempPath = filepath;
+		tempPath += ".tmp";
 		{
-			out << YAML::Key << "Rigidbody2DComponent";
-			out << YAML::BeginMap; // Rigidbody2DComponent
+			std::ofstream fout(tempPath, std::ios::binary | std::ios::trunc);
+			if (!fout)
+			{
+				NANO_ENGINE_LOG_ERROR("Failed to write scene '{}'", filepath.string());
+				return false;
+			}
 
-			auto& rb2dComponent = entity.GetComponent<Rigidbody2DComponent>();
-			out << YAML::Key << "BodyType" << YAML::Value << RigidBody2DBodyTypeToString(rb2dComponent.Type);
-			out << YAML::Key << "FixedRotation" << YAML::Value << rb2dComponent.FixedRotation;
+			fout << "Scene: Untitled\n";
+			fout << (entities.empty() ? "Entities: []\n" : "Entities:\n");
+			for (const std::string* fragment : entities)
+				fout << *fragment;
 
-			out << YAML::EndMap; // Rigidbody2DComponent
+			fout.flush();
+			if (!fout)
+			{
+				NANO_ENGINE_LOG_ERROR("Failed to write scene '{}'", filepath.string());
+				return false;
+			}
 		}
 
-		if (entity.HasComponent<BoxCollider2DComponent>())
+		std::error_code error;
+		std::filesystem::rename(tempPath, filepath, error);
+		if (error)
 		{
-			out << YAML::Key << "BoxCollider2DComponent";
-			out << YAML::BeginMap; // BoxCollider2DComponent
-
-			auto& bc2dComponent = entity.GetComponent<BoxCollider2DComponent>();
-			out << YAML::Key << "Offset" << YAML::Value << bc2dComponent.Offset;
-			out << YAML::Key << "Size" << YAML::Value << bc2dComponent.Size;
-			out << YAML::Key << "Density" << YAML::Value << bc2dComponent.Density;
-			out << YAML::Key << "Friction" << YAML::Value << bc2dComponent.Friction;
-			out << YAML::Key << "Restitution" << YAML::Value << bc2dComponent.Restitution;
-			out << YAML::Key << "RestitutionThreshold" << YAML::Value << bc2dComponent.RestitutionThreshold;
-
-			out << YAML::EndMap; // BoxCollider2DComponent
+			NANO_ENGINE_LOG_ERROR("Failed to replace scene '{}': {}", filepath.string(), error.message());
+			std::filesystem::remove(tempPath, error);
+			return false;
 		}
 
-		if (entity.HasComponent<CircleCollider2DComponent>())
-		{
-			out << YAML::Key << "CircleCollider2DComponent";
-			out << YAML::BeginMap; // CircleCollider2DComponent
-
-			auto& cc2dComponent = entity.GetComponent<CircleCollider2DComponent>();
-			out << YAML::Key << "Offset" << YAML::Value << cc2dComponent.Offset;
-			out << YAML::Key << "Radius" << YAML::Value << cc2dComponent.Radius;
-			out << YAML::Key << "Density" << YAML::Value << cc2dComponent.Density;
-			out << YAML::Key << "Friction" << YAML::Value << cc2dComponent.Friction;
-			out << YAML::Key << "Restitution" << YAML::Value << cc2dComponent.Restitution;
-			out << YAML::Key << "RestitutionThreshold" << YAML::Value << cc2dComponent.RestitutionThreshold;
-
-			out << YAML::EndMap; // CircleCollider2DComponent
-		}
+		// The full file includes everything the journal held
+		std::filesystem::remove(GetJournalPath(filepath), error);
+		return true;
+	}
 
-		out << YAML::EndMap; // Entity
+	std::filesystem::path SceneSerializer::GetJournalPath(const std::filesystem::path& scenePath)
+	{
+		std::filesystem::path journalPath = scenePath;
+		journalPath += ".journal";
+		return journalPath;
 	}
 
-	void SceneSerializer::Serialize(const std::string& filepath)
+	bool SceneSerializer::ApplyJournal(const std::filesystem::path& journalPath)
 	{
-		YAML::Emitter out;
-		out << YAML::BeginMap;
-		out << YAML::Key << "Scene" << YAML::Value << "Untitled";
-		out << YAML::Key << "Entities" << YAML::Value << YAML::BeginSeq;
-		m_Scene->m_Registry.each([&](auto entityID)
+		std::ifstream stream(journalPath, std::ios::binary);
+		if (!stream)
+			return false;
+
+		std::stringstream buffer;
+		buffer << stream.rdbuf();
+		std::string journal = buffer.str();
+
+		// Entries are separate documents, parsed one by one so a torn last entry
+		// from a crash only loses itself
+		constexpr std::string_view marker = GetJournalEntryMarker();
+		size_t entryCount = 0;
+		size_t position = journal.find(marker);
+		while (position != std::string::npos)
+		{
+			size_t begin = position + marker.size();
+			size_t end = journal.find(marker, begin);
+			std::string_view text = std::string_view(journal).substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+			position = end;
+
+			YAML::Node entry;
+			try
 			{
-				Entity entity = { entityID, m_Scene.Raw() };
-				if (!entity)	
-					return;
+				entry = YAML::Load(std::string(text));
+			}
+			catch (const YAML::Exception& e)
+			{
+				NANO_ENGINE_LOG_WARN("Stopped replaying '{}' at a damaged entry: {}", journalPath.string(), e.what());
+				break;
+			}
 
-				SerializeEntity(out, entity);
-			});
-		out << YAML::EndSeq;
-		out << YAML::EndMap;
+			// Changed entities are written whole, so they replace the current ones
+			std::vector<YAML::Node> entityNodes;
+			if (const YAML::Node entities = entry["Entities"])
+			{
+				for (const auto& entity : entities)
+					entityNodes.push_back(entity);
+			}
+
+			std::vector<UUID> removed;
+			if (const YAML::Node destroyed = entry["Destroyed"])
+			{
+				for (const auto& uuid : destroyed)
+					removed.push_back(uuid.as<uint64_t>());
+			}
+			for (const YAML::Node& entity : entityNodes)
+				removed.push_back(entity["Entity"].as<uint64_t>());
+
+			for (UUID uuid : removed)
+			{
+				if (Entity entity = m_Scene->GetEntityByUUID(uuid))
+					m_Scene->DestroyEntity(entity);
+			}
+
+			if (!DeserializeEntities(*m_Scene, entityNodes, journalPath.string()))
+				return false;
+
+			entryCount++;
+		}
 
-		std::ofstream fout(filepath);
-		fout << out.c_str();
+		NANO_ENGINE_LOG_INFO("Replayed {} autosave entries from '{}'", entryCount, journalPath.string());
+		return true;
 	}
 
 	void SceneSerializer::SerializeRuntime(const std::string& filepath)
 	{
-		// Not implemented
-		NANO_ENGINE_LOG_ASSERT(false);
+		SceneSnapshot snapshot;
+		snapshot.Capture(*m_Scene);
+		snapshot.SaveToFile(filepath);
 	}
 
 	bool SceneSerializer::Deserialize(const std::string& filepath)
 	{
+		MappedFile file;
+		if (!file.Open(filepath))
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to open .NanoCore file '{0}'", filepath);
+			return false;
+		}
+
 		YAML::Node data;
 		try
 		{
-			data = YAML::LoadFile(filepath);
+			data = YAML::Load(std::string((const char*)file.GetData(), file.GetSize()));
 		}
 		catch (YAML::ParserException e)
 		{
@@ -399,172 +646,32 @@ namespace NanoCore {
 		if (!data["Scene"])
 			return false;
 
-		std::string sceneName = data["Scene"].as<std::string>();
-		NANO_ENGINE_LOG_INFO("Deserializing scene '{0}'", sceneName);
-
-		auto entities = data["Entities"];
-		if (entities)
+		std::vector<YAML::Node> entityNodes;
+		if (const YAML::Node entities = data["Entities"])
 		{
-			for (auto entity : entities)
-			{
-				uint64_t uuid = entity["Entity"].as<uint64_t>();
-
-				std::string name;
-				auto tagComponent = entity["TagComponent"];
-				if (tagComponent)
-					name = tagComponent["Tag"].as<std::string>();
-
-				NANO_ENGINE_LOG_INFO("Deserialized entity with ID = {0}, name = {1}", uuid, name);
-
-				Entity deserializedEntity = m_Scene->CreateEntityWithUUID(uuid, name);
-
-				auto transformComponent = entity["TransformComponent"];
-				if (transformComponent)
-				{
-					// Entities always have transforms
-					auto& tc = deserializedEntity.GetComponent<TransformComponent>();
-					tc.Translation = transformComponent["Translation"].as<glm::vec3>();
-					tc.Rotation = transformComponent["Rotation"].as<glm::vec3>();
-					tc.Scale = transformComponent["Scale"].as<glm::vec3>();
-				}
-
-				auto cameraComponent = entity["CameraComponent"];
-				if (cameraComponent)
-				{
-					auto& cc = deserializedEntity.AddComponent<CameraComponent>();
-
-					auto cameraProps = cameraComponent["Camera"];
-					cc.Camera.SetProjectionType((SceneCamera::ProjectionType)cameraProps["ProjectionType"].as<int>());
-
-					cc.Camera.SetPerspectiveVerticalFOV(cameraProps["PerspectiveFOV"].as<float>());
-					cc.Camera.SetPerspectiveNearClip(cameraProps["PerspectiveNear"].as<float>());
-					cc.Camera.SetPerspectiveFarClip(cameraProps["PerspectiveFar"].as<float>());
-
-					cc.Camera.SetOrthographicSize(cameraProps["OrthographicSize"].as<float>());
-					cc.Camera.SetOrthographicNearClip(cameraProps["OrthographicNear"].as<float>());
-					cc.Camera.SetOrthographicFarClip(cameraProps["OrthographicFar"].as<float>());
-
-					cc.Primary = cameraComponent["Primary"].as<bool>();
-					cc.FixedAspectRatio = cameraComponent["FixedAspectRatio"].as<bool>();
-				}
-
-				auto scriptComponent = entity["ScriptComponent"];
-				if (scriptComponent)
-				{
-					auto& sc = deserializedEntity.AddComponent<ScriptComponent>();
-					sc.ClassName = scriptComponent["ClassName"].as<std::string>();
-
-					auto scriptFields = scriptComponent["ScriptFields"];
-					if (scriptFields)
-					{
-						Shared<ScriptClass> entityClass = ScriptEngine::GetEntityClass(sc.ClassName);
-						NANO_ENGINE_LOG_ASSERT(entityClass);
-						const auto& fields = entityClass->GetFields();
-						auto& entityFields = ScriptEngine::GetScriptFieldMap(deserializedEntity);
-
-						for (auto scriptField : scriptFields)
-						{
-							std::string name = scriptField["Name"].as<std::string>();
-							std::string typeString = scriptField["Type"].as<std::string>();
-							ScriptFieldType type = Utils::ScriptFieldTypeFromString(typeString);
-
-							ScriptFieldInstance& fieldInstance = entityFields[name];
-
-							// TODO(Yan): turn this assert into NanoCorenut log warning
-							NANO_ENGINE_LOG_ASSERT(fields.find(name) != fields.end());
-
-							if (fields.find(name) == fields.end())
-								continue;
-
-							fieldInstance.Field = fields.at(name);
-
-							switch (type)
-							{
-								READ_SCRIPT_FIELD(Float, float);
-								READ_SCRIPT_FIELD(Double, double);
-								READ_SCRIPT_FIELD(Bool, bool);
-								READ_SCRIPT_FIELD(Char, char);
-								READ_SCRIPT_FIELD(Byte, int8_t);
-								READ_SCRIPT_FIELD(Short, int16_t);
-								READ_SCRIPT_FIELD(Int, int32_t);
-								READ_SCRIPT_FIELD(Long, int64_t);
-								READ_SCRIPT_FIELD(UByte, uint8_t);
-								READ_SCRIPT_FIELD(UShort, uint16_t);
-								READ_SCRIPT_FIELD(UInt, uint32_t);
-								READ_SCRIPT_FIELD(ULong, uint64_t);
-								READ_SCRIPT_FIELD(Vector2, glm::vec2);
-								READ_SCRIPT_FIELD(Vector3, glm::vec3);
-								READ_SCRIPT_FIELD(Vector4, glm::vec4);
-								READ_SCRIPT_FIELD(Entity, UUID);
-							}
-						}
-					}
-
-				}
-
-				auto spriteRendererComponent = entity["SpriteRendererComponent"];
-				if (spriteRendererComponent)
-				{
-					auto& src = deserializedEntity.AddComponent<SpriteRendererComponent>();
-					src.Color = spriteRendererComponent["Color"].as<glm::vec4>();
-					if (spriteRendererComponent["TexturePath"])
-						src.Texture = Texture2D::Create(spriteRendererComponent["TexturePath"].as<std::string>());
-
-					if (spriteRendererComponent["TilingFactor"])
-						src.TilingFactor = spriteRendererComponent["TilingFactor"].as<float>();
-				}
-
-				auto circleRendererComponent = entity["CircleRendererComponent"];
-				if (circleRendererComponent)
-				{
-					auto& crc = deserializedEntity.AddComponent<CircleRendererComponent>();
-					crc.Color = circleRendererComponent["Color"].as<glm::vec4>();
-					crc.Thickness = circleRendererComponent["Thickness"].as<float>();
-					crc.Fade = circleRendererComponent["Fade"].as<float>();
-				}
-
-				auto rigidbody2DComponent = entity["Rigidbody2DComponent"];
-				if (rigidbody2DComponent)
-				{
-					auto& rb2d = deserializedEntity.AddComponent<Rigidbody2DComponent>();
-					rb2d.Type = RigidBody2DBodyTypeFromString(rigidbody2DComponent["BodyType"].as<std::string>());
-					rb2d.FixedRotation = rigidbody2DComponent["FixedRotation"].as<bool>();
-				}
+			entityNodes.reserve(entities.size());
+			for (const auto& entity : entities)
+				entityNodes.push_back(entity);
+		}
 
-				auto boxCollider2DComponent = entity["BoxCollider2DComponent"];
-				if (boxCollider2DComponent)
-				{
-					auto& bc2d = deserializedEntity.AddComponent<BoxCollider2DComponent>();
-					bc2d.Offset = boxCollider2DComponent["Offset"].as<glm::vec2>();
-					bc2d.Size = boxCollider2DComponent["Size"].as<glm::vec2>();
-					bc2d.Density = boxCollider2DComponent["Density"].as<float>();
-					bc2d.Friction = boxCollider2DComponent["Friction"].as<float>();
-					bc2d.Restitution = boxCollider2DComponent["Restitution"].as<float>();
-					bc2d.RestitutionThreshold = boxCollider2DComponent["RestitutionThreshold"].as<float>();
-				}
+		if (!DeserializeEntities(*m_Scene, entityNodes, filepath))
+			return false;
 
-				auto circleCollider2DComponent = entity["CircleCollider2DComponent"];
-				if (circleCollider2DComponent)
-				{
-					auto& cc2d = deserializedEntity.AddComponent<CircleCollider2DComponent>();
-					cc2d.Offset = circleCollider2DComponent["Offset"].as<glm::vec2>();
-					cc2d.Radius = circleCollider2DComponent["Radius"].as<float>();
-					cc2d.Density = circleCollider2DComponent["Density"].as<float>();
-					cc2d.Friction = circleCollider2DComponent["Friction"].as<float>();
-					cc2d.Restitution = circleCollider2DComponent["Restitution"].as<float>();
-					cc2d.RestitutionThreshold = circleCollider2DComponent["RestitutionThreshold"].as<float>();
-				}
-			}
-		}
+		// Changes autosaved after the last full save
+		std::filesystem::path journalPath = GetJournalPath(filepath);
+		if (std::filesystem::exists(journalPath))
+			ApplyJournal(journalPath);
 
 		return true;
 	}
 
 	bool SceneSerializer::DeserializeRuntime(const std::string& filepath)
 	{
-		// Not implemented
-		NANO_ENGINE_LOG_ASSERT(false);
-		return false;
+		SceneSnapshot snapshot;
+		if (!snapshot.LoadFromFile(filepath))
+			return false;
+
+		return snapshot.Restore(*m_Scene);
 	}
 
 }
\ No newline at end of file
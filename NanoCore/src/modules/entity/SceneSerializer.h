@@ -2,8 +2,12 @@
 
 #include "Scene.h"
 
+#include <filesystem>
+
 namespace NanoCore{
 
+	struct ScriptFieldStorage;
+
 	class SceneSerializer
 	{
 	public:
@@ -14,6 +18,17 @@ namespace NanoCore{
 
 		bool Deserialize(const std::string& filepath);
 		bool DeserializeRuntime(const std::string& filepath);
+
+		// Replays autosave entries appended after the last full save, Deserialize() does this on its own
+		bool ApplyJournal(const std::filesystem::path& journalPath);
+
+		// One entity as an item of the scene's Entities sequence. Script fields come from
+		// scriptFields when given, so snapshots can be written away from the script engine.
+		static std::string SerializeEntityFragment(Entity entity, const ScriptFieldStorage* scriptFields = nullptr);
+		// Writes a scene from entity fragments and atomically replaces the file, the journal is dropped
+		static bool WriteSceneFile(const std::filesystem::path& filepath, const std::vector<const std::string*>& entities);
+		static std::filesystem::path GetJournalPath(const std::filesystem::path& scenePath);
+		static constexpr std::string_view GetJournalEntryMarker() { return "--- # journal\n"; }
 	private:
 		Shared<Scene> m_Scene;
 	};
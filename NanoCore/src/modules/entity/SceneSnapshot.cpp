@@ -0,0 +1,616 @@
+#include "ncpch.h"
+#include "SceneSnapshot.h"
+#include "SceneBinaryFormat.h"
+#include "SceneStaging.h"
+
+#include "modules/physics/PhysicsWorld2D.h"
+#include "modules/utils/DeltaCodec.h"
+
+namespace NanoCore {
+
+	namespace SceneBinary {
+
+		// "NCSR", a runtime snapshot in the .nanoscene layout
+		static constexpr uint32_t SnapshotMagic = 0x5253434E;
+		static constexpr uint32_t SnapshotVersion = 1;
+
+		// Blocks only snapshots have
+		static constexpr uint32_t BodiesBlock = Hash::GenerateFNVHash("Bodies");
+		static constexpr uint32_t SceneStateBlock = Hash::GenerateFNVHash("SceneState");
+
+		// PhysicsWorld2D follows these through update signals, restoring different
+		// values into one has to patch it or its body keeps the old settings
+		using PhysicsComponents = ComponentGroup<Rigidbody2DComponent, BoxCollider2DComponent, CircleCollider2DComponent>;
+
+		template<typename Component>
+		static bool ReflectedFieldsEqual(const Component& a, const Component& b)
+		{
+			bool equal = true;
+			ForEachField<Component>([&](const auto& field) { equal = equal && field.Get(a) == field.Get(b); });
+			return equal;
+		}
+
+		// Marks the entity row of every block row, false if a row points outside the
+		// snapshot or two rows belong to the same entity
+		static bool MarkOwners(const uint32_t* owners, uint32_t count, std::vector<uint8_t>& owned)
+		{
+			for (uint32_t row = 0; row < count; row++)
+			{
+				if (owners[row] >= owned.size() || owned[owners[row]])
+					return false;
+
+				owned[owners[row]] = 1;
+			}
+			return true;
+		}
+
+		template<typename Component>
+		static bool RestoreComponents(entt::registry& registry, Scene* scene, const ImageReader& image, const std::vector<entt::entity>& entities, const EntityRows& entityRows, LoadContext& context)
+		{
+			BlockReader block(image, GetComponentTypeID<Component>());
+			const uint32_t count = block.GetCount();
+			const uint32_t* owners = block.ReadColumn<uint32_t>(EntityColumn);
+			auto columns = ReadFieldColumns<Component>(block);
+			if (!block.IsValid() || (count > 0 && !owners))
+				return false;
+
+			std::vector<uint8_t> owned(entities.size(), 0);
+			if (!MarkOwners(owners, count, owned))
+				return false;
+
+			// Removed first, removing moves the remaining components around in the storage
+			{
+				std::vector<entt::entity> removed;
+				auto view = registry.view<Component>();
+				for (auto entity : view)
+				{
+					uint32_t row = entityRows.Find(entity);
+					if (row == EntityRows::InvalidRow || !owned[row])
+						removed.push_back(entity);
+				}
+				registry.remove<Component>(removed.begin(), removed.end());
+			}
+
+			PrepareColumns<Component>(columns, count, context);
+
+			// Components that are still there are decoded in place, which leaves runtime members alone
+			std::vector<Component*> targets(count);
+			std::vector<uint32_t> added;
+			for (uint32_t row = 0; row < count; row++)
+			{
+				targets[row] = registry.try_get<Component>(entities[owners[row]]);
+				if (!targets[row])
+					added.push_back(row);
+			}
+
+			std::vector<Component> previous;
+			if constexpr (ComponentGroupContains<Component>(PhysicsComponents{}))
+			{
+				previous.resize(count);
+				for (uint32_t row = 0; row < count; row++)
+				{
+					if (targets[row])
+						previous[row] = *targets[row];
+				}
+			}
+
+			// Fixtures are sized by the scale, moves are left to the restored bodies
+			std::vector<glm::vec3> previousScales;
+			if constexpr (std::is_same_v<Component, TransformComponent>)
+			{
+				previousScales.resize(count);
+				for (uint32_t row = 0; row < count; row++)
+				{
+					if (targets[row])
+						previousScales[row] = targets[row]->Scale;
+				}
+			}
+
+			ThreadPool::ParallelFor(count, RowsPerBatch, [&](size_t first, size_t last)
+				{
+					for (size_t row = first; row < last; row++)
+					{
+						if (targets[row])
+							DecodeRow(*targets[row], (uint32_t)row, columns, context);
+					}
+				});
+
+			if constexpr (ComponentGroupContains<Component>(PhysicsComponents{}))
+			{
+				for (uint32_t row = 0; row < count; row++)
+				{
+					if (targets[row] && !ReflectedFieldsEqual(previous[row], *targets[row]))
+						registry.patch<Component>(entities[owners[row]]);
+				}
+			}
+
+			if constexpr (std::is_same_v<Component, TransformComponent>)
+			{
+				for (uint32_t row = 0; row < count; row++)
+				{
+					if (targets[row] && previousScales[row] != targets[row]->Scale)
+						registry.patch<Component>(entities[owners[row]]);
+				}
+			}
+
+			for (uint32_t row : added)
+			{
+				Component component = CreateDefaultComponent<Component>();
+				DecodeRow(component, row, columns, context);
+				Entity{ entities[owners[row]], scene }.AddComponent<Component>(std::move(component));
+			}
+
+			return true;
+		}
+
+		static bool RestoreScripts(entt::registry& registry, Scene* scene, const ImageReader& image, const std::vector<entt::entity>& entities, const EntityRows& entityRows, LoadContext& context)
+		{
+			ScriptBlockReader scripts(image);
+			if (!scripts.IsValid())
+				return false;
+
+			std::vector<uint8_t> owned(entities.size(), 0);
+			if (!MarkOwners(scripts.Owners, scripts.GetCount(), owned))
+				return false;
+
+			const bool running = scene->IsRunning();
+			{
+				std::vector<entt::entity> removed;
+				auto view = registry.view<ScriptComponent>();
+				for (auto entity : view)
+				{
+					uint32_t row = entityRows.Find(entity);
+					if (row == EntityRows::InvalidRow || !owned[row])
+						removed.push_back(entity);
+				}
+
+				for (entt::entity entity : removed)
+				{
+					if (running)
+						ScriptEngine::OnDestroyEntity({ entity, scene });
+					registry.remove<ScriptComponent>(entity);
+				}
+			}
+
+			// Scripts that are new or changed class get an instance once every component is in place
+			std::vector<entt::entity> created;
+			for (uint32_t row = 0; row < scripts.GetCount(); row++)
+			{
+				entt::entity entity = entities[scripts.Owners[row]];
+				std::string_view className = context.GetString(scripts.ClassNames[row]);
+
+				ScriptComponent* sc = registry.try_get<ScriptComponent>(entity);
+				if (sc && sc->ClassName == className)
+					continue;
+
+				if (sc)
+				{
+					if (running)
+						ScriptEngine::OnDestroyEntity({ entity, scene });
+					sc->ClassName = className;
+				}
+				else
+				{
+					Entity{ entity, scene }.AddComponent<ScriptComponent>().ClassName = className;
+				}
+				created.push_back(entity);
+			}
+
+			if (running)
+			{
+				for (entt::entity entity : created)
+					ScriptEngine::OnCreateEntity({ entity, scene });
+			}
+
+			// Applied after every instance exists, so Entity fields resolve to the script objects
+			ScriptFieldStorage instanceFields;
+			for (uint32_t row = 0; row < scripts.GetCount(); row++)
+			{
+				if (!scripts.HasFields(row))
+					continue;
+
+				Entity entity = { entities[scripts.Owners[row]], scene };
+				if (running)
+				{
+					Shared<ScriptInstance> instance = ScriptEngine::GetEntityScriptInstance(entity.GetUUID());
+					if (!instance)
+						continue;
+
+					Shared<ScriptClass> entityClass = instance->GetScriptClass();
+					instanceFields.Class = entityClass;
+					instanceFields.Buffer.assign(entityClass->GetFieldStorageSize(), 0);
+					instanceFields.AssignedFields.assign(entityClass->GetFields().size(), 0);
+					if (!scripts.ReadFields(row, context, *entityClass, instanceFields))
+						return false;
+
+					ScriptEngine::ApplyInstanceFieldStorage(entity.GetUUID(), instanceFields);
+				}
+				else
+				{
+					// Outside of play mode the values are the ones new instances start with
+					Shared<ScriptClass> entityClass = ScriptEngine::GetEntityClass(std::string(context.GetString(scripts.ClassNames[row])));
+					if (!entityClass)
+						continue;
+
+					if (!scripts.ReadFields(row, context, *entityClass, ScriptEngine::GetScriptFieldStorage(entity, entityClass)))
+						return false;
+				}
+			}
+
+			return true;
+		}
+
+		static bool RestoreBodies(PhysicsWorld2D& physics, const ImageReader& image, const std::vector<entt::entity>& entities)
+		{
+			BlockReader block(image, BodiesBlock);
+			const uint32_t* owners = block.ReadColumn<uint32_t>(EntityColumn);
+			const glm::vec2* positions = block.ReadColumn<glm::vec2>(Hash::GenerateFNVHash("Position"));
+			const float* angles = block.ReadColumn<float>(Hash::GenerateFNVHash("Angle"));
+			const glm::vec2* linearVelocities = block.ReadColumn<glm::vec2>(Hash::GenerateFNVHash("LinearVelocity"));
+			const float* angularVelocities = block.ReadColumn<float>(Hash::GenerateFNVHash("AngularVelocity"));
+			const uint8_t* awake = block.ReadColumn<uint8_t>(Hash::GenerateFNVHash("Awake"));
+
+			if (!block.IsValid() || (block.GetCount() > 0 && !(owners && positions && angles && linearVelocities && angularVelocities && awake)))
+				return false;
+
+			std::vector<Physics2DBodyState> states(block.GetCount());
+			for (uint32_t row = 0; row < block.GetCount(); row++)
+			{
+				if (owners[row] >= entities.size())
+					return false;
+
+				Physics2DBodyState& state = states[row];
+				state.Entity = entities[owners[row]];
+				state.Position = positions[row];
+				state.Angle = angles[row];
+				state.LinearVelocity = linearVelocities[row];
+				state.AngularVelocity = angularVelocities[row];
+				state.Awake = awake[row] != 0;
+			}
+
+			physics.RestoreBodyStates(states);
+			return true;
+		}
+
+	}
+
+	using namespace SceneBinary;
+
+	void SceneSnapshot::Capture(Scene& scene)
+	{
+		RA_PROFILE_FUNCTION();
+
+		entt::registry& registry = scene.m_Registry;
+		PhysicsWorld2D* physics = scene.GetPhysicsWorld2D();
+
+		// Bodies can't be read while a pipelined step is in flight
+		if (physics)
+			physics->WaitForSimulation();
+
+		Writer writer;
+
+		std::vector<entt::entity> entities;
+		EntityRows entityRows;
+		{
+			auto view = registry.view<IDComponent>();
+			entities.assign(view.begin(), view.end());
+			entityRows.Build(registry, entities);
+		}
+
+		const uint32_t entityCount = (uint32_t)entities.size();
+		if (entityCount > 0)
+		{
+			std::vector<uint64_t> uuids(entityCount);
+			for (uint32_t row = 0; row < entityCount; row++)
+				uuids[row] = registry.get<IDComponent>(entities[row]).ID;
+
+			writer.BeginBlock(EntitiesBlock, entityCount);
+			writer.WriteColumn(Hash::GenerateFNVHash("UUID"), uuids);
+		}
+
+		ForEachComponentType(ReflectedComponents{}, [&](auto type)
+			{
+				WriteComponentBlock<typename decltype(type)::Type>(writer, registry, entityRows);
+			});
+
+		// In play mode the field values come from the live instances
+		WriteScriptBlocks(writer, &scene, registry, entityRows, scene.IsRunning());
+
+		if (physics)
+		{
+			std::vector<uint32_t> owners;
+			std::vector<glm::vec2> positions, linearVelocities;
+			std::vector<float> angles, angularVelocities;
+			std::vector<uint8_t> awake;
+
+			auto view = registry.view<Rigidbody2DComponent>();
+			for (auto entity : view)
+			{
+				// Bodies added since the last step are created from their transforms on restore
+				const Rigidbody2DComponent& rb2d = view.get<Rigidbody2DComponent>(entity);
+				uint32_t row = entityRows.Find(entity);
+				if (!rb2d.RuntimeBody || row == EntityRows::InvalidRow)
+					continue;
+
+				Physics2DBodyState state = PhysicsWorld2D::GetBodyState(rb2d.RuntimeBody);
+				owners.push_back(row);
+				positions.push_back(state.Position);
+				angles.push_back(state.Angle);
+				linearVelocities.push_back(state.LinearVelocity);
+				angularVelocities.push_back(state.AngularVelocity);
+				awake.push_back(state.Awake);
+			}
+
+			if (!owners.empty())
+			{
+				writer.BeginBlock(BodiesBlock, (uint32_t)owners.size());
+				writer.WriteColumn(EntityColumn, owners);
+				writer.WriteColumn(Hash::GenerateFNVHash("Position"), positions);
+				writer.WriteColumn(Hash::GenerateFNVHash("Angle"), angles);
+				writer.WriteColumn(Hash::GenerateFNVHash("LinearVelocity"), linearVelocities);
+				writer.WriteColumn(Hash::GenerateFNVHash("AngularVelocity"), angularVelocities);
+				writer.WriteColumn(Hash::GenerateFNVHash("Awake"), awake);
+			}
+		}
+
+		writer.BeginBlock(SceneStateBlock, 1);
+		writer.WriteColumn(Hash::GenerateFNVHash("FixedTimeAccumulator"), std::vector<float>{ scene.m_FixedTimeAccumulator });
+
+		FileHeader header;
+		header.Magic = SnapshotMagic;
+		header.Version = SnapshotVersion;
+		header.EntityCount = entityCount;
+		writer.WriteImage(m_Data, header, std::string());
+		m_Textures = std::move(writer.GetTextures());
+	}
+
+	bool SceneSnapshot::Restore(Scene& scene) const
+	{
+		RA_PROFILE_FUNCTION();
+
+		auto corrupt = [](const char* reason)
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to restore scene snapshot: {}", reason);
+			return false;
+		};
+
+		ImageReader image;
+		const char* error = nullptr;
+		if (!image.Open(m_Data.data(), m_Data.size(), SnapshotMagic, error))
+			return corrupt(error);
+
+		if (image.GetHeader().Version != SnapshotVersion)
+			return corrupt("taken by a different engine version");
+
+		LoadContext context;
+		if (!context.Init(image))
+			return corrupt("invalid UUID array block");
+
+		// Textures the snapshot still holds aren't created again
+		for (const auto& [offset, texture] : m_Textures)
+			context.Textures.emplace(offset, texture);
+
+		entt::registry& registry = scene.m_Registry;
+		PhysicsWorld2D* physics = scene.GetPhysicsWorld2D();
+		if (physics)
+			physics->WaitForSimulation();
+
+		const uint32_t entityCount = image.GetHeader().EntityCount;
+		BlockReader entityBlock(image, EntitiesBlock);
+		const uint64_t* uuids = entityBlock.ReadColumn<uint64_t>(Hash::GenerateFNVHash("UUID"));
+		if (!entityBlock.IsValid() || entityBlock.GetCount() != entityCount || (entityCount > 0 && !uuids))
+			return corrupt("entity block doesn't match the entity count");
+
+		// Captured entities are matched to live ones by UUID, live ones the snapshot doesn't have are destroyed
+		std::vector<entt::entity> entities(entityCount, (entt::entity)entt::null);
+		{
+			for (uint32_t row = 0; row < entityCount; row++)
+			{
+				auto it = scene.m_EntityMap.find(uuids[row]);
+				if (it != scene.m_EntityMap.end())
+					entities[row] = it->second;
+			}
+
+			EntityRows matched;
+			matched.Build(registry, entities);
+
+			std::vector<entt::entity> destroyed;
+			auto view = registry.view<IDComponent>();
+			for (auto entity : view)
+			{
+				if (matched.Find(entity) == EntityRows::InvalidRow)
+					destroyed.push_back(entity);
+			}
+
+			for (entt::entity entity : destroyed)
+				scene.DestroyEntity({ entity, &scene });
+
+			for (uint32_t row = 0; row < entityCount; row++)
+			{
+				if (entities[row] == entt::null)
+					entities[row] = scene.CreateEntityWithUUID(uuids[row]);
+			}
+		}
+
+		EntityRows entityRows;
+		entityRows.Build(registry, entities);
+
+		bool componentsRestored = true;
+		ForEachComponentType(ReflectedComponents{}, [&](auto type)
+			{
+				using Component = typename decltype(type)::Type;
+				if (!componentsRestored)
+					return;
+
+				componentsRestored = RestoreComponents<Component>(registry, &scene, image, entities, entityRows, context);
+				if (!componentsRestored)
+					NANO_ENGINE_LOG_ERROR("Invalid {} block", ComponentReflection<Component>::Name);
+			});
+
+		if (!componentsRestored)
+			return corrupt("invalid component block");
+
+		if (!RestoreScripts(registry, &scene, image, entities, entityRows, context))
+			return corrupt("invalid script block");
+
+		if (physics && !RestoreBodies(*physics, image, entities))
+			return corrupt("invalid body block");
+
+		BlockReader stateBlock(image, SceneStateBlock);
+		if (const float* accumulator = stateBlock.ReadColumn<float>(Hash::GenerateFNVHash("FixedTimeAccumulator")))
+			scene.m_FixedTimeAccumulator = accumulator[0];
+
+		return true;
+	}
+
+	bool SceneSnapshot::SaveToFile(const std::filesystem::path& filepath) const
+	{
+		std::ofstream stream(filepath, std::ios::binary | std::ios::trunc);
+		stream.write((const char*)m_Data.data(), m_Data.size());
+		if (!stream)
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to write scene snapshot '{}'", filepath.string());
+			return false;
+		}
+		return true;
+	}
+
+	bool SceneSnapshot::LoadFromFile(const std::filesystem::path& filepath)
+	{
+		Clear();
+
+		std::ifstream stream(filepath, std::ios::binary | std::ios::ate);
+		if (!stream)
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to open scene snapshot '{}'", filepath.string());
+			return false;
+		}
+
+		m_Data.resize((size_t)stream.tellg());
+		stream.seekg(0);
+		stream.read((char*)m_Data.data(), m_Data.size());
+		if (!stream)
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to read scene snapshot '{}'", filepath.string());
+			Clear();
+			return false;
+		}
+		return true;
+	}
+
+	void SceneSnapshot::Clear()
+	{
+		m_Data.clear();
+		m_Textures.clear();
+	}
+
+	SceneSnapshotHistory::SceneSnapshotHistory(uint32_t capacity)
+		: m_Capacity(std::max(capacity, 1u))
+	{
+		m_Deltas.resize(m_Capacity - 1);
+	}
+
+	void SceneSnapshotHistory::Push(Scene& scene, uint64_t frame)
+	{
+		RA_PROFILE_FUNCTION();
+
+		NANO_ENGINE_LOG_ASSERT(!m_HasNewest || frame > m_NewestFrame, "Frames have to be pushed in increasing order!");
+
+		if (!m_HasNewest || m_Deltas.empty())
+		{
+			m_Newest.Capture(scene);
+			m_NewestFrame = frame;
+			m_HasNewest = true;
+			return;
+		}
+
+		m_Scratch.Capture(scene);
+
+		if (m_DeltaCount == (uint32_t)m_Deltas.size())
+		{
+			m_FirstDelta = (m_FirstDelta + 1) % (uint32_t)m_Deltas.size();
+			m_DeltaCount--;
+		}
+
+		// The previous newest frame becomes a delta against the new one
+		DeltaFrame& delta = GetDelta(m_DeltaCount++);
+		delta.Frame = m_NewestFrame;
+		DeltaCodec::Encode(m_Scratch.m_Data, m_Newest.m_Data, delta.Delta);
+		delta.Textures = std::move(m_Newest.m_Textures);
+
+		std::swap(m_Newest, m_Scratch);
+		m_NewestFrame = frame;
+	}
+
+	bool SceneSnapshotHistory::Rollback(Scene& scene, uint64_t frame)
+	{
+		RA_PROFILE_FUNCTION();
+
+		if (!Contains(frame))
+		{
+			NANO_ENGINE_LOG_WARN("Frame {} is not in the snapshot history", frame);
+			return false;
+		}
+
+		// Every delta rebuilds the frame before it from the one after, newer frames are dropped on the way
+		while (m_NewestFrame != frame)
+		{
+			DeltaFrame& delta = GetDelta(m_DeltaCount - 1);
+			if (!DeltaCodec::Decode(m_Newest.m_Data, delta.Delta, m_DecodeBuffer))
+			{
+				NANO_ENGINE_LOG_ERROR("Snapshot delta of frame {} is damaged, clearing the history", delta.Frame);
+				Clear();
+				return false;
+			}
+
+			std::swap(m_Newest.m_Data, m_DecodeBuffer);
+			m_Newest.m_Textures = std::move(delta.Textures);
+			m_NewestFrame = delta.Frame;
+			m_DeltaCount--;
+		}
+
+		return m_Newest.Restore(scene);
+	}
+
+	bool SceneSnapshotHistory::Contains(uint64_t frame) const
+	{
+		if (!m_HasNewest)
+			return false;
+
+		if (frame == m_NewestFrame)
+			return true;
+
+		for (uint32_t i = 0; i < m_DeltaCount; i++)
+		{
+			if (GetDelta(i).Frame == frame)
+				return true;
+		}
+		return false;
+	}
+
+	void SceneSnapshotHistory::Clear()
+	{
+		m_Newest.Clear();
+		m_HasNewest = false;
+		m_NewestFrame = 0;
+
+		for (DeltaFrame& delta : m_Deltas)
+			delta.Textures.clear();
+		m_FirstDelta = 0;
+		m_DeltaCount = 0;
+	}
+
+	uint64_t SceneSnapshotHistory::GetOldestFrame() const
+	{
+		return m_DeltaCount > 0 ? GetDelta(0).Frame : m_NewestFrame;
+	}
+
+	size_t SceneSnapshotHistory::GetMemoryUsage() const
+	{
+		size_t size = m_Newest.GetData().size();
+		for (uint32_t i = 0; i < m_DeltaCount; i++)
+			size += GetDelta(i).Delta.size();
+		return size;
+	}
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Scene.h"
+#include "modules/rendering/Texture.h"
+
+#include <filesystem>
+
+namespace NanoCore {
+
+	// Binary image of everything a running scene needs to carry on from a given frame:
+	// components, Box2D body motion, live script field values and the fixed step
+	// accumulator. It uses the .nanoscene block layout, so capturing one is a column
+	// copy per component type. Used for quick-save, test fixtures and rollback.
+	class SceneSnapshot
+	{
+	public:
+		// Reuses the buffer of the previous capture
+		void Capture(Scene& scene);
+
+		// Brings the scene back to the captured state in place. Entities are matched by UUID
+		// and existing components are overwritten field by field, so rigidbodies and colliders
+		// stay bound to their Box2D bodies and fixtures. Only entities and components that
+		// came or went since the capture go through the registry. False if the image is damaged.
+		bool Restore(Scene& scene) const;
+
+		bool SaveToFile(const std::filesystem::path& filepath) const;
+		bool LoadFromFile(const std::filesystem::path& filepath);
+
+		const std::vector<uint8_t>& GetData() const { return m_Data; }
+		bool IsEmpty() const { return m_Data.empty(); }
+		void Clear();
+	private:
+		std::vector<uint8_t> m_Data;
+
+		// Textures referenced by the image, by the string offset of their path. Snapshots
+		// loaded from disk have none and create their textures when restored.
+		std::vector<std::pair<uint32_t, Shared<Texture2D>>> m_Textures;
+
+		friend class SceneSnapshotHistory;
+	};
+
+	// The last few frames of a running scene for rollback. The newest snapshot is kept
+	// whole and every older one as a delta against the frame after it, so a push only
+	// encodes what changed since the previous frame and the oldest frame can be dropped.
+	class SceneSnapshotHistory
+	{
+	public:
+		SceneSnapshotHistory(uint32_t capacity);
+
+		// Frames have to be pushed in increasing order
+		void Push(Scene& scene, uint64_t frame);
+		// Restores a recorded frame and forgets the ones after it, they are pushed again
+		// as the scene is simulated forward
+		bool Rollback(Scene& scene, uint64_t frame);
+		bool Contains(uint64_t frame) const;
+		void Clear();
+
+		uint32_t GetCapacity() const { return m_Capacity; }
+		uint32_t GetFrameCount() const { return m_HasNewest ? m_DeltaCount + 1 : 0; }
+		uint64_t GetOldestFrame() const;
+		uint64_t GetNewestFrame() const { return m_NewestFrame; }
+		// Bytes held by the newest snapshot and the deltas
+		size_t GetMemoryUsage() const;
+	private:
+		struct DeltaFrame
+		{
+			uint64_t Frame = 0;
+			std::vector<uint8_t> Delta;
+			std::vector<std::pair<uint32_t, Shared<Texture2D>>> Textures;
+		};
+
+		DeltaFrame& GetDelta(uint32_t index) { return m_Deltas[(m_FirstDelta + index) % m_Deltas.size()]; }
+		const DeltaFrame& GetDelta(uint32_t index) const { return m_Deltas[(m_FirstDelta + index) % m_Deltas.size()]; }
+	private:
+		uint32_t m_Capacity = 0;
+
+		SceneSnapshot m_Newest;
+		uint64_t m_NewestFrame = 0;
+		bool m_HasNewest = false;
+
+		// Ring of the older frames, oldest first
+		std::vector<DeltaFrame> m_Deltas;
+		uint32_t m_FirstDelta = 0;
+		uint32_t m_DeltaCount = 0;
+
+		// Reused between pushes and rollbacks
+		SceneSnapshot m_Scratch;
+		std::vector<uint8_t> m_DecodeBuffer;
+	};
+
+}
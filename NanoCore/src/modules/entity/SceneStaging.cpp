@@ -0,0 +1,152 @@
+#include "ncpch.h"
+#include "SceneStaging.h"
+#include "AssetManager.h"
+
+namespace NanoCore {
+
+	template<typename Component>
+	static constexpr bool IsAddedToEveryEntity = std::is_same_v<Component, TagComponent> || std::is_same_v<Component, TransformComponent>;
+
+	template<typename Component>
+	static void SetStagedTexture(Component& component, uint32_t fieldHash, const Shared<Texture2D>& texture)
+	{
+		if constexpr (ComponentGroupContains<Component>(ReflectedComponents{}))
+		{
+			ForEachField<Component>([&](const auto& field)
+				{
+					using T = typename std::decay_t<decltype(field)>::ValueType;
+					if constexpr (std::is_same_v<T, Shared<Texture2D>>)
+					{
+						if (Hash::GenerateFNVHash(field.Name) == fieldHash)
+							field.Set(component, texture);
+					}
+				});
+		}
+	}
+
+	template<typename Component>
+	void SceneStaging::CommitComponents(Scene& scene, std::vector<SceneStagingBatch>& batches, const std::vector<entt::entity>& entities)
+	{
+		std::unordered_map<std::string, Shared<Texture2D>> textures;
+
+		std::vector<entt::entity> targets;
+		std::vector<Component> components;
+		if constexpr (IsAddedToEveryEntity<Component>)
+		{
+			targets = entities;
+			components.resize(entities.size(), CreateDefaultComponent<Component>());
+		}
+		else
+		{
+			size_t count = 0;
+			for (SceneStagingBatch& batch : batches)
+				count += batch.Get<Component>().Components.size();
+
+			if (count == 0)
+				return;
+
+			targets.reserve(count);
+			components.reserve(count);
+		}
+
+		// Images are decoded on the asset workers while the components are moved, only the uploads happen below
+		for (SceneStagingBatch& batch : batches)
+		{
+			for (const auto& pending : batch.Get<Component>().Textures)
+				AssetManager::RequestLoad(AssetManager::ImportAsset(pending.Path));
+		}
+
+		for (SceneStagingBatch& batch : batches)
+		{
+			StagedComponents<Component>& staged = batch.Get<Component>();
+
+			// Where each staged component ends up in the insert
+			size_t first = components.size();
+			auto target = [&](size_t index) -> Component&
+			{
+				if constexpr (IsAddedToEveryEntity<Component>)
+					return components[staged.Rows[index]];
+				else
+					return components[first + index];
+			};
+
+			for (size_t i = 0; i < staged.Components.size(); i++)
+			{
+				if constexpr (IsAddedToEveryEntity<Component>)
+				{
+					components[staged.Rows[i]] = std::move(staged.Components[i]);
+				}
+				else
+				{
+					targets.push_back(entities[staged.Rows[i]]);
+					components.push_back(std::move(staged.Components[i]));
+				}
+			}
+
+			for (const auto& pending : staged.Textures)
+			{
+				auto [it, created] = textures.try_emplace(pending.Path);
+				if (created)
+					it->second = AssetManager::GetTexture(pending.Path);
+
+				SetStagedTexture(target(pending.Index), pending.FieldHash, it->second);
+			}
+
+			staged = {};
+		}
+
+		// Same as OnComponentAdded<CameraComponent>, which range inserts don't call
+		if constexpr (std::is_same_v<Component, CameraComponent>)
+		{
+			if (scene.m_ViewportWidth > 0 && scene.m_ViewportHeight > 0)
+			{
+				for (CameraComponent& component : components)
+					component.Camera.SetViewportSize(scene.m_ViewportWidth, scene.m_ViewportHeight);
+			}
+		}
+
+		entt::registry& registry = scene.m_Registry;
+		registry.reserve<Component>(registry.size<Component>() + components.size());
+		registry.insert<Component>(targets.begin(), targets.end(), components.begin(), components.end());
+	}
+
+	std::vector<entt::entity> SceneStaging::Commit(Scene& scene, std::vector<SceneStagingBatch>& batches)
+	{
+		RA_PROFILE_FUNCTION();
+
+		size_t entityCount = 0;
+		for (const SceneStagingBatch& batch : batches)
+			entityCount += batch.Rows.size();
+
+		entt::registry& registry = scene.m_Registry;
+		std::vector<entt::entity> entities(entityCount);
+		registry.reserve(registry.size() + entityCount);
+		registry.create(entities.begin(), entities.end());
+
+		std::vector<IDComponent> ids(entityCount);
+		scene.m_EntityMap.reserve(scene.m_EntityMap.size() + entityCount);
+		for (const SceneStagingBatch& batch : batches)
+		{
+			for (size_t i = 0; i < batch.Rows.size(); i++)
+			{
+				uint32_t row = batch.Rows[i];
+				NANO_ENGINE_LOG_ASSERT(row < entityCount, "Staged rows have to cover the whole load!");
+
+				ids[row].ID = batch.UUIDs[i];
+				scene.m_EntityMap[batch.UUIDs[i]] = entities[row];
+			}
+		}
+
+		registry.reserve<IDComponent>(registry.size<IDComponent>() + entityCount);
+		registry.insert<IDComponent>(entities.begin(), entities.end(), ids.begin(), ids.end());
+
+		ForEachComponentType(ReflectedComponents{}, [&](auto type)
+			{
+				CommitComponents<typename decltype(type)::Type>(scene, batches, entities);
+			});
+		CommitComponents<ScriptComponent>(scene, batches, entities);
+
+		return entities;
+	}
+
+}
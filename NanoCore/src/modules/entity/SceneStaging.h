@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Scene.h"
+#include "Components.h"
+#include "ComponentReflection.h"
+
+#include <tuple>
+
+namespace NanoCore {
+
+	// Decoded components of one type, waiting to be added to the registry
+	template<typename Component>
+	struct StagedComponents
+	{
+		// Row of the owning entity for every component
+		std::vector<uint32_t> Rows;
+		std::vector<Component> Components;
+
+		// Textures can only be created on the main thread, their fields are
+		// left empty while staging and filled in when the batch is committed
+		struct PendingTexture
+		{
+			uint32_t Index;
+			uint32_t FieldHash;
+			std::string Path;
+		};
+		std::vector<PendingTexture> Textures;
+	};
+
+	// What a component starts as before staged fields are applied, matching Scene::CreateEntityWithUUID
+	template<typename Component>
+	Component CreateDefaultComponent()
+	{
+		if constexpr (std::is_same_v<Component, TagComponent>)
+			return TagComponent("Entity");
+		else
+			return Component();
+	}
+
+	template<typename... Component>
+	using StagedComponentsTuple = std::tuple<StagedComponents<Component>...>;
+
+	template<typename... Component>
+	StagedComponentsTuple<Component...> MakeStagedComponentsTuple(ComponentGroup<Component...>);
+
+	// Entities decoded by one worker. Rows are indices into the whole load, so
+	// batches can be filled in any order and committed together.
+	struct SceneStagingBatch
+	{
+		std::vector<uint32_t> Rows;
+		std::vector<UUID> UUIDs;
+
+		decltype(MakeStagedComponentsTuple(ReflectedComponents{})) Reflected;
+		StagedComponents<ScriptComponent> Scripts;
+
+		template<typename Component>
+		StagedComponents<Component>& Get()
+		{
+			if constexpr (std::is_same_v<Component, ScriptComponent>)
+				return Scripts;
+			else
+				return std::get<StagedComponents<Component>>(Reflected);
+		}
+	};
+
+	// Moves staged batches into a scene on the main thread. Every component type
+	// is added with one range insert into storage reserved up front, instead of
+	// going through AddComponent once per entity.
+	class SceneStaging
+	{
+	public:
+		// Returns the created entities, indexed by row. Every entity gets a tag and
+		// a transform like Scene::CreateEntityWithUUID, staged ones replace the defaults.
+		static std::vector<entt::entity> Commit(Scene& scene, std::vector<SceneStagingBatch>& batches);
+	private:
+		template<typename Component>
+		static void CommitComponents(Scene& scene, std::vector<SceneStagingBatch>& batches, const std::vector<entt::entity>& entities);
+	};
+
+}
@@ -18,6 +18,7 @@ namespace NanoCore{
 		virtual void OnCreate() {}
 		virtual void OnDestroy() {}
 		virtual void OnUpdate(Timestep ts) {}
+		virtual void OnFixedUpdate(Timestep ts) {}
 	private:
 		Entity m_Entity;
 		friend class Scene;
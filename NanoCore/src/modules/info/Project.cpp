@@ -1,6 +1,9 @@
 #include "ncpch.h"
 #include "Project.h"
 
+#include "modules/entity/AssetManager.h"
+#include "modules/entity/AssetImportPipeline.h"
+
 
 namespace NanoCore {
 
@@ -21,14 +24,13 @@ namespace NanoCore {
 	{
 		if (s_ActiveProject)
 		{
-
+			AssetManager::SaveRegistry();
+			AssetImportPipeline::SaveCache();
 		}
 
 		s_ActiveProject = project;
-		if (s_ActiveProject)
-		{
-
-		}
+		AssetManager::LoadRegistry();
+		AssetImportPipeline::LoadCache();
 	}
 
 	void Project::OnDeserialized()
@@ -4,12 +4,26 @@
 
 namespace NanoCore {
 
+	enum class ScriptCompilationMode
+	{
+		// Every method is JIT compiled on first call, required for hot reload
+		JIT = 0,
+		// Precompiled images (<assembly>.dll.dll from mono --aot) are used when present,
+		// anything they don't cover falls back to the JIT
+		AOT,
+		// Precompiled images only, the JIT is disabled. Experimental: the unmanaged thunks the
+		// script engine calls through are created at runtime and mono --aot=full doesn't
+		// precompile them, so this mode only takes effect in builds defining
+		// NANO_EXPERIMENTAL_FULL_AOT and runs as AOT everywhere else.
+		FullAOT
+	};
+
 	struct ProjectConfig
 	{
 		std::string Name;
 
 		std::string AssetDirectory;
-		std::string AssetRegistryPath;
+		std::string AssetRegistryPath = "AssetRegistry.nanoreg";
 
 		std::string AudioCommandsRegistryPath = "";
 
@@ -22,10 +36,18 @@ namespace NanoCore {
 		std::string StartScene;
 
 		bool ReloadAssemblyOnPlay;
+		ScriptCompilationMode ScriptCompilation = ScriptCompilationMode::JIT;
 
 		bool EnableAutoSave = false;
 		int AutoSaveIntervalSeconds = 300;
 
+		// Fixed-step simulation (physics and OnFixedUpdate), in steps per second
+		int FixedStepRate = 60;
+		// Fixed steps allowed per frame before the remaining backlog is dropped
+		int MaxFixedStepsPerFrame = 8;
+		// Step physics on a worker thread, overlapped with rendering the previous step
+		bool PipelinedPhysics = false;
+
 		// Not serialized
 		std::string ProjectFileName;
 		std::string ProjectDirectory = "resources";
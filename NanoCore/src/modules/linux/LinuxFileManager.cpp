@@ -0,0 +1,317 @@
+#include "ncpch.h"
+#include "core/base/Base.h"
+#include "modules/utils/FileManager.h"
+
+#ifdef RA_PLATFORM_LINUX
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <atomic>
+#include <thread>
+
+namespace NanoCore {
+
+	//////////////////////////////////////////////////////////////////////////
+	// Watcher ///////////////////////////////////////////////////////////////
+	//////////////////////////////////////////////////////////////////////////
+
+	static constexpr uint32_t WatchMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | IN_EXCL_UNLINK;
+
+	static std::thread s_WatcherThread;
+	static int s_WatcherWakeFD = -1;
+	static std::atomic<bool> s_WatcherStopping = false;
+
+	static bool IsInDirectory(const std::filesystem::path& path, const std::filesystem::path& directory)
+	{
+		auto [pathIt, directoryIt] = std::mismatch(path.begin(), path.end(), directory.begin(), directory.end());
+		return directoryIt == directory.end();
+	}
+
+	// inotify only watches single directories, every directory of a watched tree gets its own watch
+	struct InotifyWatches
+	{
+		int FD = -1;
+		std::unordered_map<int, std::filesystem::path> Directories;
+		std::vector<std::filesystem::path> Roots;
+
+		void Add(const std::filesystem::path& directory)
+		{
+			int wd = inotify_add_watch(FD, directory.c_str(), WatchMask);
+			if (wd < 0)
+			{
+				if (errno == ENOSPC)
+					NANO_ENGINE_LOG_ERROR("Can't watch '{}', out of inotify watches (fs.inotify.max_user_watches)", directory.string());
+				return;
+			}
+			Directories[wd] = directory;
+		}
+
+		// created gets an Added for everything already in a directory that just appeared,
+		// files written before its watch existed have no events of their own
+		void AddTree(const std::filesystem::path& directory, std::vector<FileSystemChangedEvent>* created)
+		{
+			Add(directory);
+
+			std::error_code error;
+			auto options = std::filesystem::directory_options::skip_permission_denied;
+			for (std::filesystem::recursive_directory_iterator it(directory, options, error), end; it != end; it.increment(error))
+			{
+				bool isDirectory = it->is_directory(error);
+				if (isDirectory)
+					Add(it->path());
+				if (created)
+					created->push_back({ FileSystemAction::Added, it->path(), isDirectory });
+			}
+		}
+
+		// Directories inside one of the kept trees stay watched, roots can be nested
+		void RemoveTree(const std::filesystem::path& directory, const std::vector<std::filesystem::path>& kept = {})
+		{
+			auto isKept = [&kept](const std::filesystem::path& path)
+			{
+				return std::any_of(kept.begin(), kept.end(), [&path](const std::filesystem::path& root) { return IsInDirectory(path, root); });
+			};
+
+			for (auto it = Directories.begin(); it != Directories.end();)
+			{
+				if (IsInDirectory(it->second, directory) && !isKept(it->second))
+				{
+					inotify_rm_watch(FD, it->first);
+					it = Directories.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+
+		void MoveTree(const std::filesystem::path& from, const std::filesystem::path& to)
+		{
+			for (auto& [wd, directory] : Directories)
+			{
+				if (IsInDirectory(directory, from))
+					directory = to / directory.lexically_relative(from);
+			}
+		}
+
+		void SyncRoots(const std::vector<std::filesystem::path>& roots)
+		{
+			for (const auto& root : Roots)
+			{
+				if (std::find(roots.begin(), roots.end(), root) == roots.end())
+					RemoveTree(root, roots);
+			}
+			for (const auto& root : roots)
+			{
+				if (std::find(Roots.begin(), Roots.end(), root) == Roots.end())
+					AddTree(root, nullptr);
+			}
+			Roots = roots;
+		}
+	};
+
+	struct MovedFrom
+	{
+		uint32_t Cookie = 0;
+		std::filesystem::path Path;
+		bool IsDirectory = false;
+	};
+
+	// Half of a move without its other half, moved out of the watched trees
+	static void FlushMovedFrom(InotifyWatches& watches, MovedFrom& movedFrom, std::vector<FileSystemChangedEvent>& events)
+	{
+		if (movedFrom.Path.empty())
+			return;
+
+		if (movedFrom.IsDirectory)
+			watches.RemoveTree(movedFrom.Path);
+		events.push_back({ FileSystemAction::Delete, std::move(movedFrom.Path), movedFrom.IsDirectory });
+		movedFrom = {};
+	}
+
+	static void ReadInotifyEvents(InotifyWatches& watches, std::vector<FileSystemChangedEvent>& events)
+	{
+		alignas(inotify_event) char buffer[64 * 1024];
+		MovedFrom movedFrom;
+
+		while (true)
+		{
+			ssize_t length = read(watches.FD, buffer, sizeof(buffer));
+			if (length <= 0)
+				break;
+
+			for (const char* data = buffer; data < buffer + length;)
+			{
+				const inotify_event* event = (const inotify_event*)data;
+				data += sizeof(inotify_event) + event->len;
+
+				// The kernel dropped events, anything in the trees may have changed
+				if (event->mask & IN_Q_OVERFLOW)
+				{
+					for (const auto& root : watches.Roots)
+						events.push_back({ FileSystemAction::Modified, root, true });
+					continue;
+				}
+
+				auto it = watches.Directories.find(event->wd);
+				if (it == watches.Directories.end())
+					continue;
+
+				if (event->mask & IN_IGNORED)
+				{
+					watches.Directories.erase(it);
+					continue;
+				}
+
+				if (event->len == 0)
+					continue;
+
+				std::filesystem::path path = it->second / event->name;
+				bool isDirectory = event->mask & IN_ISDIR;
+
+				// The two halves of a move are next to each other
+				if (!(event->mask & IN_MOVED_TO) || event->cookie != movedFrom.Cookie)
+					FlushMovedFrom(watches, movedFrom, events);
+
+				if (event->mask & IN_MOVED_FROM)
+				{
+					movedFrom = { event->cookie, std::move(path), isDirectory };
+				}
+				else if (event->mask & IN_MOVED_TO)
+				{
+					if (movedFrom.Path.empty())
+					{
+						events.push_back({ FileSystemAction::Added, path, isDirectory });
+						if (isDirectory)
+							watches.AddTree(path, &events);
+						continue;
+					}
+
+					if (isDirectory)
+						watches.MoveTree(movedFrom.Path, path);
+
+					if (movedFrom.Path.parent_path() == path.parent_path())
+					{
+						FileSystemChangedEvent& e = events.emplace_back();
+						e.Action = FileSystemAction::Rename;
+						e.FilePath = path;
+						e.IsDirectory = isDirectory;
+						e.OldName = movedFrom.Path.filename().wstring();
+					}
+					else
+					{
+						events.push_back({ FileSystemAction::Delete, movedFrom.Path, isDirectory });
+						events.push_back({ FileSystemAction::Added, path, isDirectory });
+					}
+					movedFrom = {};
+				}
+				else if (event->mask & IN_CREATE)
+				{
+					events.push_back({ FileSystemAction::Added, path, isDirectory });
+					if (isDirectory)
+						watches.AddTree(path, &events);
+				}
+				else if (event->mask & IN_DELETE)
+				{
+					events.push_back({ FileSystemAction::Delete, path, isDirectory });
+				}
+				else if ((event->mask & (IN_MODIFY | IN_CLOSE_WRITE)) && !isDirectory)
+				{
+					events.push_back({ FileSystemAction::Modified, path, false });
+				}
+			}
+		}
+
+		FlushMovedFrom(watches, movedFrom, events);
+	}
+
+	void FileSystem::WatcherThread()
+	{
+		InotifyWatches watches;
+		watches.FD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		int epoll = epoll_create1(EPOLL_CLOEXEC);
+		if (watches.FD < 0 || epoll < 0)
+		{
+			NANO_ENGINE_LOG_ERROR("File system watcher can't start, inotify isn't available");
+			if (watches.FD >= 0)
+				close(watches.FD);
+			if (epoll >= 0)
+				close(epoll);
+			return;
+		}
+
+		for (int fd : { watches.FD, s_WatcherWakeFD })
+		{
+			epoll_event event = {};
+			event.events = EPOLLIN;
+			event.data.fd = fd;
+			epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event);
+		}
+
+		watches.SyncRoots(GetWatchedDirectories());
+
+		std::vector<FileSystemChangedEvent> events;
+		while (!s_WatcherStopping)
+		{
+			epoll_event ready[2];
+			int count = epoll_wait(epoll, ready, 2, -1);
+			if (count < 0)
+			{
+				if (errno == EINTR)
+					continue;
+
+				NANO_ENGINE_LOG_ERROR("File system watcher stopped, waiting for changes failed");
+				break;
+			}
+
+			for (int i = 0; i < count; i++)
+			{
+				if (ready[i].data.fd == s_WatcherWakeFD)
+				{
+					uint64_t wakes;
+					read(s_WatcherWakeFD, &wakes, sizeof(wakes));
+					watches.SyncRoots(GetWatchedDirectories());
+					continue;
+				}
+
+				ReadInotifyEvents(watches, events);
+				QueueFileSystemChanges(events);
+			}
+		}
+
+		close(epoll);
+		close(watches.FD);
+	}
+
+	void FileSystem::StartWatcherThread()
+	{
+		s_WatcherStopping = false;
+		s_WatcherWakeFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		s_WatcherThread = std::thread(&FileSystem::WatcherThread);
+		pthread_setname_np(s_WatcherThread.native_handle(), "FileSystemWatch");
+	}
+
+	void FileSystem::StopWatcherThread()
+	{
+		s_WatcherStopping = true;
+		WakeWatcherThread();
+		s_WatcherThread.join();
+
+		close(s_WatcherWakeFD);
+		s_WatcherWakeFD = -1;
+	}
+
+	void FileSystem::WakeWatcherThread()
+	{
+		uint64_t wake = 1;
+		write(s_WatcherWakeFD, &wake, sizeof(wake));
+	}
+
+}
+
+#endif
@@ -0,0 +1,637 @@
+#include "ncpch.h"
+#include "PhysicsWorld2D.h"
+
+#include "modules/entity/Components.h"
+
+#include "box2d/b2_world.h"
+
+#include <glm/gtc/constants.hpp>
+
+namespace NanoCore {
+
+	static constexpr int32_t s_VelocityIterations = 6;
+	static constexpr int32_t s_PositionIterations = 2;
+
+	static b2BodyType Rigidbody2DTypeToBox2DBody(Rigidbody2DComponent::BodyType bodyType)
+	{
+		switch (bodyType)
+		{
+		case Rigidbody2DComponent::BodyType::Static:    return b2_staticBody;
+		case Rigidbody2DComponent::BodyType::Dynamic:   return b2_dynamicBody;
+		case Rigidbody2DComponent::BodyType::Kinematic: return b2_kinematicBody;
+		}
+
+		NANO_ENGINE_LOG_ASSERT(false, "Unknown body type");
+		return b2_staticBody;
+	}
+
+	PhysicsWorld2D::PhysicsWorld2D(entt::registry& registry, const glm::vec2& gravity, bool pipelined)
+		: m_Registry(registry), m_Pipelined(pipelined)
+	{
+		m_World = new b2World({ gravity.x, gravity.y });
+
+		// Cached transform pointers go stale whenever transform storage moves, the
+		// sprite group owns that storage and reorders it when sprites come and go.
+		m_Registry.on_construct<TransformComponent>().connect<&PhysicsWorld2D::OnTransformStorageChanged>(*this);
+		m_Registry.on_destroy<TransformComponent>().connect<&PhysicsWorld2D::OnTransformStorageChanged>(*this);
+		m_Registry.on_construct<SpriteRendererComponent>().connect<&PhysicsWorld2D::OnTransformStorageChanged>(*this);
+		m_Registry.on_destroy<SpriteRendererComponent>().connect<&PhysicsWorld2D::OnTransformStorageChanged>(*this);
+		m_Registry.on_update<TransformComponent>().connect<&PhysicsWorld2D::OnTransformChanged>(*this);
+
+		m_Registry.on_construct<Rigidbody2DComponent>().connect<&PhysicsWorld2D::OnBodyChanged>(*this);
+		m_Registry.on_update<Rigidbody2DComponent>().connect<&PhysicsWorld2D::OnBodyChanged>(*this);
+		m_Registry.on_destroy<Rigidbody2DComponent>().connect<&PhysicsWorld2D::OnBodyChanged>(*this);
+		m_Registry.on_construct<BoxCollider2DComponent>().connect<&PhysicsWorld2D::OnFixturesChanged>(*this);
+		m_Registry.on_update<BoxCollider2DComponent>().connect<&PhysicsWorld2D::OnFixturesChanged>(*this);
+		m_Registry.on_destroy<BoxCollider2DComponent>().connect<&PhysicsWorld2D::OnFixturesChanged>(*this);
+		m_Registry.on_construct<CircleCollider2DComponent>().connect<&PhysicsWorld2D::OnFixturesChanged>(*this);
+		m_Registry.on_update<CircleCollider2DComponent>().connect<&PhysicsWorld2D::OnFixturesChanged>(*this);
+		m_Registry.on_destroy<CircleCollider2DComponent>().connect<&PhysicsWorld2D::OnFixturesChanged>(*this);
+
+		if (m_Pipelined)
+			m_Worker = std::thread(&PhysicsWorld2D::WorkerThread, this);
+	}
+
+	PhysicsWorld2D::~PhysicsWorld2D()
+	{
+		if (m_Worker.joinable())
+		{
+			{
+				std::scoped_lock<std::mutex> lock(m_WorkerMutex);
+				m_ShutdownWorker = true;
+			}
+			m_WorkerCondition.notify_all();
+			m_Worker.join();
+		}
+
+		m_Registry.on_construct<TransformComponent>().disconnect(*this);
+		m_Registry.on_destroy<TransformComponent>().disconnect(*this);
+		m_Registry.on_construct<SpriteRendererComponent>().disconnect(*this);
+		m_Registry.on_destroy<SpriteRendererComponent>().disconnect(*this);
+		m_Registry.on_update<TransformComponent>().disconnect(*this);
+
+		m_Registry.on_construct<Rigidbody2DComponent>().disconnect(*this);
+		m_Registry.on_update<Rigidbody2DComponent>().disconnect(*this);
+		m_Registry.on_destroy<Rigidbody2DComponent>().disconnect(*this);
+		m_Registry.on_construct<BoxCollider2DComponent>().disconnect(*this);
+		m_Registry.on_update<BoxCollider2DComponent>().disconnect(*this);
+		m_Registry.on_destroy<BoxCollider2DComponent>().disconnect(*this);
+		m_Registry.on_construct<CircleCollider2DComponent>().disconnect(*this);
+		m_Registry.on_update<CircleCollider2DComponent>().disconnect(*this);
+		m_Registry.on_destroy<CircleCollider2DComponent>().disconnect(*this);
+
+		delete m_World;
+	}
+
+	void PhysicsWorld2D::BuildBodySnapshot(const entt::registry& registry, entt::entity entity, Physics2DBodySnapshot& snapshot)
+	{
+		const auto& transform = registry.get<TransformComponent>(entity);
+		const auto& rb2d = registry.get<Rigidbody2DComponent>(entity);
+
+		snapshot = Physics2DBodySnapshot();
+		snapshot.Entity = entity;
+		snapshot.BodyDef.type = Rigidbody2DTypeToBox2DBody(rb2d.Type);
+		snapshot.BodyDef.position.Set(transform.Translation.x, transform.Translation.y);
+		snapshot.BodyDef.angle = transform.Rotation.z;
+		snapshot.BodyDef.fixedRotation = rb2d.FixedRotation;
+
+		if (const auto* bc2d = registry.try_get<BoxCollider2DComponent>(entity))
+		{
+			snapshot.HasBoxFixture = true;
+			snapshot.BoxShape.SetAsBox(bc2d->Size.x * transform.Scale.x, bc2d->Size.y * transform.Scale.y);
+
+			snapshot.BoxFixtureDef.density = bc2d->Density;
+			snapshot.BoxFixtureDef.friction = bc2d->Friction;
+			snapshot.BoxFixtureDef.restitution = bc2d->Restitution;
+			snapshot.BoxFixtureDef.restitutionThreshold = bc2d->RestitutionThreshold;
+		}
+
+		if (const auto* cc2d = registry.try_get<CircleCollider2DComponent>(entity))
+		{
+			snapshot.HasCircleFixture = true;
+			snapshot.CircleShape.m_p.Set(cc2d->Offset.x, cc2d->Offset.y);
+			snapshot.CircleShape.m_radius = transform.Scale.x * cc2d->Radius;
+
+			snapshot.CircleFixtureDef.density = cc2d->Density;
+			snapshot.CircleFixtureDef.friction = cc2d->Friction;
+			snapshot.CircleFixtureDef.restitution = cc2d->Restitution;
+			snapshot.CircleFixtureDef.restitutionThreshold = cc2d->RestitutionThreshold;
+		}
+	}
+
+	void PhysicsWorld2D::CreateBodies(Physics2DSnapshot& snapshot)
+	{
+		if (snapshot.Bodies.empty())
+			return;
+
+		RA_PROFILE_FUNCTION();
+
+		const size_t count = snapshot.Bodies.size();
+		m_Bodies.reserve(m_Bodies.size() + count);
+		m_BodyEntities.reserve(m_BodyEntities.size() + count);
+		m_ActiveStamps.reserve(m_ActiveStamps.size() + count);
+		m_Poses[0].reserve(m_Poses[0].size() + count);
+		m_Poses[1].reserve(m_Poses[1].size() + count);
+		m_EntityBodies.reserve(m_EntityBodies.size() + count);
+
+		for (auto& bodySnapshot : snapshot.Bodies)
+		{
+			b2Body* body = m_World->CreateBody(&bodySnapshot.BodyDef);
+			m_Registry.get<Rigidbody2DComponent>(bodySnapshot.Entity).RuntimeBody = body;
+			m_EntityBodies[bodySnapshot.Entity] = body;
+
+			CreateFixtures(body, bodySnapshot);
+
+			if (bodySnapshot.BodyDef.type != b2_staticBody)
+				TrackBody(body, bodySnapshot.Entity);
+		}
+	}
+
+	void PhysicsWorld2D::FlushChanges()
+	{
+		if (m_PendingEntities.empty())
+			return;
+
+		RA_PROFILE_FUNCTION();
+
+		m_StagingSnapshot.Bodies.clear();
+
+		for (entt::entity entity : m_PendingEntities)
+		{
+			const uint8_t changes = m_PendingChanges[entity];
+
+			auto it = m_EntityBodies.find(entity);
+			b2Body* body = it != m_EntityBodies.end() ? it->second : nullptr;
+
+			auto* rb2d = m_Registry.valid(entity) ? m_Registry.try_get<Rigidbody2DComponent>(entity) : nullptr;
+			if (!rb2d)
+			{
+				if (body)
+					DestroyBody(entity, body);
+				continue;
+			}
+
+			// New bodies are batched and created together below
+			if (!body)
+			{
+				BuildBodySnapshot(m_Registry, entity, m_StagingSnapshot.Bodies.emplace_back());
+				continue;
+			}
+
+			// Updated in place so the body keeps its velocity and contacts
+			if (changes & PendingBody)
+			{
+				const b2BodyType type = Rigidbody2DTypeToBox2DBody(rb2d->Type);
+				const b2BodyType previousType = body->GetType();
+				if (type != previousType)
+				{
+					body->SetType(type);
+					if (previousType == b2_staticBody)
+						TrackBody(body, entity);
+					else if (type == b2_staticBody)
+						UntrackBody(body);
+				}
+				body->SetFixedRotation(rb2d->FixedRotation);
+			}
+
+			if (changes & PendingFixtures)
+			{
+				while (b2Fixture* fixture = body->GetFixtureList())
+					body->DestroyFixture(fixture);
+
+				BuildBodySnapshot(m_Registry, entity, m_StagingFixtures);
+				CreateFixtures(body, m_StagingFixtures);
+			}
+		}
+
+		m_PendingEntities.clear();
+		m_PendingChanges.clear();
+
+		if (m_NeedsCompaction)
+			CompactBodies();
+
+		CreateBodies(m_StagingSnapshot);
+	}
+
+	void PhysicsWorld2D::Step(Timestep ts)
+	{
+		NANO_ENGINE_LOG_ASSERT(!m_Pipelined, "Pipelined physics is stepped through StepAsync");
+
+		FlushChanges();
+		ApplyCommands();
+		// Scripts run between the steps of a frame, so each step is its own call. They add up
+		// to one run, a body that falls asleep in an early step still gets its pose written.
+		RunSteps(ts, 1, m_FrontBuffer, m_RunOpen);
+		m_RunOpen = true;
+	}
+
+	void PhysicsWorld2D::StepAsync(Timestep ts, uint32_t steps)
+	{
+		NANO_ENGINE_LOG_ASSERT(m_Pipelined, "Synchronous physics is stepped through Step");
+
+		// The worker is idle until notified below
+		FlushChanges();
+
+		if (steps == 0)
+			return;
+
+		{
+			std::scoped_lock<std::mutex> lock(m_WorkerMutex);
+			NANO_ENGINE_LOG_ASSERT(!m_StepInFlight, "WaitForSimulation must be called before the next StepAsync");
+			m_PendingSteps = steps;
+			m_PendingTimestep = ts;
+			m_StepInFlight = true;
+		}
+		m_WorkerCondition.notify_all();
+	}
+
+	void PhysicsWorld2D::WaitForSimulation()
+	{
+		if (!m_Pipelined)
+			return;
+
+		RA_PROFILE_FUNCTION();
+
+		std::unique_lock<std::mutex> lock(m_WorkerMutex);
+		m_WorkerCondition.wait(lock, [this]() { return !m_StepInFlight; });
+
+		if (m_SwapPending)
+		{
+			m_FrontBuffer = 1 - m_FrontBuffer;
+			m_SwapPending = false;
+		}
+	}
+
+	void PhysicsWorld2D::QueueLinearImpulse(void* runtimeBody, const glm::vec2& impulse, const glm::vec2& point, bool wake)
+	{
+		// Bodies added this step don't exist until the next flush
+		if (!runtimeBody)
+			return;
+
+		std::scoped_lock<std::mutex> lock(m_CommandMutex);
+		m_PendingCommands.push_back({ (b2Body*)runtimeBody, b2Vec2(impulse.x, impulse.y), b2Vec2(point.x, point.y), false, wake });
+	}
+
+	void PhysicsWorld2D::QueueLinearImpulseToCenter(void* runtimeBody, const glm::vec2& impulse, bool wake)
+	{
+		if (!runtimeBody)
+			return;
+
+		std::scoped_lock<std::mutex> lock(m_CommandMutex);
+		m_PendingCommands.push_back({ (b2Body*)runtimeBody, b2Vec2(impulse.x, impulse.y), b2Vec2(0.0f, 0.0f), true, wake });
+	}
+
+	Physics2DBodyState PhysicsWorld2D::GetBodyState(const void* runtimeBody)
+	{
+		const b2Body* body = (const b2Body*)runtimeBody;
+
+		Physics2DBodyState state;
+		state.Position = { body->GetPosition().x, body->GetPosition().y };
+		state.Angle = body->GetAngle();
+		state.LinearVelocity = { body->GetLinearVelocity().x, body->GetLinearVelocity().y };
+		state.AngularVelocity = body->GetAngularVelocity();
+		state.Awake = body->IsAwake();
+		return state;
+	}
+
+	void PhysicsWorld2D::RestoreBodyStates(const std::vector<Physics2DBodyState>& states)
+	{
+		RA_PROFILE_FUNCTION();
+
+		WaitForSimulation();
+
+		// Creates bodies for restored rigidbodies and destroys the ones that are gone
+		FlushChanges();
+
+		{
+			std::scoped_lock<std::mutex> lock(m_CommandMutex);
+			m_PendingCommands.clear();
+		}
+
+		for (const Physics2DBodyState& state : states)
+		{
+			auto it = m_EntityBodies.find(state.Entity);
+			if (it == m_EntityBodies.end())
+				continue;
+
+			b2Body* body = it->second;
+			body->SetTransform({ state.Position.x, state.Position.y }, state.Angle);
+			body->SetLinearVelocity({ state.LinearVelocity.x, state.LinearVelocity.y });
+			body->SetAngularVelocity(state.AngularVelocity);
+			body->SetAwake(state.Awake);
+		}
+
+		// Interpolation starts over from the restored poses, the transforms were restored with them
+		for (size_t index = 0; index < m_Bodies.size(); index++)
+		{
+			if (!m_Bodies[index])
+				continue;
+
+			Physics2DPose pose;
+			pose.Position = pose.PreviousPosition = { m_Bodies[index]->GetPosition().x, m_Bodies[index]->GetPosition().y };
+			pose.Angle = pose.PreviousAngle = m_Bodies[index]->GetAngle();
+			m_Poses[0][index] = pose;
+			m_Poses[1][index] = pose;
+		}
+
+		m_ActiveBodies[0].clear();
+		m_ActiveBodies[1].clear();
+		m_RunOpen = false;
+	}
+
+	void PhysicsWorld2D::RunSteps(float ts, uint32_t steps, uint32_t buffer, bool continueRun)
+	{
+		RA_PROFILE_FUNCTION();
+
+		std::vector<Physics2DPose>& poses = m_Poses[buffer];
+		std::vector<uint32_t>& activeBodies = m_ActiveBodies[buffer];
+
+		// The back buffer missed the last run, catch up on the bodies it moved
+		if (m_Pipelined)
+		{
+			const uint32_t otherBuffer = 1 - buffer;
+			for (uint32_t index : m_ActiveBodies[otherBuffer])
+				poses[index] = m_Poses[otherBuffer][index];
+		}
+
+		const uint32_t stamp = continueRun ? m_RunStamp : ++m_RunStamp;
+		if (!continueRun)
+			activeBodies.clear();
+
+		for (uint32_t step = 0; step < steps; step++)
+		{
+			// Only the pose before the final step is needed for interpolation
+			if (step == steps - 1)
+			{
+				for (b2Body* body = m_World->GetBodyList(); body; body = body->GetNext())
+				{
+					const uintptr_t slot = body->GetUserData().pointer;
+					if (slot == 0 || !body->IsAwake())
+						continue;
+
+					const uint32_t index = (uint32_t)(slot - 1);
+					const b2Vec2& position = body->GetPosition();
+					poses[index].PreviousPosition = { position.x, position.y };
+					poses[index].PreviousAngle = body->GetAngle();
+
+					if (m_ActiveStamps[index] != stamp)
+					{
+						m_ActiveStamps[index] = stamp;
+						activeBodies.push_back(index);
+					}
+				}
+			}
+
+			m_World->Step(ts, s_VelocityIterations, s_PositionIterations);
+
+			// Bodies woken by this step start interpolating from where they rested
+			for (b2Body* body = m_World->GetBodyList(); body; body = body->GetNext())
+			{
+				const uintptr_t slot = body->GetUserData().pointer;
+				if (slot == 0 || !body->IsAwake())
+					continue;
+
+				const uint32_t index = (uint32_t)(slot - 1);
+				if (m_ActiveStamps[index] == stamp)
+					continue;
+
+				m_ActiveStamps[index] = stamp;
+				activeBodies.push_back(index);
+				poses[index].PreviousPosition = poses[index].Position;
+				poses[index].PreviousAngle = poses[index].Angle;
+			}
+		}
+
+		for (uint32_t index : activeBodies)
+		{
+			b2Body* body = m_Bodies[index];
+			const b2Vec2& position = body->GetPosition();
+			Physics2DPose& pose = poses[index];
+			pose.Position = { position.x, position.y };
+			pose.Angle = body->GetAngle();
+
+			// Fell asleep during this run: settle on the final pose so the
+			// transform is exact once the body drops out of the write-back
+			if (!body->IsAwake())
+			{
+				pose.PreviousPosition = pose.Position;
+				pose.PreviousAngle = pose.Angle;
+			}
+		}
+	}
+
+	void PhysicsWorld2D::ApplyCommands()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_CommandMutex);
+			m_Commands.swap(m_PendingCommands);
+		}
+
+		for (const auto& command : m_Commands)
+		{
+			if (command.ToCenter)
+				command.Body->ApplyLinearImpulseToCenter(command.Impulse, command.Wake);
+			else
+				command.Body->ApplyLinearImpulse(command.Impulse, command.Point, command.Wake);
+		}
+		m_Commands.clear();
+	}
+
+	void PhysicsWorld2D::WriteTransforms(float alpha)
+	{
+		RA_PROFILE_FUNCTION();
+
+		if (m_TransformsStale)
+			RefreshTransforms();
+
+		m_RunOpen = false;
+
+		const std::vector<Physics2DPose>& poses = m_Poses[m_FrontBuffer];
+		for (uint32_t index : m_ActiveBodies[m_FrontBuffer])
+		{
+			TransformComponent* transform = m_Transforms[index];
+			if (!transform)
+				continue;
+
+			const Physics2DPose& pose = poses[index];
+			const glm::vec2 translation = glm::mix(pose.PreviousPosition, pose.Position, alpha);
+			transform->Translation.x = translation.x;
+			transform->Translation.y = translation.y;
+			// Along the shorter arc, a body whose angle wrapped by a full turn doesn't spin back
+			const float delta = std::remainder(pose.Angle - pose.PreviousAngle, glm::two_pi<float>());
+			transform->Rotation.z = pose.Angle - delta * (1.0f - alpha);
+		}
+	}
+
+	void PhysicsWorld2D::RefreshTransforms()
+	{
+		RA_PROFILE_FUNCTION();
+
+		m_Transforms.resize(m_BodyEntities.size());
+		for (size_t i = 0; i < m_BodyEntities.size(); i++)
+		{
+			const entt::entity entity = m_BodyEntities[i];
+			m_Transforms[i] = m_Registry.valid(entity) ? m_Registry.try_get<TransformComponent>(entity) : nullptr;
+		}
+		m_TransformsStale = false;
+	}
+
+	void PhysicsWorld2D::QueueChange(entt::entity entity, uint8_t change)
+	{
+		uint8_t& changes = m_PendingChanges[entity];
+		if (changes == 0)
+			m_PendingEntities.push_back(entity);
+		changes |= change;
+	}
+
+	void PhysicsWorld2D::CreateFixtures(b2Body* body, Physics2DBodySnapshot& snapshot)
+	{
+		// Shape pointers are bound here so the snapshot itself stays relocatable
+		if (snapshot.HasBoxFixture)
+		{
+			snapshot.BoxFixtureDef.shape = &snapshot.BoxShape;
+			m_Registry.get<BoxCollider2DComponent>(snapshot.Entity).RuntimeFixture = body->CreateFixture(&snapshot.BoxFixtureDef);
+		}
+
+		if (snapshot.HasCircleFixture)
+		{
+			snapshot.CircleFixtureDef.shape = &snapshot.CircleShape;
+			m_Registry.get<CircleCollider2DComponent>(snapshot.Entity).RuntimeFixture = body->CreateFixture(&snapshot.CircleFixtureDef);
+		}
+
+		m_FixtureScales[snapshot.Entity] = glm::vec2(m_Registry.get<TransformComponent>(snapshot.Entity).Scale);
+	}
+
+	void PhysicsWorld2D::DestroyBody(entt::entity entity, b2Body* body)
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_CommandMutex);
+			m_PendingCommands.erase(std::remove_if(m_PendingCommands.begin(), m_PendingCommands.end(),
+				[body](const ImpulseCommand& command) { return command.Body == body; }), m_PendingCommands.end());
+		}
+
+		if (body->GetUserData().pointer != 0)
+			UntrackBody(body);
+
+		// Colliders can outlive the rigidbody they were attached to
+		if (m_Registry.valid(entity))
+		{
+			if (auto* bc2d = m_Registry.try_get<BoxCollider2DComponent>(entity))
+				bc2d->RuntimeFixture = nullptr;
+			if (auto* cc2d = m_Registry.try_get<CircleCollider2DComponent>(entity))
+				cc2d->RuntimeFixture = nullptr;
+		}
+
+		m_World->DestroyBody(body);
+		m_EntityBodies.erase(entity);
+		m_FixtureScales.erase(entity);
+	}
+
+	void PhysicsWorld2D::OnTransformChanged(entt::registry& registry, entt::entity entity)
+	{
+		// Fixtures are sized by the scale. Moves and rotations are left to the simulation.
+		auto it = m_FixtureScales.find(entity);
+		if (it != m_FixtureScales.end() && it->second != glm::vec2(registry.get<TransformComponent>(entity).Scale))
+			QueueChange(entity, PendingFixtures);
+	}
+
+	void PhysicsWorld2D::TrackBody(b2Body* body, entt::entity entity)
+	{
+		body->GetUserData().pointer = m_Bodies.size() + 1;
+
+		m_Bodies.push_back(body);
+		m_BodyEntities.push_back(entity);
+		m_ActiveStamps.push_back(0);
+
+		Physics2DPose pose;
+		pose.Position = pose.PreviousPosition = { body->GetPosition().x, body->GetPosition().y };
+		pose.Angle = pose.PreviousAngle = body->GetAngle();
+		m_Poses[0].push_back(pose);
+		m_Poses[1].push_back(pose);
+
+		m_TransformsStale = true;
+	}
+
+	void PhysicsWorld2D::UntrackBody(b2Body* body)
+	{
+		const uintptr_t slot = body->GetUserData().pointer;
+		m_Bodies[slot - 1] = nullptr;
+		body->GetUserData().pointer = 0;
+		m_NeedsCompaction = true;
+	}
+
+	void PhysicsWorld2D::CompactBodies()
+	{
+		RA_PROFILE_FUNCTION();
+
+		std::vector<uint32_t> remap(m_Bodies.size(), UINT32_MAX);
+
+		uint32_t count = 0;
+		for (uint32_t index = 0; index < (uint32_t)m_Bodies.size(); index++)
+		{
+			if (!m_Bodies[index])
+				continue;
+
+			remap[index] = count;
+			m_Bodies[count] = m_Bodies[index];
+			m_BodyEntities[count] = m_BodyEntities[index];
+			m_ActiveStamps[count] = m_ActiveStamps[index];
+			m_Poses[0][count] = m_Poses[0][index];
+			m_Poses[1][count] = m_Poses[1][index];
+			m_Bodies[count]->GetUserData().pointer = count + 1;
+			count++;
+		}
+
+		m_Bodies.resize(count);
+		m_BodyEntities.resize(count);
+		m_ActiveStamps.resize(count);
+		m_Poses[0].resize(count);
+		m_Poses[1].resize(count);
+
+		for (auto& activeBodies : m_ActiveBodies)
+		{
+			size_t activeCount = 0;
+			for (uint32_t index : activeBodies)
+			{
+				if (remap[index] != UINT32_MAX)
+					activeBodies[activeCount++] = remap[index];
+			}
+			activeBodies.resize(activeCount);
+		}
+
+		m_NeedsCompaction = false;
+		m_TransformsStale = true;
+	}
+
+	void PhysicsWorld2D::WorkerThread()
+	{
+		while (true)
+		{
+			uint32_t steps;
+			float ts;
+			uint32_t backBuffer;
+			{
+				std::unique_lock<std::mutex> lock(m_WorkerMutex);
+				m_WorkerCondition.wait(lock, [this]() { return m_StepInFlight || m_ShutdownWorker; });
+				if (m_ShutdownWorker)
+					return;
+
+				steps = m_PendingSteps;
+				ts = m_PendingTimestep;
+				backBuffer = 1 - m_FrontBuffer;
+			}
+
+			ApplyCommands();
+			RunSteps(ts, steps, backBuffer);
+
+			{
+				std::scoped_lock<std::mutex> lock(m_WorkerMutex);
+				m_PendingSteps = 0;
+				m_StepInFlight = false;
+				m_SwapPending = true;
+			}
+			m_WorkerCondition.notify_all();
+		}
+	}
+
+}
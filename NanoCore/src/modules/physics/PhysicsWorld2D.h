@@ -0,0 +1,190 @@
+#pragma once
+
+#include "modules/utils/Timestep.h"
+
+#include "box2d/b2_body.h"
+#include "box2d/b2_fixture.h"
+#include "box2d/b2_polygon_shape.h"
+#include "box2d/b2_circle_shape.h"
+
+#include "entt/entt.hpp"
+
+#include <glm/glm.hpp>
+
+#include <thread>
+#include <condition_variable>
+
+class b2World;
+
+namespace NanoCore {
+
+	struct Physics2DBodySnapshot
+	{
+		entt::entity Entity = entt::null;
+		b2BodyDef BodyDef;
+
+		bool HasBoxFixture = false;
+		b2PolygonShape BoxShape;
+		b2FixtureDef BoxFixtureDef;
+
+		bool HasCircleFixture = false;
+		b2CircleShape CircleShape;
+		b2FixtureDef CircleFixtureDef;
+	};
+
+	// Box2D can't clone a world, so the snapshot holds every body and fixture
+	// definition already resolved against its transform and colliders.
+	struct Physics2DSnapshot
+	{
+		std::vector<Physics2DBodySnapshot> Bodies;
+	};
+
+	// Body pose before and after the last fixed step, used to interpolate rendering
+	struct Physics2DPose
+	{
+		glm::vec2 PreviousPosition = { 0.0f, 0.0f };
+		float PreviousAngle = 0.0f;
+
+		glm::vec2 Position = { 0.0f, 0.0f };
+		float Angle = 0.0f;
+	};
+
+	// Motion of one body, enough to carry on simulating from a scene snapshot
+	struct Physics2DBodyState
+	{
+		entt::entity Entity = entt::null;
+		glm::vec2 Position = { 0.0f, 0.0f };
+		float Angle = 0.0f;
+		glm::vec2 LinearVelocity = { 0.0f, 0.0f };
+		float AngularVelocity = 0.0f;
+		bool Awake = true;
+	};
+
+	struct TransformComponent;
+
+	class PhysicsWorld2D
+	{
+	public:
+		// In pipelined mode the steps of the next frame run on a worker thread
+		// while the current frame renders from the last completed poses.
+		PhysicsWorld2D(entt::registry& registry, const glm::vec2& gravity, bool pipelined);
+		~PhysicsWorld2D();
+
+		// Resolves the body and fixture definitions of an entity from its components
+		static void BuildBodySnapshot(const entt::registry& registry, entt::entity entity, Physics2DBodySnapshot& snapshot);
+
+		void CreateBodies(Physics2DSnapshot& snapshot);
+
+		// Rigidbody and collider changes are recorded as they happen and applied
+		// here, called by the step functions so the world is never stepping.
+		void FlushChanges();
+
+		// Synchronous fixed step
+		void Step(Timestep ts);
+
+		// Pipelined mode only
+		void StepAsync(Timestep ts, uint32_t steps);
+		void WaitForSimulation();
+
+		// Script-originated forces are deferred to the next step boundary,
+		// the world may be stepping on the worker when they are issued.
+		void QueueLinearImpulse(void* runtimeBody, const glm::vec2& impulse, const glm::vec2& point, bool wake);
+		void QueueLinearImpulseToCenter(void* runtimeBody, const glm::vec2& impulse, bool wake);
+
+		// Interpolates the transforms of bodies that moved in the last completed run.
+		// Bodies at rest already hold their final pose and are skipped.
+		void WriteTransforms(float alpha);
+
+		// Snapshot support. Bodies may only be read while no pipelined step is in flight,
+		// call WaitForSimulation first.
+		static Physics2DBodyState GetBodyState(const void* runtimeBody);
+		// Moves bodies back to captured states once the changes restoring the components
+		// queued are flushed. Queued impulses are dropped, contacts are rebuilt by the next step.
+		void RestoreBodyStates(const std::vector<Physics2DBodyState>& states);
+
+		bool IsPipelined() const { return m_Pipelined; }
+	private:
+		// continueRun adds the steps to the run before it, keeping the bodies it moved
+		void RunSteps(float ts, uint32_t steps, uint32_t buffer, bool continueRun = false);
+		void ApplyCommands();
+		void WorkerThread();
+
+		void RefreshTransforms();
+		void OnTransformStorageChanged(entt::registry& registry, entt::entity entity) { m_TransformsStale = true; }
+
+		void OnBodyChanged(entt::registry& registry, entt::entity entity) { QueueChange(entity, PendingBody); }
+		void OnFixturesChanged(entt::registry& registry, entt::entity entity) { QueueChange(entity, PendingFixtures); }
+		void OnTransformChanged(entt::registry& registry, entt::entity entity);
+		void QueueChange(entt::entity entity, uint8_t change);
+
+		void CreateFixtures(b2Body* body, Physics2DBodySnapshot& snapshot);
+		void DestroyBody(entt::entity entity, b2Body* body);
+		void TrackBody(b2Body* body, entt::entity entity);
+		void UntrackBody(b2Body* body);
+		void CompactBodies();
+	private:
+		enum PendingChange : uint8_t
+		{
+			PendingBody = 1 << 0,
+			PendingFixtures = 1 << 1
+		};
+		struct ImpulseCommand
+		{
+			b2Body* Body = nullptr;
+			b2Vec2 Impulse;
+			b2Vec2 Point;
+			bool ToCenter = false;
+			bool Wake = true;
+		};
+
+		entt::registry& m_Registry;
+		b2World* m_World = nullptr;
+
+		// Dynamic and kinematic bodies only, static bodies never write back.
+		// A body's user data holds its index here plus one, zero for untracked bodies.
+		std::vector<b2Body*> m_Bodies;
+		std::vector<entt::entity> m_BodyEntities;
+		std::vector<TransformComponent*> m_Transforms;
+		bool m_TransformsStale = true;
+
+		// Untracked bodies leave a null slot until the next flush compacts them
+		bool m_NeedsCompaction = false;
+
+		std::unordered_map<entt::entity, b2Body*> m_EntityBodies;
+		// Transform scale the fixtures of each body were sized with
+		std::unordered_map<entt::entity, glm::vec2> m_FixtureScales;
+
+		std::vector<entt::entity> m_PendingEntities;
+		std::unordered_map<entt::entity, uint8_t> m_PendingChanges;
+
+		// Reused between flushes so spawning doesn't allocate definitions per body
+		Physics2DSnapshot m_StagingSnapshot;
+		Physics2DBodySnapshot m_StagingFixtures;
+
+		// Double-buffered so rendering can read one set while the worker writes the other
+		std::array<std::vector<Physics2DPose>, 2> m_Poses;
+		uint32_t m_FrontBuffer = 0;
+
+		// Indices of the bodies each pose buffer received in its last run
+		std::array<std::vector<uint32_t>, 2> m_ActiveBodies;
+		std::vector<uint32_t> m_ActiveStamps;
+		uint32_t m_RunStamp = 0;
+		// Synchronous steps of a frame form one run, closed by WriteTransforms
+		bool m_RunOpen = false;
+
+		std::vector<ImpulseCommand> m_Commands;
+		std::vector<ImpulseCommand> m_PendingCommands;
+		std::mutex m_CommandMutex;
+
+		bool m_Pipelined = false;
+		std::thread m_Worker;
+		std::mutex m_WorkerMutex;
+		std::condition_variable m_WorkerCondition;
+		uint32_t m_PendingSteps = 0;
+		float m_PendingTimestep = 0.0f;
+		bool m_StepInFlight = false;
+		bool m_SwapPending = false;
+		bool m_ShutdownWorker = false;
+	};
+
+}
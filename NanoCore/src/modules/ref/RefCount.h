@@ -8,20 +8,39 @@ namespace NanoCore {
 	class RefCount
 	{
 	public:
-		void IncRefCount() const
+		// Both return the new count. Taking a reference needs no ordering, dropping one
+		// is acq_rel so the thread that reaches zero sees every other thread's writes.
+		uint32_t IncRefCount() const
 		{
-			++m_RefCount;
+			return m_RefCount.fetch_add(1, std::memory_order_relaxed) + 1;
 		}
-		void DecRefCount() const
+		uint32_t DecRefCount() const
 		{
-			--m_RefCount;
+			return m_RefCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
+		}
+
+		// Takes a reference unless the count already reached zero, used by weak handles
+		bool TryIncRefCount() const
+		{
+			uint32_t refCount = m_RefCount.load(std::memory_order_relaxed);
+			while (refCount != 0)
+			{
+				if (m_RefCount.compare_exchange_weak(refCount, refCount + 1, std::memory_order_relaxed))
+					return true;
+			}
+			return false;
 		}
 
 		
-		uint32_t GetRefCount() const { return m_RefCount.load(); }
+		uint32_t GetRefCount() const { return m_RefCount.load(std::memory_order_relaxed); }
+
+		// WeakHandleTable slot + 1, zero until a weak reference is taken
+		uint32_t GetWeakSlot() const { return m_WeakSlot.load(std::memory_order_acquire); }
 	private:
 		mutable std::atomic<uint32_t> m_RefCount = 0;
+		mutable std::atomic<uint32_t> m_WeakSlot = 0;
+
+		friend class WeakHandleTable;
 	};
 
 }
-
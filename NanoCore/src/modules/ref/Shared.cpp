@@ -1,30 +1,52 @@
 #include "ncpch.h"
 #include "Shared.h"
 
+#if NANO_TRACK_LIVE_REFERENCES
+
 namespace NanoCore {
 
+	// Split by address so threads registering unrelated objects don't share a lock
+	static constexpr size_t s_LiveReferenceShardCount = 64;
+
+	struct alignas(64) LiveReferenceShard
+	{
+		std::mutex Mutex;
+		std::unordered_set<void*> References;
+	};
 
-	static std::unordered_set<void*> s_LiveReferences;
-	static std::mutex s_LiveReferenceMutex;
+	static std::array<LiveReferenceShard, s_LiveReferenceShardCount> s_LiveReferenceShards;
+
+	static LiveReferenceShard& GetLiveReferenceShard(void* instance)
+	{
+		// Drop the allocation alignment bits, then mix so neighbouring objects spread out
+		uint64_t hash = ((uint64_t)(uintptr_t)instance >> 4) * 0x9E3779B97F4A7C15ull;
+		return s_LiveReferenceShards[hash >> 58];
+	}
 
 	void AddToLiveReferences(void* instance)
 	{
-		std::scoped_lock<std::mutex> lock(s_LiveReferenceMutex);
 		NANO_ENGINE_LOG_ASSERT(instance);
-		s_LiveReferences.insert(instance);
+		LiveReferenceShard& shard = GetLiveReferenceShard(instance);
+		std::scoped_lock<std::mutex> lock(shard.Mutex);
+		shard.References.insert(instance);
 	}
 
 	void RemoveFromLiveReferences(void* instance)
 	{
-		std::scoped_lock<std::mutex> lock(s_LiveReferenceMutex);
 		NANO_ENGINE_LOG_ASSERT(instance);
-		NANO_ENGINE_LOG_ASSERT(s_LiveReferences.find(instance) != s_LiveReferences.end());
-		s_LiveReferences.erase(instance);
+		LiveReferenceShard& shard = GetLiveReferenceShard(instance);
+		std::scoped_lock<std::mutex> lock(shard.Mutex);
+		NANO_ENGINE_LOG_ASSERT(shard.References.find(instance) != shard.References.end());
+		shard.References.erase(instance);
 	}
 
 	bool IsLive(void* instance)
 	{
 		NANO_ENGINE_LOG_ASSERT(instance);
-		return s_LiveReferences.find(instance) != s_LiveReferences.end();
+		LiveReferenceShard& shard = GetLiveReferenceShard(instance);
+		std::scoped_lock<std::mutex> lock(shard.Mutex);
+		return shard.References.find(instance) != shard.References.end();
 	}
-}
\ No newline at end of file
+}
+
+#endif
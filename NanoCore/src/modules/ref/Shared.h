@@ -1,13 +1,26 @@
 #pragma once
 
 #include "RefCount.h"
+#include "WeakHandleTable.h"
 
 
+// Registry of live Shared objects, used to catch access to destroyed ones. Debug builds only,
+// objects are registered when their first reference is taken and removed before they're deleted.
+#ifndef NANO_TRACK_LIVE_REFERENCES
+	#ifdef _DEBUG
+		#define NANO_TRACK_LIVE_REFERENCES 1
+	#else
+		#define NANO_TRACK_LIVE_REFERENCES 0
+	#endif
+#endif
+
 namespace NanoCore {
 
+#if NANO_TRACK_LIVE_REFERENCES
 	void AddToLiveReferences(void* instance);
 	void RemoveFromLiveReferences(void* instance);
 	bool IsLive(void* instance);
+#endif
 
 	template<typename T>
 	using Unique = std::unique_ptr<T>;
@@ -45,16 +58,23 @@ namespace NanoCore {
 		}
 
 		template<typename T2>
-		Shared(Shared<T2>&& other)
+		Shared(Shared<T2>&& other) noexcept
 		{
 			m_Instance = (T*)other.m_Instance;
 			other.m_Instance = nullptr;
 		}
 
+		// Same-type moves only hand the pointer over, no reference count traffic
+		Shared(Shared<T>&& other) noexcept
+			: m_Instance(other.m_Instance)
+		{
+			other.m_Instance = nullptr;
+		}
+
 		static Shared<T> CopyWithoutIncrement(const Shared<T>& other)
 		{
 			Shared<T> result = nullptr;
-			result->m_Instance = other.m_Instance;
+			result.m_Instance = other.m_Instance;
 			return result;
 		}
 
@@ -95,6 +115,18 @@ namespace NanoCore {
 			return *this;
 		}
 
+		Shared& operator=(Shared<T>&& other) noexcept
+		{
+			if (this != &other)
+			{
+				DecShared();
+
+				m_Instance = other.m_Instance;
+				other.m_Instance = nullptr;
+			}
+			return *this;
+		}
+
 		template<typename T2>
 		Shared& operator=(Shared<T2>&& other)
 		{
@@ -158,8 +190,12 @@ namespace NanoCore {
 		{
 			if (m_Instance)
 			{
+#if NANO_TRACK_LIVE_REFERENCES
+				if (m_Instance->IncRefCount() == 1)
+					AddToLiveReferences((void*)m_Instance);
+#else
 				m_Instance->IncRefCount();
-				AddToLiveReferences((void*)m_Instance);
+#endif
 			}
 		}
 
@@ -167,11 +203,17 @@ namespace NanoCore {
 		{
 			if (m_Instance)
 			{
-				m_Instance->DecRefCount();
-				if (m_Instance->GetRefCount() == 0)
+				// Only the thread that drops the last reference sees zero
+				if (m_Instance->DecRefCount() == 0)
 				{
-					delete m_Instance;
+					// Weak handles must stop resolving before the memory goes away
+					if (uint32_t weakSlot = m_Instance->GetWeakSlot())
+						WeakHandleTable::Retire(weakSlot);
+
+#if NANO_TRACK_LIVE_REFERENCES
 					RemoveFromLiveReferences((void*)m_Instance);
+#endif
+					delete m_Instance;
 					m_Instance = nullptr;
 				}
 			}
@@ -179,6 +221,8 @@ namespace NanoCore {
 
 		template<class T2>
 		friend class Shared;
+		template<class T2>
+		friend class WeakRef;
 		mutable T* m_Instance;
 	};
 }
@@ -0,0 +1,160 @@
+#include "ncpch.h"
+#include "WeakHandleTable.h"
+
+#include <thread>
+
+namespace NanoCore {
+
+	// State packs the generation (high 32 bits), a dead flag and the number of
+	// TryRetain calls currently reading the object (low 31 bits)
+	static constexpr uint64_t s_WeakSlotDeadBit = 1ull << 31;
+	static constexpr uint64_t s_WeakSlotPinMask = s_WeakSlotDeadBit - 1;
+
+	static constexpr uint32_t s_WeakSlotChunkSize = 16384;
+	static constexpr uint32_t s_MaxWeakSlotChunks = 4096;
+
+	struct WeakHandleSlot
+	{
+		std::atomic<uint64_t> State = 1ull << 32;
+		std::atomic<RefCount*> Object = nullptr;
+	};
+
+	struct WeakHandleTableData
+	{
+		// Chunks are never moved or freed, so readers only need the chunk pointer
+		std::array<std::atomic<WeakHandleSlot*>, s_MaxWeakSlotChunks> Chunks = {};
+
+		std::mutex AllocationMutex;
+		std::vector<uint32_t> FreeSlots;
+		uint32_t SlotCount = 0;
+	};
+
+	static WeakHandleTableData s_Data;
+
+	static uint32_t GetGeneration(uint64_t state)
+	{
+		return (uint32_t)(state >> 32);
+	}
+
+	static WeakHandleSlot* GetSlot(uint32_t index)
+	{
+		if (index == 0)
+			return nullptr;
+
+		uint32_t slot = index - 1;
+		uint32_t chunk = slot / s_WeakSlotChunkSize;
+		if (chunk >= s_MaxWeakSlotChunks)
+			return nullptr;
+
+		WeakHandleSlot* slots = s_Data.Chunks[chunk].load(std::memory_order_acquire);
+		return slots ? &slots[slot % s_WeakSlotChunkSize] : nullptr;
+	}
+
+	static uint32_t AllocateSlot()
+	{
+		std::scoped_lock<std::mutex> lock(s_Data.AllocationMutex);
+
+		if (!s_Data.FreeSlots.empty())
+		{
+			uint32_t index = s_Data.FreeSlots.back();
+			s_Data.FreeSlots.pop_back();
+			return index;
+		}
+
+		uint32_t slot = s_Data.SlotCount++;
+		uint32_t chunk = slot / s_WeakSlotChunkSize;
+		NANO_ENGINE_LOG_ASSERT(chunk < s_MaxWeakSlotChunks, "Weak handle table is full!");
+
+		if (!s_Data.Chunks[chunk].load(std::memory_order_relaxed))
+			s_Data.Chunks[chunk].store(new WeakHandleSlot[s_WeakSlotChunkSize], std::memory_order_release);
+
+		return slot + 1;
+	}
+
+	static void FreeSlot(uint32_t index)
+	{
+		std::scoped_lock<std::mutex> lock(s_Data.AllocationMutex);
+		s_Data.FreeSlots.push_back(index);
+	}
+
+	WeakHandle WeakHandleTable::Acquire(RefCount* object)
+	{
+		if (!object)
+			return {};
+
+		uint32_t index = object->m_WeakSlot.load(std::memory_order_acquire);
+		if (index == 0)
+		{
+			uint32_t newIndex = AllocateSlot();
+			GetSlot(newIndex)->Object.store(object, std::memory_order_release);
+
+			// Another thread may have slotted the object first, keep theirs
+			if (object->m_WeakSlot.compare_exchange_strong(index, newIndex, std::memory_order_acq_rel))
+			{
+				index = newIndex;
+			}
+			else
+			{
+				GetSlot(newIndex)->Object.store(nullptr, std::memory_order_relaxed);
+				FreeSlot(newIndex);
+			}
+		}
+
+		return { index, GetGeneration(GetSlot(index)->State.load(std::memory_order_acquire)) };
+	}
+
+	bool WeakHandleTable::IsValid(WeakHandle handle)
+	{
+		WeakHandleSlot* slot = GetSlot(handle.Index);
+		if (!slot)
+			return false;
+
+		uint64_t state = slot->State.load(std::memory_order_acquire);
+		return GetGeneration(state) == handle.Generation && !(state & s_WeakSlotDeadBit);
+	}
+
+	RefCount* WeakHandleTable::TryRetain(WeakHandle handle)
+	{
+		WeakHandleSlot* slot = GetSlot(handle.Index);
+		if (!slot)
+			return nullptr;
+
+		// Pin the slot so Retire can't let the object be deleted while it's read
+		uint64_t state = slot->State.load(std::memory_order_acquire);
+		do
+		{
+			if (GetGeneration(state) != handle.Generation || (state & s_WeakSlotDeadBit))
+				return nullptr;
+		} while (!slot->State.compare_exchange_weak(state, state + 1, std::memory_order_acq_rel, std::memory_order_acquire));
+
+		// A zero count means the object is already on its way to Retire
+		RefCount* object = slot->Object.load(std::memory_order_acquire);
+		bool retained = object && object->TryIncRefCount();
+
+		slot->State.fetch_sub(1, std::memory_order_release);
+		return retained ? object : nullptr;
+	}
+
+	void WeakHandleTable::Retire(uint32_t index)
+	{
+		WeakHandleSlot* slot = GetSlot(index);
+		NANO_ENGINE_LOG_ASSERT(slot);
+
+		uint64_t state = slot->State.fetch_or(s_WeakSlotDeadBit, std::memory_order_acq_rel);
+		while (state & s_WeakSlotPinMask)
+		{
+			std::this_thread::yield();
+			state = slot->State.load(std::memory_order_acquire);
+		}
+
+		uint32_t generation = GetGeneration(state) + 1;
+		if (generation == 0)
+			generation = 1;
+
+		slot->Object.store(nullptr, std::memory_order_relaxed);
+		slot->State.store((uint64_t)generation << 32, std::memory_order_release);
+
+		FreeSlot(index);
+	}
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+namespace NanoCore {
+
+	class RefCount;
+
+	struct WeakHandle
+	{
+		// Slot + 1, zero is the null handle
+		uint32_t Index = 0;
+		uint32_t Generation = 0;
+
+		bool operator==(const WeakHandle& other) const { return Index == other.Index && Generation == other.Generation; }
+		bool operator!=(const WeakHandle& other) const { return !(*this == other); }
+	};
+
+	// Gives RefCount objects an (index, generation) identity for weak references.
+	// A slot's generation is bumped when its object dies, so stale handles stop
+	// matching even if a new object is later allocated at the same address.
+	// Validation and locking are lock-free, only slot allocation takes a lock.
+	class WeakHandleTable
+	{
+	public:
+		// Handle for a live object, its slot is assigned on first use
+		static WeakHandle Acquire(RefCount* object);
+
+		static bool IsValid(WeakHandle handle);
+
+		// Adds a strong reference if the object is still alive, null otherwise
+		static RefCount* TryRetain(WeakHandle handle);
+
+		// Called once the object's last strong reference is gone, before it's deleted.
+		// Waits for in-flight TryRetain calls on the slot, then invalidates its handles.
+		static void Retire(uint32_t index);
+	};
+
+}
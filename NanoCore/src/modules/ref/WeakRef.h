@@ -1,32 +1,52 @@
 #pragma once
+
 #include "Shared.h"
 
 namespace NanoCore {
+
+	// Non-owning reference to a Shared object. Holds only a generation-checked
+	// handle, so it's 8 bytes and never reports a destroyed object as alive.
 	template<typename T>
 	class WeakRef
 	{
 	public:
 		WeakRef() = default;
 
-		WeakRef(Shared<T> ref)
+		WeakRef(const Shared<T>& shared)
 		{
-			m_Instance = ref.Raw();
+			static_assert(std::is_base_of<RefCount, T>::value, "Class is not SharedCounted!");
+
+			m_Handle = WeakHandleTable::Acquire(shared.m_Instance);
 		}
 
+		// The object must currently be owned by at least one Shared
 		WeakRef(T* instance)
 		{
-			m_Instance = instance;
+			static_assert(std::is_base_of<RefCount, T>::value, "Class is not SharedCounted!");
+
+			m_Handle = WeakHandleTable::Acquire(instance);
 		}
 
-		T* operator->() { return m_Instance; }
-		const T* operator->() const { return m_Instance; }
+		bool IsValid() const { return WeakHandleTable::IsValid(m_Handle); }
+		operator bool() const { return IsValid(); }
 
-		T& operator*() { return *m_Instance; }
-		const T& operator*() const { return *m_Instance; }
+		// Strong reference to the object, null if it has been destroyed
+		Shared<T> Lock() const
+		{
+			Shared<T> result;
+			if (RefCount* object = WeakHandleTable::TryRetain(m_Handle))
+				result.m_Instance = static_cast<T*>(object);
+			return result;
+		}
 
-		bool IsValid() const { return m_Instance ? IsLive(m_Instance) : false; }
-		operator bool() const { return IsValid(); }
+		void Reset() { m_Handle = {}; }
+
+		WeakHandle GetHandle() const { return m_Handle; }
+
+		bool operator==(const WeakRef<T>& other) const { return m_Handle == other.m_Handle; }
+		bool operator!=(const WeakRef<T>& other) const { return m_Handle != other.m_Handle; }
 	private:
-		T* m_Instance = nullptr;
+		WeakHandle m_Handle;
 	};
-}
\ No newline at end of file
+
+}
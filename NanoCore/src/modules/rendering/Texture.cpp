@@ -2,8 +2,11 @@
 #include "modules/rendering/Texture.h"
 
 #include "modules/rendering/Renderer.h"
+#include "modules/utils/FileManager.h"
 #include "Platform/OpenGL/OpenGLTexture.h"
 
+#include <stb_image/stb_image.h>
+
 namespace NanoCore{
 	Shared<Texture2D> Texture2D::Create(uint32_t width, uint32_t height)
 	{
@@ -39,6 +42,93 @@ namespace NanoCore{
 		NANO_ENGINE_LOG_ASSERT(false, "Unknown RendererAPI!");
 		return nullptr;
 	}
+	Shared<Texture2D> Texture2D::Create(const std::string& path, const TextureImage& image, TextureProperties properties)
+	{
+		switch (Renderer::GetAPI())
+		{
+		case RendererAPI::API::None:    NANO_ENGINE_LOG_ASSERT(false, "RendererAPI::None is currently not supported!"); return nullptr;
+		case RendererAPI::API::OpenGL:  return Shared<OpenGLTexture2D>::Create(path, image);
+		}
+
+		NANO_ENGINE_LOG_ASSERT(false, "Unknown RendererAPI!");
+		return nullptr;
+	}
+
+	bool Texture2D::DecodeImageFile(const std::string& path, TextureImage& image)
+	{
+		RA_PROFILE_FUNCTION();
+
+		// Mapped so images inside a mounted asset pack decode straight from the pack
+		MappedFile file;
+		if (!file.Open(path) || file.GetSize() > INT_MAX)
+			return false;
+
+		int width, height, channels;
+		// The flip setting is per thread, decodes on workers don't share it
+		stbi_set_flip_vertically_on_load_thread(1);
+		stbi_uc* data = stbi_load_from_memory(file.GetData(), (int)file.GetSize(), &width, &height, &channels, 0);
+		if (!data)
+			return false;
+
+		if (channels != 3 && channels != 4)
+		{
+			NANO_ENGINE_LOG_WARN("Image '{}' has {} channels, only RGB and RGBA are supported", path, channels);
+			stbi_image_free(data);
+			return false;
+		}
+
+		image.Width = width;
+		image.Height = height;
+		image.Channels = channels;
+		image.MipCount = 1;
+		image.Pixels.assign(data, data + (size_t)width * height * channels);
+		stbi_image_free(data);
+		return true;
+	}
+
+	void Texture2D::GenerateMips(TextureImage& image)
+	{
+		RA_PROFILE_FUNCTION();
+
+		NANO_ENGINE_LOG_ASSERT(image.MipCount == 1, "Image already has mips!");
+
+		uint32_t mipCount = 1;
+		while ((image.Width >> mipCount) > 0 || (image.Height >> mipCount) > 0)
+			mipCount++;
+
+		uint64_t size = 0;
+		image.MipCount = mipCount;
+		for (uint32_t mip = 0; mip < mipCount; mip++)
+			size += image.GetMipSize(mip);
+		image.Pixels.resize(size);
+
+		const uint32_t channels = image.Channels;
+		uint8_t* src = image.Pixels.data();
+		for (uint32_t mip = 1; mip < mipCount; mip++)
+		{
+			const uint32_t srcWidth = image.GetMipWidth(mip - 1), srcHeight = image.GetMipHeight(mip - 1);
+			const uint32_t width = image.GetMipWidth(mip), height = image.GetMipHeight(mip);
+			uint8_t* dst = src + image.GetMipSize(mip - 1);
+
+			// Average of the 2x2 texels below, a side that is already 1 wide reuses its only texel
+			for (uint32_t y = 0; y < height; y++)
+			{
+				const uint8_t* row0 = src + (size_t)std::min(y * 2, srcHeight - 1) * srcWidth * channels;
+				const uint8_t* row1 = src + (size_t)std::min(y * 2 + 1, srcHeight - 1) * srcWidth * channels;
+				uint8_t* out = dst + (size_t)y * width * channels;
+
+				for (uint32_t x = 0; x < width; x++)
+				{
+					const uint32_t x0 = std::min(x * 2, srcWidth - 1) * channels;
+					const uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1) * channels;
+					for (uint32_t c = 0; c < channels; c++)
+						out[x * channels + c] = (uint8_t)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+				}
+			}
+
+			src = dst;
+		}
+	}
 	//--------------------------!
 
 
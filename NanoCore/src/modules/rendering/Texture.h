@@ -1,8 +1,10 @@
 #pragma once
 
 #include "core/base/Base.h"
+#include "modules/entity/Asset.h"
 
 #include <string>
+#include <vector>
 
 namespace NanoCore{
 	enum class ImageFormat
@@ -72,7 +74,22 @@ namespace NanoCore{
 		bool Storage = false;
 	};
 
-	class Texture :public RefCount
+	// Decoded pixels of an image file. Decoding touches no GPU state, so it can run
+	// on any thread and only the upload has to happen on the main thread.
+	struct TextureImage
+	{
+		uint32_t Width = 0, Height = 0;
+		uint32_t Channels = 0;
+		// Pixels holds the mips one after another, largest first
+		uint32_t MipCount = 1;
+		std::vector<uint8_t> Pixels;
+
+		uint32_t GetMipWidth(uint32_t mip) const { return std::max(Width >> mip, 1u); }
+		uint32_t GetMipHeight(uint32_t mip) const { return std::max(Height >> mip, 1u); }
+		uint64_t GetMipSize(uint32_t mip) const { return (uint64_t)GetMipWidth(mip) * GetMipHeight(mip) * Channels; }
+	};
+
+	class Texture : public Asset
 	{
 	public:
 		virtual ~Texture() = default;
@@ -99,6 +116,19 @@ namespace NanoCore{
 		static Shared<Texture2D> Create(uint32_t width, uint32_t height);
 		static Shared<Texture2D> Create(ImageFormat format, uint32_t width, uint32_t height, const void* data = nullptr, TextureProperties properties = TextureProperties());
 		static Shared<Texture2D> Create(const std::string& path, TextureProperties properties = TextureProperties());
+		// Uploads an image decoded by DecodeImageFile, path is what GetPath() returns
+		static Shared<Texture2D> Create(const std::string& path, const TextureImage& image, TextureProperties properties = TextureProperties());
+
+		// Thread safe, false if the file can't be read or has an unsupported channel count
+		static bool DecodeImageFile(const std::string& path, TextureImage& image);
+		// Appends the box filtered mips down to 1x1 to an image with only its top level. Thread safe.
+		static void GenerateMips(TextureImage& image);
+
+		// Replaces the image of a loaded texture, size and channels may change. Everyone
+		// holding the texture sees the new image, the asset manager reloads textures this way.
+		virtual void Reload(const TextureImage& image) = 0;
+
+		virtual AssetType GetAssetType() const override { return AssetType::Texture; }
 
 	};
 
@@ -3,17 +3,22 @@
 #include "ScriptEngine.h"
 
 #include "ScriptGlue.h"
+#include "ScriptProfiler.h"
 
 #include "mono/jit/jit.h"
 #include "mono/metadata/assembly.h"
 #include "mono/metadata/object.h"
+#include "mono/metadata/class.h"
 
 #include "mono/metadata/tabledefs.h"
 
-#include "modules/utils/FileWatch.h"
+#include "modules/utils/FileManager.h"
 
 #include "Core/base/Application.h"
 #include "modules/utils/Timer.h"
+#include "modules/utils/Hash.h"
+#include "modules/utils/FileManager.h"
+#include "modules/info/Project.h"
 
 #include "ScriptGlue.h"
 
@@ -42,58 +47,34 @@ namespace NanoCore {
 
 	namespace Utils {
 
-		// TODO: move to FileSystem class
-		static char* ReadBytes(const std::filesystem::path& filepath, uint32_t* outSize)
+		static MonoAssembly* LoadMonoAssembly(const std::filesystem::path& assemblyPath)
 		{
-			std::ifstream stream(filepath, std::ios::binary | std::ios::ate);
-
-			if (!stream)
-			{
-				// Failed to open the file
-				return nullptr;
-			}
+			RA_PROFILE_FUNCTION();
 
-			std::streampos end = stream.tellg();
-			stream.seekg(0, std::ios::beg);
-			uint64_t size = end - stream.tellg();
-
-			if (size == 0)
+			MappedFile file;
+			if (!file.Open(assemblyPath))
 			{
-				// File is empty
+				NANO_ENGINE_LOG_ERROR("Could not open assembly {}", assemblyPath.string());
 				return nullptr;
 			}
 
-			char* buffer = new char[size];
-			stream.read((char*)buffer, size);
-			stream.close();
-
-			*outSize = (uint32_t)size;
-			return buffer;
-		}
-
-		static MonoAssembly* LoadMonoAssembly(const std::filesystem::path& assemblyPath)
-		{
-			uint32_t fileSize = 0;
-			char* fileData = ReadBytes(assemblyPath, &fileSize);
-
 			// NOTE: We can't use this image for anything other than loading the assembly because this image doesn't have a reference to the assembly
+			// Mono copies the image (need_copy), so the mapping is released right away and the build can overwrite the dll.
+			// The image is named after the file so Mono finds the AOT image (<assembly>.dll.dll) next to it.
+			std::string pathString = assemblyPath.string();
 			MonoImageOpenStatus status;
-			MonoImage* image = mono_image_open_from_data_full(fileData, fileSize, 1, &status, 0);
+			MonoImage* image = mono_image_open_from_data_with_name((char*)file.GetData(), (uint32_t)file.GetSize(), 1, &status, 0, pathString.c_str());
+			file.Close();
 
 			if (status != MONO_IMAGE_OK)
 			{
-				const char* errorMessage = mono_image_strerror(status);
-				// Log some error message using the errorMessage data
+				NANO_ENGINE_LOG_ERROR("Could not load assembly {}: {}", assemblyPath.string(), mono_image_strerror(status));
 				return nullptr;
 			}
 
-			std::string pathString = assemblyPath.string();
 			MonoAssembly* assembly = mono_assembly_load_from_full(image, pathString.c_str(), &status, 0);
 			mono_image_close(image);
 
-			// Don't forget to free the file data
-			delete[] fileData;
-
 			return assembly;
 		}
 
@@ -114,6 +95,17 @@ namespace NanoCore {
 			}
 		}
 
+		static const char* ScriptCompilationModeToString(ScriptCompilationMode mode)
+		{
+			switch (mode)
+			{
+				case ScriptCompilationMode::JIT:     return "JIT";
+				case ScriptCompilationMode::AOT:     return "AOT";
+				case ScriptCompilationMode::FullAOT: return "FullAOT";
+			}
+			return "Unknown";
+		}
+
 		ScriptFieldType MonoTypeToScriptFieldType(MonoType* monoType)
 		{
 			std::string typeName = mono_type_get_name(monoType);
@@ -130,6 +122,26 @@ namespace NanoCore {
 
 	}
 
+	struct ScriptClassBatch
+	{
+		Shared<ScriptClass> Class;
+		std::vector<ScriptInstance*> Instances;
+
+		// Static batch entry points, null when the class only has per-instance methods
+		ScriptBatchUpdateThunk OnUpdateBatchThunk = nullptr;
+		ScriptBatchUpdateThunk OnFixedUpdateBatchThunk = nullptr;
+
+		// GC handle keeping the Entity[] handed to the batch methods alive,
+		// rebuilt whenever instances are added or removed
+		uint32_t EntityArrayHandle = 0;
+		bool EntityArrayDirty = true;
+
+		// Set while instances are updated one by one. Removed instances only clear
+		// their slot then, the batch is compacted once the loop is done.
+		bool Invoking = false;
+		bool HasEmptySlots = false;
+	};
+
 	struct ScriptEngineData
 	{
 		MonoDomain* RootDomain = nullptr;
@@ -145,14 +157,25 @@ namespace NanoCore {
 		std::filesystem::path AppAssemblyFilepath;
 
 		Shared<ScriptClass> EntityClass;
+		ScriptConstructorThunk EntityConstructorThunk = nullptr;
+		MonoClassField* EntityIDField = nullptr;
 
 		std::unordered_map<std::string, Shared<ScriptClass>> EntityClasses;
+		uint64_t ClassLayoutHash = 0;
 		std::unordered_map<UUID, Shared<ScriptInstance>> EntityInstances;
-		std::unordered_map<UUID, ScriptFieldMap> EntityScriptFields;
+		std::unordered_map<UUID, ScriptFieldStorage> EntityScriptFields;
+
+		std::vector<ScriptClassBatch> ClassBatches;
+		std::unordered_map<ScriptClass*, uint32_t> ClassBatchIndices;
 
-		Unique<filewatch::FileWatch<std::string>> AppAssemblyFileWatcher;
+		uint32_t AppAssemblyChangeCallback = 0;
 		bool AssemblyReloadPending = false;
 
+		ScriptCompilationMode CompilationMode = ScriptCompilationMode::JIT;
+
+		// Set on runtime start, the first update is timed to catch JIT hitches
+		bool FirstUpdatePending = false;
+
 		// Runtime
 
 		Scene* SceneContext = nullptr;
@@ -160,25 +183,184 @@ namespace NanoCore {
 
 	static ScriptEngineData* s_Data = nullptr;
 
-	static void OnAppAssemblyFileSystemEvent(const std::string& path, const filewatch::Event change_type)
+	static ScriptBatchUpdateThunk GetStaticBatchThunk(ScriptClass& scriptClass, const char* name)
+	{
+		MonoMethod* method = scriptClass.GetMethod(name, 2);
+		if (!method)
+			return nullptr;
+
+		uint32_t implFlags;
+		if (!(mono_method_get_flags(method, &implFlags) & METHOD_ATTRIBUTE_STATIC))
+		{
+			NANO_ENGINE_LOG_WARN("{} must be static to be used as a batch update", name);
+			return nullptr;
+		}
+		return (ScriptBatchUpdateThunk)mono_method_get_unmanaged_thunk(method);
+	}
+
+	void ScriptEngine::AddToClassBatch(Shared<ScriptInstance> instance)
+	{
+		ScriptClass* scriptClass = instance->GetScriptClass().Raw();
+
+		auto it = s_Data->ClassBatchIndices.find(scriptClass);
+		if (it == s_Data->ClassBatchIndices.end())
+		{
+			it = s_Data->ClassBatchIndices.emplace(scriptClass, (uint32_t)s_Data->ClassBatches.size()).first;
+
+			ScriptClassBatch& batch = s_Data->ClassBatches.emplace_back();
+			batch.Class = instance->GetScriptClass();
+			batch.OnUpdateBatchThunk = GetStaticBatchThunk(*scriptClass, "OnUpdateBatch");
+			batch.OnFixedUpdateBatchThunk = GetStaticBatchThunk(*scriptClass, "OnFixedUpdateBatch");
+		}
+
+		ScriptClassBatch& batch = s_Data->ClassBatches[it->second];
+		instance->m_BatchSlot = (uint32_t)batch.Instances.size();
+		batch.Instances.push_back(instance.Raw());
+		batch.EntityArrayDirty = true;
+	}
+
+	void ScriptEngine::RemoveFromClassBatch(Shared<ScriptInstance> instance)
 	{
-		if (!s_Data->AssemblyReloadPending && change_type == filewatch::Event::modified)
+		ScriptClassBatch& batch = s_Data->ClassBatches[s_Data->ClassBatchIndices.at(instance->GetScriptClass().Raw())];
+		batch.EntityArrayDirty = true;
+
+		if (batch.Invoking)
 		{
-			s_Data->AssemblyReloadPending = true;
+			batch.Instances[instance->m_BatchSlot] = nullptr;
+			batch.HasEmptySlots = true;
+			return;
+		}
 
-			Application::Get().SubmitToMainThread([]()
+		ScriptInstance* last = batch.Instances.back();
+		batch.Instances[instance->m_BatchSlot] = last;
+		last->m_BatchSlot = instance->m_BatchSlot;
+		batch.Instances.pop_back();
+	}
+
+	static MonoArray* GetBatchEntityArray(ScriptClassBatch& batch, MonoClass* entityClass)
+	{
+		if (!batch.EntityArrayDirty)
+			return (MonoArray*)mono_gchandle_get_target(batch.EntityArrayHandle);
+
+		if (batch.EntityArrayHandle)
+			mono_gchandle_free(batch.EntityArrayHandle);
+
+		MonoArray* entities = mono_array_new(s_Data->AppDomain, entityClass, batch.Instances.size());
+		for (size_t i = 0; i < batch.Instances.size(); i++)
+			mono_array_setref(entities, i, batch.Instances[i]->GetManagedObject());
+
+		batch.EntityArrayHandle = mono_gchandle_new((MonoObject*)entities, false);
+		batch.EntityArrayDirty = false;
+		return entities;
+	}
+
+	void ScriptEngine::InvokeClassBatch(size_t batchIndex, ScriptBatchUpdateThunk batchThunk, void (ScriptInstance::*invoke)(float), ScriptProfileMethod method, float ts)
+	{
+		// Scripts create and destroy entities while they run. A new class adds a batch and may
+		// move this one, so it's looked up again after every call into managed code.
+		auto& batches = s_Data->ClassBatches;
+		if (batches[batchIndex].Instances.empty())
+			return;
+
+		Shared<ScriptClass> scriptClass = batches[batchIndex].Class;
+		ScriptProfileScope profileScope(scriptClass->m_ProfileIndex, method);
+
+		if (batchThunk)
+		{
+			MonoException* exception = nullptr;
+			batchThunk(GetBatchEntityArray(batches[batchIndex], s_Data->EntityClass->m_MonoClass), ts, &exception);
+			if (exception)
+				scriptClass->LogException((MonoObject*)exception, "batch update");
+			return;
+		}
+
+		// Instances created by the updates are appended and run from the next update on
+		batches[batchIndex].Invoking = true;
+		const size_t count = batches[batchIndex].Instances.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			// Held for the call, a script destroying its own entity drops the engine's reference
+			if (Shared<ScriptInstance> instance = batches[batchIndex].Instances[i])
+				(instance.Raw()->*invoke)(ts);
+		}
+
+		ScriptClassBatch& batch = batches[batchIndex];
+		batch.Invoking = false;
+		if (!batch.HasEmptySlots)
+			return;
+
+		std::vector<ScriptInstance*>& instances = batch.Instances;
+		for (size_t i = 0; i < instances.size();)
+		{
+			if (instances[i])
 			{
-				s_Data->AppAssemblyFileWatcher.reset();
-				ScriptEngine::ReloadAssembly();
-			});
+				i++;
+				continue;
+			}
+
+			instances[i] = instances.back();
+			instances.pop_back();
+			if (i < instances.size() && instances[i])
+				instances[i]->m_BatchSlot = (uint32_t)i;
 		}
+		batch.HasEmptySlots = false;
+	}
+
+	void ScriptEngine::ClearClassBatches()
+	{
+		for (auto& batch : s_Data->ClassBatches)
+		{
+			if (batch.EntityArrayHandle)
+				mono_gchandle_free(batch.EntityArrayHandle);
+		}
+
+		s_Data->ClassBatches.clear();
+		s_Data->ClassBatchIndices.clear();
+	}
+
+	static void WatchAppAssembly(bool watch)
+	{
+		if (s_Data->AppAssemblyChangeCallback)
+		{
+			FileSystem::RemoveChangeCallback(s_Data->AppAssemblyChangeCallback);
+			FileSystem::UnwatchDirectory(s_Data->AppAssemblyFilepath.parent_path());
+			s_Data->AppAssemblyChangeCallback = 0;
+		}
+
+		if (!watch)
+			return;
+
+		// Called on the main thread with the changes of a whole build, so the assembly is reloaded once
+		s_Data->AppAssemblyChangeCallback = FileSystem::AddChangeCallback([](const std::vector<FileSystemChangedEvent>& events)
+		{
+			if (s_Data->AssemblyReloadPending)
+				return;
+
+			std::filesystem::path assemblyPath = std::filesystem::absolute(s_Data->AppAssemblyFilepath).lexically_normal();
+			for (const FileSystemChangedEvent& e : events)
+			{
+				if (e.Action != FileSystemAction::Delete && e.FilePath == assemblyPath)
+				{
+					s_Data->AssemblyReloadPending = true;
+					ScriptEngine::ReloadAssembly();
+					return;
+				}
+			}
+		});
+		FileSystem::WatchDirectory(s_Data->AppAssemblyFilepath.parent_path());
 	}
 
 	void ScriptEngine::Init()
 	{
+		RA_PROFILE_FUNCTION();
+
+		Timer initTimer;
+
 		s_Data = new ScriptEngineData();
 
 		InitMono();
+		float monoTime = initTimer.ElapsedMillis();
+
 		ScriptGlue::RegisterFunctions();
 
 		//LoadAssembly("resources/scripts/ScriptSystem.dll");
@@ -187,7 +369,10 @@ namespace NanoCore {
 		ScriptGlue::RegisterComponents();
 
 		// Retrieve and instantiate class
-		s_Data->EntityClass = Shared<ScriptClass>::Create("Hazel", "Entity", true);
+		LoadEntityClass();
+
+		NANO_ENGINE_LOG_INFO("Script engine started in {:.2f}ms ({} mode, runtime {:.2f}ms)",
+			initTimer.ElapsedMillis(), Utils::ScriptCompilationModeToString(s_Data->CompilationMode), monoTime);
 #if 0
 	
 		MonoObject* instance = s_Data->EntityClass.Instantiate();
@@ -224,6 +409,7 @@ namespace NanoCore {
 
 	void ScriptEngine::Shutdown()
 	{
+		WatchAppAssembly(false);
 		ShutdownMono();
 		delete s_Data;
 	}
@@ -232,6 +418,28 @@ namespace NanoCore {
 	{
 		mono_set_assemblies_path("resources/mono/lib");
 
+		if (Shared<Project> project = Project::GetActive())
+			s_Data->CompilationMode = project->GetConfig().ScriptCompilation;
+
+#ifndef NANO_EXPERIMENTAL_FULL_AOT
+		// Method thunks need wrappers generated at runtime, which the disabled JIT can't compile
+		if (s_Data->CompilationMode == ScriptCompilationMode::FullAOT)
+		{
+			NANO_ENGINE_LOG_WARN("FullAOT script compilation is experimental, running as AOT");
+			s_Data->CompilationMode = ScriptCompilationMode::AOT;
+		}
+#endif
+
+		// Has to be set before the runtime starts
+		switch (s_Data->CompilationMode)
+		{
+			case ScriptCompilationMode::JIT:     mono_jit_set_aot_mode(MONO_AOT_MODE_NONE); break;
+			case ScriptCompilationMode::AOT:     mono_jit_set_aot_mode(MONO_AOT_MODE_NORMAL); break;
+			case ScriptCompilationMode::FullAOT: mono_jit_set_aot_mode(MONO_AOT_MODE_FULL); break;
+		}
+
+		ScriptProfiler::Init();
+
 		MonoDomain* rootDomain = mono_jit_init("HazelJITRuntime");
 		NANO_ENGINE_LOG_ASSERT(rootDomain);
 
@@ -246,10 +454,29 @@ namespace NanoCore {
 		mono_domain_unload(s_Data->AppDomain);
 		s_Data->AppDomain = nullptr;
 		
+		ScriptProfiler::Shutdown();
+
 		mono_jit_cleanup(s_Data->RootDomain);
 		s_Data->RootDomain = nullptr;
 	}
 
+	// Mono looks for the precompiled image next to the assembly, named <assembly>.dll.dll
+	static void CheckAOTImage(const std::filesystem::path& assemblyPath)
+	{
+		if (s_Data->CompilationMode == ScriptCompilationMode::JIT)
+			return;
+
+		std::filesystem::path aotImagePath = assemblyPath;
+		aotImagePath += ".dll";
+		if (std::filesystem::exists(aotImagePath))
+			return;
+
+		if (s_Data->CompilationMode == ScriptCompilationMode::FullAOT)
+			NANO_ENGINE_LOG_ERROR("No AOT image for {}, its methods can't run with the JIT disabled", assemblyPath.string());
+		else
+			NANO_ENGINE_LOG_WARN("No AOT image for {}, falling back to the JIT", assemblyPath.string());
+	}
+
 	void ScriptEngine::LoadAssembly(const std::filesystem::path& filepath)
 	{
 		// Create an App Domain
@@ -258,6 +485,7 @@ namespace NanoCore {
 
 		// Move this maybe
 		s_Data->CoreAssemblyFilepath = filepath;
+		CheckAOTImage(filepath);
 		s_Data->CoreAssembly = Utils::LoadMonoAssembly(filepath);
 		s_Data->CoreAssemblyImage = mono_assembly_get_image(s_Data->CoreAssembly);
 		// Utils::PrintAssemblyTypes(s_Data->CoreAssembly);
@@ -266,36 +494,160 @@ namespace NanoCore {
 	void ScriptEngine::LoadAppAssembly(const std::filesystem::path& filepath)
 	{
 		// Move this maybe
+		WatchAppAssembly(false);
 		s_Data->AppAssemblyFilepath = filepath;
+		CheckAOTImage(filepath);
 		s_Data->AppAssembly = Utils::LoadMonoAssembly(filepath);
 		auto assemb = s_Data->AppAssembly;
 		s_Data->AppAssemblyImage = mono_assembly_get_image(s_Data->AppAssembly);
 		auto assembi = s_Data->AppAssemblyImage;
 		// Utils::PrintAssemblyTypes(s_Data->AppAssembly);
 
-		s_Data->AppAssemblyFileWatcher = std::make_unique<filewatch::FileWatch<std::string>>(filepath.string(), OnAppAssemblyFileSystemEvent);
+		// Precompiled-only code can't be reloaded, there's no JIT for the new assembly
+		WatchAppAssembly(s_Data->CompilationMode != ScriptCompilationMode::FullAOT);
 		s_Data->AssemblyReloadPending = false;
 	}
 
+	void ScriptEngine::LoadEntityClass()
+	{
+		s_Data->EntityClass = Shared<ScriptClass>::Create("Hazel", "Entity", true);
+		s_Data->EntityConstructorThunk = (ScriptConstructorThunk)s_Data->EntityClass->GetThunk(".ctor", 1);
+		s_Data->EntityIDField = s_Data->EntityClass->m_MonoClass ? mono_class_get_field_from_name(s_Data->EntityClass->m_MonoClass, "ID") : nullptr;
+	}
+
+	// Re-lays out field values for a newer version of the class, matching fields by name and type
+	static void MigrateFieldStorage(ScriptFieldStorage& storage, Shared<ScriptClass> scriptClass)
+	{
+		ScriptFieldStorage migrated;
+		migrated.Class = scriptClass;
+		migrated.Buffer.assign(scriptClass->GetFieldStorageSize(), 0);
+		migrated.AssignedFields.assign(scriptClass->GetFields().size(), 0);
+
+		for (const ScriptField& field : scriptClass->GetFields())
+		{
+			const ScriptField* previous = storage.Class ? storage.Class->FindField(field.Name) : nullptr;
+			if (!previous || previous->Type != field.Type || !storage.IsSet(*previous))
+				continue;
+
+			memcpy(migrated.Buffer.data() + field.Offset, storage.Buffer.data() + previous->Offset, field.Size);
+			migrated.AssignedFields[field.Index] = 1;
+		}
+
+		storage = std::move(migrated);
+	}
+
 	void ScriptEngine::ReloadAssembly()
 	{
-		mono_domain_set(mono_get_root_domain(), false);
+		RA_PROFILE_FUNCTION();
 
-		mono_domain_unload(s_Data->AppDomain);
+		Timer reloadTimer;
+		Timer phaseTimer;
 
-		LoadAssembly(s_Data->CoreAssemblyFilepath);
-		LoadAppAssembly(s_Data->AppAssemblyFilepath);
-		LoadAssemblyClasses();
+		// Live instances keep their field values across the reload and don't get OnCreate again
+		struct SavedInstance
+		{
+			UUID EntityID;
+			ScriptFieldStorage Fields;
+		};
+		std::vector<SavedInstance> savedInstances;
+		{
+			RA_PROFILE_SCOPE("ScriptEngine::ReloadAssembly - Save");
 
-		ScriptGlue::RegisterComponents();
+			savedInstances.reserve(s_Data->EntityInstances.size());
+			for (auto& [entityID, instance] : s_Data->EntityInstances)
+			{
+				SavedInstance& saved = savedInstances.emplace_back();
+				saved.EntityID = entityID;
+				instance->SaveFieldStorage(saved.Fields);
+			}
 
-		// Retrieve and instantiate class
-		s_Data->EntityClass = Shared<ScriptClass>::Create("Hazel", "Entity", true);
+			ClearClassBatches();
+			s_Data->EntityInstances.clear();
+		}
+		float saveTime = phaseTimer.ElapsedMillis();
+		phaseTimer.Reset();
+
+		{
+			RA_PROFILE_SCOPE("ScriptEngine::ReloadAssembly - Unload");
+
+			mono_domain_set(mono_get_root_domain(), false);
+			mono_domain_unload(s_Data->AppDomain);
+		}
+		float unloadTime = phaseTimer.ElapsedMillis();
+		phaseTimer.Reset();
+
+		{
+			RA_PROFILE_SCOPE("ScriptEngine::ReloadAssembly - Load");
+
+			LoadAssembly(s_Data->CoreAssemblyFilepath);
+			LoadAppAssembly(s_Data->AppAssemblyFilepath);
+		}
+		float loadTime = phaseTimer.ElapsedMillis();
+		phaseTimer.Reset();
+
+		uint32_t unchangedClasses = 0;
+		{
+			RA_PROFILE_SCOPE("ScriptEngine::ReloadAssembly - Classes");
+
+			unchangedClasses = LoadAssemblyClasses();
+			ScriptGlue::RegisterComponents();
+			LoadEntityClass();
+
+			// Editor values of classes whose fields changed follow the new layout
+			for (auto& [entityID, storage] : s_Data->EntityScriptFields)
+			{
+				if (!storage.Class)
+					continue;
+
+				Shared<ScriptClass> scriptClass = GetEntityClass(storage.Class->GetFullName());
+				if (scriptClass && scriptClass != storage.Class)
+					MigrateFieldStorage(storage, scriptClass);
+			}
+		}
+		float classesTime = phaseTimer.ElapsedMillis();
+		phaseTimer.Reset();
+
+		uint32_t restoredInstances = 0;
+		if (s_Data->SceneContext)
+		{
+			RA_PROFILE_SCOPE("ScriptEngine::ReloadAssembly - Restore");
+
+			// Every instance exists before any state is applied, so Entity fields
+			// resolve to the recreated script objects instead of plain entities
+			std::vector<std::pair<ScriptInstance*, SavedInstance*>> restored;
+			restored.reserve(savedInstances.size());
+			for (SavedInstance& saved : savedInstances)
+			{
+				Shared<ScriptClass> scriptClass = GetEntityClass(saved.Fields.Class->GetFullName());
+				Entity entity = s_Data->SceneContext->GetEntityByUUID(saved.EntityID);
+				if (!scriptClass || !entity)
+					continue;
+
+				if (saved.Fields.Class != scriptClass)
+					MigrateFieldStorage(saved.Fields, scriptClass);
+
+				Shared<ScriptInstance> instance = Shared<ScriptInstance>::Create(scriptClass, entity);
+				s_Data->EntityInstances[saved.EntityID] = instance;
+				AddToClassBatch(instance);
+				restored.emplace_back(instance.Raw(), &saved);
+			}
+
+			for (auto& [instance, saved] : restored)
+				instance->ApplyFieldStorage(saved->Fields);
+
+			restoredInstances = (uint32_t)restored.size();
+		}
+		float restoreTime = phaseTimer.ElapsedMillis();
+
+		NANO_ENGINE_LOG_INFO("Reloaded script assemblies in {:.2f}ms (save {:.2f}ms, unload {:.2f}ms, load {:.2f}ms, classes {:.2f}ms, restore {:.2f}ms), {}/{} classes unchanged, {}/{} instances restored",
+			reloadTimer.ElapsedMillis(), saveTime, unloadTime, loadTime, classesTime, restoreTime,
+			unchangedClasses, (uint32_t)s_Data->EntityClasses.size(), restoredInstances, (uint32_t)savedInstances.size());
 	}
 
 	void ScriptEngine::OnRuntimeStart(Scene* scene)
 	{
 		s_Data->SceneContext = scene;
+		s_Data->FirstUpdatePending = true;
 	}
 
 	bool ScriptEngine::EntityClassExists(const std::string& fullClassName)
@@ -312,14 +664,12 @@ namespace NanoCore {
 
 			Shared<ScriptInstance> instance = Shared<ScriptInstance>::Create(s_Data->EntityClasses[sc.ClassName], entity);
 			s_Data->EntityInstances[entityID] = instance;
+			AddToClassBatch(instance);
 
 			// Copy field values
-			if (s_Data->EntityScriptFields.find(entityID) != s_Data->EntityScriptFields.end())
-			{
-				const ScriptFieldMap& fieldMap = s_Data->EntityScriptFields.at(entityID);
-				for (const auto& [name, fieldInstance] : fieldMap)
-					instance->SetFieldValueInternal(name, fieldInstance.m_Buffer);
-			}
+			auto fieldsIt = s_Data->EntityScriptFields.find(entityID);
+			if (fieldsIt != s_Data->EntityScriptFields.end() && fieldsIt->second.Class == instance->GetScriptClass())
+				instance->ApplyFieldStorage(fieldsIt->second);
 
 			instance->InvokeOnCreate();
 		}
@@ -331,9 +681,61 @@ namespace NanoCore {
 		NANO_ENGINE_LOG_ASSERT(s_Data->EntityInstances.find(entityUUID) != s_Data->EntityInstances.end());
 
 		Shared<ScriptInstance> instance = s_Data->EntityInstances[entityUUID];
+		ScriptProfileScope profileScope(instance->m_ScriptClass->m_ProfileIndex, ScriptProfileMethod::OnUpdate);
 		instance->InvokeOnUpdate((float)ts);
 	}
 
+	void ScriptEngine::OnFixedUpdateEntity(Entity entity, Timestep ts)
+	{
+		UUID entityUUID = entity.GetUUID();
+		auto it = s_Data->EntityInstances.find(entityUUID);
+		if (it == s_Data->EntityInstances.end())
+			return;
+
+		// A copy, the script may destroy its own entity
+		Shared<ScriptInstance> instance = it->second;
+		ScriptProfileScope profileScope(instance->m_ScriptClass->m_ProfileIndex, ScriptProfileMethod::OnFixedUpdate);
+		instance->InvokeOnFixedUpdate((float)ts);
+	}
+
+	void ScriptEngine::OnDestroyEntity(Entity entity)
+	{
+		auto it = s_Data->EntityInstances.find(entity.GetUUID());
+		if (it == s_Data->EntityInstances.end())
+			return;
+
+		it->second->InvokeOnDestroy();
+		RemoveFromClassBatch(it->second);
+		s_Data->EntityInstances.erase(it);
+	}
+
+	void ScriptEngine::OnUpdate(Timestep ts)
+	{
+		RA_PROFILE_FUNCTION();
+
+		ScriptProfiler::BeginFrame();
+
+		Timer timer;
+
+		for (size_t i = 0; i < s_Data->ClassBatches.size(); i++)
+			InvokeClassBatch(i, s_Data->ClassBatches[i].OnUpdateBatchThunk, &ScriptInstance::InvokeOnUpdate, ScriptProfileMethod::OnUpdate, ts);
+
+		// Under the JIT this includes compiling every OnUpdate path, compare against AOT mode
+		if (s_Data->FirstUpdatePending)
+		{
+			s_Data->FirstUpdatePending = false;
+			NANO_ENGINE_LOG_INFO("First script update took {:.2f}ms ({} mode)", timer.ElapsedMillis(), Utils::ScriptCompilationModeToString(s_Data->CompilationMode));
+		}
+	}
+
+	void ScriptEngine::OnFixedUpdate(Timestep ts)
+	{
+		RA_PROFILE_FUNCTION();
+
+		for (size_t i = 0; i < s_Data->ClassBatches.size(); i++)
+			InvokeClassBatch(i, s_Data->ClassBatches[i].OnFixedUpdateBatchThunk, &ScriptInstance::InvokeOnFixedUpdate, ScriptProfileMethod::OnFixedUpdate, ts);
+	}
+
 	Scene* ScriptEngine::GetSceneContext()
 	{
 		return s_Data->SceneContext;
@@ -349,6 +751,26 @@ namespace NanoCore {
 	}
 
 
+	bool ScriptEngine::SaveInstanceFieldStorage(UUID entityID, ScriptFieldStorage& storage)
+	{
+		auto it = s_Data->EntityInstances.find(entityID);
+		if (it == s_Data->EntityInstances.end())
+			return false;
+
+		it->second->SaveFieldStorage(storage);
+		return true;
+	}
+
+	bool ScriptEngine::ApplyInstanceFieldStorage(UUID entityID, const ScriptFieldStorage& storage)
+	{
+		auto it = s_Data->EntityInstances.find(entityID);
+		if (it == s_Data->EntityInstances.end() || storage.Class != it->second->GetScriptClass())
+			return false;
+
+		it->second->ApplyFieldStorage(storage);
+		return true;
+	}
+
 	Shared<ScriptClass> ScriptEngine::GetEntityClass(const std::string& name)
 	{
 		if (s_Data->EntityClasses.find(name) == s_Data->EntityClasses.end())
@@ -359,8 +781,12 @@ namespace NanoCore {
 
 	void ScriptEngine::OnRuntimeStop()
 	{
+		for (auto& [entityID, instance] : s_Data->EntityInstances)
+			instance->InvokeOnDestroy();
+
 		s_Data->SceneContext = nullptr;
 
+		ClearClassBatches();
 		s_Data->EntityInstances.clear();
 	}
 
@@ -369,17 +795,33 @@ namespace NanoCore {
 		return s_Data->EntityClasses;
 	}
 
-	ScriptFieldMap& ScriptEngine::GetScriptFieldMap(Entity entity)
+	uint64_t ScriptEngine::GetClassLayoutHash()
+	{
+		return s_Data ? s_Data->ClassLayoutHash : 0;
+	}
+
+	ScriptFieldStorage& ScriptEngine::GetScriptFieldStorage(Entity entity, Shared<ScriptClass> scriptClass)
 	{
 		NANO_ENGINE_LOG_ASSERT(entity);
+		NANO_ENGINE_LOG_ASSERT(scriptClass);
 
 		UUID entityID = entity.GetUUID();
-		return s_Data->EntityScriptFields[entityID];
+		ScriptFieldStorage& storage = s_Data->EntityScriptFields[entityID];
+		if (storage.Class != scriptClass)
+		{
+			storage.Class = scriptClass;
+			storage.Buffer.assign(scriptClass->GetFieldStorageSize(), 0);
+			storage.AssignedFields.assign(scriptClass->GetFields().size(), 0);
+		}
+		return storage;
 	}
 
-	void ScriptEngine::LoadAssemblyClasses()
+	uint32_t ScriptEngine::LoadAssemblyClasses()
 	{
+		// Classes from the previous load, reused when their field layout didn't change
+		std::unordered_map<std::string, Shared<ScriptClass>> previousClasses = std::move(s_Data->EntityClasses);
 		s_Data->EntityClasses.clear();
+		uint32_t unchangedClasses = 0;
 
 		const MonoTableInfo* typeDefinitionsTable = mono_image_get_table_info(s_Data->AppAssemblyImage, MONO_TABLE_TYPEDEF);
 		int32_t numTypes = mono_table_info_get_rows(typeDefinitionsTable);
@@ -407,37 +849,65 @@ namespace NanoCore {
 			if (!isEntity)
 				continue;
 
-			Shared<ScriptClass> scriptClass = Shared<ScriptClass>::Create(nameSpace, className);
-			s_Data->EntityClasses[fullName] = scriptClass;
-
-
 			// This routine is an iterator routine for retrieving the fields in a class.
 			// You must pass a gpointer that points to zero and is treated as an opaque handle
 			// to iterate over all of the elements. When no more values are available, the return value is NULL.
 
-			int fieldCount = mono_class_num_fields(monoClass);
-			NANO_ENGINE_LOG_WARN("{0} has {1} fields:", className, fieldCount);
+			std::vector<ScriptClass::FieldDescription> fields;
 			void* iterator = nullptr;
 			while (MonoClassField* field = mono_class_get_fields(monoClass, &iterator))
 			{
-				const char* fieldName = mono_field_get_name(field);
 				uint32_t flags = mono_field_get_flags(field);
 				if (flags & FIELD_ATTRIBUTE_PUBLIC)
 				{
 					MonoType* type = mono_field_get_type(field);
-					ScriptFieldType fieldType = Utils::MonoTypeToScriptFieldType(type);
-					NANO_ENGINE_LOG_WARN("  {0} ({1})", fieldName, Utils::ScriptFieldTypeToString(fieldType));
-
-					scriptClass->m_Fields[fieldName] = { fieldType, fieldName, field };
+					fields.push_back({ Utils::MonoTypeToScriptFieldType(type), mono_field_get_name(field), field });
 				}
 			}
 
+			// Keep the existing object so field storages and editor state referencing it stay valid,
+			// only its managed handles are resolved again
+			auto previousIt = previousClasses.find(fullName);
+			if (previousIt != previousClasses.end() && previousIt->second->HasSameLayout(fields))
+			{
+				previousIt->second->Rebind(monoClass, fields);
+				s_Data->EntityClasses[fullName] = previousIt->second;
+				unchangedClasses++;
+				continue;
+			}
+
+			Shared<ScriptClass> scriptClass = Shared<ScriptClass>::Create(nameSpace, className);
+
+			NANO_ENGINE_LOG_WARN("{0} has {1} fields:", className, mono_class_num_fields(monoClass));
+			for (const ScriptClass::FieldDescription& field : fields)
+			{
+				NANO_ENGINE_LOG_WARN("  {0} ({1})", field.Name, Utils::ScriptFieldTypeToString(field.Type));
+				scriptClass->AddField(field.Type, field.Name, field.ClassField);
+			}
+
+			s_Data->EntityClasses[fullName] = scriptClass;
 		}
 
-		auto& entityClasses = s_Data->EntityClasses;
+		// In name order, the map's order differs between loads
+		std::vector<const std::string*> classNames;
+		classNames.reserve(s_Data->EntityClasses.size());
+		for (const auto& [fullName, scriptClass] : s_Data->EntityClasses)
+			classNames.push_back(&fullName);
+		std::sort(classNames.begin(), classNames.end(), [](const std::string* a, const std::string* b) { return *a < *b; });
 
-		//mono_field_get_value()
+		StreamingHash64 layoutHash;
+		for (const std::string* fullName : classNames)
+		{
+			layoutHash.Update(fullName->c_str(), fullName->size() + 1);
+			for (const ScriptField& field : s_Data->EntityClasses.at(*fullName)->GetFields())
+			{
+				layoutHash.Update(field.Name.c_str(), field.Name.size() + 1);
+				layoutHash.Update(&field.Type, sizeof(field.Type));
+			}
+		}
+		s_Data->ClassLayoutHash = layoutHash.GetHash();
 
+		return unchangedClasses;
 	}
 
 	MonoImage* ScriptEngine::GetCoreAssemblyImage()
@@ -463,6 +933,10 @@ namespace NanoCore {
 		: m_ClassNamespace(classNamespace), m_ClassName(className)
 	{
 		m_MonoClass = mono_class_from_name(isCore ? s_Data->CoreAssemblyImage : s_Data->AppAssemblyImage, classNamespace.c_str(), className.c_str());
+
+		ResolveThunks();
+
+		m_ProfileIndex = ScriptProfiler::RegisterScriptClass(GetFullName());
 	}
 
 	MonoObject* ScriptClass::Instantiate()
@@ -477,7 +951,106 @@ namespace NanoCore {
 
 	MonoObject* ScriptClass::InvokeMethod(MonoObject* instance, MonoMethod* method, void** params)
 	{
-		return mono_runtime_invoke(method, instance, params, nullptr);
+		MonoObject* exception = nullptr;
+		MonoObject* result = mono_runtime_invoke(method, instance, params, &exception);
+		if (exception)
+			LogException(exception, mono_method_get_name(method));
+		return result;
+	}
+
+	const ScriptField* ScriptClass::FindField(const std::string& name) const
+	{
+		auto it = m_FieldIndices.find(name);
+		if (it == m_FieldIndices.end())
+			return nullptr;
+
+		return &m_Fields[it->second];
+	}
+
+	void ScriptClass::AddField(ScriptFieldType type, const std::string& name, MonoClassField* classField)
+	{
+		ScriptField& field = m_Fields.emplace_back();
+		field.Type = type;
+		field.Name = name;
+		field.ClassField = classField;
+		field.Index = (uint32_t)(m_Fields.size() - 1);
+		field.Offset = m_FieldStorageSize;
+		field.Size = Utils::ScriptFieldTypeSize(type);
+		field.ManagedOffset = mono_field_get_offset(classField);
+
+		m_FieldIndices[name] = field.Index;
+		m_FieldStorageSize += field.Size;
+	}
+
+	std::string ScriptClass::GetFullName() const
+	{
+		if (m_ClassNamespace.empty())
+			return m_ClassName;
+
+		return fmt::format("{}.{}", m_ClassNamespace, m_ClassName);
+	}
+
+	bool ScriptClass::HasSameLayout(const std::vector<FieldDescription>& fields) const
+	{
+		if (m_Fields.size() != fields.size())
+			return false;
+
+		for (size_t i = 0; i < m_Fields.size(); i++)
+		{
+			if (m_Fields[i].Type != fields[i].Type || m_Fields[i].Name != fields[i].Name)
+				return false;
+		}
+		return true;
+	}
+
+	void ScriptClass::Rebind(MonoClass* monoClass, const std::vector<FieldDescription>& fields)
+	{
+		m_MonoClass = monoClass;
+		ResolveThunks();
+
+		for (size_t i = 0; i < m_Fields.size(); i++)
+		{
+			m_Fields[i].ClassField = fields[i].ClassField;
+			m_Fields[i].ManagedOffset = mono_field_get_offset(fields[i].ClassField);
+		}
+	}
+
+	void* ScriptClass::GetThunk(const std::string& name, int parameterCount)
+	{
+		MonoMethod* method = GetMethod(name, parameterCount);
+		return method ? mono_method_get_unmanaged_thunk(method) : nullptr;
+	}
+
+	void ScriptClass::ResolveThunks()
+	{
+		m_OnCreateThunk = (ScriptMethodThunk)GetThunk("OnCreate", 0);
+		m_OnUpdateThunk = (ScriptUpdateThunk)GetThunk("OnUpdate", 1);
+		m_OnFixedUpdateThunk = (ScriptUpdateThunk)GetThunk("OnFixedUpdate", 1);
+		m_OnDestroyThunk = (ScriptMethodThunk)GetThunk("OnDestroy", 0);
+	}
+
+	void ScriptClass::LogException(MonoObject* exception, const char* methodName) const
+	{
+		MonoString* message = mono_object_to_string(exception, nullptr);
+		char* messageCStr = message ? mono_string_to_utf8(message) : nullptr;
+		NANO_ENGINE_LOG_ERROR("{}.{}.{} threw: {}", m_ClassNamespace, m_ClassName, methodName, messageCStr ? messageCStr : "unknown exception");
+		if (messageCStr)
+			mono_free(messageCStr);
+	}
+
+	// Script instance of the entity if it has one, otherwise a plain Entity bound to it
+	static MonoObject* GetEntityObject(UUID entityID)
+	{
+		auto it = s_Data->EntityInstances.find(entityID);
+		if (it != s_Data->EntityInstances.end())
+			return it->second->GetManagedObject();
+
+		MonoObject* entity = s_Data->EntityClass->Instantiate();
+		MonoException* exception = nullptr;
+		s_Data->EntityConstructorThunk(entity, entityID, &exception);
+		if (exception)
+			s_Data->EntityClass->LogException((MonoObject*)exception, ".ctor");
+		return entity;
 	}
 
 	ScriptInstance::ScriptInstance(Shared<ScriptClass> scriptClass, Entity entity)
@@ -485,56 +1058,131 @@ namespace NanoCore {
 	{
 		m_Instance = scriptClass->Instantiate();
 
-		m_Constructor = s_Data->EntityClass->GetMethod(".ctor", 1);
-		m_OnCreateMethod = scriptClass->GetMethod("OnCreate", 0);
-		m_OnUpdateMethod = scriptClass->GetMethod("OnUpdate", 1);
-
 		// Call Entity constructor
 		{
-			UUID entityID = entity.GetUUID();
-			void* param = &entityID;
-			m_ScriptClass->InvokeMethod(m_Instance, m_Constructor, &param);
+			MonoException* exception = nullptr;
+			s_Data->EntityConstructorThunk(m_Instance, entity.GetUUID(), &exception);
+			if (exception)
+				m_ScriptClass->LogException((MonoObject*)exception, ".ctor");
 		}
 	}
 
 	void ScriptInstance::InvokeOnCreate()
 	{
-		if (m_OnCreateMethod)
-			m_ScriptClass->InvokeMethod(m_Instance, m_OnCreateMethod);
+		if (!m_ScriptClass->m_OnCreateThunk)
+			return;
+
+		ScriptProfileScope profileScope(m_ScriptClass->m_ProfileIndex, ScriptProfileMethod::OnCreate);
+		MonoException* exception = nullptr;
+		m_ScriptClass->m_OnCreateThunk(m_Instance, &exception);
+		if (exception)
+			m_ScriptClass->LogException((MonoObject*)exception, "OnCreate");
 	}
 
 	void ScriptInstance::InvokeOnUpdate(float ts)
 	{
-		if (m_OnUpdateMethod)
-		{
-			void* param = &ts;
-			m_ScriptClass->InvokeMethod(m_Instance, m_OnUpdateMethod, &param);
-		}
+		if (!m_ScriptClass->m_OnUpdateThunk)
+			return;
+
+		MonoException* exception = nullptr;
+		m_ScriptClass->m_OnUpdateThunk(m_Instance, ts, &exception);
+		if (exception)
+			m_ScriptClass->LogException((MonoObject*)exception, "OnUpdate");
+	}
+
+	void ScriptInstance::InvokeOnFixedUpdate(float ts)
+	{
+		if (!m_ScriptClass->m_OnFixedUpdateThunk)
+			return;
+
+		MonoException* exception = nullptr;
+		m_ScriptClass->m_OnFixedUpdateThunk(m_Instance, ts, &exception);
+		if (exception)
+			m_ScriptClass->LogException((MonoObject*)exception, "OnFixedUpdate");
 	}
 
+	void ScriptInstance::InvokeOnDestroy()
+	{
+		if (!m_ScriptClass->m_OnDestroyThunk)
+			return;
+
+		ScriptProfileScope profileScope(m_ScriptClass->m_ProfileIndex, ScriptProfileMethod::OnDestroy);
+		MonoException* exception = nullptr;
+		m_ScriptClass->m_OnDestroyThunk(m_Instance, &exception);
+		if (exception)
+			m_ScriptClass->LogException((MonoObject*)exception, "OnDestroy");
+	}
 
 	bool ScriptInstance::GetFieldValueInternal(const std::string& name, void* buffer)
 	{
-		const auto& fields = m_ScriptClass->GetFields();
-		auto it = fields.find(name);
-		if (it == fields.end())
+		const ScriptField* field = m_ScriptClass->FindField(name);
+		if (!field)
 			return false;
 
-		const ScriptField& field = it->second;
-		mono_field_get_value(m_Instance, field.ClassField, buffer);
+		mono_field_get_value(m_Instance, field->ClassField, buffer);
 		return true;
 	}
 
 	bool ScriptInstance::SetFieldValueInternal(const std::string& name, const void* value)
 	{
-		const auto& fields = m_ScriptClass->GetFields();
-		auto it = fields.find(name);
-		if (it == fields.end())
+		const ScriptField* field = m_ScriptClass->FindField(name);
+		if (!field)
 			return false;
 
-		const ScriptField& field = it->second;
-		mono_field_set_value(m_Instance, field.ClassField, (void*)value);
+		mono_field_set_value(m_Instance, field->ClassField, (void*)value);
 		return true;
 	}
 
+	void ScriptInstance::SaveFieldStorage(ScriptFieldStorage& storage) const
+	{
+		storage.Class = m_ScriptClass;
+		storage.Buffer.assign(m_ScriptClass->GetFieldStorageSize(), 0);
+		storage.AssignedFields.assign(m_ScriptClass->GetFields().size(), 1);
+
+		const uint8_t* object = (const uint8_t*)m_Instance;
+		for (const ScriptField& field : m_ScriptClass->GetFields())
+		{
+			uint8_t* value = storage.Buffer.data() + field.Offset;
+
+			if (field.Type == ScriptFieldType::Entity)
+			{
+				// Saved as the UUID, the object itself dies with the domain
+				MonoObject* entity = nullptr;
+				mono_field_get_value(m_Instance, field.ClassField, &entity);
+
+				UUID entityID = 0;
+				if (entity && s_Data->EntityIDField)
+					mono_field_get_value(entity, s_Data->EntityIDField, &entityID);
+				memcpy(value, &entityID, sizeof(entityID));
+				continue;
+			}
+
+			memcpy(value, object + field.ManagedOffset, field.Size);
+		}
+	}
+
+	void ScriptInstance::ApplyFieldStorage(const ScriptFieldStorage& storage)
+	{
+		uint8_t* object = (uint8_t*)m_Instance;
+		for (const ScriptField& field : m_ScriptClass->GetFields())
+		{
+			if (!storage.IsSet(field))
+				continue;
+
+			const uint8_t* value = storage.Buffer.data() + field.Offset;
+
+			if (field.Type == ScriptFieldType::Entity)
+			{
+				// Storage holds the UUID, the managed field holds the entity object.
+				// Going through mono_field_set_value keeps the GC write barrier.
+				UUID entityID;
+				memcpy(&entityID, value, sizeof(entityID));
+				mono_field_set_value(m_Instance, field.ClassField, entityID ? GetEntityObject(entityID) : nullptr);
+				continue;
+			}
+
+			memcpy(object + field.ManagedOffset, value, field.Size);
+		}
+	}
+
 }
@@ -2,10 +2,10 @@
 
 #include "modules/entity/Scene.h"
 #include "modules/entity/Entity.h"
+#include "ScriptProfiler.h"
 
 #include <filesystem>
 #include <string>
-#include <map>
 
 extern "C" {
 	typedef struct _MonoClass MonoClass;
@@ -14,6 +14,8 @@ extern "C" {
 	typedef struct _MonoAssembly MonoAssembly;
 	typedef struct _MonoImage MonoImage;
 	typedef struct _MonoClassField MonoClassField;
+	typedef struct _MonoException MonoException;
+	typedef struct _MonoArray MonoArray;
 }
 
 namespace NanoCore {
@@ -34,39 +36,23 @@ namespace NanoCore {
 		std::string Name;
 		
 		MonoClassField* ClassField;
-	};
-
-	// ScriptField + data storage
-	struct ScriptFieldInstance
-	{
-		ScriptField Field;
 
-		ScriptFieldInstance()
-		{
-			memset(m_Buffer, 0, sizeof(m_Buffer));
-		}
-
-		template<typename T>
-		T GetValue()
-		{
-			static_assert(sizeof(T) <= 16, "Type too large!");
-			return *(T*)m_Buffer;
-		}
-
-		template<typename T>
-		void SetValue(T value)
-		{
-			static_assert(sizeof(T) <= 16, "Type too large!");
-			memcpy(m_Buffer, &value, sizeof(T));
-		}
-	private:
-		uint8_t m_Buffer[16];
+		// Position in the class field table and byte range in per-entity field storage
+		uint32_t Index = 0;
+		uint32_t Offset = 0;
+		uint32_t Size = 0;
 
-		friend class ScriptEngine;
-		friend class ScriptInstance;
+		// Offset inside the managed object, value-type fields are written there directly
+		uint32_t ManagedOffset = 0;
 	};
 
-	using ScriptFieldMap = std::unordered_map<std::string, ScriptFieldInstance>;
+	// Unmanaged thunks: direct native to managed calls that skip the
+	// mono_runtime_invoke wrapper. Instance thunks take the object first,
+	// every thunk takes the out-parameter for a thrown exception last.
+	using ScriptConstructorThunk = void(*)(MonoObject* instance, uint64_t entityID, MonoException** exception);
+	using ScriptMethodThunk = void(*)(MonoObject* instance, MonoException** exception);
+	using ScriptUpdateThunk = void(*)(MonoObject* instance, float ts, MonoException** exception);
+	using ScriptBatchUpdateThunk = void(*)(MonoArray* entities, float ts, MonoException** exception);
 
 	class ScriptClass : public RefCount
 	{
@@ -78,16 +64,87 @@ namespace NanoCore {
 		MonoMethod* GetMethod(const std::string& name, int parameterCount);
 		MonoObject* InvokeMethod(MonoObject* instance, MonoMethod* method, void** params = nullptr);
 
-		const std::map<std::string, ScriptField>& GetFields() const { return m_Fields; }
+		std::string GetFullName() const;
+
+		const std::vector<ScriptField>& GetFields() const { return m_Fields; }
+		const ScriptField* FindField(const std::string& name) const;
+		uint32_t GetFieldStorageSize() const { return m_FieldStorageSize; }
+
+		// Logs a managed exception thrown by one of this class's methods
+		void LogException(MonoObject* exception, const char* methodName) const;
+	private:
+		// Public field as read from the assembly metadata, before a class is built from it
+		struct FieldDescription
+		{
+			ScriptFieldType Type;
+			std::string Name;
+			MonoClassField* ClassField;
+		};
+
+		void* GetThunk(const std::string& name, int parameterCount);
+		void ResolveThunks();
+		void AddField(ScriptFieldType type, const std::string& name, MonoClassField* classField);
+
+		// Used by assembly reload: a class with the same fields in the same order
+		// takes over the reloaded managed handles instead of being rebuilt
+		bool HasSameLayout(const std::vector<FieldDescription>& fields) const;
+		void Rebind(MonoClass* monoClass, const std::vector<FieldDescription>& fields);
 	private:
 		std::string m_ClassNamespace;
 		std::string m_ClassName;
 
-		std::map<std::string, ScriptField> m_Fields;
+		// Compiled once when the class is loaded, in declaration order
+		std::vector<ScriptField> m_Fields;
+		std::unordered_map<std::string, uint32_t> m_FieldIndices;
+		uint32_t m_FieldStorageSize = 0;
 
 		MonoClass* m_MonoClass = nullptr;
 
+		// Lifecycle methods resolved once per class, null when not declared
+		ScriptMethodThunk m_OnCreateThunk = nullptr;
+		ScriptUpdateThunk m_OnUpdateThunk = nullptr;
+		ScriptUpdateThunk m_OnFixedUpdateThunk = nullptr;
+		ScriptMethodThunk m_OnDestroyThunk = nullptr;
+
+		// Entry in the script profiler, shared by every load of the class
+		uint32_t m_ProfileIndex = 0;
+
 		friend class ScriptEngine;
+		friend class ScriptInstance;
+	};
+
+	// Per-entity field values as one blob laid out by the class field table
+	struct ScriptFieldStorage
+	{
+		Shared<ScriptClass> Class;
+		std::vector<uint8_t> Buffer;
+
+		// Non-zero for fields set in the editor or scene file, only those are applied
+		std::vector<uint8_t> AssignedFields;
+
+		bool IsSet(const ScriptField& field) const
+		{
+			return field.Index < AssignedFields.size() && AssignedFields[field.Index];
+		}
+
+		template<typename T>
+		T GetValue(const ScriptField& field) const
+		{
+			NANO_ENGINE_LOG_ASSERT(sizeof(T) <= field.Size, "Type too large!");
+
+			T value;
+			memcpy(&value, Buffer.data() + field.Offset, sizeof(T));
+			return value;
+		}
+
+		template<typename T>
+		void SetValue(const ScriptField& field, T value)
+		{
+			NANO_ENGINE_LOG_ASSERT(sizeof(T) <= field.Size, "Type too large!");
+
+			memcpy(Buffer.data() + field.Offset, &value, sizeof(T));
+			AssignedFields[field.Index] = 1;
+		}
 	};
 
 	class ScriptInstance : public RefCount
@@ -97,6 +154,8 @@ namespace NanoCore {
 
 		void InvokeOnCreate();
 		void InvokeOnUpdate(float ts);
+		void InvokeOnFixedUpdate(float ts);
+		void InvokeOnDestroy();
 
 		Shared<ScriptClass> GetScriptClass() { return m_ScriptClass; }
 
@@ -124,20 +183,23 @@ namespace NanoCore {
 	private:
 		bool GetFieldValueInternal(const std::string& name, void* buffer);
 		bool SetFieldValueInternal(const std::string& name, const void* value);
+		void ApplyFieldStorage(const ScriptFieldStorage& storage);
+		void SaveFieldStorage(ScriptFieldStorage& storage) const;
 	private:
 		Shared<ScriptClass> m_ScriptClass;
 
 		MonoObject* m_Instance = nullptr;
-		MonoMethod* m_Constructor = nullptr;
-		MonoMethod* m_OnCreateMethod = nullptr;
-		MonoMethod* m_OnUpdateMethod = nullptr;
+
+		// Position in the per-class update batch
+		uint32_t m_BatchSlot = 0;
 
 		inline static char s_FieldValueBuffer[16];
 
 		friend class ScriptEngine;
-		friend struct ScriptFieldInstance;
 	};
 
+	struct ScriptClassBatch;
+
 	class ScriptEngine
 	{
 	public:
@@ -147,6 +209,8 @@ namespace NanoCore {
 		static void LoadAssembly(const std::filesystem::path& filepath);
 		static void LoadAppAssembly(const std::filesystem::path& filepath);
 		
+		// Swaps in the rebuilt assemblies. While the runtime is running, script
+		// instances are recreated with their current field values (OnCreate isn't run again).
 		static void ReloadAssembly();
 
 		static void OnRuntimeStart(Scene* scene);
@@ -155,13 +219,30 @@ namespace NanoCore {
 		static bool EntityClassExists(const std::string& fullClassName);
 		static void OnCreateEntity(Entity entity);
 		static void OnUpdateEntity(Entity entity, Timestep ts);
+		static void OnFixedUpdateEntity(Entity entity, Timestep ts);
+		static void OnDestroyEntity(Entity entity);
+
+		// Updates every script instance grouped by class. A class that declares
+		// static OnUpdateBatch(Entity[], float) / OnFixedUpdateBatch(Entity[], float)
+		// gets one managed call for all of its instances instead of one per entity.
+		static void OnUpdate(Timestep ts);
+		static void OnFixedUpdate(Timestep ts);
 
 		static Scene* GetSceneContext();
 		static Shared<ScriptInstance> GetEntityScriptInstance(UUID entityID);
 		
 		static Shared<ScriptClass> GetEntityClass(const std::string& name);
 		static std::unordered_map<std::string, Shared<ScriptClass>> GetEntityClasses();
-		static ScriptFieldMap& GetScriptFieldMap(Entity entity);
+		// Of the loaded classes and their fields, changes when a reload changes either.
+		// Zero before the app assembly is loaded.
+		static uint64_t GetClassLayoutHash();
+		// Laid out for scriptClass, existing values are dropped if the entity's class changed
+		static ScriptFieldStorage& GetScriptFieldStorage(Entity entity, Shared<ScriptClass> scriptClass);
+
+		// Current field values of a live script instance, used by runtime snapshots.
+		// Both return false when the entity has no instance.
+		static bool SaveInstanceFieldStorage(UUID entityID, ScriptFieldStorage& storage);
+		static bool ApplyInstanceFieldStorage(UUID entityID, const ScriptFieldStorage& storage);
 		
 		static MonoImage* GetCoreAssemblyImage();
 
@@ -171,7 +252,14 @@ namespace NanoCore {
 		static void ShutdownMono();
 
 		static MonoObject* InstantiateClass(MonoClass* monoClass);
-		static void LoadAssemblyClasses();
+		// Returns how many classes kept their previous ScriptClass because their fields didn't change
+		static uint32_t LoadAssemblyClasses();
+		static void LoadEntityClass();
+
+		static void AddToClassBatch(Shared<ScriptInstance> instance);
+		static void RemoveFromClassBatch(Shared<ScriptInstance> instance);
+		static void InvokeClassBatch(size_t batchIndex, ScriptBatchUpdateThunk batchThunk, void (ScriptInstance::*invoke)(float), ScriptProfileMethod method, float ts);
+		static void ClearClassBatches();
 
 		friend class ScriptClass;
 		friend class ScriptGlue;
@@ -205,6 +293,31 @@ namespace NanoCore {
 			return "None";
 		}
 
+		// Bytes a field takes in ScriptFieldStorage, Entity fields hold the UUID
+		inline uint32_t ScriptFieldTypeSize(ScriptFieldType fieldType)
+		{
+			switch (fieldType)
+			{
+				case ScriptFieldType::Float:   return 4;
+				case ScriptFieldType::Double:  return 8;
+				case ScriptFieldType::Bool:    return 1;
+				case ScriptFieldType::Char:    return 2;
+				case ScriptFieldType::Byte:    return 1;
+				case ScriptFieldType::Short:   return 2;
+				case ScriptFieldType::Int:     return 4;
+				case ScriptFieldType::Long:    return 8;
+				case ScriptFieldType::UByte:   return 1;
+				case ScriptFieldType::UShort:  return 2;
+				case ScriptFieldType::UInt:    return 4;
+				case ScriptFieldType::ULong:   return 8;
+				case ScriptFieldType::Vector2: return 8;
+				case ScriptFieldType::Vector3: return 12;
+				case ScriptFieldType::Vector4: return 16;
+				case ScriptFieldType::Entity:  return 8;
+			}
+			return 0;
+		}
+
 		inline ScriptFieldType ScriptFieldTypeFromString(std::string_view fieldType)
 		{
 			if (fieldType == "None")    return ScriptFieldType::None;
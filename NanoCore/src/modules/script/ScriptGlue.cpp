@@ -1,6 +1,7 @@
 #include "ncpch.h"
 #include "ScriptGlue.h"
 #include "ScriptEngine.h"
+#include "ScriptProfiler.h"
 
 #include "modules/utils/UUID.h"
 #include "modules/events/EventCodes.h"
@@ -8,17 +9,38 @@
 
 #include "modules/entity/Scene.h"
 #include "modules/entity/Entity.h"
+#include "modules/entity/ComponentReflection.h"
 
 #include "mono/metadata/object.h"
 #include "mono/metadata/reflection.h"
 
-#include "box2d/b2_body.h"
+#include "modules/physics/PhysicsWorld2D.h"
+#include "modules/utils/FrameAllocator.h"
 
 namespace NanoCore {
 
 	static std::unordered_map<MonoType*, std::function<bool(Entity)>> s_EntityHasComponentFuncs;
 
-#define HZ_ADD_INTERNAL_CALL(Name) mono_add_internal_call("Hazel.InternalCalls::" #Name, Name)
+	// Internal calls are registered through this wrapper so the script profiler
+	// counts every managed to native transition per function
+	template<auto Func, typename Signature = decltype(Func)>
+	struct ProfiledInternalCall;
+
+	template<auto Func, typename R, typename... Args>
+	struct ProfiledInternalCall<Func, R(*)(Args...)>
+	{
+		inline static uint32_t CallIndex = 0;
+
+		static R Invoke(Args... args)
+		{
+			ScriptProfiler::CountInternalCall(CallIndex);
+			return Func(args...);
+		}
+	};
+
+#define HZ_ADD_INTERNAL_CALL(Name) \
+	ProfiledInternalCall<&Name>::CallIndex = ScriptProfiler::RegisterInternalCall(#Name); \
+	mono_add_internal_call("Hazel.InternalCalls::" #Name, (const void*)ProfiledInternalCall<&Name>::Invoke)
 
 	static void NativeLog(MonoString* string, int parameter)
 	{
@@ -57,14 +79,55 @@ namespace NanoCore {
 		return s_EntityHasComponentFuncs.at(managedType)(entity);
 	}
 
+	// UTF-8 copy of a managed string in scope memory, instead of a heap string from mono_string_to_utf8
+	static std::string_view ToUTF8(MonoString* string, ArenaScope& scope)
+	{
+		const mono_unichar2* chars = mono_string_chars(string);
+		int32_t length = mono_string_length(string);
+
+		// Three bytes per UTF-16 unit covers every case, a surrogate pair takes four for two units
+		char* buffer = scope.AllocateArray<char>((size_t)length * 3);
+		size_t size = 0;
+		for (int32_t i = 0; i < length; i++)
+		{
+			uint32_t c = chars[i];
+			if (c >= 0xD800 && c <= 0xDBFF && i + 1 < length && chars[i + 1] >= 0xDC00 && chars[i + 1] <= 0xDFFF)
+				c = 0x10000 + ((c - 0xD800) << 10) + (chars[++i] - 0xDC00);
+
+			if (c < 0x80)
+			{
+				buffer[size++] = (char)c;
+			}
+			else if (c < 0x800)
+			{
+				buffer[size++] = (char)(0xC0 | (c >> 6));
+				buffer[size++] = (char)(0x80 | (c & 0x3F));
+			}
+			else if (c < 0x10000)
+			{
+				buffer[size++] = (char)(0xE0 | (c >> 12));
+				buffer[size++] = (char)(0x80 | ((c >> 6) & 0x3F));
+				buffer[size++] = (char)(0x80 | (c & 0x3F));
+			}
+			else
+			{
+				buffer[size++] = (char)(0xF0 | (c >> 18));
+				buffer[size++] = (char)(0x80 | ((c >> 12) & 0x3F));
+				buffer[size++] = (char)(0x80 | ((c >> 6) & 0x3F));
+				buffer[size++] = (char)(0x80 | (c & 0x3F));
+			}
+		}
+
+		return { buffer, size };
+	}
+
 	static uint64_t Entity_FindEntityByName(MonoString* name)
 	{
-		char* nameCStr = mono_string_to_utf8(name);
+		ArenaScope scope;
 
 		Scene* scene = ScriptEngine::GetSceneContext();
 		NANO_ENGINE_LOG_ASSERT(scene);
-		Entity entity = scene->FindEntityByName(nameCStr);
-		mono_free(nameCStr);
+		Entity entity = scene->FindEntityByName(ToUTF8(name, scope));
 
 		if (!entity)
 			return 0;
@@ -100,8 +163,7 @@ namespace NanoCore {
 		NANO_ENGINE_LOG_ASSERT(entity);
 
 		auto& rb2d = entity.GetComponent<Rigidbody2DComponent>();
-		b2Body* body = (b2Body*)rb2d.RuntimeBody;
-		body->ApplyLinearImpulse(b2Vec2(impulse->x, impulse->y), b2Vec2(point->x, point->y), wake);
+		scene->GetPhysicsWorld2D()->QueueLinearImpulse(rb2d.RuntimeBody, *impulse, *point, wake);
 	}
 
 	static void Rigidbody2DComponent_ApplyLinearImpulseToCenter(UUID entityID, glm::vec2* impulse, bool wake)
@@ -112,45 +174,187 @@ namespace NanoCore {
 		NANO_ENGINE_LOG_ASSERT(entity);
 
 		auto& rb2d = entity.GetComponent<Rigidbody2DComponent>();
-		b2Body* body = (b2Body*)rb2d.RuntimeBody;
-		body->ApplyLinearImpulseToCenter(b2Vec2(impulse->x, impulse->y), wake);
+		scene->GetPhysicsWorld2D()->QueueLinearImpulseToCenter(rb2d.RuntimeBody, *impulse, wake);
 	}
 	
+	// Bulk transform access. Begin gathers the transforms of every entity matching
+	// the filter into native SoA arrays that managed code reads and writes through
+	// the returned pointers, End scatters them back: two transitions per query
+	// instead of two per entity.
+	enum class TransformQueryFilter : uint32_t
+	{
+		None             = 0,
+		Rigidbody2D      = 1 << 0,
+		BoxCollider2D    = 1 << 1,
+		CircleCollider2D = 1 << 2,
+		SpriteRenderer   = 1 << 3,
+		CircleRenderer   = 1 << 4,
+		Script           = 1 << 5
+	};
+
+	// Mirrored by Hazel.TransformQueryView, pointers stay valid until TransformQuery_End
+	struct TransformQueryView
+	{
+		uint64_t* EntityIDs;
+		glm::vec3* Translations;
+		glm::vec3* Rotations;
+		glm::vec3* Scales;
+		uint32_t Count;
+	};
+
+	struct TransformQuery
+	{
+		bool InUse = false;
+		uint64_t TransformStorageVersion = 0;
+
+		std::vector<entt::entity> Entities;
+		std::vector<TransformComponent*> Transforms;
+
+		std::vector<uint64_t> EntityIDs;
+		std::vector<glm::vec3> Translations;
+		std::vector<glm::vec3> Rotations;
+		std::vector<glm::vec3> Scales;
+	};
+
+	// Slots and their arrays are reused so steady-state queries don't allocate
+	static std::vector<TransformQuery> s_TransformQueries;
+
+	template<typename Component>
+	static void AddQueryComponent(uint32_t filter, TransformQueryFilter flag, ENTT_ID_TYPE* types, uint32_t& typeCount)
+	{
+		if (filter & (uint32_t)flag)
+			types[typeCount++] = entt::type_info<Component>::id();
+	}
+
+	uint32_t ScriptGlue::TransformQuery_Begin(uint32_t filter, TransformQueryView* outView)
+	{
+		Scene* scene = ScriptEngine::GetSceneContext();
+		NANO_ENGINE_LOG_ASSERT(scene);
+		entt::registry& registry = scene->m_Registry;
+
+		uint32_t queryIndex = 0;
+		while (queryIndex < s_TransformQueries.size() && s_TransformQueries[queryIndex].InUse)
+			queryIndex++;
+		if (queryIndex == s_TransformQueries.size())
+			s_TransformQueries.emplace_back();
+
+		TransformQuery& query = s_TransformQueries[queryIndex];
+		query.InUse = true;
+		query.TransformStorageVersion = scene->GetTransformStorageVersion();
+		query.Entities.clear();
+		query.Transforms.clear();
+		query.EntityIDs.clear();
+		query.Translations.clear();
+		query.Rotations.clear();
+		query.Scales.clear();
+
+		ENTT_ID_TYPE types[7] = { entt::type_info<TransformComponent>::id() };
+		uint32_t typeCount = 1;
+		AddQueryComponent<Rigidbody2DComponent>(filter, TransformQueryFilter::Rigidbody2D, types, typeCount);
+		AddQueryComponent<BoxCollider2DComponent>(filter, TransformQueryFilter::BoxCollider2D, types, typeCount);
+		AddQueryComponent<CircleCollider2DComponent>(filter, TransformQueryFilter::CircleCollider2D, types, typeCount);
+		AddQueryComponent<SpriteRendererComponent>(filter, TransformQueryFilter::SpriteRenderer, types, typeCount);
+		AddQueryComponent<CircleRendererComponent>(filter, TransformQueryFilter::CircleRenderer, types, typeCount);
+		AddQueryComponent<ScriptComponent>(filter, TransformQueryFilter::Script, types, typeCount);
+
+		for (auto e : registry.runtime_view(types, types + typeCount))
+		{
+			auto& transform = registry.get<TransformComponent>(e);
+
+			query.Entities.push_back(e);
+			query.Transforms.push_back(&transform);
+			query.EntityIDs.push_back(registry.get<IDComponent>(e).ID);
+			query.Translations.push_back(transform.Translation);
+			query.Rotations.push_back(transform.Rotation);
+			query.Scales.push_back(transform.Scale);
+		}
+
+		outView->EntityIDs = query.EntityIDs.data();
+		outView->Translations = query.Translations.data();
+		outView->Rotations = query.Rotations.data();
+		outView->Scales = query.Scales.data();
+		outView->Count = (uint32_t)query.Entities.size();
+		return queryIndex + 1;
+	}
+
+	void ScriptGlue::TransformQuery_End(uint32_t queryID, bool writeBack)
+	{
+		NANO_ENGINE_LOG_ASSERT(queryID != 0 && queryID <= s_TransformQueries.size() && s_TransformQueries[queryID - 1].InUse, "Invalid transform query");
+		TransformQuery& query = s_TransformQueries[queryID - 1];
+		query.InUse = false;
+
+		if (!writeBack)
+			return;
+
+		Scene* scene = ScriptEngine::GetSceneContext();
+		NANO_ENGINE_LOG_ASSERT(scene);
+
+		// Moves are written in place, a changed scale is patched so physics resizes the fixtures
+		entt::registry& registry = scene->m_Registry;
+		if (scene->GetTransformStorageVersion() == query.TransformStorageVersion)
+		{
+			for (size_t i = 0; i < query.Transforms.size(); i++)
+			{
+				TransformComponent& transform = *query.Transforms[i];
+				transform.Translation = query.Translations[i];
+				transform.Rotation = query.Rotations[i];
+				if (transform.Scale != query.Scales[i])
+				{
+					transform.Scale = query.Scales[i];
+					registry.patch<TransformComponent>(query.Entities[i]);
+				}
+			}
+			return;
+		}
+
+		// Entities or transforms were added or removed while the query was open,
+		// the cached pointers may have moved so each entity is resolved again
+		NANO_ENGINE_LOG_WARN("Transform storage changed during a transform query, writing back by entity");
+
+		for (size_t i = 0; i < query.Entities.size(); i++)
+		{
+			if (!registry.valid(query.Entities[i]))
+				continue;
+
+			if (auto* transform = registry.try_get<TransformComponent>(query.Entities[i]))
+			{
+				transform->Translation = query.Translations[i];
+				transform->Rotation = query.Rotations[i];
+				if (transform->Scale != query.Scales[i])
+				{
+					transform->Scale = query.Scales[i];
+					registry.patch<TransformComponent>(query.Entities[i]);
+				}
+			}
+		}
+	}
+
 	static bool Input_IsKeyDown(KeyCode keycode)
 	{
 		return Input::IsKeyPressed(keycode);
 	}
 
 	template<typename... Component>
-	static void RegisterComponent()
+	static void RegisterComponent(ComponentGroup<Component...>)
 	{
 		([]()
 		{
-			std::string_view typeName = typeid(Component).name();
-			size_t pos = typeName.find_last_of(':');
-			std::string_view structName = typeName.substr(pos + 1);
-			std::string managedTypename = fmt::format("Hazel.{}", structName);
-
+			std::string managedTypename = fmt::format("Hazel.{}", ComponentReflection<Component>::Name);
 			MonoType* managedType = mono_reflection_type_from_name(managedTypename.data(), ScriptEngine::GetCoreAssemblyImage());
+			// Not every engine component has a managed counterpart
 			if (!managedType)
 			{
-				NANO_ENGINE_LOG_ERROR("Could not find component type {}", managedTypename);
+				NANO_ENGINE_LOG_TRANCE("No managed type for component {}", managedTypename);
 				return;
 			}
 			s_EntityHasComponentFuncs[managedType] = [](Entity entity) { return entity.HasComponent<Component>(); };
 		}(), ...);
 	}
 
-	template<typename... Component>
-	static void RegisterComponent(ComponentGroup<Component...>)
-	{
-		RegisterComponent<Component...>();
-	}
-
 	void ScriptGlue::RegisterComponents()
 	{
 		s_EntityHasComponentFuncs.clear();
-		RegisterComponent(AllComponents{});
+		RegisterComponent(ReflectedComponents{});
 	}
 
 	void ScriptGlue::RegisterFunctions()
@@ -166,6 +370,9 @@ namespace NanoCore {
 
 		HZ_ADD_INTERNAL_CALL(TransformComponent_GetTranslation);
 		HZ_ADD_INTERNAL_CALL(TransformComponent_SetTranslation);
+
+		HZ_ADD_INTERNAL_CALL(TransformQuery_Begin);
+		HZ_ADD_INTERNAL_CALL(TransformQuery_End);
 		
 		HZ_ADD_INTERNAL_CALL(Rigidbody2DComponent_ApplyLinearImpulse);
 		HZ_ADD_INTERNAL_CALL(Rigidbody2DComponent_ApplyLinearImpulseToCenter);
@@ -2,11 +2,17 @@
 
 namespace NanoCore {
 
+	struct TransformQueryView;
+
 	class ScriptGlue
 	{
 	public:
 		static void RegisterComponents();
 		static void RegisterFunctions();
+	private:
+		// Need the scene registry, which Scene only shares with its friends
+		static uint32_t TransformQuery_Begin(uint32_t filter, TransformQueryView* outView);
+		static void TransformQuery_End(uint32_t queryID, bool writeBack);
 	};
 
 
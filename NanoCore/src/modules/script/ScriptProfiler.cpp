@@ -0,0 +1,240 @@
+#include "ncpch.h"
+#include "ScriptProfiler.h"
+
+#include "mono/metadata/profiler.h"
+#include "mono/metadata/mono-gc.h"
+
+namespace NanoCore {
+
+	using ProfilerClock = std::chrono::high_resolution_clock;
+
+	static long long ToMicroseconds(ProfilerClock::time_point timepoint)
+	{
+		return std::chrono::time_point_cast<std::chrono::microseconds>(timepoint).time_since_epoch().count();
+	}
+
+	struct GCPause
+	{
+		long long Start, End;
+		uint32_t ThreadID;
+	};
+
+	struct ScriptProfilerData
+	{
+		bool Enabled = true;
+
+		std::vector<ScriptClassProfile> Classes;
+		std::unordered_map<std::string, uint32_t> ClassIndices;
+
+		std::vector<ScriptInternalCallProfile> InternalCalls;
+
+		ScriptGCProfile GC;
+		MonoProfilerHandle ProfilerHandle = nullptr;
+
+		// Written by whichever thread runs the collection, drained in BeginFrame
+		ProfilerClock::time_point GCPauseStart;
+		std::mutex GCMutex;
+		std::vector<GCPause> PendingGCPauses;
+		// Swapped with the pending list, so neither loses its capacity
+		std::vector<GCPause> DrainedGCPauses;
+	};
+
+	static ScriptProfilerData* s_Data = nullptr;
+
+	// Pause closed by the collecting thread while Mono still holds the GC lock,
+	// published once the lock is released
+	static thread_local GCPause s_ClosedGCPause;
+	static thread_local bool s_HasClosedGCPause = false;
+
+	static void OnGCEvent(MonoProfiler* profiler, MonoProfilerGCEvent gcEvent, uint32_t generation, mono_bool isSerial)
+	{
+		// Stop-the-world collections are serialized, only one pause is open at a time
+		if (gcEvent == MONO_GC_EVENT_PRE_STOP_WORLD)
+		{
+			s_Data->GCPauseStart = ProfilerClock::now();
+		}
+		else if (gcEvent == MONO_GC_EVENT_POST_START_WORLD)
+		{
+			// Mono still holds the GC lock here, a thread blocked on it while holding
+			// GCMutex would deadlock the collection, so only the timestamps are taken
+			uint32_t threadID = (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id());
+			s_ClosedGCPause = { ToMicroseconds(s_Data->GCPauseStart), ToMicroseconds(ProfilerClock::now()), threadID };
+			s_HasClosedGCPause = true;
+		}
+		else if (gcEvent == MONO_GC_EVENT_POST_START_WORLD_UNLOCKED && s_HasClosedGCPause)
+		{
+			s_HasClosedGCPause = false;
+			std::scoped_lock<std::mutex> lock(s_Data->GCMutex);
+			s_Data->PendingGCPauses.push_back(s_ClosedGCPause);
+		}
+	}
+
+	void ScriptProfiler::Init()
+	{
+		s_Data = new ScriptProfilerData();
+
+		s_Data->ProfilerHandle = mono_profiler_create(nullptr);
+		mono_profiler_set_gc_event_callback(s_Data->ProfilerHandle, OnGCEvent);
+	}
+
+	void ScriptProfiler::Shutdown()
+	{
+		// Profiler handles can't be destroyed, only detached from the events
+		if (s_Data->ProfilerHandle)
+			mono_profiler_set_gc_event_callback(s_Data->ProfilerHandle, nullptr);
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	void ScriptProfiler::SetEnabled(bool enabled)
+	{
+		s_Data->Enabled = enabled;
+	}
+
+	bool ScriptProfiler::IsEnabled()
+	{
+		return s_Data && s_Data->Enabled;
+	}
+
+	void ScriptProfiler::BeginFrame()
+	{
+		RA_PROFILE_FUNCTION();
+
+		for (auto& classProfile : s_Data->Classes)
+		{
+			for (auto& method : classProfile.Methods)
+			{
+				method.FrameCalls = method.PendingCalls;
+				method.FrameMs = method.PendingMs;
+				method.AverageMs += (method.FrameMs - method.AverageMs) * 0.05f;
+				method.PeakMs = std::max(method.PeakMs, method.FrameMs);
+				method.TotalCalls += method.PendingCalls;
+
+				method.PendingCalls = 0;
+				method.PendingMs = 0.0f;
+			}
+		}
+
+		for (auto& call : s_Data->InternalCalls)
+		{
+			call.FrameCalls = call.PendingCalls;
+			call.TotalCalls += call.PendingCalls;
+			call.PendingCalls = 0;
+		}
+
+		ScriptGCProfile& gc = s_Data->GC;
+		gc.FramePauses = 0;
+		gc.FramePauseMs = 0.0f;
+
+		std::vector<GCPause>& pauses = s_Data->DrainedGCPauses;
+		pauses.clear();
+		{
+			std::scoped_lock<std::mutex> lock(s_Data->GCMutex);
+			pauses.swap(s_Data->PendingGCPauses);
+		}
+
+		for (const GCPause& pause : pauses)
+		{
+			float pauseMs = (float)(pause.End - pause.Start) * 0.001f;
+			gc.FramePauses++;
+			gc.FramePauseMs += pauseMs;
+			gc.PeakPauseMs = std::max(gc.PeakPauseMs, pauseMs);
+			gc.TotalPauseMs += pauseMs;
+
+#if RA_PROFILE
+			if (s_Data->Enabled)
+				Instrumentor::Get().WriteProfile({ "Mono GC", pause.Start, pause.End, pause.ThreadID });
+#endif
+		}
+
+		if (!s_Data->Enabled)
+			return;
+
+		gc.HeapSize = mono_gc_get_heap_size();
+		gc.UsedSize = mono_gc_get_used_size();
+
+		gc.Collections.resize(mono_gc_max_generation() + 1);
+		for (int generation = 0; generation < (int)gc.Collections.size(); generation++)
+			gc.Collections[generation] = mono_gc_collection_count(generation);
+	}
+
+	void ScriptProfiler::Reset()
+	{
+		for (auto& classProfile : s_Data->Classes)
+			classProfile.Methods = {};
+
+		for (auto& call : s_Data->InternalCalls)
+		{
+			call.FrameCalls = 0;
+			call.PendingCalls = 0;
+			call.TotalCalls = 0;
+		}
+
+		s_Data->GC.PeakPauseMs = 0.0f;
+		s_Data->GC.TotalPauseMs = 0.0f;
+	}
+
+	uint32_t ScriptProfiler::RegisterScriptClass(const std::string& className)
+	{
+		// Reloaded classes keep their entry
+		auto it = s_Data->ClassIndices.find(className);
+		if (it != s_Data->ClassIndices.end())
+			return it->second;
+
+		uint32_t classIndex = (uint32_t)s_Data->Classes.size();
+		ScriptClassProfile& classProfile = s_Data->Classes.emplace_back();
+		classProfile.ClassName = className;
+		for (size_t i = 0; i < classProfile.EventNames.size(); i++)
+			classProfile.EventNames[i] = fmt::format("Script {}.{}", className, Utils::ScriptProfileMethodToString((ScriptProfileMethod)i));
+
+		s_Data->ClassIndices[className] = classIndex;
+		return classIndex;
+	}
+
+	uint32_t ScriptProfiler::RegisterInternalCall(const char* name)
+	{
+		uint32_t callIndex = (uint32_t)s_Data->InternalCalls.size();
+		s_Data->InternalCalls.push_back({ name });
+		return callIndex;
+	}
+
+	void ScriptProfiler::CountInternalCall(uint32_t callIndex)
+	{
+		if (!s_Data->Enabled)
+			return;
+
+		s_Data->InternalCalls[callIndex].PendingCalls++;
+	}
+
+	void ScriptProfiler::Record(uint32_t classIndex, ScriptProfileMethod method, ProfilerClock::time_point start)
+	{
+		auto end = ProfilerClock::now();
+
+		ScriptClassProfile& classProfile = s_Data->Classes[classIndex];
+		ScriptMethodProfile& methodProfile = classProfile.Methods[(size_t)method];
+		methodProfile.PendingCalls++;
+		methodProfile.PendingMs += std::chrono::duration<float, std::milli>(end - start).count();
+
+#if RA_PROFILE
+		uint32_t threadID = (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id());
+		Instrumentor::Get().WriteProfile({ classProfile.EventNames[(size_t)method], ToMicroseconds(start), ToMicroseconds(end), threadID });
+#endif
+	}
+
+	const std::vector<ScriptClassProfile>& ScriptProfiler::GetClassProfiles()
+	{
+		return s_Data->Classes;
+	}
+
+	const std::vector<ScriptInternalCallProfile>& ScriptProfiler::GetInternalCallProfiles()
+	{
+		return s_Data->InternalCalls;
+	}
+
+	const ScriptGCProfile& ScriptProfiler::GetGCProfile()
+	{
+		return s_Data->GC;
+	}
+
+}
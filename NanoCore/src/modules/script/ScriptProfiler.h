@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace NanoCore {
+
+	enum class ScriptProfileMethod : uint8_t
+	{
+		OnCreate = 0, OnUpdate, OnFixedUpdate, OnDestroy,
+		Count
+	};
+
+	struct ScriptMethodProfile
+	{
+		// Last finished frame
+		uint32_t FrameCalls = 0;
+		float FrameMs = 0.0f;
+
+		// Smoothed over recent frames, and the worst frame since the last reset
+		float AverageMs = 0.0f;
+		float PeakMs = 0.0f;
+		uint64_t TotalCalls = 0;
+
+		// Accumulated during the current frame
+		uint32_t PendingCalls = 0;
+		float PendingMs = 0.0f;
+	};
+
+	struct ScriptClassProfile
+	{
+		std::string ClassName;
+		std::array<ScriptMethodProfile, (size_t)ScriptProfileMethod::Count> Methods;
+
+		// Instrumentor event names, built once per class
+		std::array<std::string, (size_t)ScriptProfileMethod::Count> EventNames;
+	};
+
+	struct ScriptInternalCallProfile
+	{
+		const char* Name = "";
+		uint32_t FrameCalls = 0;
+		uint32_t PendingCalls = 0;
+		uint64_t TotalCalls = 0;
+	};
+
+	struct ScriptGCProfile
+	{
+		int64_t HeapSize = 0;
+		int64_t UsedSize = 0;
+
+		// Collections per generation since the runtime started
+		std::vector<int> Collections;
+
+		uint32_t FramePauses = 0;
+		float FramePauseMs = 0.0f;
+		float PeakPauseMs = 0.0f;
+		float TotalPauseMs = 0.0f;
+	};
+
+	// Aggregates script cost per class and lifecycle method, counts internal call
+	// transitions and samples the managed heap. Timed calls are also written to
+	// the Instrumentor trace.
+	class ScriptProfiler
+	{
+	public:
+		// Installs the GC event hooks, call before the Mono runtime starts
+		static void Init();
+		static void Shutdown();
+
+		static void SetEnabled(bool enabled);
+		static bool IsEnabled();
+
+		// Closes the previous frame's stats and samples the managed heap
+		static void BeginFrame();
+		static void Reset();
+
+		static uint32_t RegisterScriptClass(const std::string& className);
+		static uint32_t RegisterInternalCall(const char* name);
+		static void CountInternalCall(uint32_t callIndex);
+
+		static const std::vector<ScriptClassProfile>& GetClassProfiles();
+		static const std::vector<ScriptInternalCallProfile>& GetInternalCallProfiles();
+		static const ScriptGCProfile& GetGCProfile();
+	private:
+		static void Record(uint32_t classIndex, ScriptProfileMethod method, std::chrono::high_resolution_clock::time_point start);
+
+		friend class ScriptProfileScope;
+	};
+
+	// Times one lifecycle call, or a whole class batch, into the class profile
+	class ScriptProfileScope
+	{
+	public:
+		ScriptProfileScope(uint32_t classIndex, ScriptProfileMethod method)
+			: m_ClassIndex(classIndex), m_Method(method), m_Active(ScriptProfiler::IsEnabled())
+		{
+			if (m_Active)
+				m_Start = std::chrono::high_resolution_clock::now();
+		}
+
+		~ScriptProfileScope()
+		{
+			if (m_Active)
+				ScriptProfiler::Record(m_ClassIndex, m_Method, m_Start);
+		}
+
+		ScriptProfileScope(const ScriptProfileScope&) = delete;
+		ScriptProfileScope& operator=(const ScriptProfileScope&) = delete;
+	private:
+		uint32_t m_ClassIndex;
+		ScriptProfileMethod m_Method;
+		bool m_Active;
+		std::chrono::high_resolution_clock::time_point m_Start;
+	};
+
+	namespace Utils {
+
+		inline const char* ScriptProfileMethodToString(ScriptProfileMethod method)
+		{
+			switch (method)
+			{
+				case ScriptProfileMethod::OnCreate:      return "OnCreate";
+				case ScriptProfileMethod::OnUpdate:      return "OnUpdate";
+				case ScriptProfileMethod::OnFixedUpdate: return "OnFixedUpdate";
+				case ScriptProfileMethod::OnDestroy:     return "OnDestroy";
+			}
+			return "Unknown";
+		}
+
+	}
+
+}
@@ -0,0 +1,341 @@
+#include "ncpch.h"
+#include "AssetPack.h"
+#include "Compression.h"
+#include "ThreadPool.h"
+#include "Hash.h"
+
+#include <fstream>
+
+namespace NanoCore {
+
+	// "NCPK"
+	static constexpr uint32_t PackMagic = 0x4B50434E;
+	static constexpr uint32_t PackVersion = 2;
+
+	static constexpr uint32_t CompressedEntryFlag = 1 << 0;
+
+	// Files read and compressed together by the builder, bounds its memory use
+	static constexpr size_t FilesPerBatch = 64;
+
+	// Followed by the entry data, the path strings and the table of contents
+	struct AssetPackHeader
+	{
+		uint32_t Magic = PackMagic;
+		uint32_t Version = PackVersion;
+		uint32_t EntryCount = 0;
+		uint32_t Reserved = 0;
+		uint64_t StringsOffset = 0;
+		uint64_t StringsSize = 0;
+		uint64_t TableOffset = 0;
+	};
+
+	static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	bool AssetPackEntry::IsCompressed() const
+	{
+		return Flags & CompressedEntryFlag;
+	}
+
+	std::string AssetPack::NormalizePath(const std::filesystem::path& filepath)
+	{
+		std::filesystem::path path = filepath;
+		if (path.is_absolute())
+		{
+			std::filesystem::path relative = path.lexically_relative(std::filesystem::current_path());
+			if (!relative.empty() && *relative.begin() != "..")
+				path = relative;
+		}
+		return path.lexically_normal().generic_string();
+	}
+
+	uint64_t AssetPack::HashPath(std::string_view path)
+	{
+		// Collisions are resolved by comparing the paths
+		return Hash::Hash64(path);
+	}
+
+	bool AssetPack::Open(const std::filesystem::path& filepath)
+	{
+		RA_PROFILE_FUNCTION();
+
+		Close();
+
+		auto corrupt = [&](const char* reason)
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to open asset pack '{}': {}", filepath.string(), reason);
+			Close();
+			return false;
+		};
+
+		if (!m_File.Open(filepath))
+			return corrupt("can't map the file");
+
+		const uint8_t* data = m_File.GetData();
+		const uint64_t size = m_File.GetSize();
+
+		AssetPackHeader header;
+		if (size < sizeof(AssetPackHeader))
+			return corrupt("truncated header");
+		memcpy(&header, data, sizeof(AssetPackHeader));
+
+		if (header.Magic != PackMagic)
+			return corrupt("not an asset pack");
+		if (header.Version != PackVersion)
+			return corrupt("built by a different engine version");
+
+		if (header.StringsOffset > size || header.StringsSize > size - header.StringsOffset)
+			return corrupt("path strings out of range");
+		if (header.TableOffset % alignof(AssetPackEntry) != 0 || header.TableOffset > size
+			|| header.EntryCount > (size - header.TableOffset) / sizeof(AssetPackEntry))
+			return corrupt("table of contents out of range");
+
+		m_Entries = (const AssetPackEntry*)(data + header.TableOffset);
+		m_EntryCount = header.EntryCount;
+		m_Strings = (const char*)(data + header.StringsOffset);
+		m_StringsSize = header.StringsSize;
+
+		for (uint32_t i = 0; i < m_EntryCount; i++)
+		{
+			const AssetPackEntry& entry = m_Entries[i];
+			if (entry.Offset > size || entry.StoredSize > size - entry.Offset || (uint64_t)entry.PathOffset + entry.PathLength > m_StringsSize)
+				return corrupt("entry out of range");
+			if (!entry.IsCompressed() && entry.StoredSize != entry.Size)
+				return corrupt("entry size mismatch");
+			if (i > 0 && m_Entries[i - 1].PathHash > entry.PathHash)
+				return corrupt("table of contents isn't sorted");
+		}
+
+		m_FilePath = filepath;
+		return true;
+	}
+
+	void AssetPack::Close()
+	{
+		m_File.Close();
+		m_FilePath.clear();
+		m_Entries = nullptr;
+		m_EntryCount = 0;
+		m_Strings = nullptr;
+		m_StringsSize = 0;
+	}
+
+	const AssetPackEntry* AssetPack::Find(const std::filesystem::path& filepath) const
+	{
+		if (m_EntryCount == 0)
+			return nullptr;
+
+		std::string path = NormalizePath(filepath);
+		uint64_t hash = HashPath(path);
+
+		const AssetPackEntry* end = m_Entries + m_EntryCount;
+		const AssetPackEntry* it = std::lower_bound(m_Entries, end, hash, [](const AssetPackEntry& entry, uint64_t hash) { return entry.PathHash < hash; });
+		for (; it != end && it->PathHash == hash; ++it)
+		{
+			if (GetPath(*it) == path)
+				return it;
+		}
+		return nullptr;
+	}
+
+	const uint8_t* AssetPack::GetData(const AssetPackEntry& entry) const
+	{
+		return entry.IsCompressed() ? nullptr : m_File.GetData() + entry.Offset;
+	}
+
+	bool AssetPack::Read(const AssetPackEntry& entry, uint8_t* dst) const
+	{
+		const uint8_t* stored = m_File.GetData() + entry.Offset;
+		if (!entry.IsCompressed())
+		{
+			memcpy(dst, stored, entry.Size);
+			return true;
+		}
+
+		// Decompressing costs more than checking, and a damaged block could still decode
+		if (!Verify(entry) || !Compression::DecompressLZ4(stored, entry.StoredSize, dst, entry.Size))
+		{
+			NANO_ENGINE_LOG_ERROR("Asset pack entry '{}' in '{}' is damaged", GetPath(entry), m_FilePath.string());
+			return false;
+		}
+		return true;
+	}
+
+	bool AssetPack::Verify(const AssetPackEntry& entry) const
+	{
+		return Hash::CRC32C(m_File.GetData() + entry.Offset, entry.StoredSize) == entry.Checksum;
+	}
+
+	std::string_view AssetPack::GetPath(const AssetPackEntry& entry) const
+	{
+		return std::string_view(m_Strings + entry.PathOffset, entry.PathLength);
+	}
+
+	void AssetPackBuilder::AddFile(const std::filesystem::path& filepath, bool allowCompression)
+	{
+		m_Files.push_back({ filepath, AssetPack::NormalizePath(filepath), allowCompression });
+	}
+
+	void AssetPackBuilder::AddDirectory(const std::filesystem::path& directory, bool allowCompression)
+	{
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+		{
+			if (entry.is_regular_file())
+				AddFile(entry.path(), allowCompression);
+		}
+	}
+
+	bool AssetPackBuilder::Build(const std::filesystem::path& packPath, AssetPackStats* stats) const
+	{
+		RA_PROFILE_FUNCTION();
+
+		// Sorted so the same files always give the same pack
+		std::vector<const PackFile*> files;
+		files.reserve(m_Files.size());
+		for (const PackFile& file : m_Files)
+			files.push_back(&file);
+		std::sort(files.begin(), files.end(), [](const PackFile* a, const PackFile* b) { return a->PackPath < b->PackPath; });
+		files.erase(std::unique(files.begin(), files.end(), [](const PackFile* a, const PackFile* b) { return a->PackPath == b->PackPath; }), files.end());
+
+		std::ofstream stream(packPath, std::ios::binary | std::ios::trunc);
+		if (!stream)
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to create asset pack '{}'", packPath.string());
+			return false;
+		}
+
+		AssetPackHeader header;
+		uint64_t position = sizeof(AssetPackHeader);
+		stream.write((const char*)&header, sizeof(AssetPackHeader));
+
+		auto pad = [&](uint64_t alignment)
+		{
+			static const char zeros[AssetPack::EntryAlignment] = {};
+			uint64_t aligned = AlignUp(position, alignment);
+			stream.write(zeros, aligned - position);
+			position = aligned;
+		};
+
+		AssetPackStats packStats;
+		std::vector<AssetPackEntry> entries;
+		entries.reserve(files.size());
+		std::string strings;
+
+		struct StoredFile
+		{
+			std::vector<uint8_t> Data;
+			uint64_t Size = 0;
+			uint32_t Checksum = 0;
+			bool Compressed = false;
+			bool Read = false;
+		};
+
+		for (size_t first = 0; first < files.size(); first += FilesPerBatch)
+		{
+			const size_t count = std::min(FilesPerBatch, files.size() - first);
+			std::vector<StoredFile> stored(count);
+
+			ThreadPool::ParallelFor(count, 1, [&](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; i++)
+					{
+						const PackFile& file = *files[first + i];
+						StoredFile& result = stored[i];
+
+						std::ifstream input(file.Path, std::ios::binary | std::ios::ate);
+						if (!input)
+							continue;
+
+						std::vector<uint8_t> data((size_t)input.tellg());
+						input.seekg(0);
+						input.read((char*)data.data(), data.size());
+						if (!input)
+							continue;
+
+						result.Read = true;
+						result.Size = data.size();
+
+						if (file.AllowCompression && data.size() >= 64)
+						{
+							std::vector<uint8_t> compressed(Compression::GetMaxCompressedSizeLZ4(data.size()));
+							size_t compressedSize = Compression::CompressLZ4(data.data(), data.size(), compressed.data(), compressed.size());
+							if (compressedSize <= data.size() - data.size() / 8)
+							{
+								compressed.resize(compressedSize);
+								data = std::move(compressed);
+								result.Compressed = true;
+							}
+						}
+
+						result.Checksum = Hash::CRC32C(data.data(), data.size());
+						result.Data = std::move(data);
+					}
+				});
+
+			for (size_t i = 0; i < count; i++)
+			{
+				const PackFile& file = *files[first + i];
+				StoredFile& result = stored[i];
+				if (!result.Read)
+				{
+					NANO_ENGINE_LOG_ERROR("Failed to read '{}' into asset pack '{}'", file.Path.string(), packPath.string());
+					return false;
+				}
+
+				pad(AssetPack::EntryAlignment);
+
+				AssetPackEntry& entry = entries.emplace_back();
+				entry.PathHash = AssetPack::HashPath(file.PackPath);
+				entry.PathOffset = (uint32_t)strings.size();
+				entry.PathLength = (uint32_t)file.PackPath.size();
+				entry.Offset = position;
+				entry.StoredSize = result.Data.size();
+				entry.Size = result.Size;
+				entry.Flags = result.Compressed ? CompressedEntryFlag : 0;
+				entry.Checksum = result.Checksum;
+				strings += file.PackPath;
+
+				stream.write((const char*)result.Data.data(), result.Data.size());
+				position += result.Data.size();
+
+				packStats.FileCount++;
+				packStats.CompressedCount += result.Compressed;
+				packStats.Size += result.Size;
+				packStats.StoredSize += result.Data.size();
+			}
+		}
+
+		header.StringsOffset = position;
+		header.StringsSize = strings.size();
+		stream.write(strings.data(), strings.size());
+		position += strings.size();
+
+		// Equal hashes are ordered by path so lookups only compare the paths of real collisions
+		std::sort(entries.begin(), entries.end(), [&](const AssetPackEntry& a, const AssetPackEntry& b)
+			{
+				if (a.PathHash != b.PathHash)
+					return a.PathHash < b.PathHash;
+				return strings.compare(a.PathOffset, a.PathLength, strings, b.PathOffset, b.PathLength) < 0;
+			});
+
+		pad(alignof(AssetPackEntry));
+		header.TableOffset = position;
+		header.EntryCount = (uint32_t)entries.size();
+		stream.write((const char*)entries.data(), entries.size() * sizeof(AssetPackEntry));
+
+		stream.seekp(0);
+		stream.write((const char*)&header, sizeof(AssetPackHeader));
+		if (!stream)
+		{
+			NANO_ENGINE_LOG_ERROR("Failed to write asset pack '{}'", packPath.string());
+			return false;
+		}
+
+		if (stats)
+			*stats = packStats;
+		return true;
+	}
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "FileManager.h"
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace NanoCore {
+
+	struct AssetPackEntry
+	{
+		uint64_t PathHash = 0;
+		uint32_t PathOffset = 0;
+		uint32_t PathLength = 0;
+
+		// Aligned to AssetPack::EntryAlignment from the start of the pack
+		uint64_t Offset = 0;
+		uint64_t StoredSize = 0;
+		uint64_t Size = 0;
+
+		uint32_t Flags = 0;
+		// CRC32C of the stored bytes
+		uint32_t Checksum = 0;
+
+		bool IsCompressed() const;
+	};
+
+	// Many files in one read-only archive that is mapped as a whole. The table of contents
+	// is sorted by path hash, so finding a file is a binary search without touching the
+	// disk, and uncompressed entries are read in place from the mapping.
+	// Paths are relative to the working directory with forward slashes, as NormalizePath makes them.
+	class AssetPack
+	{
+	public:
+		static constexpr uint64_t EntryAlignment = 64;
+
+		AssetPack() = default;
+		AssetPack(const AssetPack&) = delete;
+		AssetPack& operator=(const AssetPack&) = delete;
+
+		bool Open(const std::filesystem::path& filepath);
+		void Close();
+
+		const AssetPackEntry* Find(const std::filesystem::path& filepath) const;
+
+		// Entry bytes inside the mapping, null for compressed entries
+		const uint8_t* GetData(const AssetPackEntry& entry) const;
+		// Copies or decompresses the entry into dst, which holds entry.Size bytes. False if it is damaged.
+		bool Read(const AssetPackEntry& entry, uint8_t* dst) const;
+		// Checks the stored bytes against the checksum. Read does this for compressed entries,
+		// views of uncompressed ones aren't checked.
+		bool Verify(const AssetPackEntry& entry) const;
+
+		std::string_view GetPath(const AssetPackEntry& entry) const;
+		uint32_t GetEntryCount() const { return m_EntryCount; }
+		const std::filesystem::path& GetFilePath() const { return m_FilePath; }
+
+		static std::string NormalizePath(const std::filesystem::path& filepath);
+		static uint64_t HashPath(std::string_view path);
+
+		operator bool() const { return (bool)m_File; }
+	private:
+		std::filesystem::path m_FilePath;
+		MappedFile m_File;
+
+		const AssetPackEntry* m_Entries = nullptr;
+		uint32_t m_EntryCount = 0;
+		const char* m_Strings = nullptr;
+		uint64_t m_StringsSize = 0;
+	};
+
+	struct AssetPackStats
+	{
+		uint32_t FileCount = 0;
+		uint32_t CompressedCount = 0;
+		uint64_t Size = 0;
+		uint64_t StoredSize = 0;
+	};
+
+	// Collects files and writes them into an AssetPack. Files are read and compressed on the
+	// thread pool a batch at a time, and only kept compressed when that saves an eighth or more.
+	class AssetPackBuilder
+	{
+	public:
+		void AddFile(const std::filesystem::path& filepath, bool allowCompression = true);
+		// Every file below directory
+		void AddDirectory(const std::filesystem::path& directory, bool allowCompression = true);
+
+		bool Build(const std::filesystem::path& packPath, AssetPackStats* stats = nullptr) const;
+	private:
+		struct PackFile
+		{
+			std::filesystem::path Path;
+			std::string PackPath;
+			bool AllowCompression = true;
+		};
+
+		std::vector<PackFile> m_Files;
+	};
+
+}
@@ -0,0 +1,200 @@
+#include "ncpch.h"
+#include "Compression.h"
+
+namespace NanoCore {
+
+	static constexpr size_t MinMatch = 4;
+	// The format ends every block with literals, and no match may start closer to the end
+	static constexpr size_t LastLiterals = 5;
+	static constexpr size_t MatchStartLimit = 12;
+	static constexpr size_t MaxOffset = 65535;
+
+	// Positions of recent 4-byte sequences, 16KB on the stack
+	static constexpr uint32_t HashLog = 12;
+
+	static uint32_t Read32(const uint8_t* data)
+	{
+		uint32_t value;
+		memcpy(&value, data, sizeof(uint32_t));
+		return value;
+	}
+
+	static uint32_t HashSequence(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HashLog);
+	}
+
+	// Lengths of 15 and up continue in extra bytes, 255 means another byte follows
+	static uint8_t* WriteLength(uint8_t* out, size_t length)
+	{
+		length -= 15;
+		while (length >= 255)
+		{
+			*out++ = 255;
+			length -= 255;
+		}
+		*out++ = (uint8_t)length;
+		return out;
+	}
+
+	static bool ReadLength(const uint8_t*& in, const uint8_t* end, size_t& length)
+	{
+		uint8_t byte;
+		do
+		{
+			if (in == end)
+				return false;
+
+			byte = *in++;
+			length += byte;
+		} while (byte == 255);
+		return true;
+	}
+
+	static uint8_t* WriteSequence(uint8_t* out, const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength)
+	{
+		uint8_t* token = out++;
+		*token = (uint8_t)(std::min<size_t>(literalCount, 15) << 4);
+		if (literalCount >= 15)
+			out = WriteLength(out, literalCount);
+
+		// Empty inputs pass no literals, memcpy needs valid pointers even for zero bytes
+		if (literalCount > 0)
+			memcpy(out, literals, literalCount);
+		out += literalCount;
+
+		// The last sequence is literals only
+		if (matchLength == 0)
+			return out;
+
+		*out++ = (uint8_t)(offset & 0xFF);
+		*out++ = (uint8_t)(offset >> 8);
+
+		matchLength -= MinMatch;
+		*token |= (uint8_t)std::min<size_t>(matchLength, 15);
+		if (matchLength >= 15)
+			out = WriteLength(out, matchLength);
+
+		return out;
+	}
+
+	size_t Compression::GetMaxCompressedSizeLZ4(size_t size)
+	{
+		return size + size / 255 + 16;
+	}
+
+	size_t Compression::CompressLZ4(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity)
+	{
+		NANO_ENGINE_LOG_ASSERT(capacity >= GetMaxCompressedSizeLZ4(size), "LZ4 output buffer is too small!");
+
+		uint32_t table[1 << HashLog] = {};
+
+		const uint8_t* end = src + size;
+		const uint8_t* anchor = src;
+		uint8_t* out = dst;
+
+		if (size > MatchStartLimit)
+		{
+			const uint8_t* matchLimit = end - LastLiterals;
+			const uint8_t* lastMatchStart = end - MatchStartLimit;
+
+			const uint8_t* in = src + 1;
+			while (in <= lastMatchStart)
+			{
+				uint32_t sequence = Read32(in);
+				uint32_t& slot = table[HashSequence(sequence)];
+				const uint8_t* match = src + slot;
+				slot = (uint32_t)(in - src);
+
+				if (match >= in || (size_t)(in - match) > MaxOffset || Read32(match) != sequence)
+				{
+					in++;
+					continue;
+				}
+
+				// Grow the match backwards into the pending literals, then forwards
+				while (in > anchor && match > src && in[-1] == match[-1])
+				{
+					in--;
+					match--;
+				}
+
+				const uint8_t* matchEnd = in + MinMatch;
+				const uint8_t* reference = match + MinMatch;
+				while (matchEnd < matchLimit && *matchEnd == *reference)
+				{
+					matchEnd++;
+					reference++;
+				}
+
+				out = WriteSequence(out, anchor, in - anchor, in - match, matchEnd - in);
+
+				in = anchor = matchEnd;
+				table[HashSequence(Read32(in - 2))] = (uint32_t)(in - 2 - src);
+			}
+		}
+
+		out = WriteSequence(out, anchor, end - anchor, 0, 0);
+		return out - dst;
+	}
+
+	bool Compression::DecompressLZ4(const uint8_t* src, size_t size, uint8_t* dst, size_t decompressedSize)
+	{
+		const uint8_t* in = src;
+		const uint8_t* inEnd = src + size;
+		uint8_t* out = dst;
+		uint8_t* outEnd = dst + decompressedSize;
+
+		while (in < inEnd)
+		{
+			uint8_t token = *in++;
+
+			size_t literalCount = token >> 4;
+			if (literalCount == 15 && !ReadLength(in, inEnd, literalCount))
+				return false;
+
+			if (literalCount > (size_t)(inEnd - in) || literalCount > (size_t)(outEnd - out))
+				return false;
+
+			if (literalCount > 0)
+				memcpy(out, in, literalCount);
+			in += literalCount;
+			out += literalCount;
+
+			if (in == inEnd)
+				break;
+
+			if (inEnd - in < 2)
+				return false;
+
+			size_t offset = in[0] | (in[1] << 8);
+			in += 2;
+			if (offset == 0 || offset > (size_t)(out - dst))
+				return false;
+
+			size_t matchLength = token & 15;
+			if (matchLength == 15 && !ReadLength(in, inEnd, matchLength))
+				return false;
+
+			matchLength += MinMatch;
+			if (matchLength > (size_t)(outEnd - out))
+				return false;
+
+			// Matches closer than their length repeat the bytes they are copying
+			const uint8_t* match = out - offset;
+			if (offset >= matchLength)
+			{
+				memcpy(out, match, matchLength);
+			}
+			else
+			{
+				for (size_t i = 0; i < matchLength; i++)
+					out[i] = match[i];
+			}
+			out += matchLength;
+		}
+
+		return out == outEnd;
+	}
+
+}
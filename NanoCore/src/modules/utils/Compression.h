@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace NanoCore {
+
+	// Byte-oriented LZ compression in the LZ4 block format, fast to decode and meant for
+	// data that is written once at build time and read often, like asset pack entries.
+	class Compression
+	{
+	public:
+		// dst of CompressLZ4 has to hold at least this many bytes
+		static size_t GetMaxCompressedSizeLZ4(size_t size);
+
+		// Returns the compressed size
+		static size_t CompressLZ4(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity);
+		// decompressedSize has to be the exact original size, false if src is damaged
+		static bool DecompressLZ4(const uint8_t* src, size_t size, uint8_t* dst, size_t decompressedSize);
+	};
+
+}
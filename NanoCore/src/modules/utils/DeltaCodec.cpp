@@ -0,0 +1,192 @@
+#include "ncpch.h"
+#include "DeltaCodec.h"
+#include "ThreadPool.h"
+
+namespace NanoCore {
+
+	// Bytes of the target covered by one chunk, each chunk is one task
+	static constexpr size_t ChunkSize = 64 * 1024;
+	// Unchanged bytes inside a changed span are stored as literals until there are this many
+	// in a row, every run costs a token
+	static constexpr size_t MinUnchangedRun = 8;
+
+	// Followed by the encoded size of every chunk, then the chunks. A chunk is a sequence
+	// of tokens: unchanged byte count, changed byte count, the changed bytes XOR the base.
+	struct DeltaHeader
+	{
+		uint64_t TargetSize = 0;
+		uint32_t ChunkCount = 0;
+		uint32_t Reserved = 0;
+	};
+
+	static void WriteVarint(std::vector<uint8_t>& out, uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back((uint8_t)value);
+	}
+
+	static bool ReadVarint(const uint8_t*& it, const uint8_t* end, uint64_t& value)
+	{
+		value = 0;
+		for (uint32_t shift = 0; shift < 64; shift += 7)
+		{
+			if (it == end)
+				return false;
+
+			uint8_t byte = *it++;
+			value |= (uint64_t)(byte & 0x7F) << shift;
+			if (!(byte & 0x80))
+				return true;
+		}
+		return false;
+	}
+
+	// The base reads as zero past its end, so buffers can grow and shrink between versions
+	static uint8_t GetBaseByte(const std::vector<uint8_t>& base, size_t index)
+	{
+		return index < base.size() ? base[index] : 0;
+	}
+
+	static void EncodeChunk(const std::vector<uint8_t>& base, const std::vector<uint8_t>& target, size_t first, size_t last, std::vector<uint8_t>& out)
+	{
+		auto changed = [&](size_t index) { return target[index] != GetBaseByte(base, index); };
+		const size_t comparable = std::min(last, base.size());
+
+		size_t position = first;
+		while (position < last)
+		{
+			// Unchanged bytes, a word at a time where the base still has bytes
+			size_t run = position;
+			while (run + sizeof(uint64_t) <= comparable && memcmp(target.data() + run, base.data() + run, sizeof(uint64_t)) == 0)
+				run += sizeof(uint64_t);
+			while (run < last && !changed(run))
+				run++;
+
+			// Changed span, up to the first long enough unchanged run
+			size_t spanEnd = run;
+			for (size_t scan = run; scan < last && scan - spanEnd < MinUnchangedRun; scan++)
+			{
+				if (changed(scan))
+					spanEnd = scan + 1;
+			}
+
+			WriteVarint(out, run - position);
+			WriteVarint(out, spanEnd - run);
+			for (size_t index = run; index < spanEnd; index++)
+				out.push_back(target[index] ^ GetBaseByte(base, index));
+
+			position = spanEnd;
+		}
+	}
+
+	static bool DecodeChunk(const std::vector<uint8_t>& base, const uint8_t* it, const uint8_t* end, size_t first, size_t last, std::vector<uint8_t>& target)
+	{
+		size_t position = first;
+		while (position < last)
+		{
+			uint64_t unchanged, changed;
+			if (!ReadVarint(it, end, unchanged) || !ReadVarint(it, end, changed))
+				return false;
+
+			if (unchanged > last - position || changed > last - position - unchanged || changed > (uint64_t)(end - it) || (unchanged == 0 && changed == 0))
+				return false;
+
+			const size_t copied = position < base.size() ? std::min<size_t>(unchanged, base.size() - position) : 0;
+			memcpy(target.data() + position, base.data() + position, copied);
+			memset(target.data() + position + copied, 0, unchanged - copied);
+			position += unchanged;
+
+			for (size_t index = 0; index < changed; index++, position++)
+				target[position] = it[index] ^ GetBaseByte(base, position);
+			it += changed;
+		}
+		return it == end;
+	}
+
+	void DeltaCodec::Encode(const std::vector<uint8_t>& base, const std::vector<uint8_t>& target, std::vector<uint8_t>& delta)
+	{
+		RA_PROFILE_FUNCTION();
+
+		DeltaHeader header;
+		header.TargetSize = target.size();
+		header.ChunkCount = (uint32_t)((target.size() + ChunkSize - 1) / ChunkSize);
+
+		std::vector<std::vector<uint8_t>> chunks(header.ChunkCount);
+		ThreadPool::ParallelFor(header.ChunkCount, 1, [&](size_t first, size_t last)
+			{
+				for (size_t chunk = first; chunk < last; chunk++)
+					EncodeChunk(base, target, chunk * ChunkSize, std::min(target.size(), (chunk + 1) * ChunkSize), chunks[chunk]);
+			});
+
+		size_t size = sizeof(DeltaHeader) + sizeof(uint32_t) * chunks.size();
+		for (const std::vector<uint8_t>& chunk : chunks)
+			size += chunk.size();
+
+		delta.resize(size);
+		uint8_t* out = delta.data();
+		memcpy(out, &header, sizeof(DeltaHeader));
+		out += sizeof(DeltaHeader);
+
+		for (const std::vector<uint8_t>& chunk : chunks)
+		{
+			uint32_t chunkSize = (uint32_t)chunk.size();
+			memcpy(out, &chunkSize, sizeof(uint32_t));
+			out += sizeof(uint32_t);
+		}
+
+		for (const std::vector<uint8_t>& chunk : chunks)
+		{
+			memcpy(out, chunk.data(), chunk.size());
+			out += chunk.size();
+		}
+	}
+
+	bool DeltaCodec::Decode(const std::vector<uint8_t>& base, const std::vector<uint8_t>& delta, std::vector<uint8_t>& target)
+	{
+		RA_PROFILE_FUNCTION();
+
+		NANO_ENGINE_LOG_ASSERT(&base != &target, "A delta can't be decoded in place!");
+
+		if (delta.size() < sizeof(DeltaHeader))
+			return false;
+
+		DeltaHeader header;
+		memcpy(&header, delta.data(), sizeof(DeltaHeader));
+		if (header.ChunkCount != (header.TargetSize + ChunkSize - 1) / ChunkSize
+			|| sizeof(uint32_t) * (uint64_t)header.ChunkCount > delta.size() - sizeof(DeltaHeader))
+			return false;
+
+		// Where every chunk starts in the delta
+		const uint8_t* chunkSizes = delta.data() + sizeof(DeltaHeader);
+		std::vector<uint64_t> offsets(header.ChunkCount + 1);
+		offsets[0] = sizeof(DeltaHeader) + sizeof(uint32_t) * (uint64_t)header.ChunkCount;
+		for (uint32_t chunk = 0; chunk < header.ChunkCount; chunk++)
+		{
+			uint32_t chunkSize;
+			memcpy(&chunkSize, chunkSizes + sizeof(uint32_t) * chunk, sizeof(uint32_t));
+			offsets[chunk + 1] = offsets[chunk] + chunkSize;
+		}
+
+		if (offsets.back() != delta.size())
+			return false;
+
+		target.resize(header.TargetSize);
+
+		std::vector<uint8_t> decoded(header.ChunkCount, 0);
+		ThreadPool::ParallelFor(header.ChunkCount, 1, [&](size_t first, size_t last)
+			{
+				for (size_t chunk = first; chunk < last; chunk++)
+				{
+					decoded[chunk] = DecodeChunk(base, delta.data() + offsets[chunk], delta.data() + offsets[chunk + 1],
+						chunk * ChunkSize, std::min<size_t>(header.TargetSize, (chunk + 1) * ChunkSize), target);
+				}
+			});
+
+		return std::all_of(decoded.begin(), decoded.end(), [](uint8_t chunk) { return chunk != 0; });
+	}
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+
+namespace NanoCore {
+
+	// Describes one byte buffer in terms of another as their XOR with the zero runs left out.
+	// Meant for buffers that keep their layout from one version to the next, like scene
+	// snapshots: unchanged bytes cost next to nothing, changed bytes are stored as they are.
+	// The buffer is cut into chunks that are encoded and decoded on the thread pool.
+	class DeltaCodec
+	{
+	public:
+		static void Encode(const std::vector<uint8_t>& base, const std::vector<uint8_t>& target, std::vector<uint8_t>& delta);
+		// Rebuilds target from the base the delta was encoded against, false if the delta is damaged
+		static bool Decode(const std::vector<uint8_t>& base, const std::vector<uint8_t>& delta, std::vector<uint8_t>& target);
+	};
+
+}
@@ -1,9 +1,69 @@
 #include "ncpch.h"
 #include "FileManager.h"
+#include "AssetPack.h"
 
+#include "modules/info/Project.h"
+
+#include <chrono>
+#include <fstream>
 
 namespace NanoCore {
 
+	// Searched from the back, later packs override earlier ones
+	static std::vector<Unique<AssetPack>> s_AssetPacks;
+
+	// A burst of changes is dispatched once nothing changed for SettleTime,
+	// or MaxDelay after its first change when files keep changing
+	static constexpr std::chrono::milliseconds SettleTime(100);
+	static constexpr std::chrono::milliseconds MaxDelay(1000);
+
+	struct PendingChange
+	{
+		FileSystemChangedEvent Event;
+		// Cancelled out by a later change, like a file added and deleted again
+		bool Dropped = false;
+	};
+
+	struct WatchedDirectory
+	{
+		std::filesystem::path Path;
+		// WatchDirectory calls not matched by an UnwatchDirectory yet
+		uint32_t WatchCount = 0;
+	};
+
+	struct FileSystemWatcherData
+	{
+		std::mutex Mutex;
+		std::vector<WatchedDirectory> Directories;
+		bool ThreadRunning = false;
+
+		// One change per path, merged as they come in
+		std::vector<PendingChange> Pending;
+		std::unordered_map<std::string, size_t> PendingIndices;
+		std::chrono::steady_clock::time_point FirstChangeTime;
+		std::chrono::steady_clock::time_point LastChangeTime;
+		bool SkipNextBatch = false;
+
+		// Main thread only
+		std::vector<std::pair<uint32_t, FileSystem::FileSystemChangedCallbackFn>> Callbacks;
+		uint32_t NextCallbackID = 1;
+	};
+
+	static FileSystemWatcherData s_Watcher;
+
+	static const AssetPackEntry* FindPackedFile(const std::filesystem::path& filepath, const AssetPack*& pack)
+	{
+		for (auto it = s_AssetPacks.rbegin(); it != s_AssetPacks.rend(); ++it)
+		{
+			if (const AssetPackEntry* entry = (*it)->Find(filepath))
+			{
+				pack = it->get();
+				return entry;
+			}
+		}
+		return nullptr;
+	}
+
 	bool FileSystem::CreateDirectory(const std::filesystem::path& directory)
 	{
 		return std::filesystem::create_directories(directory);
@@ -109,4 +169,335 @@ namespace NanoCore {
 		return true;
 	}
 
+	bool FileSystem::MountAssetPack(const std::filesystem::path& packPath)
+	{
+		auto pack = std::make_unique<AssetPack>();
+		if (!pack->Open(packPath))
+			return false;
+
+		NANO_ENGINE_LOG_INFO("Mounted asset pack '{}' with {} files", packPath.string(), pack->GetEntryCount());
+		s_AssetPacks.push_back(std::move(pack));
+		return true;
+	}
+
+	void FileSystem::UnmountAssetPacks()
+	{
+		s_AssetPacks.clear();
+	}
+
+	Buffer FileSystem::ReadBytes(const std::filesystem::path& filepath)
+	{
+		bool isView;
+		Buffer buffer = ReadBytes(filepath, isView);
+		NANO_ENGINE_LOG_ASSERT(buffer);
+
+		// The caller owns the result
+		if (isView)
+			return Buffer::Copy(buffer.Data, buffer.Size);
+		return buffer;
+	}
+
+	Buffer FileSystem::ReadBytes(const std::filesystem::path& filepath, bool& isView)
+	{
+		isView = false;
+
+		const AssetPack* pack = nullptr;
+		if (const AssetPackEntry* entry = FindPackedFile(filepath, pack))
+		{
+			if (const uint8_t* data = pack->GetData(*entry))
+			{
+				isView = true;
+				return Buffer((void*)data, (uint32_t)entry->Size);
+			}
+
+			Buffer buffer;
+			buffer.Allocate((uint32_t)entry->Size);
+			if (!pack->Read(*entry, (uint8_t*)buffer.Data))
+				buffer.Release();
+			return buffer;
+		}
+
+		Buffer buffer;
+
+		std::ifstream stream(filepath, std::ios::binary | std::ios::ate);
+		if (!stream)
+			return buffer;
+
+		uint32_t size = (uint32_t)stream.tellg();
+		stream.seekg(0, std::ios::beg);
+
+		buffer.Allocate(size);
+		stream.read((char*)buffer.Data, buffer.Size);
+		if (!stream)
+			buffer.Release();
+
+		return buffer;
+	}
+
+	bool MappedFile::Open(const std::filesystem::path& filepath)
+	{
+		Close();
+
+		const AssetPack* pack = nullptr;
+		if (const AssetPackEntry* entry = FindPackedFile(filepath, pack))
+		{
+			// Empty files can't be mapped either
+			if (entry->Size == 0)
+				return false;
+
+			m_Data = pack->GetData(*entry);
+			if (!m_Data)
+			{
+				m_Decompressed.resize(entry->Size);
+				if (!pack->Read(*entry, m_Decompressed.data()))
+				{
+					Close();
+					return false;
+				}
+				m_Data = m_Decompressed.data();
+			}
+
+			m_Size = entry->Size;
+			return true;
+		}
+
+		return Map(filepath);
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_FileHandle || m_MappingHandle)
+			Unmap();
+
+		m_Data = nullptr;
+		m_Size = 0;
+		m_Decompressed.clear();
+		m_Decompressed.shrink_to_fit();
+	}
+
+	uint32_t FileSystem::AddChangeCallback(const FileSystemChangedCallbackFn& callback)
+	{
+		uint32_t id = s_Watcher.NextCallbackID++;
+		s_Watcher.Callbacks.emplace_back(id, callback);
+		return id;
+	}
+
+	void FileSystem::RemoveChangeCallback(uint32_t id)
+	{
+		auto& callbacks = s_Watcher.Callbacks;
+		callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(), [id](const auto& callback) { return callback.first == id; }), callbacks.end());
+	}
+
+	void FileSystem::StartWatching()
+	{
+		WatchDirectory(Project::GetActive()->GetAssetDirectory());
+	}
+
+	void FileSystem::StopWatching()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(s_Watcher.Mutex);
+			if (!s_Watcher.ThreadRunning)
+				return;
+
+			s_Watcher.ThreadRunning = false;
+			s_Watcher.Directories.clear();
+		}
+
+		StopWatcherThread();
+
+		std::scoped_lock<std::mutex> lock(s_Watcher.Mutex);
+		s_Watcher.Pending.clear();
+		s_Watcher.PendingIndices.clear();
+	}
+
+	void FileSystem::WatchDirectory(const std::filesystem::path& directory)
+	{
+		std::filesystem::path path = std::filesystem::absolute(directory).lexically_normal();
+
+		bool startThread = false;
+		{
+			std::scoped_lock<std::mutex> lock(s_Watcher.Mutex);
+			auto& directories = s_Watcher.Directories;
+			auto it = std::find_if(directories.begin(), directories.end(), [&path](const WatchedDirectory& watched) { return watched.Path == path; });
+			if (it != directories.end())
+			{
+				it->WatchCount++;
+				return;
+			}
+
+			directories.push_back({ path, 1 });
+			startThread = !s_Watcher.ThreadRunning;
+			s_Watcher.ThreadRunning = true;
+		}
+
+		if (startThread)
+			StartWatcherThread();
+		else
+			WakeWatcherThread();
+	}
+
+	void FileSystem::UnwatchDirectory(const std::filesystem::path& directory)
+	{
+		std::filesystem::path path = std::filesystem::absolute(directory).lexically_normal();
+
+		{
+			std::scoped_lock<std::mutex> lock(s_Watcher.Mutex);
+			auto& directories = s_Watcher.Directories;
+			auto it = std::find_if(directories.begin(), directories.end(), [&path](const WatchedDirectory& watched) { return watched.Path == path; });
+			if (it == directories.end() || --it->WatchCount > 0)
+				return;
+
+			directories.erase(it);
+		}
+
+		WakeWatcherThread();
+	}
+
+	std::vector<std::filesystem::path> FileSystem::GetWatchedDirectories()
+	{
+		std::scoped_lock<std::mutex> lock(s_Watcher.Mutex);
+		std::vector<std::filesystem::path> paths;
+		paths.reserve(s_Watcher.Directories.size());
+		for (const WatchedDirectory& watched : s_Watcher.Directories)
+			paths.push_back(watched.Path);
+		return paths;
+	}
+
+	void FileSystem::SkipNextFileSystemChange()
+	{
+		std::scoped_lock<std::mutex> lock(s_Watcher.Mutex);
+		s_Watcher.SkipNextBatch = true;
+	}
+
+	// Folds a change into the one already pending for the same path
+	static void MergeFileSystemChange(FileSystemChangedEvent& event)
+	{
+		std::string key = event.FilePath.generic_string();
+		auto it = s_Watcher.PendingIndices.find(key);
+		if (it == s_Watcher.PendingIndices.end())
+		{
+			s_Watcher.PendingIndices[key] = s_Watcher.Pending.size();
+			s_Watcher.Pending.push_back({ std::move(event) });
+			return;
+		}
+
+		PendingChange& pending = s_Watcher.Pending[it->second];
+		FileSystemChangedEvent& previous = pending.Event;
+		switch (event.Action)
+		{
+			case FileSystemAction::Modified:
+			{
+				// Still new or renamed, the contents are read either way
+				if (previous.Action == FileSystemAction::Added || previous.Action == FileSystemAction::Rename)
+					return;
+				break;
+			}
+			case FileSystemAction::Delete:
+			{
+				if (previous.Action == FileSystemAction::Added)
+				{
+					pending.Dropped = true;
+					s_Watcher.PendingIndices.erase(it);
+					return;
+				}
+				// What was deleted is the file under its old name
+				if (previous.Action == FileSystemAction::Rename)
+					event.FilePath = event.FilePath.parent_path() / previous.OldName;
+				break;
+			}
+			case FileSystemAction::Added:
+			case FileSystemAction::Rename:
+			{
+				// Replaced, like a save that deletes the file and writes a new one
+				if (previous.Action == FileSystemAction::Delete || previous.Action == FileSystemAction::Modified)
+				{
+					event.Action = FileSystemAction::Modified;
+					event.OldName.clear();
+				}
+				break;
+			}
+		}
+
+		previous = std::move(event);
+	}
+
+	void FileSystem::QueueFileSystemChanges(std::vector<FileSystemChangedEvent>& events)
+	{
+		if (events.empty())
+			return;
+
+		std::scoped_lock<std::mutex> lock(s_Watcher.Mutex);
+
+		auto now = std::chrono::steady_clock::now();
+		if (s_Watcher.Pending.empty())
+			s_Watcher.FirstChangeTime = now;
+		s_Watcher.LastChangeTime = now;
+
+		for (FileSystemChangedEvent& event : events)
+		{
+			if (event.Action == FileSystemAction::Rename)
+			{
+				// A file written under a temporary name and renamed over the real one is a change of the real one
+				auto it = s_Watcher.PendingIndices.find((event.FilePath.parent_path() / event.OldName).generic_string());
+				if (it != s_Watcher.PendingIndices.end())
+				{
+					// Added when the real file was replaced without deleting it first, there's
+					// no telling if it existed before
+					PendingChange& source = s_Watcher.Pending[it->second];
+					if (source.Event.Action == FileSystemAction::Added)
+					{
+						event.Action = FileSystemAction::Added;
+						event.OldName.clear();
+					}
+
+					source.Dropped = true;
+					s_Watcher.PendingIndices.erase(it);
+				}
+			}
+
+			MergeFileSystemChange(event);
+		}
+		events.clear();
+	}
+
+	void FileSystem::DispatchFileSystemChanges()
+	{
+		RA_PROFILE_FUNCTION();
+
+		std::vector<FileSystemChangedEvent> batch;
+		{
+			std::scoped_lock<std::mutex> lock(s_Watcher.Mutex);
+			if (s_Watcher.Pending.empty())
+				return;
+
+			auto now = std::chrono::steady_clock::now();
+			if (now - s_Watcher.LastChangeTime < SettleTime && now - s_Watcher.FirstChangeTime < MaxDelay)
+				return;
+
+			batch.reserve(s_Watcher.Pending.size());
+			for (PendingChange& pending : s_Watcher.Pending)
+			{
+				if (!pending.Dropped)
+					batch.push_back(std::move(pending.Event));
+			}
+			s_Watcher.Pending.clear();
+			s_Watcher.PendingIndices.clear();
+
+			if (s_Watcher.SkipNextBatch)
+			{
+				s_Watcher.SkipNextBatch = false;
+				return;
+			}
+		}
+
+		if (batch.empty())
+			return;
+
+		// Callbacks may add or remove callbacks
+		auto callbacks = s_Watcher.Callbacks;
+		for (auto& [id, callback] : callbacks)
+			callback(batch);
+	}
+
 }
@@ -13,6 +13,7 @@
 
 #include <functional>
 #include <filesystem>
+#include <vector>
 
 namespace NanoCore {
 
@@ -24,13 +25,49 @@ namespace NanoCore {
 	struct FileSystemChangedEvent
 	{
 		FileSystemAction Action;
+		// Inside the watched directory, the directory itself when its changes couldn't be
+		// told apart (a Modified directory, anything below it may have changed)
 		std::filesystem::path FilePath;
 		bool IsDirectory;
 
-		// If this is a rename event the new name will be in the FilePath
+		// If this is a rename event the new name will be in the FilePath.
+		// Renames only happen within a directory, moves are a Delete and an Added.
 		std::wstring OldName = L"";
 	};
 
+	// Read-only view of a whole file. The pages are mapped instead of copied,
+	// the view stays valid until Close() or destruction. Files in a mounted asset
+	// pack are views into the pack, or decompressed into memory the view owns.
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const std::filesystem::path& filepath) { Open(filepath); }
+		~MappedFile() { Close(); }
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const std::filesystem::path& filepath);
+		void Close();
+
+		const uint8_t* GetData() const { return m_Data; }
+		uint64_t GetSize() const { return m_Size; }
+
+		operator bool() const { return m_Data != nullptr; }
+	private:
+		// Platform mapping of a loose file
+		bool Map(const std::filesystem::path& filepath);
+		void Unmap();
+	private:
+		void* m_FileHandle = nullptr;
+		void* m_MappingHandle = nullptr;
+		const uint8_t* m_Data = nullptr;
+		uint64_t m_Size = 0;
+
+		std::vector<uint8_t> m_Decompressed;
+	};
+
 	class FileSystem
 	{
 	public:
@@ -54,13 +91,37 @@ namespace NanoCore {
 
 		static bool WriteBytes(const std::filesystem::path& filepath, const Buffer& buffer);
 		static Buffer ReadBytes(const std::filesystem::path& filepath);
+		// Uncompressed files in a mounted asset pack come back as a view into the pack's
+		// mapping (isView, valid while the pack is mounted, not released by the caller),
+		// everything else in a new allocation. Empty if the file can't be read.
+		static Buffer ReadBytes(const std::filesystem::path& filepath, bool& isView);
+
+		// Mounted packs are looked at before the disk, the last mounted first. Meant for
+		// startup, mounting isn't synchronized with reads on other threads.
+		static bool MountAssetPack(const std::filesystem::path& packPath);
+		static void UnmountAssetPacks();
 	public:
 		using FileSystemChangedCallbackFn = std::function<void(const std::vector<FileSystemChangedEvent>&)>;
 
-		static void SetChangeCallback(const FileSystemChangedCallbackFn& callback);
+		// Callbacks run on the main thread, returns the id to remove the callback with
+		static uint32_t AddChangeCallback(const FileSystemChangedCallbackFn& callback);
+		static void RemoveChangeCallback(uint32_t id);
+
+		// Watches the asset directory of the active project
 		static void StartWatching();
+		// Forgets every watched directory and stops the watcher thread
 		static void StopWatching();
 
+		// Whole directory trees, all watched by a single thread however many files they hold.
+		// Counted, a directory watched twice stays watched until it's unwatched twice.
+		static void WatchDirectory(const std::filesystem::path& directory);
+		static void UnwatchDirectory(const std::filesystem::path& directory);
+
+		// Hands the changes to the callbacks as one batch once a burst of them settled,
+		// so a save that writes, renames and modifies a file comes out as one change.
+		// Called once per frame.
+		static void DispatchFileSystemChanges();
+
 		static std::filesystem::path OpenFileDialog(const char* filter = "All\0*.*\0");
 		static std::filesystem::path OpenFolderDialog(const char* initialFolder = "");
 		static std::filesystem::path SaveFileDialog(const char* filter = "All\0*.*\0");
@@ -73,9 +134,14 @@ namespace NanoCore {
 		static std::string GetEnvironmentVariable(const std::string& key);
 
 	private:
-		static unsigned long Watch(void* param);
-
-	private:
-		static FileSystemChangedCallbackFn s_Callback;
+		// Platform watcher thread, woken to pick up changes of the watched directories
+		static void StartWatcherThread();
+		static void StopWatcherThread();
+		static void WakeWatcherThread();
+		static void WatcherThread();
+
+		// Used by the watcher thread
+		static std::vector<std::filesystem::path> GetWatchedDirectories();
+		static void QueueFileSystemChanges(std::vector<FileSystemChangedEvent>& events);
 	};
 }
@@ -0,0 +1,158 @@
+#include "ncpch.h"
+#include "FrameAllocator.h"
+
+#include <thread>
+
+namespace NanoCore {
+
+	// Offsets are aligned relative to the block, so the block itself is cache line aligned
+	static constexpr size_t s_ArenaBlockAlignment = 64;
+
+	static size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	LinearArena::LinearArena(size_t capacity)
+		: m_Capacity(capacity)
+	{
+		m_Memory = (uint8_t*)::operator new(capacity, std::align_val_t(s_ArenaBlockAlignment));
+	}
+
+	LinearArena::~LinearArena()
+	{
+		Reset();
+		::operator delete(m_Memory, std::align_val_t(s_ArenaBlockAlignment));
+	}
+
+	void* LinearArena::Allocate(size_t size, size_t alignment)
+	{
+		size_t offset = AlignUp(m_Offset, alignment);
+		if (offset + size <= m_Capacity)
+		{
+			m_Offset = offset + size;
+			m_Peak = std::max(m_Peak, m_Offset + m_OverflowBytes);
+			return m_Memory + offset;
+		}
+
+		// Out of space for this frame, the block is resized to the peak on the next Reset()
+		alignment = std::max(alignment, alignof(std::max_align_t));
+		void* block = ::operator new(size, std::align_val_t(alignment));
+		m_OverflowBlocks.push_back({ block, alignment });
+		m_OverflowBytes += size;
+		m_Peak = std::max(m_Peak, m_Offset + m_OverflowBytes);
+		return block;
+	}
+
+	void LinearArena::Rewind(size_t marker)
+	{
+		NANO_ENGINE_LOG_ASSERT(marker <= m_Offset, "Arena scopes must be released in reverse order!");
+		m_Offset = marker;
+	}
+
+	void LinearArena::Reset()
+	{
+		for (auto& [block, alignment] : m_OverflowBlocks)
+			::operator delete(block, std::align_val_t(alignment));
+		m_OverflowBlocks.clear();
+
+		if (m_OverflowBytes > 0)
+		{
+			size_t capacity = m_Capacity;
+			while (capacity < m_Peak)
+				capacity *= 2;
+
+			NANO_ENGINE_LOG_WARN("Linear arena overflowed by {} bytes, growing it from {} to {} bytes", m_OverflowBytes, m_Capacity, capacity);
+
+			::operator delete(m_Memory, std::align_val_t(s_ArenaBlockAlignment));
+			m_Memory = (uint8_t*)::operator new(capacity, std::align_val_t(s_ArenaBlockAlignment));
+			m_Capacity = capacity;
+		}
+
+		m_Offset = 0;
+		m_Peak = 0;
+		m_OverflowBytes = 0;
+	}
+
+	ArenaScope::ArenaScope()
+		: ArenaScope(FrameAllocator::GetArena())
+	{
+	}
+
+	ArenaScope::ArenaScope(LinearArena& arena)
+		: m_Arena(arena), m_Marker(arena.GetMarker())
+	{
+	}
+
+	ArenaScope::~ArenaScope()
+	{
+		// Destroyed in reverse order of construction
+		for (Destructor* destructor = m_Destructors; destructor; destructor = destructor->Next)
+			destructor->Destroy(destructor->Object);
+
+		m_Arena.Rewind(m_Marker);
+	}
+
+	struct FrameAllocatorData
+	{
+		std::array<Unique<LinearArena>, 2> Arenas;
+		uint32_t CurrentArena = 0;
+
+		std::thread::id OwnerThread;
+		FrameAllocatorStats Stats;
+	};
+
+	static FrameAllocatorData* s_Data = nullptr;
+
+	void FrameAllocator::Init(size_t capacity)
+	{
+		s_Data = new FrameAllocatorData();
+		for (auto& arena : s_Data->Arenas)
+			arena = std::make_unique<LinearArena>(capacity);
+
+		s_Data->OwnerThread = std::this_thread::get_id();
+		s_Data->Stats.Capacity = capacity;
+	}
+
+	void FrameAllocator::Shutdown()
+	{
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	void FrameAllocator::EndFrame()
+	{
+		RA_PROFILE_FUNCTION();
+
+		LinearArena& finished = *s_Data->Arenas[s_Data->CurrentArena];
+
+		FrameAllocatorStats& stats = s_Data->Stats;
+		stats.LastFramePeak = finished.GetPeak();
+		stats.LastFrameOverflow = finished.GetOverflow();
+		stats.HighWaterMark = std::max(stats.HighWaterMark, stats.LastFramePeak);
+
+		// The other arena holds the frame before the one that just finished, nothing references it anymore
+		s_Data->CurrentArena ^= 1;
+		LinearArena& next = *s_Data->Arenas[s_Data->CurrentArena];
+		next.Reset();
+
+		stats.Capacity = next.GetCapacity();
+	}
+
+	LinearArena& FrameAllocator::GetArena()
+	{
+		NANO_ENGINE_LOG_ASSERT(IsOwnerThread(), "Frame memory can only be used on the main thread!");
+		return *s_Data->Arenas[s_Data->CurrentArena];
+	}
+
+	bool FrameAllocator::IsOwnerThread()
+	{
+		return s_Data && std::this_thread::get_id() == s_Data->OwnerThread;
+	}
+
+	const FrameAllocatorStats& FrameAllocator::GetStats()
+	{
+		return s_Data->Stats;
+	}
+
+}
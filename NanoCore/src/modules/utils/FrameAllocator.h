@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace NanoCore {
+
+	// Bump allocator over one fixed block. Allocations are freed all at once by
+	// Reset() or Rewind(), destructors are never run by the arena itself.
+	// Requests that don't fit spill to the heap and the block grows on the next Reset().
+	class LinearArena
+	{
+	public:
+		LinearArena(size_t capacity);
+		~LinearArena();
+
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		size_t GetMarker() const { return m_Offset; }
+		// Frees everything allocated after the marker was taken
+		void Rewind(size_t marker);
+		void Reset();
+
+		size_t GetCapacity() const { return m_Capacity; }
+		size_t GetUsed() const { return m_Offset; }
+		// Highest usage since the last Reset(), including spilled bytes
+		size_t GetPeak() const { return m_Peak; }
+		size_t GetOverflow() const { return m_OverflowBytes; }
+	private:
+		uint8_t* m_Memory = nullptr;
+		size_t m_Capacity = 0;
+		size_t m_Offset = 0;
+		size_t m_Peak = 0;
+
+		// Spilled allocations and their alignment, freed on Reset()
+		std::vector<std::pair<void*, size_t>> m_OverflowBlocks;
+		size_t m_OverflowBytes = 0;
+	};
+
+	// Scratch allocations that are released when the scope ends, in LIFO order
+	// with other scopes on the same arena. Objects made with New() are destroyed.
+	// Anything else allocated from the arena while the scope is open goes with it.
+	class ArenaScope
+	{
+	public:
+		ArenaScope();
+		ArenaScope(LinearArena& arena);
+		~ArenaScope();
+
+		ArenaScope(const ArenaScope&) = delete;
+		ArenaScope& operator=(const ArenaScope&) = delete;
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+		{
+			return m_Arena.Allocate(size, alignment);
+		}
+
+		template<typename T>
+		T* AllocateArray(size_t count)
+		{
+			static_assert(std::is_trivially_destructible_v<T>, "Use New() for types with destructors");
+			return (T*)m_Arena.Allocate(sizeof(T) * count, alignof(T));
+		}
+
+		template<typename T, typename... Args>
+		T* New(Args&&... args)
+		{
+			T* object = new (m_Arena.Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			if constexpr (!std::is_trivially_destructible_v<T>)
+			{
+				Destructor* destructor = (Destructor*)m_Arena.Allocate(sizeof(Destructor), alignof(Destructor));
+				destructor->Destroy = [](void* instance) { ((T*)instance)->~T(); };
+				destructor->Object = object;
+				destructor->Next = m_Destructors;
+				m_Destructors = destructor;
+			}
+			return object;
+		}
+
+		LinearArena& GetArena() { return m_Arena; }
+	private:
+		struct Destructor
+		{
+			void (*Destroy)(void*);
+			void* Object;
+			Destructor* Next;
+		};
+
+		LinearArena& m_Arena;
+		size_t m_Marker;
+		Destructor* m_Destructors = nullptr;
+	};
+
+	// STL allocator on a LinearArena, deallocation is a no-op
+	template<typename T>
+	class ArenaAllocator
+	{
+	public:
+		using value_type = T;
+
+		ArenaAllocator(LinearArena& arena) : m_Arena(&arena) {}
+
+		template<typename T2>
+		ArenaAllocator(const ArenaAllocator<T2>& other) : m_Arena(other.m_Arena) {}
+
+		T* allocate(size_t count) { return (T*)m_Arena->Allocate(sizeof(T) * count, alignof(T)); }
+		void deallocate(T*, size_t) {}
+
+		template<typename T2>
+		bool operator==(const ArenaAllocator<T2>& other) const { return m_Arena == other.m_Arena; }
+		template<typename T2>
+		bool operator!=(const ArenaAllocator<T2>& other) const { return m_Arena != other.m_Arena; }
+	private:
+		LinearArena* m_Arena;
+
+		template<typename T2>
+		friend class ArenaAllocator;
+	};
+
+	template<typename T>
+	using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+	struct FrameAllocatorStats
+	{
+		size_t Capacity = 0;
+		// Peak usage of the last finished frame and of any frame so far
+		size_t LastFramePeak = 0;
+		size_t HighWaterMark = 0;
+		// Bytes the last frame had to take from the heap
+		size_t LastFrameOverflow = 0;
+	};
+
+	// Two arenas alternating per frame, so frame memory stays valid until the end
+	// of the next frame (events queued in one frame are handled at the start of the next).
+	// Owned by the main thread, other threads must not allocate from it.
+	class FrameAllocator
+	{
+	public:
+		static void Init(size_t capacity = 4 * 1024 * 1024);
+		static void Shutdown();
+
+		// Called once at the end of every frame by Application::Run
+		static void EndFrame();
+
+		static LinearArena& GetArena();
+		static bool IsOwnerThread();
+
+		static void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+		{
+			return GetArena().Allocate(size, alignment);
+		}
+
+		template<typename T>
+		static ArenaAllocator<T> GetSTLAllocator() { return ArenaAllocator<T>(GetArena()); }
+
+		static const FrameAllocatorStats& GetStats();
+	};
+
+}
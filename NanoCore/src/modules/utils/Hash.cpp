@@ -0,0 +1,387 @@
+#include "ncpch.h"
+#include "Hash.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+	#define NANO_CRC32C_HARDWARE
+	#include <nmmintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+		#define NANO_TARGET_SSE42
+	#else
+		#include <cpuid.h>
+		#define NANO_TARGET_SSE42 __attribute__((target("sse4.2")))
+	#endif
+#endif
+
+namespace NanoCore {
+
+	static uint32_t Read32(const uint8_t* data)
+	{
+		uint32_t value;
+		memcpy(&value, data, sizeof(uint32_t));
+		return value;
+	}
+
+	static uint64_t Read64(const uint8_t* data)
+	{
+		uint64_t value;
+		memcpy(&value, data, sizeof(uint64_t));
+		return value;
+	}
+
+	static uint64_t RotateLeft(uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// CRC32C ////////////////////////////////////////////////////////////////
+	//////////////////////////////////////////////////////////////////////////
+
+	// Reflected Castagnoli polynomial
+	static constexpr uint32_t CRC32CPolynomial = 0x82F63B78;
+
+	// Slice k gives the CRC of a byte followed by k zero bytes, so 8 lookups process 8 bytes
+	struct CRC32CSlices
+	{
+		uint32_t Table[8][256] = {};
+
+		constexpr CRC32CSlices()
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t crc = i;
+				for (int bit = 0; bit < 8; bit++)
+					crc = (crc >> 1) ^ (CRC32CPolynomial & (0u - (crc & 1)));
+				Table[0][i] = crc;
+			}
+
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				for (int slice = 1; slice < 8; slice++)
+					Table[slice][i] = (Table[slice - 1][i] >> 8) ^ Table[0][Table[slice - 1][i] & 0xFF];
+			}
+		}
+	};
+
+	static constexpr CRC32CSlices s_CRC32CSlices;
+
+	static uint32_t CRC32CSoftware(uint32_t crc, const uint8_t* data, size_t size)
+	{
+		const auto& table = s_CRC32CSlices.Table;
+
+		for (; size >= 8; size -= 8, data += 8)
+		{
+			uint32_t low = Read32(data) ^ crc;
+			uint32_t high = Read32(data + 4);
+			crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24]
+				^ table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^ table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+		}
+
+		for (; size > 0; size--, data++)
+			crc = (crc >> 8) ^ table[0][(crc ^ *data) & 0xFF];
+
+		return crc;
+	}
+
+#ifdef NANO_CRC32C_HARDWARE
+
+	// The crc32 instruction has a latency of 3 cycles, so long blobs are hashed as three
+	// interleaved streams. The CRCs of the first two are then shifted over the bytes that
+	// follow them with a table per block size and combined.
+	static constexpr size_t CRC32CLongBlock = 8192;
+	static constexpr size_t CRC32CShortBlock = 256;
+
+	// Multiplies a vector by a 32x32 matrix over GF(2)
+	static uint32_t GF2MatrixTimes(const uint32_t* matrix, uint32_t vector)
+	{
+		uint32_t sum = 0;
+		for (; vector; vector >>= 1, matrix++)
+		{
+			if (vector & 1)
+				sum ^= *matrix;
+		}
+		return sum;
+	}
+
+	static void GF2MatrixSquare(uint32_t* square, const uint32_t* matrix)
+	{
+		for (int n = 0; n < 32; n++)
+			square[n] = GF2MatrixTimes(matrix, matrix[n]);
+	}
+
+	// Lookup tables that append size zero bytes to a CRC
+	struct CRC32CShift
+	{
+		uint32_t Table[4][256];
+
+		CRC32CShift(size_t size)
+		{
+			// Operator for one zero bit, squared up to one zero byte and then per bit of size
+			uint32_t odd[32];
+			uint32_t even[32];
+			odd[0] = CRC32CPolynomial;
+			for (int n = 1; n < 32; n++)
+				odd[n] = 1u << (n - 1);
+
+			GF2MatrixSquare(even, odd);
+			GF2MatrixSquare(odd, even);
+
+			const uint32_t* op = nullptr;
+			while (true)
+			{
+				GF2MatrixSquare(even, odd);
+				size >>= 1;
+				if (size == 0)
+				{
+					op = even;
+					break;
+				}
+
+				GF2MatrixSquare(odd, even);
+				size >>= 1;
+				if (size == 0)
+				{
+					op = odd;
+					break;
+				}
+			}
+
+			for (uint32_t n = 0; n < 256; n++)
+			{
+				Table[0][n] = GF2MatrixTimes(op, n);
+				Table[1][n] = GF2MatrixTimes(op, n << 8);
+				Table[2][n] = GF2MatrixTimes(op, n << 16);
+				Table[3][n] = GF2MatrixTimes(op, n << 24);
+			}
+		}
+
+		uint32_t operator()(uint32_t crc) const
+		{
+			return Table[0][crc & 0xFF] ^ Table[1][(crc >> 8) & 0xFF] ^ Table[2][(crc >> 16) & 0xFF] ^ Table[3][crc >> 24];
+		}
+	};
+
+	static bool HasCRC32Instruction()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 20)) != 0;
+#else
+		unsigned int eax, ebx, ecx, edx;
+		return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_2);
+#endif
+	}
+
+	NANO_TARGET_SSE42 static uint32_t CRC32CStreams(uint32_t crc, const uint8_t*& data, size_t& size, size_t blockSize, const CRC32CShift& shift)
+	{
+		uint64_t crc0 = crc;
+		while (size >= blockSize * 3)
+		{
+			uint64_t crc1 = 0;
+			uint64_t crc2 = 0;
+			const uint8_t* end = data + blockSize;
+			for (; data < end; data += 8)
+			{
+				crc0 = _mm_crc32_u64(crc0, Read64(data));
+				crc1 = _mm_crc32_u64(crc1, Read64(data + blockSize));
+				crc2 = _mm_crc32_u64(crc2, Read64(data + blockSize * 2));
+			}
+
+			crc0 = shift((uint32_t)crc0) ^ (uint32_t)crc1;
+			crc0 = shift((uint32_t)crc0) ^ (uint32_t)crc2;
+			data += blockSize * 2;
+			size -= blockSize * 3;
+		}
+		return (uint32_t)crc0;
+	}
+
+	NANO_TARGET_SSE42 static uint32_t CRC32CHardware(uint32_t crc, const uint8_t* data, size_t size)
+	{
+		static const CRC32CShift s_LongShift(CRC32CLongBlock);
+		static const CRC32CShift s_ShortShift(CRC32CShortBlock);
+
+		for (; size > 0 && ((uintptr_t)data & 7); size--, data++)
+			crc = _mm_crc32_u8(crc, *data);
+
+		crc = CRC32CStreams(crc, data, size, CRC32CLongBlock, s_LongShift);
+		crc = CRC32CStreams(crc, data, size, CRC32CShortBlock, s_ShortShift);
+
+		uint64_t crc64 = crc;
+		for (; size >= 8; size -= 8, data += 8)
+			crc64 = _mm_crc32_u64(crc64, Read64(data));
+		crc = (uint32_t)crc64;
+
+		for (; size > 0; size--, data++)
+			crc = _mm_crc32_u8(crc, *data);
+
+		return crc;
+	}
+
+#endif
+
+	uint32_t Hash::CRC32C(const void* data, size_t size, uint32_t crc)
+	{
+		crc = ~crc;
+
+#ifdef NANO_CRC32C_HARDWARE
+		static const bool s_Hardware = HasCRC32Instruction();
+		if (s_Hardware)
+			return ~CRC32CHardware(crc, (const uint8_t*)data, size);
+#endif
+
+		return ~CRC32CSoftware(crc, (const uint8_t*)data, size);
+	}
+
+	uint32_t Hash::CRC32(const char* str)
+	{
+		return CRC32C(str, strlen(str));
+	}
+
+	uint32_t Hash::CRC32(const std::string& string)
+	{
+		return CRC32C(string.data(), string.size());
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Hash64 ////////////////////////////////////////////////////////////////
+	//////////////////////////////////////////////////////////////////////////
+
+	static constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+	static constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+	static constexpr uint64_t Prime3 = 0x165667B19E3779F9ull;
+	static constexpr uint64_t Prime4 = 0x85EBCA77C2B2AE63ull;
+	static constexpr uint64_t Prime5 = 0x27D4EB2F165667C5ull;
+
+	static constexpr size_t StripeSize = 32;
+
+	static uint64_t Round(uint64_t accumulator, uint64_t input)
+	{
+		accumulator += input * Prime2;
+		accumulator = RotateLeft(accumulator, 31);
+		return accumulator * Prime1;
+	}
+
+	static uint64_t MergeRound(uint64_t hash, uint64_t accumulator)
+	{
+		hash ^= Round(0, accumulator);
+		return hash * Prime1 + Prime4;
+	}
+
+	// Consumes whole 32 byte stripes, four independent lanes of 8 bytes each
+	static const uint8_t* ProcessStripes(uint64_t* accumulators, const uint8_t* data, size_t size)
+	{
+		uint64_t v1 = accumulators[0], v2 = accumulators[1], v3 = accumulators[2], v4 = accumulators[3];
+		const uint8_t* end = data + size - size % StripeSize;
+		for (; data < end; data += StripeSize)
+		{
+			v1 = Round(v1, Read64(data));
+			v2 = Round(v2, Read64(data + 8));
+			v3 = Round(v3, Read64(data + 16));
+			v4 = Round(v4, Read64(data + 24));
+		}
+		accumulators[0] = v1; accumulators[1] = v2; accumulators[2] = v3; accumulators[3] = v4;
+		return data;
+	}
+
+	static uint64_t FinalizeHash64(uint64_t hash, const uint8_t* tail, size_t size)
+	{
+		for (; size >= 8; size -= 8, tail += 8)
+		{
+			hash ^= Round(0, Read64(tail));
+			hash = RotateLeft(hash, 27) * Prime1 + Prime4;
+		}
+
+		if (size >= 4)
+		{
+			hash ^= (uint64_t)Read32(tail) * Prime1;
+			hash = RotateLeft(hash, 23) * Prime2 + Prime3;
+			size -= 4;
+			tail += 4;
+		}
+
+		for (; size > 0; size--, tail++)
+		{
+			hash ^= *tail * Prime5;
+			hash = RotateLeft(hash, 11) * Prime1;
+		}
+
+		hash ^= hash >> 33;
+		hash *= Prime2;
+		hash ^= hash >> 29;
+		hash *= Prime3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	static uint64_t MergeAccumulators(const uint64_t* accumulators)
+	{
+		uint64_t hash = RotateLeft(accumulators[0], 1) + RotateLeft(accumulators[1], 7) + RotateLeft(accumulators[2], 12) + RotateLeft(accumulators[3], 18);
+		for (int i = 0; i < 4; i++)
+			hash = MergeRound(hash, accumulators[i]);
+		return hash;
+	}
+
+	uint64_t Hash::Hash64(const void* data, size_t size, uint64_t seed)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+
+		uint64_t hash;
+		if (size >= StripeSize)
+		{
+			uint64_t accumulators[4] = { seed + Prime1 + Prime2, seed + Prime2, seed, seed - Prime1 };
+			const uint8_t* tail = ProcessStripes(accumulators, bytes, size);
+			hash = MergeAccumulators(accumulators) + size;
+			return FinalizeHash64(hash, tail, size % StripeSize);
+		}
+
+		hash = seed + Prime5 + size;
+		return FinalizeHash64(hash, bytes, size);
+	}
+
+	void StreamingHash64::Reset(uint64_t seed)
+	{
+		m_Seed = seed;
+		m_Accumulators[0] = seed + Prime1 + Prime2;
+		m_Accumulators[1] = seed + Prime2;
+		m_Accumulators[2] = seed;
+		m_Accumulators[3] = seed - Prime1;
+		m_TotalSize = 0;
+		m_BufferSize = 0;
+	}
+
+	void StreamingHash64::Update(const void* data, size_t size)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		m_TotalSize += size;
+
+		if (m_BufferSize + size < StripeSize)
+		{
+			memcpy(m_Buffer + m_BufferSize, bytes, size);
+			m_BufferSize += (uint32_t)size;
+			return;
+		}
+
+		if (m_BufferSize > 0)
+		{
+			const size_t fill = StripeSize - m_BufferSize;
+			memcpy(m_Buffer + m_BufferSize, bytes, fill);
+			ProcessStripes(m_Accumulators, m_Buffer, StripeSize);
+			bytes += fill;
+			size -= fill;
+			m_BufferSize = 0;
+		}
+
+		const uint8_t* tail = ProcessStripes(m_Accumulators, bytes, size);
+		m_BufferSize = (uint32_t)(bytes + size - tail);
+		memcpy(m_Buffer, tail, m_BufferSize);
+	}
+
+	uint64_t StreamingHash64::GetHash() const
+	{
+		uint64_t hash = m_TotalSize >= StripeSize ? MergeAccumulators(m_Accumulators) : m_Seed + Prime5;
+		return FinalizeHash64(hash + m_TotalSize, m_Buffer, m_BufferSize);
+	}
+
+}
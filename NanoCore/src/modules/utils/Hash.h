@@ -25,7 +25,47 @@ namespace NanoCore {
 			return GenerateFNVHash(string.data());
 		}
 
+		// CRC32C of the characters, see CRC32C
 		static uint32_t CRC32(const char* str);
 		static uint32_t CRC32(const std::string& string);
+
+		// CRC32C (Castagnoli) of a blob, with the SSE4.2 crc32 instruction when the CPU has it.
+		// Blobs hashed in pieces pass the previous result in as crc.
+		static uint32_t CRC32C(const void* data, size_t size, uint32_t crc = 0);
+
+		// 64-bit non-cryptographic hash for content keys, bit-compatible with XXH64.
+		// Many times faster than FNV on large blobs.
+		static uint64_t Hash64(const void* data, size_t size, uint64_t seed = 0);
+		static uint64_t Hash64(std::string_view string, uint64_t seed = 0) { return Hash64(string.data(), string.size(), seed); }
+	};
+
+	// Hash::CRC32C of data fed in pieces
+	class StreamingCRC32C
+	{
+	public:
+		void Update(const void* data, size_t size) { m_CRC = Hash::CRC32C(data, size, m_CRC); }
+		uint32_t GetHash() const { return m_CRC; }
+		void Reset() { m_CRC = 0; }
+	private:
+		uint32_t m_CRC = 0;
+	};
+
+	// Hash::Hash64 of data fed in pieces, gives the same result as hashing it in one go
+	class StreamingHash64
+	{
+	public:
+		StreamingHash64(uint64_t seed = 0) { Reset(seed); }
+
+		void Update(const void* data, size_t size);
+		uint64_t GetHash() const;
+		void Reset(uint64_t seed = 0);
+	private:
+		uint64_t m_Seed = 0;
+		uint64_t m_Accumulators[4] = {};
+		uint64_t m_TotalSize = 0;
+
+		// Tail shorter than a 32 byte stripe
+		uint8_t m_Buffer[32] = {};
+		uint32_t m_BufferSize = 0;
 	};
-}
\ No newline at end of file
+}
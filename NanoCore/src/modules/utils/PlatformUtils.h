@@ -15,7 +15,7 @@ namespace NanoCore{
 	class Time
 	{
 	public:
-		static float GetTime();
+		static double GetTime();
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include "ncpch.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+namespace NanoCore {
+
+	struct ParallelForJob
+	{
+		const std::function<void(size_t, size_t)>* Function = nullptr;
+		size_t Count = 0;
+		size_t GrainSize = 0;
+		size_t ChunkCount = 0;
+
+		std::atomic<size_t> NextChunk = 0;
+		std::atomic<size_t> FinishedChunks = 0;
+
+		std::mutex Mutex;
+		std::condition_variable Finished;
+		std::exception_ptr Exception;
+
+		// Owned by the job for Submit, nobody waits on those
+		std::function<void(size_t, size_t)> Task;
+	};
+
+	struct ThreadPoolData
+	{
+		std::vector<std::thread> Workers;
+
+		std::mutex QueueMutex;
+		std::condition_variable QueueCondition;
+		std::deque<std::shared_ptr<ParallelForJob>> Queue;
+		bool Stopping = false;
+	};
+
+	static ThreadPoolData* s_Data = nullptr;
+
+	// Runs chunks until none are left, returns once this thread can't take any more
+	static void RunChunks(ParallelForJob& job)
+	{
+		size_t chunk;
+		while ((chunk = job.NextChunk.fetch_add(1)) < job.ChunkCount)
+		{
+			size_t first = chunk * job.GrainSize;
+			size_t last = std::min(first + job.GrainSize, job.Count);
+
+			try
+			{
+				(*job.Function)(first, last);
+			}
+			catch (...)
+			{
+				std::scoped_lock<std::mutex> lock(job.Mutex);
+				if (!job.Exception)
+					job.Exception = std::current_exception();
+			}
+
+			if (job.FinishedChunks.fetch_add(1) + 1 == job.ChunkCount)
+			{
+				std::scoped_lock<std::mutex> lock(job.Mutex);
+				job.Finished.notify_all();
+			}
+		}
+	}
+
+	static void WorkerThread()
+	{
+		while (true)
+		{
+			std::shared_ptr<ParallelForJob> job;
+			{
+				std::unique_lock<std::mutex> lock(s_Data->QueueMutex);
+				s_Data->QueueCondition.wait(lock, [] { return s_Data->Stopping || !s_Data->Queue.empty(); });
+				if (s_Data->Queue.empty())
+					return;
+
+				job = std::move(s_Data->Queue.front());
+				s_Data->Queue.pop_front();
+			}
+
+			RunChunks(*job);
+		}
+	}
+
+	void ThreadPool::Init(uint32_t workerCount)
+	{
+		s_Data = new ThreadPoolData();
+
+		if (workerCount == 0)
+			workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+		s_Data->Workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; i++)
+			s_Data->Workers.emplace_back(WorkerThread);
+
+		NANO_ENGINE_LOG_INFO("Thread pool started with {} workers", workerCount);
+	}
+
+	void ThreadPool::Shutdown()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(s_Data->QueueMutex);
+			s_Data->Stopping = true;
+		}
+		s_Data->QueueCondition.notify_all();
+
+		for (std::thread& worker : s_Data->Workers)
+			worker.join();
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	uint32_t ThreadPool::GetWorkerCount()
+	{
+		return s_Data ? (uint32_t)s_Data->Workers.size() : 0;
+	}
+
+	void ThreadPool::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& fn)
+	{
+		if (count == 0)
+			return;
+
+		grainSize = std::max<size_t>(grainSize, 1);
+		size_t chunkCount = (count + grainSize - 1) / grainSize;
+		if (chunkCount == 1 || GetWorkerCount() == 0)
+		{
+			fn(0, count);
+			return;
+		}
+
+		auto job = std::make_shared<ParallelForJob>();
+		job->Function = &fn;
+		job->Count = count;
+		job->GrainSize = grainSize;
+		job->ChunkCount = chunkCount;
+
+		// One queue entry per helping worker, each takes chunks until the job runs dry.
+		// Entries picked up after that return without touching fn.
+		size_t helpers = std::min<size_t>(chunkCount - 1, s_Data->Workers.size());
+		{
+			std::scoped_lock<std::mutex> lock(s_Data->QueueMutex);
+			for (size_t i = 0; i < helpers; i++)
+				s_Data->Queue.push_back(job);
+		}
+		s_Data->QueueCondition.notify_all();
+
+		RunChunks(*job);
+
+		{
+			std::unique_lock<std::mutex> lock(job->Mutex);
+			job->Finished.wait(lock, [&] { return job->FinishedChunks.load() == job->ChunkCount; });
+		}
+
+		if (job->Exception)
+			std::rethrow_exception(job->Exception);
+	}
+
+	void ThreadPool::Submit(std::function<void()> fn)
+	{
+		auto task = [fn = std::move(fn)](size_t, size_t)
+		{
+			try
+			{
+				fn();
+			}
+			catch (const std::exception& e)
+			{
+				NANO_ENGINE_LOG_ERROR("Background task failed: {}", e.what());
+			}
+		};
+
+		if (GetWorkerCount() == 0)
+		{
+			task(0, 1);
+			return;
+		}
+
+		auto job = std::make_shared<ParallelForJob>();
+		job->Task = std::move(task);
+		job->Function = &job->Task;
+		job->Count = 1;
+		job->GrainSize = 1;
+		job->ChunkCount = 1;
+
+		{
+			std::scoped_lock<std::mutex> lock(s_Data->QueueMutex);
+			s_Data->Queue.push_back(std::move(job));
+		}
+		s_Data->QueueCondition.notify_one();
+	}
+
+}
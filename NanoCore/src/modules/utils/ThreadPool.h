@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace NanoCore {
+
+	// Fixed set of worker threads for data-parallel loops.
+	// The calling thread takes part in the work, so ParallelFor also runs before
+	// Init() or on a single core, just without the speedup.
+	class ThreadPool
+	{
+	public:
+		// 0 uses one worker per hardware thread, minus the main thread
+		static void Init(uint32_t workerCount = 0);
+		static void Shutdown();
+
+		static uint32_t GetWorkerCount();
+
+		// Calls fn(first, last) for consecutive ranges of at most grainSize items and
+		// returns once all of them are done. Exceptions thrown by fn are rethrown here.
+		static void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& fn);
+
+		// Runs fn on a worker and returns right away, or runs it here when there are no
+		// workers. Meant for background work like asset loads; a worker busy with one only
+		// slows ParallelFor down, the caller still works through the loop itself.
+		static void Submit(std::function<void()> fn);
+	};
+
+}
@@ -16,36 +16,222 @@
 #include <Shlobj.h>
 
 #include <filesystem>
+#include <thread>
+#include <atomic>
 
 namespace NanoCore {
 
-	FileSystem::FileSystemChangedCallbackFn FileSystem::s_Callback;
+	//////////////////////////////////////////////////////////////////////////
+	// Watcher ///////////////////////////////////////////////////////////////
+	//////////////////////////////////////////////////////////////////////////
 
-	static bool s_Watching = false;
-	static bool s_IgnoreNextChange = false;
-	static HANDLE s_WatcherThread;
+	struct WatchedDirectory
+	{
+		std::filesystem::path Path;
+		HANDLE Handle = INVALID_HANDLE_VALUE;
+		OVERLAPPED Overlapped = {};
+		// ReadDirectoryChangesW needs it DWORD aligned, 64KB is its limit for network drives
+		alignas(DWORD) uint8_t Buffer[64 * 1024];
+	};
+
+	static std::thread s_WatcherThread;
+	static HANDLE s_WatcherWakeEvent = nullptr;
+	static std::atomic<bool> s_WatcherStopping = false;
+
+	static bool ReadDirectoryChanges(WatchedDirectory& directory)
+	{
+		return ReadDirectoryChangesW(directory.Handle, directory.Buffer, sizeof(directory.Buffer), TRUE,
+			FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE,
+			nullptr, &directory.Overlapped, nullptr);
+	}
 
-	void FileSystem::SetChangeCallback(const FileSystemChangedCallbackFn& callback)
+	static Unique<WatchedDirectory> OpenWatchedDirectory(const std::filesystem::path& path)
 	{
-		s_Callback = callback;
+		auto directory = std::make_unique<WatchedDirectory>();
+		directory->Path = path;
+		directory->Handle = CreateFileW(path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+		if (directory->Handle == INVALID_HANDLE_VALUE)
+		{
+			NANO_ENGINE_LOG_ERROR("Can't watch directory '{}'", path.string());
+			return nullptr;
+		}
+
+		directory->Overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+		if (!ReadDirectoryChanges(*directory))
+		{
+			NANO_ENGINE_LOG_ERROR("Can't watch directory '{}'", path.string());
+			CloseHandle(directory->Overlapped.hEvent);
+			CloseHandle(directory->Handle);
+			return nullptr;
+		}
+		return directory;
 	}
 
-	void FileSystem::StartWatching()
+	static void CloseWatchedDirectory(WatchedDirectory& directory)
 	{
-		s_Watching = true;
-		DWORD threadId;
-		s_WatcherThread = CreateThread(NULL, 0, Watch, 0, 0, &threadId);
-		SetThreadDescription(s_WatcherThread, L"Hazel FileSystemWatcher");
+		// The pending read writes into the buffer until it is cancelled
+		DWORD bytes;
+		CancelIoEx(directory.Handle, &directory.Overlapped);
+		GetOverlappedResult(directory.Handle, &directory.Overlapped, &bytes, TRUE);
+		CloseHandle(directory.Overlapped.hEvent);
+		CloseHandle(directory.Handle);
 	}
 
-	void FileSystem::StopWatching()
+	static void ParseDirectoryChanges(const WatchedDirectory& directory, std::vector<FileSystemChangedEvent>& events)
 	{
-		if (!s_Watching)
-			return;
+		std::filesystem::path oldPath;
+
+		const uint8_t* data = directory.Buffer;
+		while (true)
+		{
+			const FILE_NOTIFY_INFORMATION* notify = (const FILE_NOTIFY_INFORMATION*)data;
+
+			FileSystemChangedEvent e;
+			e.FilePath = directory.Path / std::wstring(notify->FileName, notify->FileNameLength / sizeof(wchar_t));
+			std::error_code error;
+			e.IsDirectory = std::filesystem::is_directory(e.FilePath, error);
 
-		s_Watching = false;
-		TerminateThread(s_WatcherThread, 0);
-		CloseHandle(s_WatcherThread);
+			switch (notify->Action)
+			{
+				case FILE_ACTION_ADDED:    e.Action = FileSystemAction::Added; break;
+				case FILE_ACTION_REMOVED:  e.Action = FileSystemAction::Delete; break;
+				case FILE_ACTION_MODIFIED: e.Action = FileSystemAction::Modified; break;
+				case FILE_ACTION_RENAMED_OLD_NAME:
+				{
+					oldPath = e.FilePath;
+					break;
+				}
+				case FILE_ACTION_RENAMED_NEW_NAME:
+				{
+					if (oldPath.parent_path() == e.FilePath.parent_path())
+					{
+						e.Action = FileSystemAction::Rename;
+						e.OldName = oldPath.filename().wstring();
+					}
+					else
+					{
+						events.push_back({ FileSystemAction::Delete, oldPath, e.IsDirectory });
+						e.Action = FileSystemAction::Added;
+					}
+					break;
+				}
+			}
+
+			// Directories report a change whenever a file in them does
+			bool directoryModified = e.IsDirectory && notify->Action == FILE_ACTION_MODIFIED;
+			if (notify->Action != FILE_ACTION_RENAMED_OLD_NAME && !directoryModified)
+				events.push_back(std::move(e));
+
+			if (notify->NextEntryOffset == 0)
+				break;
+			data += notify->NextEntryOffset;
+		}
+	}
+
+	void FileSystem::WatcherThread()
+	{
+		std::vector<Unique<WatchedDirectory>> directories;
+		std::vector<HANDLE> waitHandles;
+		std::vector<FileSystemChangedEvent> events;
+
+		while (!s_WatcherStopping)
+		{
+			// Picks up directories added or removed since the last wake
+			std::vector<std::filesystem::path> paths = FileSystem::GetWatchedDirectories();
+			for (auto it = directories.begin(); it != directories.end();)
+			{
+				if (std::find(paths.begin(), paths.end(), (*it)->Path) == paths.end())
+				{
+					CloseWatchedDirectory(**it);
+					it = directories.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+			for (const auto& path : paths)
+			{
+				auto watched = [&](const Unique<WatchedDirectory>& directory) { return directory->Path == path; };
+				if (std::find_if(directories.begin(), directories.end(), watched) != directories.end())
+					continue;
+
+				// One wait handle is the wake event
+				if (directories.size() == MAXIMUM_WAIT_OBJECTS - 1)
+				{
+					NANO_ENGINE_LOG_ERROR("Can't watch directory '{}', {} directory trees are watched already", path.string(), directories.size());
+					continue;
+				}
+
+				if (auto directory = OpenWatchedDirectory(path))
+					directories.push_back(std::move(directory));
+			}
+
+			waitHandles.clear();
+			waitHandles.push_back(s_WatcherWakeEvent);
+			for (const auto& directory : directories)
+				waitHandles.push_back(directory->Overlapped.hEvent);
+
+			// Stays in here until something changes on disk or the watched directories do
+			while (true)
+			{
+				DWORD result = WaitForMultipleObjects((DWORD)waitHandles.size(), waitHandles.data(), FALSE, INFINITE);
+				if (result == WAIT_OBJECT_0)
+					break;
+				if (result == WAIT_FAILED)
+				{
+					NANO_ENGINE_LOG_ERROR("File system watcher stopped, waiting for changes failed");
+					s_WatcherStopping = true;
+					break;
+				}
+
+				WatchedDirectory& directory = *directories[result - WAIT_OBJECT_0 - 1];
+				DWORD bytes = 0;
+				if (!GetOverlappedResult(directory.Handle, &directory.Overlapped, &bytes, FALSE))
+				{
+					NANO_ENGINE_LOG_WARN("Stopped watching '{}', it can't be read anymore", directory.Path.string());
+					FileSystem::UnwatchDirectory(directory.Path);
+					break;
+				}
+
+				// An empty result means the buffer overflowed and the changes were lost
+				if (bytes == 0)
+					events.push_back({ FileSystemAction::Modified, directory.Path, true });
+				else
+					ParseDirectoryChanges(directory, events);
+				FileSystem::QueueFileSystemChanges(events);
+
+				ResetEvent(directory.Overlapped.hEvent);
+				ReadDirectoryChanges(directory);
+			}
+		}
+
+		for (auto& directory : directories)
+			CloseWatchedDirectory(*directory);
+	}
+
+	void FileSystem::StartWatcherThread()
+	{
+		s_WatcherStopping = false;
+		s_WatcherWakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+		s_WatcherThread = std::thread(&FileSystem::WatcherThread);
+		SetThreadDescription(s_WatcherThread.native_handle(), L"NanoCore FileSystemWatcher");
+	}
+
+	void FileSystem::StopWatcherThread()
+	{
+		s_WatcherStopping = true;
+		SetEvent(s_WatcherWakeEvent);
+		s_WatcherThread.join();
+
+		CloseHandle(s_WatcherWakeEvent);
+		s_WatcherWakeEvent = nullptr;
+	}
+
+	void FileSystem::WakeWatcherThread()
+	{
+		SetEvent(s_WatcherWakeEvent);
 	}
 
 	std::filesystem::path FileSystem::OpenFileDialog(const char* filter)
@@ -131,139 +317,6 @@ namespace NanoCore {
 		return std::filesystem::path();
 	}
 
-	void FileSystem::SkipNextFileSystemChange()
-	{
-		s_IgnoreNextChange = true;
-	}
-
-	unsigned long FileSystem::Watch(void* param)
-	{
-		auto assetDirectory = Project::GetActive()->GetAssetDirectory();
-		std::wstring dirStr = assetDirectory.wstring();
-
-		char buf[2048];
-		DWORD bytesReturned;
-		std::filesystem::path filepath;
-		BOOL result = TRUE;
-
-		HANDLE directoryHandle = CreateFile(
-			dirStr.c_str(),
-			GENERIC_READ | FILE_LIST_DIRECTORY,
-			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
-			NULL,
-			OPEN_EXISTING,
-			FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
-			NULL
-		);
-
-		if (directoryHandle == INVALID_HANDLE_VALUE)
-		{
-
-			return 0;
-		}
-
-		OVERLAPPED pollingOverlap;
-		pollingOverlap.OffsetHigh = 0;
-		pollingOverlap.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
-
-		std::vector<FileSystemChangedEvent> eventBatch;
-		eventBatch.reserve(10);
-
-		while (s_Watching && result)
-		{
-			result = ReadDirectoryChangesW(
-				directoryHandle,
-				&buf,
-				sizeof(buf),
-				TRUE,
-				FILE_NOTIFY_CHANGE_FILE_NAME |
-				FILE_NOTIFY_CHANGE_DIR_NAME |
-				FILE_NOTIFY_CHANGE_SIZE,
-				&bytesReturned,
-				&pollingOverlap,
-				NULL
-			);
-
-			WaitForSingleObject(pollingOverlap.hEvent, INFINITE);
-
-			if (s_IgnoreNextChange)
-			{
-				s_IgnoreNextChange = false;
-				eventBatch.clear();
-				continue;
-			}
-
-			FILE_NOTIFY_INFORMATION* pNotify;
-			int offset = 0;
-			std::wstring oldName;
-
-			do
-			{
-				pNotify = (FILE_NOTIFY_INFORMATION*)((char*)buf + offset);
-				size_t filenameLength = pNotify->FileNameLength / sizeof(wchar_t);
-
-				FileSystemChangedEvent e;
-				e.FilePath = std::filesystem::path(std::wstring(pNotify->FileName, filenameLength));
-				e.IsDirectory = IsDirectory(e.FilePath);
-
-				switch (pNotify->Action)
-				{
-				case FILE_ACTION_ADDED:
-				{
-					e.Action = FileSystemAction::Added;
-					break;
-				}
-				case FILE_ACTION_REMOVED:
-				{
-					e.Action = FileSystemAction::Delete;
-					break;
-				}
-				case FILE_ACTION_MODIFIED:
-				{
-					e.Action = FileSystemAction::Modified;
-					break;
-				}
-				case FILE_ACTION_RENAMED_OLD_NAME:
-				{
-					oldName = e.FilePath.filename();
-					break;
-				}
-				case FILE_ACTION_RENAMED_NEW_NAME:
-				{
-					e.OldName = oldName;
-					e.Action = FileSystemAction::Rename;
-					break;
-				}
-				}
-
-				// NOTE(Peter): Fix for https://gitlab.com/chernoprojects/Hazel-dev/-/issues/143
-				bool hasAddedEvent = false;
-				if (e.Action == FileSystemAction::Modified)
-				{
-					for (const auto& event : eventBatch)
-					{
-						if (event.FilePath == e.FilePath && event.Action == FileSystemAction::Added)
-							hasAddedEvent = true;
-					}
-				}
-
-				if (pNotify->Action != FILE_ACTION_RENAMED_OLD_NAME && !hasAddedEvent)
-					eventBatch.push_back(e);
-
-				offset += pNotify->NextEntryOffset;
-			} while (pNotify->NextEntryOffset);
-
-			if (eventBatch.size() > 0)
-			{
-				s_Callback(eventBatch);
-				eventBatch.clear();
-			}
-		}
-
-		CloseHandle(directoryHandle);
-		return 0;
-	}
-
 	bool FileSystem::WriteBytes(const std::filesystem::path& filepath, const Buffer& buffer)
 	{
 		std::ofstream stream(filepath, std::ios::binary | std::ios::trunc);
@@ -280,23 +333,53 @@ namespace NanoCore {
 		return true;
 	}
 
-	Buffer FileSystem::ReadBytes(const std::filesystem::path& filepath)
+	bool MappedFile::Map(const std::filesystem::path& filepath)
 	{
-		Buffer buffer;
+		// Share write/delete so the file can still be replaced on disk, e.g. by a rebuild
+		HANDLE file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
 
-		std::ifstream stream(filepath, std::ios::binary | std::ios::ate);
-		NANO_ENGINE_LOG_ASSERT(stream);
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
 
-		std::streampos end = stream.tellg();
-		stream.seekg(0, std::ios::beg);
-		uint32_t size = end - stream.tellg();
-		NANO_ENGINE_LOG_ASSERT(size != 0);
+		HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (!mapping)
+		{
+			CloseHandle(file);
+			return false;
+		}
 
-		buffer.Allocate(size);
-		stream.read((char*)buffer.Data, buffer.Size);
-		stream.close();
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!data)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
 
-		return buffer;
+		m_FileHandle = file;
+		m_MappingHandle = mapping;
+		m_Data = (const uint8_t*)data;
+		m_Size = (uint64_t)size.QuadPart;
+		return true;
+	}
+
+	void MappedFile::Unmap()
+	{
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+		if (m_MappingHandle)
+			CloseHandle(m_MappingHandle);
+		if (m_FileHandle)
+			CloseHandle(m_FileHandle);
+
+		m_FileHandle = nullptr;
+		m_MappingHandle = nullptr;
 	}
 
 	bool FileSystem::HasEnvironmentVariable(const std::string& key)
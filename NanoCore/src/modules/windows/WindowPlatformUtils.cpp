@@ -9,7 +9,7 @@
 
 namespace NanoCore{
 
-	float Time::GetTime()
+	double Time::GetTime()
 	{
 		return glfwGetTime();
 	}
@@ -23,5 +23,6 @@
 #include "modules/utils/Instrumentor.h"
 
 #include "modules/ref/Shared.h"
+#include "modules/ref/WeakRef.h"
 
 
@@ -11,6 +11,8 @@
 #include <spirv_cross/spirv_glsl.hpp>
 
 #include "modules/utils/Timer.h"
+#include "modules/utils/FileManager.h"
+#include "modules/utils/Hash.h"
 
 namespace NanoCore {
 
@@ -84,6 +86,44 @@ namespace NanoCore {
 			return "";
 		}
 
+		// Cache files start with the hash of the source they were compiled from
+		static bool ReadCacheFile(const std::filesystem::path& cachedPath, uint64_t sourceHash, std::vector<char>& data)
+		{
+			std::ifstream in(cachedPath, std::ios::ate | std::ios::binary);
+			if (!in.is_open())
+				return false;
+
+			size_t size = in.tellg();
+			uint64_t hash = 0;
+			in.seekg(0);
+			if (size < sizeof(uint64_t) || !in.read((char*)&hash, sizeof(uint64_t)) || hash != sourceHash)
+				return false;
+
+			data.resize(size - sizeof(uint64_t));
+			return (bool)in.read(data.data(), data.size());
+		}
+
+		static bool ReadCachedBinary(const std::filesystem::path& cachedPath, uint64_t sourceHash, std::vector<uint32_t>& binary)
+		{
+			std::vector<char> data;
+			if (!ReadCacheFile(cachedPath, sourceHash, data))
+				return false;
+
+			binary.resize(data.size() / sizeof(uint32_t));
+			memcpy(binary.data(), data.data(), binary.size() * sizeof(uint32_t));
+			return true;
+		}
+
+		static void WriteCacheFile(const std::filesystem::path& cachedPath, uint64_t sourceHash, const void* data, size_t size)
+		{
+			std::ofstream out(cachedPath, std::ios::out | std::ios::binary);
+			if (out.is_open())
+			{
+				out.write((const char*)&sourceHash, sizeof(uint64_t));
+				out.write((const char*)data, size);
+			}
+		}
+
 		static const bool IsAmdGpu()
 		{
 			const char* vendor = (char*)glGetString(GL_VENDOR);
@@ -100,6 +140,7 @@ namespace NanoCore {
 		Utils::CreateCacheDirectoryIfNeeded();
 
 		std::string source = ReadFile(filepath);
+		m_SourceHash = Hash::Hash64(source);
 		auto shaderSources = PreProcess(source);
 
 		{
@@ -154,26 +195,11 @@ namespace NanoCore {
 		RA_PROFILE_FUNCTION();
 
 		std::string result;
-		std::ifstream in(filepath, std::ios::in | std::ios::binary); // ifstream closes itself due to RAII
-		if (in)
-		{
-			in.seekg(0, std::ios::end);
-			size_t size = in.tellg();
-			if (size != -1)
-			{
-				result.resize(size);
-				in.seekg(0, std::ios::beg);
-				in.read(&result[0], size);
-			}
-			else
-			{
-				NANO_ENGINE_LOG_ERROR("Could not read from file '{0}'", filepath);
-			}
-		}
+		MappedFile file;
+		if (file.Open(filepath))
+			result.assign((const char*)file.GetData(), file.GetSize());
 		else
-		{
 			NANO_ENGINE_LOG_ERROR("Could not open file '{0}'", filepath);
-		}
 
 		return result;
 	}
@@ -225,18 +251,7 @@ namespace NanoCore {
 			std::filesystem::path shaderFilePath = m_FilePath;
 			std::filesystem::path cachedPath = cacheDirectory / (shaderFilePath.filename().string() + Utils::GLShaderStageCachedVulkanFileExtension(stage));
 
-			std::ifstream in(cachedPath, std::ios::in | std::ios::binary);
-			if (in.is_open())
-			{
-				in.seekg(0, std::ios::end);
-				auto size = in.tellg();
-				in.seekg(0, std::ios::beg);
-
-				auto& data = shaderData[stage];
-				data.resize(size / sizeof(uint32_t));
-				in.read((char*)data.data(), size);
-			}
-			else
+			if (!Utils::ReadCachedBinary(cachedPath, m_SourceHash, shaderData[stage]))
 			{
 				shaderc::SpvCompilationResult module = compiler.CompileGlslToSpv(source, Utils::GLShaderStageToShaderC(stage), m_FilePath.c_str(), options);
 				if (module.GetCompilationStatus() != shaderc_compilation_status_success)
@@ -245,16 +260,9 @@ namespace NanoCore {
 					NANO_ENGINE_LOG_ASSERT(false);
 				}
 
-				shaderData[stage] = std::vector<uint32_t>(module.cbegin(), module.cend());
-
-				std::ofstream out(cachedPath, std::ios::out | std::ios::binary);
-				if (out.is_open())
-				{
-					auto& data = shaderData[stage];
-					out.write((char*)data.data(), data.size() * sizeof(uint32_t));
-					out.flush();
-					out.close();
-				}
+				auto& data = shaderData[stage];
+				data = std::vector<uint32_t>(module.cbegin(), module.cend());
+				Utils::WriteCacheFile(cachedPath, m_SourceHash, data.data(), data.size() * sizeof(uint32_t));
 			}
 		}
 
@@ -282,18 +290,7 @@ namespace NanoCore {
 			std::filesystem::path shaderFilePath = m_FilePath;
 			std::filesystem::path cachedPath = cacheDirectory / (shaderFilePath.filename().string() + Utils::GLShaderStageCachedOpenGLFileExtension(stage));
 
-			std::ifstream in(cachedPath, std::ios::in | std::ios::binary);
-			if (in.is_open())
-			{
-				in.seekg(0, std::ios::end);
-				auto size = in.tellg();
-				in.seekg(0, std::ios::beg);
-
-				auto& data = shaderData[stage];
-				data.resize(size / sizeof(uint32_t));
-				in.read((char*)data.data(), size);
-			}
-			else
+			if (!Utils::ReadCachedBinary(cachedPath, m_SourceHash, shaderData[stage]))
 			{
 				spirv_cross::CompilerGLSL glslCompiler(spirv);
 				m_OpenGLSourceCode[stage] = glslCompiler.compile();
@@ -306,16 +303,9 @@ namespace NanoCore {
 					NANO_ENGINE_LOG_ASSERT(false);
 				}
 
-				shaderData[stage] = std::vector<uint32_t>(module.cbegin(), module.cend());
-
-				std::ofstream out(cachedPath, std::ios::out | std::ios::binary);
-				if (out.is_open())
-				{
-					auto& data = shaderData[stage];
-					out.write((char*)data.data(), data.size() * sizeof(uint32_t));
-					out.flush();
-					out.close();
-				}
+				auto& data = shaderData[stage];
+				data = std::vector<uint32_t>(module.cbegin(), module.cend());
+				Utils::WriteCacheFile(cachedPath, m_SourceHash, data.data(), data.size() * sizeof(uint32_t));
 			}
 		}
 	}
@@ -389,18 +379,13 @@ namespace NanoCore {
 		std::filesystem::path cacheDirectory = Utils::GetCacheDirectory();
 		std::filesystem::path shaderFilePath = m_FilePath;
 		std::filesystem::path cachedPath = cacheDirectory / (shaderFilePath.filename().string() + ".cached_opengl.pgr");
-		std::ifstream in(cachedPath, std::ios::ate | std::ios::binary);
+		std::vector<char> data;
 
-		if (in.is_open())
+		if (Utils::ReadCacheFile(cachedPath, m_SourceHash, data) && data.size() > sizeof(uint32_t))
 		{
-			auto size = in.tellg();
-			in.seekg(0);
-
-			auto data = std::vector<char>(size);
 			uint32_t format = 0;
-			in.read((char*)&format, sizeof(uint32_t));
-			in.read((char*)data.data(), size);
-			glProgramBinary(program, format, data.data(), data.size());
+			memcpy(&format, data.data(), sizeof(uint32_t));
+			glProgramBinary(program, format, data.data() + sizeof(uint32_t), (GLsizei)(data.size() - sizeof(uint32_t)));
 
 			bool linked = VerifyProgramLink(program);
 
@@ -424,17 +409,11 @@ namespace NanoCore {
 				Utils::CreateCacheDirectoryIfNeeded();
 				GLint length = 0;
 				glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
-				auto shaderData = std::vector<char>(length);
+				auto shaderData = std::vector<char>(sizeof(uint32_t) + length);
 				uint32_t format = 0;
-				glGetProgramBinary(program, length, nullptr, &format, shaderData.data());
-				std::ofstream out(cachedPath, std::ios::out | std::ios::binary);
-				if (out.is_open())
-				{
-					out.write((char*)&format, sizeof(uint32_t));
-					out.write(shaderData.data(), shaderData.size());
-					out.flush();
-					out.close();
-				}
+				glGetProgramBinary(program, length, nullptr, &format, shaderData.data() + sizeof(uint32_t));
+				memcpy(shaderData.data(), &format, sizeof(uint32_t));
+				Utils::WriteCacheFile(cachedPath, m_SourceHash, shaderData.data(), shaderData.size());
 			}
 
 			for (auto& id : glShadersIDs)
@@ -54,6 +54,8 @@ namespace NanoCore {
 		uint32_t m_RendererID;
 		std::string m_FilePath;
 		std::string m_Name;
+		// Hash of the shader file, cached binaries of other sources are recompiled
+		uint64_t m_SourceHash = 0;
 
 		std::unordered_map<GLenum, std::vector<uint32_t>> m_VulkanSPIRV;
 		std::unordered_map<GLenum, std::vector<uint32_t>> m_OpenGLSPIRV;
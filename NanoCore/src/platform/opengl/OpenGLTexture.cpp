@@ -1,8 +1,6 @@
 #include "ncpch.h"
 #include "Platform/OpenGL/OpenGLTexture.h"
 
-#include <stb_image/stb_image.h>
-
 namespace NanoCore{
 
 	OpenGLTexture2D::OpenGLTexture2D(uint32_t width, uint32_t height)
@@ -28,51 +26,77 @@ namespace NanoCore{
 	{
 		RA_PROFILE_FUNCTION();
 
-		int width, height, channels;
-		stbi_set_flip_vertically_on_load(1);
-		stbi_uc* data = nullptr;
+		TextureImage image;
+		if (Texture2D::DecodeImageFile(path, image))
+			Upload(image);
+	}
+
+	OpenGLTexture2D::OpenGLTexture2D(const std::string& path, const TextureImage& image)
+		: m_Path(path)
+	{
+		RA_PROFILE_FUNCTION();
+
+		// Images that failed to decode give an unloaded texture, as a missing file does
+		if (!image.Pixels.empty())
+			Upload(image);
+	}
+
+	void OpenGLTexture2D::Upload(const TextureImage& image)
+	{
+		m_IsLoaded = true;
+
+		m_Width = image.Width;
+		m_Height = image.Height;
+		m_MipCount = image.MipCount;
+
+		GLenum internalFormat = 0, dataFormat = 0;
+		if (image.Channels == 4)
 		{
-			RA_PROFILE_SCOPE("stbi_load - OpenGLTexture2D::OpenGLTexture2D(const std::string&)");
-			data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+			internalFormat = GL_RGBA8;
+			dataFormat = GL_RGBA;
 		}
-
-		if (data)
+		else if (image.Channels == 3)
 		{
-			m_IsLoaded = true;
+			internalFormat = GL_RGB8;
+			dataFormat = GL_RGB;
+		}
 
-			m_Width = width;
-			m_Height = height;
+		m_InternalFormat = internalFormat;
+		m_DataFormat = dataFormat;
 
-			GLenum internalFormat = 0, dataFormat = 0;
-			if (channels == 4)
-			{
-				internalFormat = GL_RGBA8;
-				dataFormat = GL_RGBA;
-			}
-			else if (channels == 3)
-			{
-				internalFormat = GL_RGB8;
-				dataFormat = GL_RGB;
-			}
+		NANO_ENGINE_LOG_ASSERT(internalFormat & dataFormat, "Format not supported!");
 
-			m_InternalFormat = internalFormat;
-			m_DataFormat = dataFormat;
+		glCreateTextures(GL_TEXTURE_2D, 1, &m_RendererID);
+		glTextureStorage2D(m_RendererID, m_MipCount, internalFormat, m_Width, m_Height);
 
-			NANO_ENGINE_LOG_ASSERT(internalFormat & dataFormat, "Format not supported!");
+		glTextureParameteri(m_RendererID, GL_TEXTURE_MIN_FILTER, m_MipCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTextureParameteri(m_RendererID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-			glCreateTextures(GL_TEXTURE_2D, 1, &m_RendererID);
-			glTextureStorage2D(m_RendererID, 1, internalFormat, m_Width, m_Height);
+		glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-			glTextureParameteri(m_RendererID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTextureParameteri(m_RendererID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		// Rows of RGB mips aren't padded to four bytes
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		const uint8_t* pixels = image.Pixels.data();
+		for (uint32_t mip = 0; mip < m_MipCount; mip++)
+		{
+			glTextureSubImage2D(m_RendererID, mip, 0, 0, image.GetMipWidth(mip), image.GetMipHeight(mip), dataFormat, GL_UNSIGNED_BYTE, pixels);
+			pixels += image.GetMipSize(mip);
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
 
-			glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	void OpenGLTexture2D::Reload(const TextureImage& image)
+	{
+		RA_PROFILE_FUNCTION();
 
-			glTextureSubImage2D(m_RendererID, 0, 0, 0, m_Width, m_Height, dataFormat, GL_UNSIGNED_BYTE, data);
+		// The storage of a texture can't change size, the new image gets a new texture
+		glDeleteTextures(1, &m_RendererID);
+		m_RendererID = 0;
+		m_IsLoaded = false;
 
-			stbi_image_free(data);
-		}
+		if (!image.Pixels.empty())
+			Upload(image);
 	}
 
 	OpenGLTexture2D::~OpenGLTexture2D()
@@ -91,6 +115,18 @@ namespace NanoCore{
 		glTextureSubImage2D(m_RendererID, 0, 0, 0, m_Width, m_Height, m_DataFormat, GL_UNSIGNED_BYTE, data);
 	}
 
+	uint64_t OpenGLTexture2D::GetGPUMemorySize() const
+	{
+		if (m_RendererID == 0)
+			return 0;
+
+		// RGB8 is padded to four bytes per texel by most drivers
+		uint64_t size = 0;
+		for (uint32_t mip = 0; mip < m_MipCount; mip++)
+			size += (uint64_t)std::max(m_Width >> mip, 1u) * std::max(m_Height >> mip, 1u) * 4;
+		return size;
+	}
+
 	void OpenGLTexture2D::Bind(uint32_t slot) const
 	{
 		RA_PROFILE_FUNCTION();
@@ -10,6 +10,7 @@ namespace NanoCore{
 	{
 	public:
 		OpenGLTexture2D(const std::string& path);
+		OpenGLTexture2D(const std::string& path, const TextureImage& image);
 		OpenGLTexture2D(uint32_t width, uint32_t height);
 		virtual ~OpenGLTexture2D();
 
@@ -20,20 +21,26 @@ namespace NanoCore{
 		virtual const std::string& GetPath() const override { return m_Path; }
 
 		virtual void SetData(void* data, uint32_t size) override;
+		virtual void Reload(const TextureImage& image) override;
 
 		virtual void Bind(uint32_t slot = 0) const override;
 
 		virtual bool IsLoaded() const override { return m_IsLoaded; }
 
+		virtual uint64_t GetGPUMemorySize() const override;
+
 		virtual bool operator==(const Texture& other) const override
 		{
 			return m_RendererID == other.GetRendererID();
 		}
+	private:
+		void Upload(const TextureImage& image);
 	private:
 		std::string m_Path;
 		bool m_IsLoaded = false;
 		uint32_t m_Width, m_Height;
-		uint32_t m_RendererID;
+		uint32_t m_MipCount = 1;
+		uint32_t m_RendererID = 0;
 		GLenum m_InternalFormat, m_DataFormat;
 	};
 